@@ -54,6 +54,41 @@
 #define PRINTF(...)
 #endif
 
+/*---------------------------------------------------------------------------*/
+#if NATIVE_MULTI_NODES
+static rtimer_clock_t next_rtimer;
+static uint8_t rtimer_scheduled;
+/*---------------------------------------------------------------------------*/
+void
+rtimer_arch_init(void)
+{
+  rtimer_scheduled = 0;
+}
+/*---------------------------------------------------------------------------*/
+void
+rtimer_arch_schedule(rtimer_clock_t t)
+{
+  next_rtimer = t;
+  rtimer_scheduled = 1;
+}
+/*---------------------------------------------------------------------------*/
+int
+rtimer_arch_next(rtimer_clock_t *t)
+{
+  *t = next_rtimer;
+  return rtimer_scheduled;
+}
+/*---------------------------------------------------------------------------*/
+void
+rtimer_arch_run_expired(void)
+{
+  if(rtimer_scheduled && !RTIMER_CLOCK_LT(RTIMER_NOW(), next_rtimer)) {
+    rtimer_scheduled = 0;
+    rtimer_run_next();
+  }
+}
+/*---------------------------------------------------------------------------*/
+#else /* NATIVE_MULTI_NODES */
 /*---------------------------------------------------------------------------*/
 static void
 interrupt(int sig)
@@ -90,3 +125,5 @@ rtimer_arch_schedule(rtimer_clock_t t)
 #endif /* !_WIN32 */
 }
 /*---------------------------------------------------------------------------*/
+#endif /* NATIVE_MULTI_NODES */
+/*---------------------------------------------------------------------------*/
@@ -46,4 +46,11 @@
 
 #define rtimer_arch_now() clock_time()
 
+#if NATIVE_MULTI_NODES
+/* With several nodes in one process, rtimers are run by the node itself
+ * against the virtual clock instead of SIGALRM */
+int rtimer_arch_next(rtimer_clock_t *t);
+void rtimer_arch_run_expired(void);
+#endif /* NATIVE_MULTI_NODES */
+
 #endif /* RTIMER_ARCH_H_ */
@@ -38,6 +38,7 @@
  */
 
 #include "sys/clock.h"
+#include "native-multi.h"
 #include <time.h>
 #include <sys/time.h>
 
@@ -72,6 +73,10 @@ clock_time(void)
 {
   clock_timespec_t ts;
 
+#if NATIVE_MULTI_NODES
+  return native_multi_clock_time();
+#endif /* NATIVE_MULTI_NODES */
+
   get_time(&ts);
 
   return ts.tv_sec * CLOCK_SECOND + ts.tv_nsec / (1000000000 / CLOCK_SECOND);
@@ -82,6 +87,10 @@ clock_seconds(void)
 {
   clock_timespec_t ts;
 
+#if NATIVE_MULTI_NODES
+  return native_multi_clock_time() / CLOCK_SECOND;
+#endif /* NATIVE_MULTI_NODES */
+
   get_time(&ts);
 
   return ts.tv_sec;
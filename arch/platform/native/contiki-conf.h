@@ -66,6 +66,23 @@ typedef unsigned int uip_stats_t;
 #define UIP_CONF_BYTE_ORDER      UIP_LITTLE_ENDIAN
 #endif
 
+/* Number of nodes hosted by the process, see native-multi.h. When enabled,
+ * the nodes talk 6LoWPAN over an in-memory radio medium. */
+#ifdef NATIVE_CONF_MULTI_NODES
+#define NATIVE_MULTI_NODES NATIVE_CONF_MULTI_NODES
+#else /* NATIVE_CONF_MULTI_NODES */
+#define NATIVE_MULTI_NODES 0
+#endif /* NATIVE_CONF_MULTI_NODES */
+
+#if NATIVE_MULTI_NODES
+#ifndef NETSTACK_CONF_NETWORK
+#define NETSTACK_CONF_NETWORK    sicslowpan_driver
+#endif
+#ifndef NETSTACK_CONF_RADIO
+#define NETSTACK_CONF_RADIO      native_multi_radio_driver
+#endif /* NETSTACK_CONF_RADIO */
+#endif /* NATIVE_MULTI_NODES */
+
 #if NETSTACK_CONF_WITH_IPV6
 
 #ifndef NETSTACK_CONF_NETWORK
@@ -0,0 +1,578 @@
+/*
+ * Copyright (c) 2026, Contiki-NG contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \addtogroup native_multi
+ * @{
+ *
+ * \file
+ *         Multi-instance native nodes: scheduler, virtual clock and radio
+ *         medium
+ */
+
+#include "contiki.h"
+#include "native-multi.h"
+
+#if NATIVE_MULTI_NODES
+
+#ifndef __linux__
+#error "Multi-instance native nodes are only supported on Linux"
+#endif
+
+#include "net/netstack.h"
+#include "net/packetbuf.h"
+#include "net/mac/framer/frame802154.h"
+#include "sys/etimer.h"
+#include "sys/rtimer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ucontext.h>
+#include <sys/time.h>
+
+/* Log configuration */
+#include "sys/log.h"
+#define LOG_MODULE "Native"
+#define LOG_LEVEL LOG_LEVEL_MAIN
+
+#define ACK_LEN 3
+#define RX_RSSI -60
+#define RX_LQI 105
+
+/* Boundaries of the static memory of the firmware, from the GNU linker.
+ * This covers .data and .bss, which hold all the state of a node. */
+extern char __data_start[];
+extern char _end[];
+
+int main(int argc, char **argv);
+
+struct rx_frame {
+  uint16_t len;
+  uint8_t data[PACKETBUF_SIZE];
+};
+
+struct node {
+  ucontext_t context;
+  uint8_t *image;
+  uint8_t *stack;
+  linkaddr_t addr;
+  uint8_t started;
+  uint8_t has_wakeup;
+  clock_time_t wakeup;
+  struct rx_frame rx[NATIVE_MULTI_RX_QUEUE];
+  uint8_t rx_head;
+  uint8_t rx_count;
+  uint8_t ack_pending;
+  uint8_t ack[ACK_LEN];
+};
+
+struct simulation {
+  ucontext_t scheduler;
+  clock_time_t now;
+  int current;
+  int loaded;
+  int grid_width;
+  int argc;
+  char **argv;
+  size_t image_size;
+  unsigned long switches;
+  unsigned long frames;
+  struct timeval start;
+  struct node nodes[NATIVE_MULTI_NODES];
+};
+
+/* The only static variable of the scheduler. It is set before the first
+ * node image is taken, so all images hold the same value. Everything else
+ * is allocated on the heap, outside of the swapped memory. */
+static struct simulation *sim;
+
+/* Per-node state, swapped along with the rest of the node */
+static const void *pending_data;
+
+PROCESS(native_multi_radio_process, "Native multi radio");
+/*---------------------------------------------------------------------------*/
+static struct node *
+current_node(void)
+{
+  return &sim->nodes[sim->current];
+}
+/*---------------------------------------------------------------------------*/
+static void
+print_stats(void)
+{
+  struct timeval end;
+  unsigned long elapsed;
+
+  gettimeofday(&end, NULL);
+  elapsed = (end.tv_sec - sim->start.tv_sec) * 1000
+    + (end.tv_usec - sim->start.tv_usec) / 1000;
+
+  printf("Native multi: %u nodes, %lu s simulated in %lu.%03lu s, "
+         "%lu frames, %lu context switches\n",
+         NATIVE_MULTI_NODES, (unsigned long)(sim->now / CLOCK_SECOND),
+         elapsed / 1000, elapsed % 1000, sim->frames, sim->switches);
+}
+/*---------------------------------------------------------------------------*/
+static void
+node_entry(void)
+{
+  main(sim->argc, sim->argv);
+}
+/*---------------------------------------------------------------------------*/
+static void
+switch_to(int index)
+{
+  struct node *n = &sim->nodes[index];
+
+  if(sim->loaded != index) {
+    if(sim->loaded >= 0) {
+      memcpy(sim->nodes[sim->loaded].image, __data_start, sim->image_size);
+    }
+    memcpy(__data_start, n->image, sim->image_size);
+    sim->loaded = index;
+  }
+  sim->current = index;
+  sim->switches++;
+  swapcontext(&sim->scheduler, &n->context);
+}
+/*---------------------------------------------------------------------------*/
+static void
+run(void)
+{
+  struct node *n;
+  clock_time_t next;
+  int has_next;
+  int ran;
+  int i;
+
+  while(1) {
+    ran = 0;
+    for(i = 0; i < NATIVE_MULTI_NODES; i++) {
+      n = &sim->nodes[i];
+      if(!n->started || n->rx_count > 0
+         || (n->has_wakeup && n->wakeup <= sim->now)) {
+        n->started = 1;
+        switch_to(i);
+        ran = 1;
+      }
+    }
+    if(ran) {
+      /* Nodes visited earlier may have received frames since */
+      continue;
+    }
+
+    /* Every node is idle, advance the clock to the next timer */
+    has_next = 0;
+    next = 0;
+    for(i = 0; i < NATIVE_MULTI_NODES; i++) {
+      n = &sim->nodes[i];
+      if(n->has_wakeup && (!has_next || n->wakeup < next)) {
+        next = n->wakeup;
+        has_next = 1;
+      }
+    }
+    if(!has_next) {
+      LOG_WARN("no more events, stopping\n");
+      return;
+    }
+    if(NATIVE_MULTI_DURATION > 0
+       && next > (clock_time_t)NATIVE_MULTI_DURATION * CLOCK_SECOND) {
+      sim->now = (clock_time_t)NATIVE_MULTI_DURATION * CLOCK_SECOND;
+      return;
+    }
+    sim->now = next;
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+native_multi_start(int argc, char **argv)
+{
+  struct node *n;
+  int i;
+
+  if(sim != NULL) {
+    /* A node is being started */
+    return;
+  }
+
+  sim = calloc(1, sizeof(struct simulation));
+  if(sim == NULL) {
+    perror("native multi");
+    exit(1);
+  }
+  sim->argc = argc;
+  sim->argv = argv;
+  sim->now = 1;
+  sim->loaded = -1;
+  sim->image_size = _end - __data_start;
+  while(sim->grid_width * sim->grid_width < NATIVE_MULTI_NODES) {
+    sim->grid_width++;
+  }
+
+  for(i = 0; i < NATIVE_MULTI_NODES; i++) {
+    n = &sim->nodes[i];
+    n->image = malloc(sim->image_size);
+    n->stack = malloc(NATIVE_MULTI_STACK_SIZE);
+    if(n->image == NULL || n->stack == NULL) {
+      perror("native multi");
+      exit(1);
+    }
+    /* Every node starts from the pristine image, which already holds sim */
+    memcpy(n->image, __data_start, sim->image_size);
+
+    /* Node IDs start at 1 and are stored in the last two address bytes */
+    n->addr.u8[LINKADDR_SIZE - 2] = (i + 1) >> 8;
+    n->addr.u8[LINKADDR_SIZE - 1] = (i + 1) & 0xff;
+
+    getcontext(&n->context);
+    n->context.uc_stack.ss_sp = n->stack;
+    n->context.uc_stack.ss_size = NATIVE_MULTI_STACK_SIZE;
+    n->context.uc_link = &sim->scheduler;
+    makecontext(&n->context, node_entry, 0);
+  }
+
+  printf("Native multi: %u nodes on a %ux%u grid, range %u, %lu bytes per node\n",
+         NATIVE_MULTI_NODES, sim->grid_width, sim->grid_width,
+         NATIVE_MULTI_RANGE, (unsigned long)sim->image_size);
+
+  gettimeofday(&sim->start, NULL);
+  atexit(print_stats);
+  run();
+  exit(0);
+}
+/*---------------------------------------------------------------------------*/
+void
+native_multi_yield(void)
+{
+  struct node *n = current_node();
+  rtimer_clock_t rt;
+  clock_time_t t;
+
+  n->has_wakeup = etimer_pending();
+  n->wakeup = etimer_next_expiration_time();
+  if(rtimer_arch_next(&rt)) {
+    t = sim->now;
+    if(RTIMER_CLOCK_LT(RTIMER_NOW(), rt)) {
+      t += RTIMER_CLOCK_DIFF(rt, RTIMER_NOW());
+    }
+    if(!n->has_wakeup || t < n->wakeup) {
+      n->wakeup = t;
+      n->has_wakeup = 1;
+    }
+  }
+  if(n->has_wakeup && n->wakeup <= sim->now) {
+    /* Never let a node hold the clock back */
+    n->wakeup = sim->now + 1;
+  }
+
+  swapcontext(&n->context, &sim->scheduler);
+
+  rtimer_arch_run_expired();
+  if(n->rx_count > 0) {
+    process_poll(&native_multi_radio_process);
+  }
+}
+/*---------------------------------------------------------------------------*/
+clock_time_t
+native_multi_clock_time(void)
+{
+  return sim != NULL ? sim->now : 0;
+}
+/*---------------------------------------------------------------------------*/
+void
+native_multi_lladdr(linkaddr_t *addr)
+{
+  linkaddr_copy(addr, &current_node()->addr);
+}
+/*---------------------------------------------------------------------------*/
+static int
+in_range(int a, int b)
+{
+  int dx = a % sim->grid_width - b % sim->grid_width;
+  int dy = a / sim->grid_width - b / sim->grid_width;
+
+  return dx * dx + dy * dy <= NATIVE_MULTI_RANGE * NATIVE_MULTI_RANGE;
+}
+/*---------------------------------------------------------------------------*/
+static int
+deliver(struct node *n, const void *payload, unsigned short len)
+{
+  struct rx_frame *f;
+
+  if(n->rx_count >= NATIVE_MULTI_RX_QUEUE) {
+    return 0;
+  }
+  f = &n->rx[(n->rx_head + n->rx_count) % NATIVE_MULTI_RX_QUEUE];
+  memcpy(f->data, payload, len);
+  f->len = len;
+  n->rx_count++;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static int
+read_frame(void *buf, unsigned short bufsize)
+{
+  struct node *n = current_node();
+  struct rx_frame *f;
+  int len;
+
+  if(n->rx_count == 0) {
+    return 0;
+  }
+  f = &n->rx[n->rx_head];
+  n->rx_head = (n->rx_head + 1) % NATIVE_MULTI_RX_QUEUE;
+  n->rx_count--;
+  if(f->len > bufsize) {
+    return 0;
+  }
+  memcpy(buf, f->data, f->len);
+  len = f->len;
+  packetbuf_set_attr(PACKETBUF_ATTR_RSSI, RX_RSSI);
+  packetbuf_set_attr(PACKETBUF_ATTR_LINK_QUALITY, RX_LQI);
+  return len;
+}
+/*---------------------------------------------------------------------------*/
+static int
+init(void)
+{
+  process_start(&native_multi_radio_process, NULL);
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static int
+radio_send(const void *payload, unsigned short payload_len)
+{
+  struct node *self = current_node();
+  frame802154_t frame;
+  linkaddr_t dest;
+  int width = sim->grid_width;
+  int x0 = sim->current % width;
+  int y0 = sim->current / width;
+  int x, y, i;
+
+  self->ack_pending = 0;
+  if(payload_len == 0 || payload_len > PACKETBUF_SIZE) {
+    return RADIO_TX_ERR;
+  }
+  if(frame802154_parse((uint8_t *)payload, payload_len, &frame) == 0
+     || frame802154_extract_linkaddr(&frame, NULL, &dest) == 0) {
+    return RADIO_TX_ERR;
+  }
+  sim->frames++;
+
+  if(linkaddr_cmp(&dest, &linkaddr_null)) {
+    /* Broadcast, only visit the square of the grid that is within range */
+    for(y = MAX(y0 - NATIVE_MULTI_RANGE, 0); y <= y0 + NATIVE_MULTI_RANGE; y++) {
+      for(x = MAX(x0 - NATIVE_MULTI_RANGE, 0);
+          x <= x0 + NATIVE_MULTI_RANGE && x < width; x++) {
+        i = y * width + x;
+        if(i >= NATIVE_MULTI_NODES) {
+          break;
+        }
+        if(i != sim->current && in_range(i, sim->current)) {
+          deliver(&sim->nodes[i], payload, payload_len);
+        }
+      }
+    }
+    return RADIO_TX_OK;
+  }
+
+  /* Unicast, only the destination gets the frame. It is acknowledged right
+   * away when it could be queued. */
+  i = ((dest.u8[LINKADDR_SIZE - 2] << 8) | dest.u8[LINKADDR_SIZE - 1]) - 1;
+  if(i >= 0 && i < NATIVE_MULTI_NODES && i != sim->current
+     && linkaddr_cmp(&sim->nodes[i].addr, &dest)
+     && in_range(i, sim->current)
+     && deliver(&sim->nodes[i], payload, payload_len)
+     && frame.fcf.ack_required) {
+    self->ack[0] = FRAME802154_ACKFRAME;
+    self->ack[1] = 0;
+    self->ack[2] = frame.seq;
+    self->ack_pending = 1;
+  }
+  return RADIO_TX_OK;
+}
+/*---------------------------------------------------------------------------*/
+static int
+prepare_packet(const void *payload, unsigned short payload_len)
+{
+  pending_data = payload;
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static int
+transmit_packet(unsigned short transmit_len)
+{
+  if(pending_data == NULL) {
+    return RADIO_TX_ERR;
+  }
+  return radio_send(pending_data, transmit_len);
+}
+/*---------------------------------------------------------------------------*/
+static int
+radio_read(void *buf, unsigned short bufsize)
+{
+  struct node *n = current_node();
+
+  if(n->ack_pending) {
+    n->ack_pending = 0;
+    if(bufsize < ACK_LEN) {
+      return 0;
+    }
+    memcpy(buf, n->ack, ACK_LEN);
+    return ACK_LEN;
+  }
+  return read_frame(buf, bufsize);
+}
+/*---------------------------------------------------------------------------*/
+static int
+channel_clear(void)
+{
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static int
+receiving_packet(void)
+{
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static int
+pending_packet(void)
+{
+  /* Only acknowledgements are read synchronously, incoming frames are
+   * passed up by the radio process */
+  return current_node()->ack_pending;
+}
+/*---------------------------------------------------------------------------*/
+static int
+radio_on(void)
+{
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static int
+radio_off(void)
+{
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static radio_result_t
+get_value(radio_param_t param, radio_value_t *value)
+{
+  switch(param) {
+  case RADIO_PARAM_RX_MODE:
+  case RADIO_PARAM_TX_MODE:
+    *value = 0;
+    return RADIO_RESULT_OK;
+  case RADIO_PARAM_CHANNEL:
+    *value = IEEE802154_DEFAULT_CHANNEL;
+    return RADIO_RESULT_OK;
+  case RADIO_PARAM_LAST_RSSI:
+    *value = RX_RSSI;
+    return RADIO_RESULT_OK;
+  case RADIO_PARAM_LAST_LINK_QUALITY:
+    *value = RX_LQI;
+    return RADIO_RESULT_OK;
+  default:
+    return RADIO_RESULT_NOT_SUPPORTED;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static radio_result_t
+set_value(radio_param_t param, radio_value_t value)
+{
+  switch(param) {
+  case RADIO_PARAM_RX_MODE:
+  case RADIO_PARAM_TX_MODE:
+  case RADIO_PARAM_CHANNEL:
+    return RADIO_RESULT_OK;
+  default:
+    return RADIO_RESULT_NOT_SUPPORTED;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static radio_result_t
+get_object(radio_param_t param, void *dest, size_t size)
+{
+  return RADIO_RESULT_NOT_SUPPORTED;
+}
+/*---------------------------------------------------------------------------*/
+static radio_result_t
+set_object(radio_param_t param, const void *src, size_t size)
+{
+  return RADIO_RESULT_NOT_SUPPORTED;
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(native_multi_radio_process, ev, data)
+{
+  int len;
+
+  PROCESS_BEGIN();
+
+  while(1) {
+    PROCESS_YIELD_UNTIL(ev == PROCESS_EVENT_POLL);
+
+    while(current_node()->rx_count > 0) {
+      packetbuf_clear();
+      len = read_frame(packetbuf_dataptr(), PACKETBUF_SIZE);
+      if(len > 0) {
+        packetbuf_set_datalen(len);
+        NETSTACK_MAC.input();
+      }
+    }
+  }
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
+const struct radio_driver native_multi_radio_driver = {
+  init,
+  prepare_packet,
+  transmit_packet,
+  radio_send,
+  radio_read,
+  channel_clear,
+  receiving_packet,
+  pending_packet,
+  radio_on,
+  radio_off,
+  get_value,
+  set_value,
+  get_object,
+  set_object
+};
+/*---------------------------------------------------------------------------*/
+#endif /* NATIVE_MULTI_NODES */
+/** @} */
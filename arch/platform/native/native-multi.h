@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2026, Contiki-NG contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \addtogroup native_platform
+ * @{
+ *
+ * \defgroup native_multi Multi-instance native nodes
+ *
+ * Hosts several Contiki-NG nodes in a single native process. Each node
+ * runs on its own stack, and the static memory of the firmware (.data and
+ * .bss) is swapped in and out when the scheduler switches between nodes,
+ * the same way Cooja does for Contiki motes. Nodes share a virtual clock
+ * and an in-memory radio medium where they are placed on a square grid.
+ *
+ * Enabled by setting NATIVE_CONF_MULTI_NODES to the number of nodes. Only
+ * supported on Linux (GNU ld section symbols and ucontext).
+ * @{
+ *
+ * \file
+ *         Multi-instance native nodes
+ */
+
+#ifndef NATIVE_MULTI_H_
+#define NATIVE_MULTI_H_
+
+#include "contiki.h"
+#include "net/linkaddr.h"
+#include "dev/radio.h"
+
+/*---------------------------------------------------------------------------*/
+/**
+ * \name Multi-instance configuration
+ * @{
+ */
+
+/* Radio range, in grid units. Nodes at (x1, y1) and (x2, y2) hear each other
+ * if (x1 - x2)^2 + (y1 - y2)^2 <= range^2 */
+#ifdef NATIVE_MULTI_CONF_RANGE
+#define NATIVE_MULTI_RANGE NATIVE_MULTI_CONF_RANGE
+#else
+#define NATIVE_MULTI_RANGE 1
+#endif
+
+/* Number of frames that can wait in the radio of a node */
+#ifdef NATIVE_MULTI_CONF_RX_QUEUE
+#define NATIVE_MULTI_RX_QUEUE NATIVE_MULTI_CONF_RX_QUEUE
+#else
+#define NATIVE_MULTI_RX_QUEUE 8
+#endif
+
+/* Stack size of each node, in bytes */
+#ifdef NATIVE_MULTI_CONF_STACK_SIZE
+#define NATIVE_MULTI_STACK_SIZE NATIVE_MULTI_CONF_STACK_SIZE
+#else
+#define NATIVE_MULTI_STACK_SIZE (64 * 1024)
+#endif
+
+/* Simulated duration in seconds after which the process exits, 0 for none */
+#ifdef NATIVE_MULTI_CONF_DURATION
+#define NATIVE_MULTI_DURATION NATIVE_MULTI_CONF_DURATION
+#else
+#define NATIVE_MULTI_DURATION 0
+#endif
+/** @} */
+/*---------------------------------------------------------------------------*/
+extern const struct radio_driver native_multi_radio_driver;
+/*---------------------------------------------------------------------------*/
+/**
+ * \brief Start the nodes and schedule them until the end of the simulation
+ * \param argc The argument count, passed on to the nodes
+ * \param argv The arguments, passed on to the nodes
+ *
+ * Called from the platform before the node is initialized. Returns
+ * immediately when called by a node that has already been started,
+ * otherwise it never returns.
+ */
+void native_multi_start(int argc, char **argv);
+
+/**
+ * \brief Hand over to the scheduler until the node has something to do
+ *
+ * Called from the platform main loop when all processes are idle.
+ */
+void native_multi_yield(void);
+
+/**
+ * \brief Tells the current virtual time
+ * \return The time in clock ticks
+ */
+clock_time_t native_multi_clock_time(void);
+
+/**
+ * \brief Tells the link-layer address of the current node
+ * \param addr Where to write the address
+ */
+void native_multi_lladdr(linkaddr_t *addr);
+/*---------------------------------------------------------------------------*/
+#endif /* NATIVE_MULTI_H_ */
+/**
+ * @}
+ * @}
+ */
@@ -64,6 +64,8 @@
 #include "net/ipv6/uip-debug.h"
 #include "net/queuebuf.h"
 
+#include "native-multi.h"
+
 #if NETSTACK_CONF_WITH_IPV6
 #include "net/ipv6/uip-ds6.h"
 #endif /* NETSTACK_CONF_WITH_IPV6 */
@@ -114,7 +116,9 @@
 static const struct select_callback *select_callback[SELECT_MAX];
 static int select_max = 0;
 
-#ifdef PLATFORM_CONF_MAC_ADDR
+#if NATIVE_MULTI_NODES
+/* Each node gets its own address from native-multi */
+#elif defined(PLATFORM_CONF_MAC_ADDR)
 static uint8_t mac_addr[] = PLATFORM_CONF_MAC_ADDR;
 #else /* PLATFORM_CONF_MAC_ADDR */
 static uint8_t mac_addr[] = { 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08 };
@@ -181,7 +185,9 @@ set_lladdr(void)
   linkaddr_t addr;
 
   memset(&addr, 0, sizeof(linkaddr_t));
-#if NETSTACK_CONF_WITH_IPV6
+#if NATIVE_MULTI_NODES
+  native_multi_lladdr(&addr);
+#elif NETSTACK_CONF_WITH_IPV6
   memcpy(addr.u8, mac_addr, sizeof(addr.u8));
 #else
   int i;
@@ -192,7 +198,7 @@ set_lladdr(void)
   linkaddr_set_node_addr(&addr);
 }
 /*---------------------------------------------------------------------------*/
-#if NETSTACK_CONF_WITH_IPV6
+#if NETSTACK_CONF_WITH_IPV6 && !NATIVE_MULTI_NODES
 static void
 set_global_address(void)
 {
@@ -226,6 +232,11 @@ char **contiki_argv;
 void
 platform_process_args(int argc, char**argv)
 {
+#if NATIVE_MULTI_NODES
+  /* Does not return, unless we are a node being started */
+  native_multi_start(argc, argv);
+#endif /* NATIVE_MULTI_NODES */
+
   /* crappy way of remembering and accessing argc/v */
   contiki_argc = argc;
   contiki_argv = argv;
@@ -267,7 +278,9 @@ platform_init_stage_three()
   process_start(&wpcap_process, NULL);
 #endif
 
+#if !NATIVE_MULTI_NODES
   set_global_address();
+#endif /* !NATIVE_MULTI_NODES */
 
 #endif /* NETSTACK_CONF_WITH_IPV6 */
 
@@ -278,6 +291,14 @@ platform_init_stage_three()
 void
 platform_main_loop()
 {
+#if NATIVE_MULTI_NODES
+  while(1) {
+    while(process_run() > 0);
+    native_multi_yield();
+    etimer_request_poll();
+  }
+#endif /* NATIVE_MULTI_NODES */
+
 #if SELECT_STDIN
   select_set_callback(STDIN_FILENO, &stdin_fd);
 #endif /* SELECT_STDIN */
@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2026, Contiki-NG contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         Native benchmark of the CoAP server: activates a large number of
+ *         LwM2M-like resources and measures how many GET requests per second
+ *         go through coap_receive().
+ */
+
+#include "contiki.h"
+#include "coap-engine.h"
+#include "coap-endpoint.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Log configuration */
+#include "sys/log.h"
+#define LOG_MODULE "App"
+#define LOG_LEVEL LOG_LEVEL_APP
+
+#ifdef BENCHMARK_CONF_REQUESTS
+#define BENCHMARK_REQUESTS BENCHMARK_CONF_REQUESTS
+#else
+#define BENCHMARK_REQUESTS 200000
+#endif
+
+#define PATH_LEN 24
+#define REQUEST_LEN 64
+
+static coap_resource_t resources[BENCHMARK_RESOURCES];
+static char paths[BENCHMARK_RESOURCES][PATH_LEN];
+static uint8_t requests[BENCHMARK_RESOURCES][REQUEST_LEN];
+static uint16_t request_lens[BENCHMARK_RESOURCES];
+
+PROCESS(coap_benchmark_process, "CoAP benchmark");
+AUTOSTART_PROCESSES(&coap_benchmark_process);
+/*---------------------------------------------------------------------------*/
+static void
+res_get_handler(coap_message_t *request, coap_message_t *response,
+                uint8_t *buffer, uint16_t preferred_size, int32_t *offset)
+{
+  coap_set_header_content_format(response, TEXT_PLAIN);
+  coap_set_payload(response, "1", 1);
+}
+/*---------------------------------------------------------------------------*/
+static unsigned long
+now_us(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000UL + ts.tv_nsec / 1000;
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(coap_benchmark_process, ev, data)
+{
+  static struct etimer timer;
+  static coap_endpoint_t client;
+  static uint8_t buf[REQUEST_LEN];
+  coap_message_t request[1];
+  unsigned long start;
+  unsigned long elapsed;
+  unsigned long i;
+  int r;
+
+  PROCESS_BEGIN();
+
+  /* Paths look like LwM2M object instances and resources: obj/inst/res */
+  for(r = 0; r < BENCHMARK_RESOURCES; r++) {
+    snprintf(paths[r], PATH_LEN, "%u/%u/%u",
+             3300 + r / 16, (r / 4) % 4, 5700 + r % 4);
+    resources[r].get_handler = res_get_handler;
+    coap_activate_resource(&resources[r], paths[r]);
+
+    coap_init_message(request, COAP_TYPE_NON, COAP_GET, r);
+    coap_set_header_uri_path(request, paths[r]);
+    request_lens[r] = coap_serialize_message(request, requests[r]);
+  }
+  coap_endpoint_parse("coap://[fd00::2]", strlen("coap://[fd00::2]"), &client);
+
+  /* Let the network stack settle */
+  etimer_set(&timer, CLOCK_SECOND);
+  PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&timer));
+
+  start = now_us();
+  for(i = 0; i < BENCHMARK_REQUESTS; i++) {
+    r = i % BENCHMARK_RESOURCES;
+    memcpy(buf, requests[r], request_lens[r]);
+    coap_receive(&client, buf, request_lens[r]);
+  }
+  elapsed = now_us() - start;
+
+  printf("%u resources, %u requests in %lu ms: %lu requests/s\n",
+         BENCHMARK_RESOURCES, BENCHMARK_REQUESTS, elapsed / 1000,
+         elapsed > 0 ? (unsigned long)(BENCHMARK_REQUESTS * 1000000ULL / elapsed) : 0);
+
+  exit(0);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
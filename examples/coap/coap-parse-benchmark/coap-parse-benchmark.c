@@ -0,0 +1,245 @@
+/*
+ * Copyright (c) 2026, Contiki-NG contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         Native benchmark of the CoAP message parser: parses a corpus of
+ *         typical CoAP and LwM2M messages and reads no option, only the
+ *         Uri-Path, as the request dispatcher does, or every option.
+ */
+
+#include "contiki.h"
+#include "coap.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef BENCHMARK_CONF_ROUNDS
+#define BENCHMARK_ROUNDS BENCHMARK_CONF_ROUNDS
+#else
+#define BENCHMARK_ROUNDS 200000
+#endif
+
+/* options read after parsing */
+#define READ_NONE      0
+#define READ_URI_PATH  1
+#define READ_ALL       2
+
+typedef struct {
+  uint16_t len;
+  uint8_t data[COAP_MAX_PACKET_SIZE];
+} message_t;
+
+/* Messages as they appear on the air, with tokens and MIDs */
+static const message_t corpus[] = {
+  /* LwM2M Register: POST /rd?ep=node-0012&lt=300&lwm2m=1.0&b=U */
+  { 81, {
+      0x44, 0x02, 0x1a, 0x2b, 0x5a, 0x17, 0xc3, 0x02, 0xb2, 0x72,
+      0x64, 0x11, 0x28, 0x3c, 0x65, 0x70, 0x3d, 0x6e, 0x6f, 0x64,
+      0x65, 0x2d, 0x30, 0x30, 0x31, 0x32, 0x06, 0x6c, 0x74, 0x3d,
+      0x33, 0x30, 0x30, 0x09, 0x6c, 0x77, 0x6d, 0x32, 0x6d, 0x3d,
+      0x31, 0x2e, 0x30, 0x03, 0x62, 0x3d, 0x55, 0xff, 0x3c, 0x2f,
+      0x31, 0x2f, 0x30, 0x3e, 0x2c, 0x3c, 0x2f, 0x33, 0x2f, 0x30,
+      0x3e, 0x2c, 0x3c, 0x2f, 0x33, 0x33, 0x30, 0x33, 0x2f, 0x30,
+      0x3e, 0x2c, 0x3c, 0x2f, 0x33, 0x33, 0x30, 0x33, 0x2f, 0x31,
+      0x3e } },
+  /* LwM2M Read: GET /3303/0/5700, Accept TLV */
+  { 21, {
+      0x42, 0x01, 0x1a, 0x2c, 0x5a, 0x17, 0xb4, 0x33, 0x33, 0x30,
+      0x33, 0x01, 0x30, 0x04, 0x35, 0x37, 0x30, 0x30, 0x62, 0x2d,
+      0x16 } },
+  /* Observe: GET /sensors/temperature, Observe 0 */
+  { 29, {
+      0x44, 0x01, 0x1a, 0x2d, 0x5a, 0x17, 0xc3, 0x02, 0x60, 0x57,
+      0x73, 0x65, 0x6e, 0x73, 0x6f, 0x72, 0x73, 0x0b, 0x74, 0x65,
+      0x6d, 0x70, 0x65, 0x72, 0x61, 0x74, 0x75, 0x72, 0x65 } },
+  /* Notification: 2.05, Observe 1234, Max-Age 60 */
+  { 19, {
+      0x54, 0x45, 0x1a, 0x2e, 0x5a, 0x17, 0xc3, 0x02, 0x62, 0x04,
+      0xd2, 0x60, 0x21, 0x3c, 0xff, 0x32, 0x32, 0x2e, 0x35 } },
+  /* Block2 response: 2.05, ETag, Block2 3+/64 */
+  { 79, {
+      0x62, 0x45, 0x1a, 0x2f, 0x5a, 0x17, 0x44, 0xe1, 0x7a, 0x90,
+      0x3b, 0x80, 0xb1, 0x3a, 0xff, 0x30, 0x31, 0x32, 0x33, 0x34,
+      0x35, 0x36, 0x37, 0x38, 0x39, 0x61, 0x62, 0x63, 0x64, 0x65,
+      0x66, 0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38,
+      0x39, 0x61, 0x62, 0x63, 0x64, 0x65, 0x66, 0x30, 0x31, 0x32,
+      0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x61, 0x62, 0x63,
+      0x64, 0x65, 0x66, 0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36,
+      0x37, 0x38, 0x39, 0x61, 0x62, 0x63, 0x64, 0x65, 0x66 } },
+  /* Firmware: PUT /5/0/0, Block1 7+/64, Size1 4096 */
+  { 88, {
+      0x44, 0x03, 0x1a, 0x30, 0x5a, 0x17, 0xc3, 0x02, 0xb1, 0x35,
+      0x01, 0x30, 0x01, 0x30, 0x11, 0x2a, 0xd1, 0x02, 0x7a, 0xd2,
+      0x14, 0x10, 0x00, 0xff, 0x30, 0x31, 0x32, 0x33, 0x34, 0x35,
+      0x36, 0x37, 0x38, 0x39, 0x61, 0x62, 0x63, 0x64, 0x65, 0x66,
+      0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39,
+      0x61, 0x62, 0x63, 0x64, 0x65, 0x66, 0x30, 0x31, 0x32, 0x33,
+      0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x61, 0x62, 0x63, 0x64,
+      0x65, 0x66, 0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37,
+      0x38, 0x39, 0x61, 0x62, 0x63, 0x64, 0x65, 0x66 } },
+  /* Discovery: GET /.well-known/core?rt=temperature */
+  { 38, {
+      0x41, 0x01, 0x1a, 0x31, 0x5a, 0xbb, 0x2e, 0x77, 0x65, 0x6c,
+      0x6c, 0x2d, 0x6b, 0x6e, 0x6f, 0x77, 0x6e, 0x04, 0x63, 0x6f,
+      0x72, 0x65, 0x4d, 0x01, 0x72, 0x74, 0x3d, 0x74, 0x65, 0x6d,
+      0x70, 0x65, 0x72, 0x61, 0x74, 0x75, 0x72, 0x65 } },
+  /* Registered: 2.01, Location-Path rd/5a3f */
+  { 16, {
+      0x64, 0x41, 0x1a, 0x2b, 0x5a, 0x17, 0xc3, 0x02, 0x82, 0x72,
+      0x64, 0x04, 0x35, 0x61, 0x33, 0x66 } },
+  /* LwM2M Update: POST /rd/5a3f?lt=300 */
+  { 23, {
+      0x44, 0x02, 0x1a, 0x32, 0x5a, 0x17, 0xc3, 0x02, 0xb2, 0x72,
+      0x64, 0x04, 0x35, 0x61, 0x33, 0x66, 0x46, 0x6c, 0x74, 0x3d,
+      0x33, 0x30, 0x30 } },
+  /* GET /test */
+  { 11, {
+      0x42, 0x01, 0x1a, 0x33, 0x5a, 0x17, 0xb4, 0x74, 0x65, 0x73,
+      0x74 } },
+};
+
+#define CORPUS_SIZE (sizeof(corpus) / sizeof(corpus[0]))
+
+PROCESS(coap_parse_benchmark_process, "CoAP parse benchmark");
+AUTOSTART_PROCESSES(&coap_parse_benchmark_process);
+/*---------------------------------------------------------------------------*/
+static unsigned long
+now_us(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000UL + ts.tv_nsec / 1000;
+}
+/*---------------------------------------------------------------------------*/
+/* Reads every option, returns a checksum so the work is not optimized away */
+static unsigned long
+read_all_options(coap_message_t *message)
+{
+  unsigned long sum = 0;
+  const char *str;
+  const uint8_t *bytes;
+  unsigned int value;
+  uint32_t num;
+  uint32_t u32;
+  uint8_t more;
+  uint16_t size;
+
+  sum += coap_get_header_uri_path(message, &str);
+  sum += coap_get_header_uri_query(message, &str);
+  sum += coap_get_header_location_path(message, &str);
+  sum += coap_get_header_location_query(message, &str);
+  sum += coap_get_header_uri_host(message, &str);
+  sum += coap_get_header_etag(message, &bytes);
+  sum += coap_get_header_if_match(message, &bytes);
+  if(coap_get_header_content_format(message, &value)) {
+    sum += value;
+  }
+  if(coap_get_header_accept(message, &value)) {
+    sum += value;
+  }
+  coap_get_header_max_age(message, &u32);
+  sum += u32;
+  if(coap_get_header_observe(message, &u32)) {
+    sum += u32;
+  }
+  if(coap_get_header_block2(message, &num, &more, &size, NULL)) {
+    sum += num + more + size;
+  }
+  if(coap_get_header_block1(message, &num, &more, &size, NULL)) {
+    sum += num + more + size;
+  }
+  if(coap_get_header_size1(message, &u32)) {
+    sum += u32;
+  }
+  return sum;
+}
+/*---------------------------------------------------------------------------*/
+static void
+run(const char *name, int mode)
+{
+  static coap_message_t message[1];
+  static uint8_t buf[COAP_MAX_PACKET_SIZE + 1];
+  unsigned long start;
+  unsigned long elapsed;
+  unsigned long sum = 0;
+  unsigned long i;
+  const char *path;
+  int m;
+
+  start = now_us();
+  for(i = 0; i < BENCHMARK_ROUNDS; i++) {
+    for(m = 0; m < CORPUS_SIZE; m++) {
+      /* parsing may rewrite the buffer */
+      memcpy(buf, corpus[m].data, corpus[m].len);
+      if(coap_parse_message(message, buf, corpus[m].len) != NO_ERROR) {
+        printf("Failed to parse message %d\n", m);
+        exit(1);
+      }
+      if(mode == READ_ALL) {
+        sum += read_all_options(message);
+      } else if(mode == READ_URI_PATH) {
+        sum += coap_get_header_uri_path(message, &path);
+      } else {
+        sum += message->code;
+      }
+    }
+  }
+  elapsed = now_us() - start;
+
+  printf("%s: %lu messages in %lu ms: %lu messages/s (checksum %lu)\n",
+         name, (unsigned long)(BENCHMARK_ROUNDS * CORPUS_SIZE), elapsed / 1000,
+         elapsed > 0 ? (unsigned long)(BENCHMARK_ROUNDS * CORPUS_SIZE *
+                                       1000000ULL / elapsed) : 0,
+         sum);
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(coap_parse_benchmark_process, ev, data)
+{
+  PROCESS_BEGIN();
+
+  printf("sizeof(coap_message_t) = %u, %u messages in corpus\n",
+         (unsigned)sizeof(coap_message_t), (unsigned)CORPUS_SIZE);
+
+  run("No options", READ_NONE);
+  run("Uri-Path only", READ_URI_PATH);
+  run("All options", READ_ALL);
+
+  exit(0);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -60,7 +60,8 @@ RESOURCE(res_plugtest_large_create,
 static void
 res_post_handler(coap_message_t *request, coap_message_t *response, uint8_t *buffer, uint16_t preferred_size, int32_t *offset)
 {
-  coap_message_t *const coap_req = (coap_message_t *)request;
+  uint32_t block1_num = 0;
+  uint16_t block1_size = 0;
 
   uint8_t *incoming = NULL;
   size_t len = 0;
@@ -74,12 +75,14 @@ res_post_handler(coap_message_t *request, coap_message_t *response, uint8_t *buf
     return;
   }
 
+  coap_get_header_block1(request, &block1_num, NULL, &block1_size, NULL);
+
   if((len = coap_get_payload(request, (const uint8_t **)&incoming))) {
-    if(coap_req->block1_num * coap_req->block1_size + len <= 2048) {
+    if(block1_num * block1_size + len <= 2048) {
       coap_set_status_code(response, CREATED_2_01);
       coap_set_header_location_path(response, "/nirvana");
-      coap_set_header_block1(response, coap_req->block1_num, 0,
-                             coap_req->block1_size);
+      coap_set_header_block1(response, block1_num, 0,
+                             block1_size);
     } else {
       coap_set_status_code(response, REQUEST_ENTITY_TOO_LARGE_4_13);
       const char *error_msg = "2048B max.";
@@ -90,7 +90,8 @@ res_get_handler(coap_message_t *request, coap_message_t *response, uint8_t *buff
 static void
 res_put_handler(coap_message_t *request, coap_message_t *response, uint8_t *buffer, uint16_t preferred_size, int32_t *offset)
 {
-  coap_message_t *const coap_req = (coap_message_t *)request;
+  uint32_t block1_num = 0;
+  uint16_t block1_size = 0;
   uint8_t *incoming = NULL;
   size_t len = 0;
 
@@ -103,17 +104,19 @@ res_put_handler(coap_message_t *request, coap_message_t *response, uint8_t *buff
     return;
   }
 
+  coap_get_header_block1(request, &block1_num, NULL, &block1_size, NULL);
+
   if((len = coap_get_payload(request, (const uint8_t **)&incoming))) {
-    if(coap_req->block1_num * coap_req->block1_size + len <= sizeof(large_update_store)) {
+    if(block1_num * block1_size + len <= sizeof(large_update_store)) {
       memcpy(
-        large_update_store + coap_req->block1_num * coap_req->block1_size,
+        large_update_store + block1_num * block1_size,
         incoming, len);
-      large_update_size = coap_req->block1_num * coap_req->block1_size + len;
+      large_update_size = block1_num * block1_size + len;
       large_update_ct = ct;
 
       coap_set_status_code(response, CHANGED_2_04);
-      coap_set_header_block1(response, coap_req->block1_num, 0,
-                             coap_req->block1_size);
+      coap_set_header_block1(response, block1_num, 0,
+                             block1_size);
     } else {
       coap_set_status_code(response,
                                REQUEST_ENTITY_TOO_LARGE_4_13);
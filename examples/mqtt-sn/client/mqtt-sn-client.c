@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) 2026, Contiki-NG contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/*---------------------------------------------------------------------------*/
+/**
+ * \file
+ *    An MQTT-SN client that publishes its uptime through the gateway of the
+ *    RPL root, and logs what it receives on its command topic.
+ */
+/*---------------------------------------------------------------------------*/
+#include "contiki.h"
+#include "mqtt-sn.h"
+#include "net/routing/routing.h"
+#include "net/linkaddr.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "sys/log.h"
+#define LOG_MODULE "MQTT-SN client"
+#define LOG_LEVEL LOG_LEVEL_INFO
+/*---------------------------------------------------------------------------*/
+#ifdef MQTT_SN_CLIENT_CONF_PUBLISH_INTERVAL
+#define PUBLISH_INTERVAL MQTT_SN_CLIENT_CONF_PUBLISH_INTERVAL
+#else
+#define PUBLISH_INTERVAL (30 * CLOCK_SECOND)
+#endif
+
+/* Sleep between publications instead of staying connected */
+#ifdef MQTT_SN_CLIENT_CONF_SLEEP
+#define SLEEP MQTT_SN_CLIENT_CONF_SLEEP
+#else
+#define SLEEP 0
+#endif
+
+#define KEEP_ALIVE 60
+#define SLEEP_DURATION (2 * PUBLISH_INTERVAL / CLOCK_SECOND)
+/*---------------------------------------------------------------------------*/
+static struct mqtt_sn_connection conn;
+static char client_id[MQTT_SN_CLIENT_ID_MAX_LEN + 1];
+static char status_topic[MQTT_SN_MAX_TOPIC_LENGTH + 1];
+static char cmd_topic[MQTT_SN_MAX_TOPIC_LENGTH + 1];
+static uint16_t status_topic_id;
+static uint8_t subscribed;
+static unsigned seq;
+/*---------------------------------------------------------------------------*/
+PROCESS(mqtt_sn_client_process, "MQTT-SN client");
+AUTOSTART_PROCESSES(&mqtt_sn_client_process);
+/*---------------------------------------------------------------------------*/
+static void
+event_callback(struct mqtt_sn_connection *m, mqtt_sn_event_t event,
+               void *data)
+{
+  struct mqtt_sn_ack_event *ack = data;
+  struct mqtt_sn_message *msg = data;
+
+  switch(event) {
+  case MQTT_SN_EVENT_CONNECTED:
+    LOG_INFO("Connected\n");
+    break;
+  case MQTT_SN_EVENT_REGACK:
+    if(ack->return_code == MQTT_SN_RC_ACCEPTED) {
+      status_topic_id = ack->topic_id;
+    }
+    break;
+  case MQTT_SN_EVENT_SUBACK:
+    subscribed = 1;
+    break;
+  case MQTT_SN_EVENT_PUBLISH:
+    LOG_INFO("Received %.*s on %s\n", msg->payload_length,
+             (const char *)msg->payload,
+             msg->topic != NULL ? msg->topic : "?");
+    break;
+  case MQTT_SN_EVENT_PUBACK:
+    LOG_INFO("Message %u acknowledged\n", ack->msg_id);
+    break;
+  case MQTT_SN_EVENT_ASLEEP:
+    LOG_INFO("Asleep\n");
+    break;
+  case MQTT_SN_EVENT_DISCONNECTED:
+  case MQTT_SN_EVENT_GATEWAY_LOST_ERROR:
+  case MQTT_SN_EVENT_CONNECTION_REFUSED_ERROR:
+    LOG_WARN("Disconnected (%u)\n", event);
+    /* A new session with the gateway */
+    status_topic_id = 0;
+    subscribed = 0;
+    break;
+  default:
+    LOG_WARN("Event %u\n", event);
+    break;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+publish(void)
+{
+  char payload[32];
+  int len;
+
+  len = snprintf(payload, sizeof(payload), "{\"seq\":%u,\"uptime\":%lu}",
+                 ++seq, (unsigned long)clock_seconds());
+  if(mqtt_sn_publish(&conn, NULL, status_topic_id, MQTT_SN_TOPIC_TYPE_NORMAL,
+                     (uint8_t *)payload, len, MQTT_SN_QOS_LEVEL_1,
+                     MQTT_SN_RETAIN_OFF) == MQTT_SN_STATUS_OK) {
+    LOG_INFO("Publishing %s\n", payload);
+  }
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(mqtt_sn_client_process, ev, data)
+{
+  static struct etimer timer;
+  static uint8_t publish_due;
+  uip_ipaddr_t gateway;
+
+  PROCESS_BEGIN();
+
+  snprintf(client_id, sizeof(client_id), "contiki-%02x%02x",
+           linkaddr_node_addr.u8[LINKADDR_SIZE - 2],
+           linkaddr_node_addr.u8[LINKADDR_SIZE - 1]);
+  snprintf(status_topic, sizeof(status_topic), "%s/status", client_id);
+  snprintf(cmd_topic, sizeof(cmd_topic), "%s/cmd", client_id);
+
+  /* The gateway runs on the RPL root */
+  etimer_set(&timer, CLOCK_SECOND);
+  while(!NETSTACK_ROUTING.node_is_reachable() ||
+        !NETSTACK_ROUTING.get_root_ipaddr(&gateway)) {
+    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&timer));
+    etimer_reset(&timer);
+  }
+  LOG_INFO("Gateway at ");
+  LOG_INFO_6ADDR(&gateway);
+  LOG_INFO_("\n");
+
+  mqtt_sn_register(&conn, &mqtt_sn_client_process, client_id, &gateway,
+                   MQTT_SN_DEFAULT_PORT, event_callback);
+  etimer_set(&timer, PUBLISH_INTERVAL);
+  publish_due = 1;
+
+  while(1) {
+    if(conn.state == MQTT_SN_STATE_NOT_CONNECTED ||
+       (conn.state == MQTT_SN_STATE_ASLEEP && publish_due)) {
+      mqtt_sn_connect(&conn, KEEP_ALIVE);
+    } else if(mqtt_sn_ready(&conn)) {
+      if(status_topic_id == 0) {
+        mqtt_sn_register_topic(&conn, NULL, status_topic);
+      } else if(!subscribed) {
+        mqtt_sn_subscribe(&conn, NULL, cmd_topic, MQTT_SN_QOS_LEVEL_0);
+      } else if(publish_due) {
+        publish();
+        publish_due = 0;
+      } else if(SLEEP) {
+        mqtt_sn_sleep(&conn, SLEEP_DURATION);
+      }
+    }
+
+    PROCESS_WAIT_EVENT();
+    if(ev == PROCESS_EVENT_TIMER && data == &timer) {
+      publish_due = 1;
+      etimer_reset(&timer);
+    }
+  }
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
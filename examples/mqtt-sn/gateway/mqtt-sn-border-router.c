@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2026, Contiki-NG contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/*---------------------------------------------------------------------------*/
+/**
+ * \file
+ *    A border router running an MQTT-SN gateway for the nodes of its
+ *    network.
+ */
+/*---------------------------------------------------------------------------*/
+#include "contiki.h"
+#include "mqtt-sn-gateway.h"
+
+#include "sys/log.h"
+#define LOG_MODULE "MQTT-SN GW"
+#define LOG_LEVEL LOG_LEVEL_INFO
+/*---------------------------------------------------------------------------*/
+#ifdef MQTT_SN_GATEWAY_CONF_BROKER_IP_ADDR
+#define BROKER_IP_ADDR MQTT_SN_GATEWAY_CONF_BROKER_IP_ADDR
+#else
+#define BROKER_IP_ADDR "fd00::1"
+#endif
+
+#define BROKER_PORT 1883
+/*---------------------------------------------------------------------------*/
+PROCESS(gateway_process, "MQTT-SN gateway example");
+AUTOSTART_PROCESSES(&gateway_process);
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(gateway_process, ev, data)
+{
+  PROCESS_BEGIN();
+
+  /* Clients can publish to "contiki-ng/alerts" as topic ID 1 with QoS -1 */
+  mqtt_sn_gateway_predefine(1, "contiki-ng/alerts");
+  mqtt_sn_gateway_init(BROKER_IP_ADDR, BROKER_PORT, "contiki-ng-gw");
+
+  LOG_INFO("MQTT-SN gateway started, broker at %s\n", BROKER_IP_ADDR);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2026, Contiki-NG contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         Measures how long an RPL network of native nodes takes to
+ *         converge, with all nodes hosted in one process. Node 1 is the
+ *         root, and the process exits once it has a route to every node.
+ */
+
+#include "contiki.h"
+#include "net/routing/routing.h"
+#include "net/ipv6/uip-sr.h"
+#include "net/ipv6/uip-ds6-route.h"
+#if ROUTING_CONF_RPL_CLASSIC
+#include "net/routing/rpl-classic/rpl.h"
+#endif /* ROUTING_CONF_RPL_CLASSIC */
+#include "sys/node-id.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+/*---------------------------------------------------------------------------*/
+PROCESS(rpl_convergence_process, "RPL convergence");
+AUTOSTART_PROCESSES(&rpl_convergence_process);
+/*---------------------------------------------------------------------------*/
+static unsigned
+num_nodes(void)
+{
+#if ROUTING_CONF_RPL_CLASSIC && RPL_WITH_STORING
+  /* Storing mode: one route per node, plus the root itself */
+  return uip_ds6_route_num_routes() + 1;
+#else
+  /* The root itself is part of the source routing graph */
+  return uip_sr_num_nodes();
+#endif
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(rpl_convergence_process, ev, data)
+{
+  static struct etimer timer;
+
+  PROCESS_BEGIN();
+
+  if(node_id != 1) {
+    PROCESS_EXIT();
+  }
+
+  NETSTACK_ROUTING.root_start();
+
+  etimer_set(&timer, CLOCK_SECOND);
+  while(1) {
+    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&timer));
+    etimer_reset(&timer);
+
+    if(clock_seconds() % 10 == 0) {
+      printf("%lu s: %u/%u nodes\n", clock_seconds(),
+             num_nodes(), NATIVE_MULTI_NODES);
+    }
+    if(num_nodes() >= NATIVE_MULTI_NODES) {
+      printf("Converged: %u nodes after %lu s\n",
+             NATIVE_MULTI_NODES, clock_seconds());
+      exit(0);
+    }
+  }
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
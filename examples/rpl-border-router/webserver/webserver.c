@@ -138,7 +138,7 @@ PT_THREAD(generate_routes(struct httpd_state *s))
 
         ADD(" (parent: ");
         ipaddr_add(&parent_ipaddr);
-        ADD(") %us", (unsigned int)link->lifetime);
+        ADD(") %us", (unsigned int)uip_sr_node_lifetime(link));
 
         ADD("</li>\n");
         SEND(&s->sout);
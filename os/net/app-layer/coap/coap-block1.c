@@ -81,6 +81,10 @@ coap_block1_handler(coap_message_t *request, coap_message_t *response,
 {
   const uint8_t *payload = 0;
   int pay_len = coap_get_payload(request, &payload);
+  uint32_t block1_num = 0;
+  uint8_t block1_more = 0;
+  uint16_t block1_size = 0;
+  uint32_t block1_offset = 0;
 
   if(!pay_len || !payload) {
     coap_status_code = BAD_REQUEST_4_00;
@@ -88,27 +92,30 @@ coap_block1_handler(coap_message_t *request, coap_message_t *response,
     return -1;
   }
 
-  if(request->block1_offset + pay_len > max_len) {
+  coap_get_header_block1(request, &block1_num, &block1_more, &block1_size,
+                         &block1_offset);
+
+  if(block1_offset + pay_len > max_len) {
     coap_status_code = REQUEST_ENTITY_TOO_LARGE_4_13;
     coap_error_message = "Message to big";
     return -1;
   }
 
   if(target && len) {
-    memcpy(target + request->block1_offset, payload, pay_len);
-    *len = request->block1_offset + pay_len;
+    memcpy(target + block1_offset, payload, pay_len);
+    *len = block1_offset + pay_len;
   }
 
   if(coap_is_option(request, COAP_OPTION_BLOCK1)) {
     LOG_DBG("Blockwise: block 1 request: Num: %"PRIu32
             ", More: %u, Size: %u, Offset: %"PRIu32"\n",
-            request->block1_num,
-            request->block1_more,
-            request->block1_size,
-            request->block1_offset);
+            block1_num,
+            block1_more,
+            block1_size,
+            block1_offset);
 
-    coap_set_header_block1(response, request->block1_num, request->block1_more, request->block1_size);
-    if(request->block1_more) {
+    coap_set_header_block1(response, block1_num, block1_more, block1_size);
+    if(block1_more) {
       coap_set_status_code(response, CONTINUE_2_31);
       return 1;
     }
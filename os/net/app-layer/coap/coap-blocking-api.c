@@ -43,6 +43,7 @@
 
 #include "coap-engine.h"
 #include "coap-blocking-api.h"
+#include "coap-cache.h"
 #include "sys/cc.h"
 #include <stdio.h>
 #include <stdlib.h>
@@ -57,6 +58,56 @@
 /*---------------------------------------------------------------------------*/
 /*- Client Part -------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
+#if COAP_BLOCK_WINDOW > 1
+static void
+coap_blocking_window_callback(coap_callback_request_state_t *callback_state)
+{
+  coap_blocking_request_state_t *blocking_state =
+    (coap_blocking_request_state_t *)callback_state;
+
+  if(callback_state->state.status == COAP_REQUEST_STATUS_MORE
+     || callback_state->state.status == COAP_REQUEST_STATUS_RESPONSE) {
+    /* blocks are handed over in order as they complete */
+    blocking_state->request_callback(callback_state->state.response);
+  } else {
+    process_poll(blocking_state->process);
+  }
+}
+/*---------------------------------------------------------------------------*/
+PT_THREAD(coap_blocking_request
+          (coap_blocking_request_state_t *blocking_state, process_event_t ev,
+           coap_endpoint_t *remote_ep,
+           coap_message_t *request,
+           coap_blocking_response_handler_t request_callback))
+{
+  coap_request_state_t *state = &blocking_state->callback_state.state;
+
+  PT_BEGIN(&blocking_state->pt);
+
+  blocking_state->process = PROCESS_CURRENT();
+  blocking_state->request_callback = request_callback;
+  state->status = COAP_REQUEST_STATUS_MORE;
+
+  if(!coap_send_request(&blocking_state->callback_state, remote_ep, request,
+                        coap_blocking_window_callback)) {
+    LOG_WARN("Could not allocate transaction buffer");
+    state->status = COAP_REQUEST_STATUS_TIMEOUT;
+    PT_EXIT(&blocking_state->pt);
+  }
+
+  PT_YIELD_UNTIL(&blocking_state->pt, ev == PROCESS_EVENT_EXIT
+                 || (ev == PROCESS_EVENT_POLL
+                     && state->status != COAP_REQUEST_STATUS_MORE
+                     && state->status != COAP_REQUEST_STATUS_RESPONSE));
+  if(ev == PROCESS_EVENT_EXIT) {
+    /* the request may still be waiting for room in the NSTART window */
+    coap_nstart_cancel(&blocking_state->callback_state.waiter);
+    state->status = COAP_REQUEST_STATUS_TIMEOUT;
+  }
+
+  PT_END(&blocking_state->pt);
+}
+#else /* COAP_BLOCK_WINDOW > 1 */
 void
 coap_blocking_request_callback(void *callback_data, coap_message_t *response)
 {
@@ -66,6 +117,12 @@ coap_blocking_request_callback(void *callback_data, coap_message_t *response)
   process_poll(blocking_state->process);
 }
 /*---------------------------------------------------------------------------*/
+static void
+coap_blocking_request_resume(void *data)
+{
+  process_poll(((coap_blocking_request_state_t *)data)->process);
+}
+/*---------------------------------------------------------------------------*/
 PT_THREAD(coap_blocking_request
           (coap_blocking_request_state_t *blocking_state, process_event_t ev,
            coap_endpoint_t *remote_ep,
@@ -74,6 +131,9 @@ PT_THREAD(coap_blocking_request
 {
   /* Before PT_BEGIN in order to not be a local variable in the PT_Thread and maintain it */
   coap_request_state_t *state = &blocking_state->state;
+#if COAP_CACHE_SIZE
+  static coap_message_t cached[1];
+#endif /* COAP_CACHE_SIZE */
 
   PT_BEGIN(&blocking_state->pt);
 
@@ -85,6 +145,32 @@ PT_THREAD(coap_blocking_request
   state->res_block = 0;
   state->block_error = 0;
 
+#if COAP_CACHE_SIZE
+  if(coap_cache_lookup(remote_ep, request) == COAP_CACHE_FRESH
+     && coap_cache_get(remote_ep, request, cached)) {
+    state->status = COAP_REQUEST_STATUS_RESPONSE;
+    request_callback(cached);
+    state->status = COAP_REQUEST_STATUS_FINISHED;
+    PT_EXIT(&blocking_state->pt);
+  }
+#endif /* COAP_CACHE_SIZE */
+
+  /* wait until fewer than NSTART exchanges with the server are outstanding */
+  while(!coap_nstart_available(remote_ep)) {
+    blocking_state->waiter.endpoint = remote_ep;
+    blocking_state->waiter.resume = coap_blocking_request_resume;
+    blocking_state->waiter.data = blocking_state;
+    coap_nstart_wait(&blocking_state->waiter);
+    PT_YIELD_UNTIL(&blocking_state->pt, ev == PROCESS_EVENT_POLL
+                   || ev == PROCESS_EVENT_EXIT);
+    coap_nstart_cancel(&blocking_state->waiter);
+    if(ev == PROCESS_EVENT_EXIT) {
+      /* the process is gone, the waiter must not stay in the list */
+      state->status = COAP_REQUEST_STATUS_TIMEOUT;
+      PT_EXIT(&blocking_state->pt);
+    }
+  }
+
   do {
     request->mid = coap_get_mid();
     if((state->transaction = coap_new_transaction(request->mid, remote_ep))) {
@@ -111,6 +197,13 @@ PT_THREAD(coap_blocking_request
         PT_EXIT(&blocking_state->pt);
       }
 
+#if COAP_CACHE_SIZE
+      if(state->block_num == 0) {
+        state->response = coap_cache_response(remote_ep, request,
+                                              state->response);
+      }
+#endif /* COAP_CACHE_SIZE */
+
       coap_get_header_block2(state->response, &state->res_block, &state->more, NULL, NULL);
 
       LOG_DBG("Received #%"PRIu32"%s (%u bytes)\n", state->res_block, state->more ? "+" : "",
@@ -144,5 +237,6 @@ PT_THREAD(coap_blocking_request
   }
   PT_END(&blocking_state->pt);
 }
+#endif /* COAP_BLOCK_WINDOW > 1 */
 /*---------------------------------------------------------------------------*/
 /** @} */
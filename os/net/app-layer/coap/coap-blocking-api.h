@@ -40,18 +40,28 @@
 #include "sys/pt.h"
 #include "coap-transactions.h"
 #include "coap-request-state.h"
+#if COAP_BLOCK_WINDOW > 1
+#include "coap-callback-api.h"
+#endif /* COAP_BLOCK_WINDOW > 1 */
 
 /*---------------------------------------------------------------------------*/
 /*- Client Part -------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
+typedef void (* coap_blocking_response_handler_t)(coap_message_t *response);
+
 typedef struct coap_blocking_request_state {
+#if COAP_BLOCK_WINDOW > 1
+  /* windowed transfers run on the callback API */
+  coap_callback_request_state_t callback_state;
+  coap_blocking_response_handler_t request_callback;
+#else /* COAP_BLOCK_WINDOW > 1 */
   coap_request_state_t state;
+  coap_nstart_waiter_t waiter;
+#endif /* COAP_BLOCK_WINDOW > 1 */
   struct pt pt;
   struct process *process;
 } coap_blocking_request_state_t;
 
-typedef void (* coap_blocking_response_handler_t)(coap_message_t *response);
-
 PT_THREAD(coap_blocking_request
           (coap_blocking_request_state_t *blocking_state, process_event_t ev,
            coap_endpoint_t *remote,
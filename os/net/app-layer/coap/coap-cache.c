@@ -0,0 +1,325 @@
+/*
+ * Copyright (c) 2026, Contiki-NG contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *      Cache of CoAP responses for the client APIs (RFC 7252, Section 5.6)
+ */
+
+/**
+ * \addtogroup coap
+ * @{
+ */
+
+#include "coap-cache.h"
+#include "coap-timer.h"
+#include "lib/memb.h"
+#include "lib/list.h"
+#include <string.h>
+
+/* Log configuration */
+#include "coap-log.h"
+#define LOG_MODULE "coap"
+#define LOG_LEVEL  LOG_LEVEL_COAP
+
+#if COAP_CACHE_SIZE
+
+#if COAP_CACHE_MAX_URI_LEN > 255
+#error COAP_CACHE_MAX_URI_LEN must not exceed 255
+#endif
+
+/* What a response is cached under, besides the endpoint */
+typedef struct {
+  uint16_t accept;
+  uint8_t has_accept;
+  uint8_t uri_len;
+  char uri[COAP_CACHE_MAX_URI_LEN]; /* Uri-Path?Uri-Query */
+} coap_cache_key_t;
+
+typedef struct coap_cache_entry {
+  struct coap_cache_entry *next;
+  coap_endpoint_t endpoint;
+  coap_cache_key_t key;
+  uint64_t expiration_time;
+  uint16_t content_format;
+  uint8_t has_content_format;
+  uint8_t code;
+  uint8_t etag_len;
+  uint8_t etag[COAP_ETAG_LEN];
+  uint16_t payload_len;
+  uint8_t payload[COAP_CACHE_MAX_PAYLOAD];
+} coap_cache_entry_t;
+
+MEMB(cache_memb, coap_cache_entry_t, COAP_CACHE_SIZE);
+/* Most recently used first */
+LIST(cache_list);
+
+static coap_cache_stats_t stats;
+
+/*---------------------------------------------------------------------------*/
+/*
+ * Returns 0 if the request is not cacheable or its URI does not fit.
+ * Observe registrations always go to the server, their notifications are
+ * not cached either.
+ */
+static int
+make_key(coap_message_t *request, coap_cache_key_t *key)
+{
+  const char *path = NULL;
+  const char *query = NULL;
+  size_t path_len;
+  size_t query_len;
+  unsigned int accept;
+
+  if(request->code != COAP_GET
+     || coap_is_option(request, COAP_OPTION_OBSERVE)) {
+    return 0;
+  }
+
+  path_len = coap_get_header_uri_path(request, &path);
+  query_len = coap_get_header_uri_query(request, &query);
+  if(path_len + (query_len > 0) + query_len > sizeof(key->uri)) {
+    return 0;
+  }
+
+  memset(key, 0, sizeof(*key));
+  if(path_len > 0) {
+    memcpy(key->uri, path, path_len);
+    key->uri_len = path_len;
+  }
+  if(query_len > 0) {
+    key->uri[key->uri_len++] = '?';
+    memcpy(&key->uri[key->uri_len], query, query_len);
+    key->uri_len += query_len;
+  }
+  if(coap_get_header_accept(request, &accept)) {
+    key->accept = accept;
+    key->has_accept = 1;
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+/* Finds the entry for a key and makes it the most recently used one */
+static coap_cache_entry_t *
+find(const coap_endpoint_t *ep, const coap_cache_key_t *key)
+{
+  coap_cache_entry_t *e;
+
+  for(e = list_head(cache_list); e != NULL; e = e->next) {
+    if(e->key.uri_len == key->uri_len
+       && e->key.has_accept == key->has_accept
+       && e->key.accept == key->accept
+       && memcmp(e->key.uri, key->uri, key->uri_len) == 0
+       && coap_endpoint_cmp(&e->endpoint, ep)) {
+      if(e != list_head(cache_list)) {
+        list_remove(cache_list, e);
+        list_push(cache_list, e);
+      }
+      return e;
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static void
+remove_entry(coap_cache_entry_t *e)
+{
+  list_remove(cache_list, e);
+  memb_free(&cache_memb, e);
+}
+/*---------------------------------------------------------------------------*/
+static void
+refresh(coap_cache_entry_t *e, coap_message_t *response)
+{
+  uint32_t max_age;
+
+  coap_get_header_max_age(response, &max_age);
+  e->expiration_time = coap_timer_uptime() + 1000ULL * max_age;
+}
+/*---------------------------------------------------------------------------*/
+static void
+fill_response(coap_cache_entry_t *e, coap_message_t *response)
+{
+  uint64_t now = coap_timer_uptime();
+
+  coap_init_message(response, COAP_TYPE_ACK, e->code, 0);
+  if(e->has_content_format) {
+    coap_set_header_content_format(response, e->content_format);
+  }
+  if(e->etag_len > 0) {
+    coap_set_header_etag(response, e->etag, e->etag_len);
+  }
+  coap_set_header_max_age(response, e->expiration_time > now
+                          ? (e->expiration_time - now) / 1000 : 0);
+  coap_set_payload(response, e->payload, e->payload_len);
+}
+/*---------------------------------------------------------------------------*/
+coap_cache_result_t
+coap_cache_lookup(const coap_endpoint_t *ep, coap_message_t *request)
+{
+  coap_cache_key_t key;
+  coap_cache_entry_t *e;
+
+  if(!make_key(request, &key)) {
+    return COAP_CACHE_MISS;
+  }
+
+  if((e = find(ep, &key)) == NULL) {
+    stats.misses++;
+    return COAP_CACHE_MISS;
+  }
+  if(e->expiration_time > coap_timer_uptime()) {
+    LOG_DBG("Cache hit for %.*s\n", e->key.uri_len, e->key.uri);
+    stats.hits++;
+    return COAP_CACHE_FRESH;
+  }
+
+  stats.misses++;
+  if(e->etag_len == 0) {
+    remove_entry(e);
+    return COAP_CACHE_MISS;
+  }
+  LOG_DBG("Revalidating %.*s\n", e->key.uri_len, e->key.uri);
+  /* an ETag the application set itself is kept */
+  if(!coap_is_option(request, COAP_OPTION_ETAG)) {
+    coap_set_header_etag(request, e->etag, e->etag_len);
+  }
+  return COAP_CACHE_STALE;
+}
+/*---------------------------------------------------------------------------*/
+int
+coap_cache_get(const coap_endpoint_t *ep, coap_message_t *request,
+               coap_message_t *response)
+{
+  coap_cache_key_t key;
+  coap_cache_entry_t *e;
+
+  if(!make_key(request, &key) || (e = find(ep, &key)) == NULL) {
+    return 0;
+  }
+  fill_response(e, response);
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+coap_message_t *
+coap_cache_response(const coap_endpoint_t *ep, coap_message_t *request,
+                    coap_message_t *response)
+{
+  static coap_message_t cached[1];
+  coap_cache_key_t key;
+  coap_cache_entry_t *e;
+  const uint8_t *etag = NULL;
+  uint32_t block_num;
+  uint8_t block_more;
+  uint32_t max_age;
+  unsigned int content_format = 0;
+  int etag_len;
+
+  if(!make_key(request, &key)) {
+    return response;
+  }
+
+  etag_len = coap_get_header_etag(response, &etag);
+  e = find(ep, &key);
+
+  if(response->code == VALID_2_03) {
+    if(e != NULL && (etag_len == 0 || (etag_len == e->etag_len
+                                       && memcmp(etag, e->etag, etag_len) == 0))) {
+      refresh(e, response);
+      stats.revalidations++;
+      fill_response(e, cached);
+      return cached;
+    }
+    return response;
+  }
+
+  if(response->code != CONTENT_2_05) {
+    return response;
+  }
+
+  coap_get_header_max_age(response, &max_age);
+  if((coap_get_header_block2(response, &block_num, &block_more, NULL, NULL)
+      && (block_num > 0 || block_more))
+     || (max_age == 0 && etag_len == 0)
+     || response->payload_len > COAP_CACHE_MAX_PAYLOAD) {
+    /* whatever was cached is outdated now */
+    if(e != NULL) {
+      remove_entry(e);
+    }
+    return response;
+  }
+
+  if(e == NULL) {
+    if((e = memb_alloc(&cache_memb)) == NULL) {
+      e = list_chop(cache_list);
+      stats.evictions++;
+    }
+    coap_endpoint_copy(&e->endpoint, ep);
+    e->key = key;
+    list_push(cache_list, e);
+  }
+
+  refresh(e, response);
+  e->code = response->code;
+  e->has_content_format =
+    coap_get_header_content_format(response, &content_format);
+  e->content_format = content_format;
+  e->etag_len = etag_len;
+  if(etag_len > 0) {
+    memcpy(e->etag, etag, etag_len);
+  }
+  e->payload_len = response->payload_len;
+  if(response->payload_len > 0) {
+    memcpy(e->payload, response->payload, response->payload_len);
+  }
+  return response;
+}
+/*---------------------------------------------------------------------------*/
+void
+coap_cache_flush(void)
+{
+  coap_cache_entry_t *e;
+
+  while((e = list_pop(cache_list)) != NULL) {
+    memb_free(&cache_memb, e);
+  }
+}
+/*---------------------------------------------------------------------------*/
+const coap_cache_stats_t *
+coap_cache_get_stats(void)
+{
+  return &stats;
+}
+/*---------------------------------------------------------------------------*/
+#endif /* COAP_CACHE_SIZE */
+/** @} */
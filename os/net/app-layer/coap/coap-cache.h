@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2026, Contiki-NG contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *      Cache of CoAP responses for the client APIs (RFC 7252, Section 5.6)
+ */
+
+/**
+ * \addtogroup coap
+ * @{
+ */
+
+#ifndef COAP_CACHE_H_
+#define COAP_CACHE_H_
+
+#include "coap.h"
+#include "coap-endpoint.h"
+
+typedef enum {
+  COAP_CACHE_MISS,  /* nothing cached, send the request */
+  COAP_CACHE_FRESH, /* the cached response can be used as is */
+  COAP_CACHE_STALE  /* send the request, it now carries the cached ETag */
+} coap_cache_result_t;
+
+typedef struct coap_cache_stats {
+  uint32_t hits;          /* fresh responses served from the cache */
+  uint32_t misses;        /* lookups that needed a request */
+  uint32_t revalidations; /* stale responses confirmed by 2.03 Valid */
+  uint32_t evictions;     /* entries dropped to make room */
+} coap_cache_stats_t;
+
+/**
+ * \brief Look up the response to a GET request
+ * \param ep The endpoint the request is for
+ * \param request The request
+ * \return COAP_CACHE_FRESH if coap_cache_get() can answer the request,
+ *         COAP_CACHE_STALE if the ETag of the stale response has been
+ *         added to the request, COAP_CACHE_MISS otherwise
+ *
+ * Responses are keyed by endpoint, Uri-Path, Uri-Query and Accept. Requests
+ * with an Observe option are not looked up.
+ */
+coap_cache_result_t coap_cache_lookup(const coap_endpoint_t *ep,
+                                      coap_message_t *request);
+
+/**
+ * \brief Fill in the cached response to a request
+ * \param ep The endpoint the request is for
+ * \param request The request
+ * \param response The message to fill in, its payload points into the cache
+ * \return 1 if a response is cached, fresh or not, 0 otherwise
+ */
+int coap_cache_get(const coap_endpoint_t *ep, coap_message_t *request,
+                   coap_message_t *response);
+
+/**
+ * \brief Let the cache see the response to a request
+ * \param ep The endpoint that sent the response
+ * \param request The request
+ * \param response The response
+ * \return The response to hand to the application: the cached one if the
+ *         response is a 2.03 Valid for it, \p response otherwise
+ *
+ * 2.05 Content responses with a Max-Age, or with an ETag to revalidate
+ * them later, are stored unless they are only the first of several blocks.
+ */
+coap_message_t *coap_cache_response(const coap_endpoint_t *ep,
+                                    coap_message_t *request,
+                                    coap_message_t *response);
+
+/**
+ * \brief Drop all cached responses
+ */
+void coap_cache_flush(void);
+
+/**
+ * \brief Get the cache statistics
+ */
+const coap_cache_stats_t *coap_cache_get_stats(void);
+
+#endif /* COAP_CACHE_H_ */
+/** @} */
@@ -45,6 +45,7 @@
 #include "coap-engine.h"
 #include "coap-callback-api.h"
 #include "coap-transactions.h"
+#include "coap-cache.h"
 #include "sys/cc.h"
 #include <stdlib.h>
 #include <string.h>
@@ -103,6 +104,13 @@ coap_request_callback(void *callback_data, coap_message_t *response)
     return;
   }
 
+#if COAP_CACHE_SIZE
+  if(state->block_num == 0) {
+    state->response = coap_cache_response(state->remote_endpoint,
+                                          state->request, response);
+  }
+#endif /* COAP_CACHE_SIZE */
+
   /* Got a response */
   coap_get_header_block2(state->response, &state->res_block, &state->more, NULL, NULL);
   coap_get_header_block1(state->response, &res_block1, NULL, NULL, NULL);
@@ -142,7 +150,320 @@ coap_request_callback(void *callback_data, coap_message_t *response)
     callback_state->callback(callback_state);
   }
 }
+/*---------------------------------------------------------------------------*/
+/*
+ * Windowed Block2 transfers: after the first block has told the block size,
+ * up to COAP_BLOCK_WINDOW blocks are requested at once, each through its
+ * own transaction and slot. Blocks are delivered to the callback in order;
+ * those arriving early are kept in their slot until it is their turn.
+ */
+static void coap_window_callback(void *callback_data, coap_message_t *response);
+
+static int
+request_block(coap_block_slot_t *slot, uint32_t num)
+{
+  coap_request_state_t *state = slot->state;
+  coap_message_t *request = state->request;
+
+  request->mid = coap_get_mid();
+  if((slot->transaction =
+      coap_new_transaction(request->mid, state->remote_endpoint)) == NULL) {
+    return 0;
+  }
+  slot->num = num;
+  slot->received = 0;
+  slot->transaction->callback = coap_window_callback;
+  slot->transaction->callback_data = slot;
+
+  /* also on the first block, so that the server does not use larger ones */
+  coap_set_header_block2(request, num, 0, state->block_size);
+  slot->transaction->message_len =
+    coap_serialize_message(request, slot->transaction->message);
+
+  coap_send_transaction(slot->transaction);
+  LOG_DBG("Requested #%"PRIu32" (MID %u)\n", num, request->mid);
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static void
+window_stop(coap_request_state_t *state)
+{
+  int i;
+
+  for(i = 0; i < COAP_BLOCK_WINDOW; i++) {
+    coap_clear_transaction(state->slots[i].transaction);
+    state->slots[i].transaction = NULL;
+    state->slots[i].received = 0;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+window_finish(coap_callback_request_state_t *callback_state,
+              coap_request_status_t status)
+{
+  window_stop(&callback_state->state);
+  callback_state->state.status = status;
+  callback_state->state.response = NULL;
+  callback_state->callback(callback_state);
+}
+/*---------------------------------------------------------------------------*/
+static coap_block_slot_t *
+window_free_slot(coap_request_state_t *state)
+{
+  int i;
 
+  for(i = 0; i < COAP_BLOCK_WINDOW; i++) {
+    if(state->slots[i].transaction == NULL && !state->slots[i].received) {
+      return &state->slots[i];
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static int
+window_has(coap_request_state_t *state, uint32_t num)
+{
+  int i;
+
+  for(i = 0; i < COAP_BLOCK_WINDOW; i++) {
+    if((state->slots[i].transaction != NULL || state->slots[i].received)
+       && state->slots[i].num == num) {
+      return 1;
+    }
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Requests the blocks that were lost or could not be sent before, then
+ * the next ones. Returns the number of blocks in flight.
+ */
+static int
+window_fill(coap_request_state_t *state)
+{
+  coap_block_slot_t *slot;
+  uint32_t num;
+  int in_flight = 0;
+  int i;
+
+  for(num = state->block_num;
+      num < state->next_block && num <= state->last_block; num++) {
+    if(!window_has(state, num)) {
+      if((slot = window_free_slot(state)) == NULL || !request_block(slot, num)) {
+        break;
+      }
+    }
+  }
+
+  while(state->next_block <= state->last_block
+        && state->next_block < state->block_num + COAP_BLOCK_WINDOW
+        && (slot = window_free_slot(state)) != NULL
+        && request_block(slot, state->next_block)) {
+    state->next_block++;
+  }
+
+  for(i = 0; i < COAP_BLOCK_WINDOW; i++) {
+    in_flight += state->slots[i].transaction != NULL;
+  }
+  return in_flight;
+}
+/*---------------------------------------------------------------------------*/
+static void
+window_deliver(coap_callback_request_state_t *callback_state,
+               coap_message_t *response)
+{
+  coap_request_state_t *state = &callback_state->state;
+
+  state->response = response;
+  state->res_block = state->block_num;
+  state->more = 0;
+  coap_get_header_block2(response, NULL, &state->more, NULL, NULL);
+  state->status = state->more ? COAP_REQUEST_STATUS_MORE
+    : COAP_REQUEST_STATUS_RESPONSE;
+  callback_state->callback(callback_state);
+  ++(state->block_num);
+}
+/*---------------------------------------------------------------------------*/
+/* Delivers the buffered blocks that are next in order */
+static void
+window_deliver_buffered(coap_callback_request_state_t *callback_state)
+{
+  coap_request_state_t *state = &callback_state->state;
+  static coap_message_t message[1];
+  int i;
+
+  for(i = 0; i < COAP_BLOCK_WINDOW; i++) {
+    coap_block_slot_t *slot = &state->slots[i];
+    if(slot->received && slot->num == state->block_num) {
+      /* only code, Block2 and payload of the original response remain */
+      coap_init_message(message, COAP_TYPE_ACK, slot->code, 0);
+      coap_set_header_block2(message, slot->num, slot->more, state->block_size);
+      coap_set_payload(message, slot->payload, slot->len);
+      slot->received = 0;
+      window_deliver(callback_state, message);
+      /* the next block may be in any slot */
+      i = -1;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+coap_window_callback(void *callback_data, coap_message_t *response)
+{
+  coap_block_slot_t *slot = callback_data;
+  coap_request_state_t *state = slot->state;
+  coap_callback_request_state_t *callback_state =
+    (coap_callback_request_state_t *)state;
+  uint32_t res_block = 0;
+  uint8_t more = 0;
+  uint16_t size = state->block_size;
+
+  slot->transaction = NULL;
+
+#if COAP_CACHE_SIZE
+  if(response != NULL && slot->num == 0) {
+    response = coap_cache_response(state->remote_endpoint, state->request,
+                                   response);
+  }
+#endif /* COAP_CACHE_SIZE */
+
+  if(slot->num > state->last_block) {
+    /* requested beyond the end of the body */
+  } else if(response == NULL) {
+    LOG_WARN("Block #%"PRIu32" timed out\n", slot->num);
+    if(++(state->block_error) >= COAP_MAX_ATTEMPTS) {
+      window_finish(callback_state, COAP_REQUEST_STATUS_TIMEOUT);
+      return;
+    }
+  } else if(slot->num > 0 && response->code == BAD_OPTION_4_02
+            && !coap_is_option(response, COAP_OPTION_BLOCK2)) {
+    /* the body ends before this block */
+    state->last_block = slot->num - 1;
+  } else {
+    coap_get_header_block2(response, &res_block, &more, &size, NULL);
+    if(res_block != slot->num) {
+      LOG_WARN("WRONG BLOCK %"PRIu32"/%"PRIu32"\n", res_block, slot->num);
+      if(++(state->block_error) >= COAP_MAX_ATTEMPTS) {
+        window_finish(callback_state, COAP_REQUEST_STATUS_BLOCK_ERROR);
+        return;
+      }
+    } else {
+      if(slot->num == 0) {
+        state->block_size = size;
+      }
+      if(!more) {
+        state->last_block = slot->num;
+      }
+      if(slot->num == state->block_num) {
+        window_deliver(callback_state, response);
+        window_deliver_buffered(callback_state);
+      } else {
+        slot->received = 1;
+        slot->code = response->code;
+        slot->more = more;
+        slot->len = MIN(response->payload_len, sizeof(slot->payload));
+        memcpy(slot->payload, response->payload, slot->len);
+      }
+    }
+  }
+
+  if(state->block_num > state->last_block) {
+    window_finish(callback_state, COAP_REQUEST_STATUS_FINISHED);
+  } else if(!window_fill(state)) {
+    LOG_WARN("Could not allocate transaction buffer\n");
+    window_finish(callback_state, COAP_REQUEST_STATUS_BLOCK_ERROR);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static int
+window_start(coap_callback_request_state_t *callback_state)
+{
+  coap_request_state_t *state = &callback_state->state;
+  int i;
+
+  for(i = 0; i < COAP_BLOCK_WINDOW; i++) {
+    state->slots[i].state = state;
+    state->slots[i].transaction = NULL;
+    state->slots[i].received = 0;
+  }
+  state->next_block = 1;
+  state->last_block = UINT32_MAX;
+  state->block_size = COAP_MAX_BLOCK_SIZE;
+
+  /* the block size is only known after the first block */
+  return request_block(&state->slots[0], 0);
+}
+/*---------------------------------------------------------------------------*/
+static int
+start_request(coap_callback_request_state_t *callback_state)
+{
+  /* both variants are always compiled, the unused one is optimized out */
+  if(COAP_BLOCK_WINDOW > 1) {
+    return window_start(callback_state);
+  }
+  return progress_request(callback_state);
+}
+/*---------------------------------------------------------------------------*/
+
+static void
+coap_request_resume(void *data)
+{
+  coap_callback_request_state_t *callback_state = data;
+
+  if(!start_request(callback_state)) {
+    LOG_WARN("Could not allocate transaction buffer\n");
+    callback_state->state.status = COAP_REQUEST_STATUS_TIMEOUT;
+    callback_state->callback(callback_state);
+  }
+}
+
+/*---------------------------------------------------------------------------*/
+
+static int
+coap_request_send(coap_callback_request_state_t *callback_state)
+{
+  coap_endpoint_t *endpoint = callback_state->state.remote_endpoint;
+
+  if(!coap_nstart_available(endpoint)) {
+    /* sent from coap_request_resume() when an exchange completes */
+    callback_state->waiter.endpoint = endpoint;
+    callback_state->waiter.resume = coap_request_resume;
+    callback_state->waiter.data = callback_state;
+    coap_nstart_wait(&callback_state->waiter);
+    return 1;
+  }
+
+  return start_request(callback_state);
+}
+
+/*---------------------------------------------------------------------------*/
+#if COAP_CACHE_SIZE
+static void
+coap_request_cached(coap_timer_t *timer)
+{
+  coap_callback_request_state_t *callback_state = coap_timer_get_user_data(timer);
+  coap_request_state_t *state = &callback_state->state;
+  static coap_message_t response[1];
+
+  if(!coap_cache_get(state->remote_endpoint, state->request, response)) {
+    /* evicted since the lookup */
+    if(!coap_request_send(callback_state)) {
+      LOG_WARN("Could not allocate transaction buffer\n");
+      state->status = COAP_REQUEST_STATUS_TIMEOUT;
+      callback_state->callback(callback_state);
+    }
+    return;
+  }
+
+  state->response = response;
+  state->status = COAP_REQUEST_STATUS_RESPONSE;
+  callback_state->callback(callback_state);
+
+  state->status = COAP_REQUEST_STATUS_FINISHED;
+  state->response = NULL;
+  callback_state->callback(callback_state);
+}
+#endif /* COAP_CACHE_SIZE */
 /*---------------------------------------------------------------------------*/
 
 int
@@ -161,7 +482,17 @@ coap_send_request(coap_callback_request_state_t *callback_state, coap_endpoint_t
   state->remote_endpoint = endpoint;
   callback_state->callback = callback;
 
-  return progress_request(callback_state);
+#if COAP_CACHE_SIZE
+  if(coap_cache_lookup(endpoint, request) == COAP_CACHE_FRESH) {
+    /* answered once the caller has returned, as if it had been sent */
+    coap_timer_set_callback(&callback_state->cache_timer, coap_request_cached);
+    coap_timer_set_user_data(&callback_state->cache_timer, callback_state);
+    coap_timer_set(&callback_state->cache_timer, 0);
+    return 1;
+  }
+#endif /* COAP_CACHE_SIZE */
+
+  return coap_request_send(callback_state);
 }
 /*---------------------------------------------------------------------------*/
 /** @} */
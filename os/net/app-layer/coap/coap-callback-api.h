@@ -48,6 +48,7 @@
 #include "coap-engine.h"
 #include "coap-transactions.h"
 #include "coap-request-state.h"
+#include "coap-cache.h"
 #include "sys/cc.h"
 
 /*---------------------------------------------------------------------------*/
@@ -58,6 +59,10 @@ typedef struct coap_callback_request_state coap_callback_request_state_t;
 struct coap_callback_request_state {
   coap_request_state_t state;
   void (*callback)(coap_callback_request_state_t *state);
+  coap_nstart_waiter_t waiter;
+#if COAP_CACHE_SIZE
+  coap_timer_t cache_timer;
+#endif /* COAP_CACHE_SIZE */
 };
 
 /**
@@ -67,6 +72,11 @@ struct coap_callback_request_state {
  * \param request The request to be sent
  * \param callback callback to execute when the response arrives or the timeout expires
  * \return 1 if there is a transaction available to send, 0 otherwise
+ *
+ * If COAP_NSTART exchanges with the endpoint are already outstanding, the
+ * request is sent once one of them completes and 1 is returned. A GET
+ * request with a fresh response in the cache is not sent at all, the
+ * callback then gets the cached response.
  */
 int coap_send_request(coap_callback_request_state_t *callback_state, coap_endpoint_t *endpoint,
                        coap_message_t *request,
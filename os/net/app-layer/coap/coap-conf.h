@@ -78,11 +78,98 @@
 #define COAP_SERVER_PORT               COAP_DEFAULT_PORT
 #endif /* COAP_SERVER_PORT */
 
+/* CoAP over TCP (RFC 8323) for coap+tcp:// endpoints, needs UIP_CONF_TCP.
+ * Each connection takes an input buffer of COAP_TCP_MAX_MESSAGE_SIZE and
+ * an output buffer of COAP_TCP_OUTPUT_SIZE bytes; idle connections accept
+ * incoming ones on COAP_DEFAULT_PORT. */
+#ifndef COAP_TCP
+#define COAP_TCP                       0
+#endif /* COAP_TCP */
+
+#ifndef COAP_TCP_CONNECTIONS
+#define COAP_TCP_CONNECTIONS           2
+#endif /* COAP_TCP_CONNECTIONS */
+
+/* Largest message received over TCP, announced to peers in the CSM */
+#ifndef COAP_TCP_MAX_MESSAGE_SIZE
+#define COAP_TCP_MAX_MESSAGE_SIZE      COAP_MAX_PACKET_SIZE
+#endif /* COAP_TCP_MAX_MESSAGE_SIZE */
+
+#ifndef COAP_TCP_OUTPUT_SIZE
+#define COAP_TCP_OUTPUT_SIZE           (2 * COAP_MAX_PACKET_SIZE)
+#endif /* COAP_TCP_OUTPUT_SIZE */
+
 /* The number of concurrent messages that can be stored for retransmission in the transaction layer. */
 #ifndef COAP_MAX_OPEN_TRANSACTIONS
 #define COAP_MAX_OPEN_TRANSACTIONS     4
 #endif /* COAP_MAX_OPEN_TRANSACTIONS */
 
+/* Number of buckets of the transaction and observer indices, must be a
+ * power of two. Transactions are indexed by MID, observers by token and by
+ * the MID of their last notification. */
+#ifndef COAP_TRANSACTION_TABLE_SIZE
+#define COAP_TRANSACTION_TABLE_SIZE    8
+#endif /* COAP_TRANSACTION_TABLE_SIZE */
+
+/* Number of responses to confirmable requests kept for duplicate detection
+ * (RFC 7252, Section 4.5). A retransmitted request is answered with the
+ * cached response without calling the resource handler again. Each entry
+ * takes about COAP_MAX_PACKET_SIZE bytes, 0 disables the cache. */
+#ifndef COAP_DEDUP_CACHE_SIZE
+#define COAP_DEDUP_CACHE_SIZE          0
+#endif /* COAP_DEDUP_CACHE_SIZE */
+
+/* Seconds a cached response is kept, EXCHANGE_LIFETIME by default */
+#ifndef COAP_DEDUP_LIFETIME
+#define COAP_DEDUP_LIFETIME            247
+#endif /* COAP_DEDUP_LIFETIME */
+
+/* Number of responses to GET requests the blocking and callback APIs keep
+ * (RFC 7252, Section 5.6), least recently used first to go. Requests are
+ * answered from the cache while Max-Age has not expired, after that with
+ * an ETag for the server to validate. 0 disables the cache. */
+#ifndef COAP_CACHE_SIZE
+#define COAP_CACHE_SIZE                0
+#endif /* COAP_CACHE_SIZE */
+
+/* Largest cached payload, larger responses are not cached */
+#ifndef COAP_CACHE_MAX_PAYLOAD
+#define COAP_CACHE_MAX_PAYLOAD         COAP_MAX_CHUNK_SIZE
+#endif /* COAP_CACHE_MAX_PAYLOAD */
+
+/* Longest Uri-Path and Uri-Query, joined by '?', a cache entry is kept for */
+#ifndef COAP_CACHE_MAX_URI_LEN
+#define COAP_CACHE_MAX_URI_LEN         48
+#endif /* COAP_CACHE_MAX_URI_LEN */
+
+/* Number of confirmable exchanges a client keeps outstanding to the same
+ * endpoint (NSTART, RFC 7252, Section 4.7). Requests sent through the
+ * blocking and callback APIs wait until the window has room. */
+#ifndef COAP_NSTART
+#define COAP_NSTART                    1
+#endif /* COAP_NSTART */
+
+/* Number of Block2 requests the blocking and callback APIs keep in flight
+ * for one blockwise transfer, sequential transfers by default. A window
+ * larger than 1 should not exceed COAP_NSTART. Blocks arriving out of order
+ * are buffered until they can be delivered, which takes COAP_MAX_CHUNK_SIZE
+ * bytes per block in each request state. */
+#ifndef COAP_BLOCK_WINDOW
+#define COAP_BLOCK_WINDOW              1
+#endif /* COAP_BLOCK_WINDOW */
+
+/* CoCoA congestion control (draft-ietf-core-cocoa): retransmission timeouts
+ * follow weak and strong RTT estimates kept per endpoint instead of the
+ * fixed COAP_RESPONSE_TIMEOUT, with a variable backoff factor. */
+#ifndef COAP_COCOA
+#define COAP_COCOA                     0
+#endif /* COAP_COCOA */
+
+/* Number of endpoints CoCoA keeps RTT estimates for */
+#ifndef COAP_COCOA_ENDPOINTS
+#define COAP_COCOA_ENDPOINTS           2
+#endif /* COAP_COCOA_ENDPOINTS */
+
 /* Maximum number of failed request attempts before action */
 #ifndef COAP_MAX_ATTEMPTS
 #define COAP_MAX_ATTEMPTS              4
@@ -93,6 +180,26 @@
 #define COAP_MAX_HEADER_SIZE           (4 + COAP_TOKEN_LEN + 3 + 1 + COAP_ETAG_LEN + 4 + 4 + 30)  /* 65 */
 #endif /* COAP_MAX_HEADER_SIZE */
 
+/* Number of resources the dispatch table is sized for. More can be
+ * activated, but requests to them then go through longer bucket chains. */
+#ifndef COAP_EXPECTED_RESOURCES
+#define COAP_EXPECTED_RESOURCES        16
+#endif /* COAP_EXPECTED_RESOURCES */
+
+/* Number of buckets of the resource dispatch table, must be a power of two.
+ * Defaults to the smallest one that holds COAP_EXPECTED_RESOURCES with at
+ * most one resource per bucket on average. */
+#ifndef COAP_RESOURCE_TABLE_SIZE
+#define COAP_RESOURCE_TABLE_SIZE                                         \
+  ((COAP_EXPECTED_RESOURCES) <= 8 ? 8 :                                  \
+   (COAP_EXPECTED_RESOURCES) <= 16 ? 16 :                                \
+   (COAP_EXPECTED_RESOURCES) <= 32 ? 32 :                                \
+   (COAP_EXPECTED_RESOURCES) <= 64 ? 64 :                                \
+   (COAP_EXPECTED_RESOURCES) <= 128 ? 128 :                              \
+   (COAP_EXPECTED_RESOURCES) <= 256 ? 256 :                              \
+   (COAP_EXPECTED_RESOURCES) <= 512 ? 512 : 1024)
+#endif /* COAP_RESOURCE_TABLE_SIZE */
+
 /* Number of observer slots (each takes abot xxx bytes) */
 #ifndef COAP_MAX_OBSERVERS
 #define COAP_MAX_OBSERVERS    COAP_MAX_OPEN_TRANSACTIONS - 1
@@ -103,5 +210,13 @@
 #define COAP_OBSERVE_REFRESH_INTERVAL  20
 #endif /* COAP_OBSERVE_REFRESH_INTERVAL */
 
+/* Build a notification once for all observers of a resource: the handler
+ * runs once and only the token, MID and Observe option are patched per
+ * observer. NON notifications are sent from a shared buffer instead of
+ * taking a transaction each. */
+#ifndef COAP_OBSERVE_FANOUT
+#define COAP_OBSERVE_FANOUT            1
+#endif /* COAP_OBSERVE_FANOUT */
+
 #endif /* COAP_CONF_H_ */
 /** @} */
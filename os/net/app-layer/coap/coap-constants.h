@@ -79,7 +79,10 @@ typedef enum {
   COAP_GET = 1,
   COAP_POST,
   COAP_PUT,
-  COAP_DELETE
+  COAP_DELETE,
+  COAP_FETCH,                   /* RFC 8132 */
+  COAP_PATCH,
+  COAP_IPATCH
 } coap_method_t;
 
 /* CoAP response codes */
@@ -120,6 +123,18 @@ typedef enum {
   PING_RESPONSE
 } coap_status_t;
 
+/* CoAP signaling codes of reliable transports (RFC 8323, Section 5) */
+typedef enum {
+  COAP_SIGNAL_CSM = 225,        /* 7.01 Capabilities and Settings */
+  COAP_SIGNAL_PING = 226,       /* 7.02 */
+  COAP_SIGNAL_PONG = 227,       /* 7.03 */
+  COAP_SIGNAL_RELEASE = 228,    /* 7.04 */
+  COAP_SIGNAL_ABORT = 229       /* 7.05 */
+} coap_signal_code_t;
+
+#define COAP_SIGNAL_OPTION_MAX_MESSAGE_SIZE  2  /* CSM option */
+#define COAP_TCP_DEFAULT_MAX_MESSAGE_SIZE    1152
+
 /* CoAP header option numbers */
 typedef enum {
   COAP_OPTION_IF_MATCH = 1,     /* 0-8 B */
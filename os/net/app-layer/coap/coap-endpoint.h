@@ -53,6 +53,7 @@ typedef struct {
   uip_ipaddr_t ipaddr;
   uint16_t port;
   uint8_t secure;
+  uint8_t tcp;
 } coap_endpoint_t;
 #endif /* COAP_ENDPOINT_CUSTOM */
 
@@ -120,6 +121,18 @@ int coap_endpoint_parse(const char *text, size_t size, coap_endpoint_t *ep);
  */
 int coap_endpoint_is_secure(const coap_endpoint_t *ep);
 
+/**
+ * \brief      Check if a CoAP endpoint is reached over a reliable transport,
+ *             such as CoAP over TCP (RFC 8323).
+ *
+ *             Messages to reliable endpoints are neither acknowledged nor
+ *             retransmitted.
+ *
+ * \param ep   A pointer to a CoAP endpoint.
+ * \return     Returns non-zero if the transport is reliable and zero otherwise.
+ */
+int coap_endpoint_is_reliable(const coap_endpoint_t *ep);
+
 /**
  * \brief      Check if a CoAP endpoint is connected.
  *
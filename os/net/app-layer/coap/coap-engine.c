@@ -72,6 +72,15 @@ LIST(coap_handlers);
 LIST(coap_resource_services);
 static uint8_t is_initialized = 0;
 
+#if (COAP_RESOURCE_TABLE_SIZE & (COAP_RESOURCE_TABLE_SIZE - 1)) != 0
+#error "COAP_RESOURCE_TABLE_SIZE must be a power of two"
+#endif
+
+/* Activated resources, hashed by URI path. Used for dispatching requests,
+ * while the list above keeps the activation order for discovery. */
+static coap_resource_t *resource_table[COAP_RESOURCE_TABLE_SIZE];
+static uint16_t num_table_resources;
+
 /*---------------------------------------------------------------------------*/
 /*- CoAP service handlers---------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
@@ -155,19 +164,29 @@ coap_receive(const coap_endpoint_t *src,
 
   if(coap_status_code == NO_ERROR) {
 
-    /*TODO duplicates suppression, if required by application */
+    /* answer retransmitted requests from the duplicate detection cache */
+    if(message->type == COAP_TYPE_CON
+       && message->code >= COAP_GET && message->code <= COAP_IPATCH
+       && coap_dedup_resend(src, message->mid)) {
+      return coap_status_code;
+    }
 
     LOG_DBG("  Parsed: v %u, t %u, tkl %u, c %u, mid %u\n", message->version,
             message->type, message->token_len, message->code, message->mid);
-    LOG_DBG("  URL:");
-    LOG_DBG_COAP_STRING(message->uri_path, message->uri_path_len);
-    LOG_DBG_("\n");
+    if(LOG_DBG_ENABLED) {
+      const char *url;
+      int url_len = coap_get_header_uri_path(message, &url);
+
+      LOG_DBG("  URL:");
+      LOG_DBG_COAP_STRING(url, url_len);
+      LOG_DBG_("\n");
+    }
     LOG_DBG("  Payload: ");
     LOG_DBG_COAP_STRING((const char *)message->payload, message->payload_len);
     LOG_DBG_("\n");
 
     /* handle requests */
-    if(message->code >= COAP_GET && message->code <= COAP_DELETE) {
+    if(message->code >= COAP_GET && message->code <= COAP_IPATCH) {
 
       /* use transaction buffer for response to confirmable request */
       if((transaction = coap_new_transaction(message->mid, src))) {
@@ -307,11 +326,12 @@ coap_receive(const coap_endpoint_t *src,
         coap_remove_observer_by_mid(src, message->mid);
       }
 
-      if((transaction = coap_get_transaction_by_mid(message->mid))) {
+      if((transaction = coap_get_transaction(src, message->mid))) {
         /* free transaction memory before callback, as it may create a new transaction */
         coap_resource_response_handler_t callback = transaction->callback;
         void *callback_data = transaction->callback_data;
 
+        coap_transaction_answered(transaction);
         coap_clear_transaction(transaction);
 
         /* check if someone registered for the response */
@@ -326,7 +346,6 @@ coap_receive(const coap_endpoint_t *src,
       /* if observe notification */
       if((message->type == COAP_TYPE_CON || message->type == COAP_TYPE_NON)
          && coap_is_option(message, COAP_OPTION_OBSERVE)) {
-        LOG_DBG("Observe [%"PRId32"]\n", message->observe);
         coap_handle_notification(src, message);
       }
 #endif /* COAP_OBSERVE_CLIENT */
@@ -336,6 +355,11 @@ coap_receive(const coap_endpoint_t *src,
     /* if(parsed correctly) */
   if(coap_status_code == NO_ERROR) {
     if(transaction) {
+      if(message->type == COAP_TYPE_CON
+         && message->code >= COAP_GET && message->code <= COAP_IPATCH) {
+        coap_dedup_store(src, message->mid, transaction->message,
+                         transaction->message_len);
+      }
       coap_send_transaction(transaction);
     }
   } else if(coap_status_code == MANUAL_RESPONSE) {
@@ -343,6 +367,8 @@ coap_receive(const coap_endpoint_t *src,
     coap_clear_transaction(transaction);
   } else {
     coap_message_type_t reply_type = COAP_TYPE_ACK;
+    uint8_t token[COAP_TOKEN_LEN];
+    uint8_t token_len;
 
     LOG_WARN("ERROR %u: %s\n", coap_status_code, coap_error_message);
     coap_clear_transaction(transaction);
@@ -355,8 +381,13 @@ coap_receive(const coap_endpoint_t *src,
       coap_status_code = INTERNAL_SERVER_ERROR_5_00;
       /* reuse input buffer for error message */
     }
+    token_len = message->version == 1 && message->token_len <= COAP_TOKEN_LEN
+      ? message->token_len : 0;
+    memcpy(token, message->token, token_len);
     coap_init_message(message, reply_type, coap_status_code,
                       message->mid);
+    /* reliable transports match responses by token only */
+    coap_set_token(message, token, token_len);
     coap_set_payload(message, coap_error_message,
                      strlen(coap_error_message));
     coap_sendto(src, payload, coap_serialize_message(message, payload));
@@ -379,6 +410,8 @@ coap_engine_init(void)
 
   list_init(coap_handlers);
   list_init(coap_resource_services);
+  memset(resource_table, 0, sizeof(resource_table));
+  num_table_resources = 0;
 
   coap_activate_resource(&res_well_known_core, ".well-known/core");
 
@@ -386,6 +419,109 @@ coap_engine_init(void)
   coap_init_connection();
 }
 /*---------------------------------------------------------------------------*/
+static CC_INLINE uint32_t
+path_hash_update(uint32_t hash, char c)
+{
+  return (hash * 33) ^ (uint8_t)c;
+}
+/*---------------------------------------------------------------------------*/
+static uint32_t
+path_hash(const char *path)
+{
+  uint32_t hash = 5381;
+  while(*path != '\0') {
+    hash = path_hash_update(hash, *path++);
+  }
+  return hash;
+}
+/*---------------------------------------------------------------------------*/
+static coap_resource_t **
+table_bucket(uint32_t hash)
+{
+  return &resource_table[hash & (COAP_RESOURCE_TABLE_SIZE - 1)];
+}
+/*---------------------------------------------------------------------------*/
+static void
+table_remove(coap_resource_t *resource)
+{
+  coap_resource_t **r;
+
+  if(resource->url == NULL) {
+    return;
+  }
+  for(r = table_bucket(resource->url_hash); *r != NULL;
+      r = &(*r)->table_next) {
+    if(*r == resource) {
+      *r = resource->table_next;
+      num_table_resources--;
+      break;
+    }
+  }
+  resource->table_next = NULL;
+}
+/*---------------------------------------------------------------------------*/
+static void
+table_add(coap_resource_t *resource)
+{
+  coap_resource_t **r;
+
+  resource->url_hash = path_hash(resource->url);
+
+  /* Append, so that the first activated resource wins for a given path */
+  for(r = table_bucket(resource->url_hash); *r != NULL;
+      r = &(*r)->table_next);
+  *r = resource;
+  resource->table_next = NULL;
+
+  if(++num_table_resources == COAP_RESOURCE_TABLE_SIZE + 1) {
+    LOG_WARN("More resources than dispatch table buckets, "
+             "consider raising COAP_EXPECTED_RESOURCES\n");
+  }
+}
+/*---------------------------------------------------------------------------*/
+static coap_resource_t *
+table_find(uint32_t hash, const char *path, int len, int parents_only)
+{
+  coap_resource_t *r;
+
+  for(r = *table_bucket(hash); r != NULL; r = r->table_next) {
+    if(r->url_hash == hash
+       && (!parents_only || (r->flags & HAS_SUB_RESOURCES))
+       && strncmp(r->url, path, len) == 0 && r->url[len] == '\0') {
+      return r;
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Finds the resource for a URI path: the resource registered with that exact
+ * path, or else the one with the longest path prefix ending at a segment
+ * boundary and having HAS_SUB_RESOURCES set. The hashes of all prefixes are
+ * computed in a single pass, so the cost depends on the number of path
+ * segments and not on the number of resources.
+ */
+static coap_resource_t *
+find_resource(const char *url, int url_len)
+{
+  coap_resource_t *parent = NULL;
+  coap_resource_t *r;
+  uint32_t hash = 5381;
+  int i;
+
+  for(i = 0; i < url_len; i++) {
+    if(url[i] == '/') {
+      r = table_find(hash, url, i, 1);
+      if(r != NULL) {
+        parent = r;
+      }
+    }
+    hash = path_hash_update(hash, url[i]);
+  }
+  r = table_find(hash, url, url_len, 0);
+  return r != NULL ? r : parent;
+}
+/*---------------------------------------------------------------------------*/
 /**
  * \brief Makes a resource available under the given URI path
  * \param resource A pointer to a resource implementation
@@ -399,8 +535,10 @@ void
 coap_activate_resource(coap_resource_t *resource, const char *path)
 {
   coap_periodic_resource_t *periodic;
+  table_remove(resource);
   resource->url = path;
   list_add(coap_resource_services, resource);
+  table_add(resource);
 
   LOG_INFO("Activating: %s\n", resource->url);
 
@@ -442,44 +580,34 @@ invoke_coap_resource_service(coap_message_t *request, coap_message_t *response,
 
   coap_resource_t *resource = NULL;
   const char *url = NULL;
-  int url_len, res_url_len;
+  int url_len;
 
   url_len = coap_get_header_uri_path(request, &url);
-  for(resource = list_head(coap_resource_services);
-      resource; resource = resource->next) {
-
-    /* if the web service handles that kind of requests and urls matches */
-    res_url_len = strlen(resource->url);
-    if((url_len == res_url_len
-        || (url_len > res_url_len
-            && (resource->flags & HAS_SUB_RESOURCES)
-            && url[res_url_len] == '/'))
-       && strncmp(resource->url, url, res_url_len) == 0) {
-      coap_resource_flags_t method = coap_get_method_type(request);
-      found = 1;
-
-      LOG_INFO("/%s, method %u, resource->flags %u\n", resource->url,
-               (uint16_t)method, resource->flags);
-
-      if((method & METHOD_GET) && resource->get_handler != NULL) {
-        /* call handler function */
-        resource->get_handler(request, response, buffer, buffer_size, offset);
-      } else if((method & METHOD_POST) && resource->post_handler != NULL) {
-        /* call handler function */
-        resource->post_handler(request, response, buffer, buffer_size,
+  resource = find_resource(url != NULL ? url : "", url_len);
+  if(resource != NULL) {
+    coap_resource_flags_t method = coap_get_method_type(request);
+    found = 1;
+
+    LOG_INFO("/%s, method %u, resource->flags %u\n", resource->url,
+             (uint16_t)method, resource->flags);
+
+    if((method & METHOD_GET) && resource->get_handler != NULL) {
+      /* call handler function */
+      resource->get_handler(request, response, buffer, buffer_size, offset);
+    } else if((method & METHOD_POST) && resource->post_handler != NULL) {
+      /* call handler function */
+      resource->post_handler(request, response, buffer, buffer_size,
+                             offset);
+    } else if((method & METHOD_PUT) && resource->put_handler != NULL) {
+      /* call handler function */
+      resource->put_handler(request, response, buffer, buffer_size, offset);
+    } else if((method & METHOD_DELETE) && resource->delete_handler != NULL) {
+      /* call handler function */
+      resource->delete_handler(request, response, buffer, buffer_size,
                                offset);
-      } else if((method & METHOD_PUT) && resource->put_handler != NULL) {
-        /* call handler function */
-        resource->put_handler(request, response, buffer, buffer_size, offset);
-      } else if((method & METHOD_DELETE) && resource->delete_handler != NULL) {
-        /* call handler function */
-        resource->delete_handler(request, response, buffer, buffer_size,
-                                 offset);
-      } else {
-        allowed = 0;
-        coap_set_status_code(response, METHOD_NOT_ALLOWED_4_05);
-      }
-      break;
+    } else {
+      allowed = 0;
+      coap_set_status_code(response, METHOD_NOT_ALLOWED_4_05);
     }
   }
   if(!found) {
@@ -111,6 +111,8 @@ struct coap_resource_s {
     coap_resource_trigger_handler_t trigger;
     coap_resource_trigger_handler_t resume;
   };
+  coap_resource_t *table_next;      /* next resource in the same dispatch table bucket */
+  uint32_t url_hash;                /* hash of url, set upon activation */
 };
 
 struct coap_periodic_resource_s {
@@ -45,6 +45,7 @@
 #include <string.h>
 #include "coap-observe.h"
 #include "coap-engine.h"
+#include "coap-transport.h"
 #include "lib/memb.h"
 #include "lib/list.h"
 
@@ -56,6 +57,57 @@
 /*---------------------------------------------------------------------------*/
 MEMB(observers_memb, coap_observer_t, COAP_MAX_OBSERVERS);
 LIST(observers_list);
+
+/* Observers hashed by token and by the MID of their last notification */
+static coap_observer_t *token_table[COAP_TRANSACTION_TABLE_SIZE];
+static coap_observer_t *mid_table[COAP_TRANSACTION_TABLE_SIZE];
+
+#if COAP_OBSERVE_FANOUT
+/* Notification serialized once for all observers, without token */
+static uint8_t notification_template[COAP_MAX_PACKET_SIZE + 1];
+/* Per-observer NON notifications are built here right before sending */
+static uint8_t notification_buffer[COAP_MAX_PACKET_SIZE + 1];
+#endif /* COAP_OBSERVE_FANOUT */
+/*---------------------------------------------------------------------------*/
+static coap_observer_t **
+token_bucket(const uint8_t *token, size_t token_len)
+{
+  unsigned hash = 0;
+
+  while(token_len-- > 0) {
+    hash = hash * 31 + *token++;
+  }
+  return &token_table[hash & (COAP_TRANSACTION_TABLE_SIZE - 1)];
+}
+/*---------------------------------------------------------------------------*/
+static coap_observer_t **
+mid_bucket(uint16_t mid)
+{
+  return &mid_table[mid & (COAP_TRANSACTION_TABLE_SIZE - 1)];
+}
+/*---------------------------------------------------------------------------*/
+static void
+mid_index_remove(coap_observer_t *o)
+{
+  coap_observer_t **p;
+
+  for(p = mid_bucket(o->last_mid); *p != NULL; p = &(*p)->mid_next) {
+    if(*p == o) {
+      *p = o->mid_next;
+      return;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Records the MID of the latest notification, used to match RSTs */
+static void
+set_last_mid(coap_observer_t *o, uint16_t mid)
+{
+  mid_index_remove(o);
+  o->last_mid = mid;
+  o->mid_next = *mid_bucket(mid);
+  *mid_bucket(mid) = o;
+}
 /*---------------------------------------------------------------------------*/
 /*- Internal API ------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
@@ -79,6 +131,10 @@ add_observer(const coap_endpoint_t *endpoint, const uint8_t *token,
     o->token_len = token_len;
     memcpy(o->token, token, token_len);
     o->last_mid = 0;
+    o->mid_next = *mid_bucket(0);
+    *mid_bucket(0) = o;
+    o->token_next = *token_bucket(token, token_len);
+    *token_bucket(token, token_len) = o;
 
     LOG_INFO("Adding observer (%u/%u) for /%s [0x%02X%02X]\n",
              list_length(observers_list) + 1, COAP_MAX_OBSERVERS,
@@ -97,6 +153,17 @@ coap_remove_observer(coap_observer_t *o)
   LOG_INFO("Removing observer for /%s [0x%02X%02X]\n", o->url, o->token[0],
            o->token[1]);
 
+  coap_observer_t **p;
+
+  for(p = token_bucket(o->token, o->token_len); *p != NULL;
+      p = &(*p)->token_next) {
+    if(*p == o) {
+      *p = o->token_next;
+      break;
+    }
+  }
+  mid_index_remove(o);
+
   memb_free(&observers_memb, o);
   list_remove(observers_list, o);
 }
@@ -125,11 +192,12 @@ coap_remove_observer_by_token(const coap_endpoint_t *endpoint,
                               uint8_t *token, size_t token_len)
 {
   int removed = 0;
-  coap_observer_t *obs = NULL;
+  coap_observer_t *obs;
+  coap_observer_t *next;
 
-  for(obs = (coap_observer_t *)list_head(observers_list); obs;
-      obs = obs->next) {
-    LOG_DBG("Remove check Token 0x%02X%02X\n", token[0], token[1]);
+  LOG_DBG("Remove check Token 0x%02X%02X\n", token[0], token[1]);
+  for(obs = *token_bucket(token, token_len); obs; obs = next) {
+    next = obs->token_next;
     if(coap_endpoint_cmp(&obs->endpoint, endpoint)
        && obs->token_len == token_len
        && memcmp(obs->token, token, token_len) == 0) {
@@ -164,11 +232,12 @@ int
 coap_remove_observer_by_mid(const coap_endpoint_t *endpoint, uint16_t mid)
 {
   int removed = 0;
-  coap_observer_t *obs = NULL;
+  coap_observer_t *obs;
+  coap_observer_t *next;
 
-  for(obs = (coap_observer_t *)list_head(observers_list); obs;
-      obs = obs->next) {
-    LOG_DBG("Remove check MID %u\n", mid);
+  LOG_DBG("Remove check MID %u\n", mid);
+  for(obs = *mid_bucket(mid); obs; obs = next) {
+    next = obs->mid_next;
     if(coap_endpoint_cmp(&obs->endpoint, endpoint)
        && obs->last_mid == mid) {
       coap_remove_observer(obs);
@@ -185,18 +254,128 @@ coap_notify_observers(coap_resource_t *resource)
 {
   coap_notify_observers_sub(resource, NULL);
 }
-/* Can be used either for sub - or when there is not resource - just
-   a handler */
-void
-coap_notify_observers_sub(coap_resource_t *resource, const char *subpath)
+static int
+observer_matches(const coap_observer_t *obs, const char *url, int url_len,
+                 uint8_t sub_ok)
+{
+  int obs_url_len = strlen(obs->url);
+
+  /* Do a match based on the parent/sub-resource match so that it is
+     possible to do parent-node observe */
+  return (obs_url_len == url_len
+          || (obs_url_len > url_len
+              && sub_ok
+              && obs->url[url_len] == '/'))
+    && strncmp(url, obs->url, url_len) == 0;
+}
+/*---------------------------------------------------------------------------*/
+#if COAP_OBSERVE_FANOUT
+/*
+ * Finds the Observe option in a serialized message without token. Returns
+ * the offset of its option header byte and sets the length of its value,
+ * or returns 0 if the message has no Observe option.
+ */
+static uint16_t
+find_observe_option(const uint8_t *message, uint16_t len, uint16_t *value_len)
+{
+  uint16_t i = COAP_HEADER_LEN;
+  uint16_t start;
+  unsigned number = 0;
+  unsigned delta;
+  unsigned option_len;
+
+  while(i < len && message[i] != 0xFF) {
+    start = i;
+    delta = message[i] >> 4;
+    option_len = message[i] & COAP_HEADER_OPTION_SHORT_LENGTH_MASK;
+    i++;
+    if(delta == 13) {
+      delta = 13 + message[i++];
+    } else if(delta == 14) {
+      delta = 269 + ((message[i] << 8) | message[i + 1]);
+      i += 2;
+    }
+    if(option_len == 13) {
+      option_len = 13 + message[i++];
+    } else if(option_len == 14) {
+      option_len = 269 + ((message[i] << 8) | message[i + 1]);
+      i += 2;
+    }
+    number += delta;
+    if(number == COAP_OPTION_OBSERVE) {
+      *value_len = option_len;
+      return start;
+    }
+    if(number > COAP_OPTION_OBSERVE) {
+      break;
+    }
+    i += option_len;
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Builds the notification for one observer from the shared template: sets
+ * type, token and MID in the header and rewrites the Observe value. The
+ * options before Observe all have smaller numbers, so its delta fits in the
+ * option header byte, and the options after it are copied unchanged.
+ */
+static uint16_t
+build_notification(uint8_t *out, const uint8_t *template, uint16_t template_len,
+                   uint16_t observe_offset, uint16_t observe_len,
+                   const coap_observer_t *obs, coap_message_type_t type,
+                   uint16_t mid)
+{
+  uint16_t pos = COAP_HEADER_LEN;
+  uint16_t tail;
+  uint32_t observe = obs->obs_counter;
+  uint8_t n;
+
+  out[0] = (template[0] & COAP_HEADER_VERSION_MASK)
+    | (COAP_HEADER_TYPE_MASK & (type << COAP_HEADER_TYPE_POSITION))
+    | (COAP_HEADER_TOKEN_LEN_MASK & obs->token_len);
+  out[1] = template[1];
+  out[2] = (uint8_t)(mid >> 8);
+  out[3] = (uint8_t)mid;
+  memcpy(&out[pos], obs->token, obs->token_len);
+  pos += obs->token_len;
+
+  if(observe_offset == 0) {
+    memcpy(&out[pos], &template[COAP_HEADER_LEN], template_len - COAP_HEADER_LEN);
+    return pos + template_len - COAP_HEADER_LEN;
+  }
+
+  memcpy(&out[pos], &template[COAP_HEADER_LEN], observe_offset - COAP_HEADER_LEN);
+  pos += observe_offset - COAP_HEADER_LEN;
+
+  n = observe > 0xFFFF ? 3 : observe > 0xFF ? 2 : observe > 0 ? 1 : 0;
+  out[pos++] = (template[observe_offset] & COAP_HEADER_OPTION_DELTA_MASK) | n;
+  while(n > 0) {
+    out[pos++] = (uint8_t)(observe >> (8 * --n));
+  }
+
+  tail = observe_offset + 1 + observe_len;
+  memcpy(&out[pos], &template[tail], template_len - tail);
+  return pos + template_len - tail;
+}
+#endif /* COAP_OBSERVE_FANOUT */
+/*---------------------------------------------------------------------------*/
+static void
+notify_observers(coap_resource_t *resource, const char *subpath,
+                 uint8_t exact)
 {
   /* build notification */
   coap_message_t notification[1]; /* this way the message can be treated as pointer as usual */
   coap_message_t request[1]; /* this way the message can be treated as pointer as usual */
   coap_observer_t *obs = NULL;
-  int url_len, obs_url_len;
+  int url_len;
   char url[COAP_OBSERVER_URL_LEN];
   uint8_t sub_ok = 0;
+#if COAP_OBSERVE_FANOUT
+  uint16_t template_len = 0;
+  uint16_t observe_offset = 0;
+  uint16_t observe_len = 0;
+#endif /* COAP_OBSERVE_FANOUT */
 
   if(resource != NULL) {
     url_len = strlen(resource->url);
@@ -224,21 +403,106 @@ coap_notify_observers_sub(coap_resource_t *resource, const char *subpath)
   /* iterate over observers */
   url_len = strlen(url);
   /* Assumes lazy evaluation... */
-  sub_ok = (resource == NULL) || (resource->flags & HAS_SUB_RESOURCES);
+  sub_ok = !exact
+    && ((resource == NULL) || (resource->flags & HAS_SUB_RESOURCES));
+#if COAP_OBSERVE_FANOUT
   for(obs = (coap_observer_t *)list_head(observers_list); obs;
       obs = obs->next) {
-    obs_url_len = strlen(obs->url);
-
-    /* Do a match based on the parent/sub-resource match so that it is
-       possible to do parent-node observe */
-
-    /***** TODO fix here so that we handle the notofication correctly ******/
-    /* All the new-style ... is assuming that the URL might be within */
-    if((obs_url_len == url_len
-        || (obs_url_len > url_len
-            && sub_ok
-            && obs->url[url_len] == '/'))
-       && strncmp(url, obs->url, url_len) == 0) {
+    coap_transaction_t *transaction;
+    coap_message_type_t type;
+    uint16_t mid;
+
+    if(!observer_matches(obs, url, url_len, sub_ok)) {
+      continue;
+    }
+
+    if(template_len == 0) {
+      /* First observer: run the handler and serialize the notification */
+      int32_t new_offset = 0;
+
+      /* Either old style get_handler or the full handler */
+      if(coap_call_handlers(request, notification, notification_template +
+                            COAP_MAX_HEADER_SIZE, COAP_MAX_CHUNK_SIZE,
+                            &new_offset) > 0) {
+        LOG_DBG("Notification on new handlers\n");
+      } else {
+        if(resource != NULL) {
+          resource->get_handler(request, notification,
+                                notification_template + COAP_MAX_HEADER_SIZE,
+                                COAP_MAX_CHUNK_SIZE, &new_offset);
+        } else {
+          /* What to do here? */
+          notification->code = BAD_REQUEST_4_00;
+        }
+      }
+
+      if(notification->code < BAD_REQUEST_4_00) {
+        /* Placeholder, rewritten for each observer */
+        coap_set_header_observe(notification, 0);
+      }
+
+      if(new_offset != 0) {
+        coap_set_header_block2(notification,
+                               0,
+                               new_offset != -1,
+                               COAP_MAX_BLOCK_SIZE);
+        coap_set_payload(notification,
+                         notification->payload,
+                         MIN(notification->payload_len,
+                             COAP_MAX_BLOCK_SIZE));
+      }
+
+      template_len = coap_serialize_message(notification, notification_template);
+      if(template_len == 0) {
+        LOG_WARN("Notification serialization failed\n");
+        return;
+      }
+      observe_offset = find_observe_option(notification_template, template_len,
+                                           &observe_len);
+    }
+
+    LOG_DBG("           Observer ");
+    LOG_DBG_COAP_EP(&obs->endpoint);
+    LOG_DBG_("\n");
+
+    type = COAP_TYPE_NON;
+    if(obs->obs_counter % COAP_OBSERVE_REFRESH_INTERVAL == 0) {
+      LOG_DBG("           Force Confirmable for\n");
+      type = COAP_TYPE_CON;
+    }
+
+    if(type == COAP_TYPE_CON) {
+      /* Confirmable notifications need their own buffer for retransmissions */
+      transaction = coap_new_transaction(coap_get_mid(), &obs->endpoint);
+      if(transaction == NULL) {
+        continue;
+      }
+      /* update last MID for RST matching */
+      set_last_mid(obs, transaction->mid);
+      transaction->message_len =
+        build_notification(transaction->message, notification_template,
+                           template_len, observe_offset, observe_len,
+                           obs, type, transaction->mid);
+      coap_send_transaction(transaction);
+    } else {
+      mid = coap_get_mid();
+      set_last_mid(obs, mid);
+      coap_sendto(&obs->endpoint, notification_buffer,
+                  build_notification(notification_buffer, notification_template,
+                                     template_len, observe_offset, observe_len,
+                                     obs, type, mid));
+    }
+
+    if(notification->code < BAD_REQUEST_4_00) {
+      (obs->obs_counter)++;
+      /* mask out to keep the CoAP observe option length <= 3 bytes */
+      obs->obs_counter &= 0xffffff;
+    }
+  }
+#else /* COAP_OBSERVE_FANOUT */
+  for(obs = (coap_observer_t *)list_head(observers_list); obs;
+      obs = obs->next) {
+    if(observer_matches(obs, url, url_len, sub_ok)) {
       coap_transaction_t *transaction = NULL;
 
       /*TODO implement special transaction for CON, sharing the same buffer to allow for more observers */
@@ -254,7 +518,7 @@ coap_notify_observers_sub(coap_resource_t *resource, const char *subpath)
         LOG_DBG_("\n");
 
         /* update last MID for RST matching */
-        obs->last_mid = transaction->mid;
+        set_last_mid(obs, transaction->mid);
 
         /* prepare response */
         notification->mid = transaction->mid;
@@ -302,6 +566,22 @@ coap_notify_observers_sub(coap_resource_t *resource, const char *subpath)
       }
     }
   }
+#endif /* COAP_OBSERVE_FANOUT */
+}
+/*---------------------------------------------------------------------------*/
+/* Can be used either for sub - or when there is not resource - just
+   a handler */
+void
+coap_notify_observers_sub(coap_resource_t *resource, const char *subpath)
+{
+  notify_observers(resource, subpath, 0);
+}
+/*---------------------------------------------------------------------------*/
+/* Notifies the observers of path only, not those of its sub-resources */
+void
+coap_notify_observers_exact(const char *path)
+{
+  notify_observers(NULL, path, 1);
 }
 /*---------------------------------------------------------------------------*/
 void
@@ -310,18 +590,22 @@ coap_observe_handler(coap_resource_t *resource, coap_message_t *coap_req,
 {
   const coap_endpoint_t *src_ep;
   coap_observer_t *obs;
+  uint32_t observe;
+  const char *uri_path;
+  int uri_path_len;
 
   LOG_DBG("CoAP observer handler rsc: %d\n", resource != NULL);
 
   if(coap_req->code == COAP_GET && coap_res->code < 128) { /* GET request and response without error code */
-    if(coap_is_option(coap_req, COAP_OPTION_OBSERVE)) {
+    if(coap_get_header_observe(coap_req, &observe)) {
       src_ep = coap_get_src_endpoint(coap_req);
       if(src_ep == NULL) {
         /* No source endpoint, can not add */
-      } else if(coap_req->observe == 0) {
+      } else if(observe == 0) {
+        uri_path_len = coap_get_header_uri_path(coap_req, &uri_path);
         obs = add_observer(src_ep,
                            coap_req->token, coap_req->token_len,
-                           coap_req->uri_path, coap_req->uri_path_len);
+                           uri_path, uri_path_len);
         if(obs) {
           coap_set_header_observe(coap_res, (obs->obs_counter)++);
           /* mask out to keep the CoAP observe option length <= 3 bytes */
@@ -343,7 +627,7 @@ coap_observe_handler(coap_resource_t *resource, coap_message_t *coap_req,
           coap_res->code = SERVICE_UNAVAILABLE_5_03;
           coap_set_payload(coap_res, "TooManyObservers", 16);
         }
-      } else if(coap_req->observe == 1) {
+      } else if(observe == 1) {
 
         /* remove client if it is currently observe */
         coap_remove_observer_by_token(src_ep,
@@ -367,4 +651,18 @@ coap_has_observers(char *path)
   return 0;
 }
 /*---------------------------------------------------------------------------*/
+uint8_t
+coap_has_observers_exact(const char *path)
+{
+  coap_observer_t *obs = NULL;
+
+  for(obs = (coap_observer_t *)list_head(observers_list); obs;
+      obs = obs->next) {
+    if(strcmp(obs->url, path) == 0) {
+      return 1;
+    }
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
 /** @} */
@@ -52,6 +52,8 @@
 
 typedef struct coap_observer {
   struct coap_observer *next;   /* for LIST */
+  struct coap_observer *token_next; /* for the token index */
+  struct coap_observer *mid_next;   /* for the last MID index */
 
   char url[COAP_OBSERVER_URL_LEN];
   coap_endpoint_t endpoint;
@@ -76,11 +78,13 @@ int coap_remove_observer_by_mid(const coap_endpoint_t *ep,
 
 void coap_notify_observers(coap_resource_t *resource);
 void coap_notify_observers_sub(coap_resource_t *resource, const char *subpath);
+void coap_notify_observers_exact(const char *path);
 
 void coap_observe_handler(coap_resource_t *resource, coap_message_t *request,
                           coap_message_t *response);
 
 uint8_t coap_has_observers(char *path);
+uint8_t coap_has_observers_exact(const char *path);
 
 #endif /* COAP_OBSERVE_H_ */
 /** @} */
@@ -51,6 +51,31 @@ typedef enum {
 } coap_request_status_t;
 
 
+#if COAP_BLOCK_WINDOW < 1
+#error COAP_BLOCK_WINDOW must be at least 1
+#endif
+
+/* blocks arriving out of order are only buffered with a larger window */
+#if COAP_BLOCK_WINDOW > 1
+#define COAP_BLOCK_SLOT_SIZE COAP_MAX_CHUNK_SIZE
+#else /* COAP_BLOCK_WINDOW > 1 */
+#define COAP_BLOCK_SLOT_SIZE 1
+#endif /* COAP_BLOCK_WINDOW > 1 */
+
+struct coap_request_state;
+
+/* one Block2 request of a windowed transfer */
+typedef struct coap_block_slot {
+  struct coap_request_state *state;
+  coap_transaction_t *transaction;
+  uint32_t num;
+  uint16_t len;
+  uint8_t code;
+  uint8_t more;
+  uint8_t received;
+  uint8_t payload[COAP_BLOCK_SLOT_SIZE];
+} coap_block_slot_t;
+
 typedef struct coap_request_state {
   coap_transaction_t *transaction;
   coap_message_t *response;
@@ -62,6 +87,10 @@ typedef struct coap_request_state {
   uint8_t block_error;
   void *user_data;
   coap_request_status_t status;
+  uint32_t next_block;  /* next block to request */
+  uint32_t last_block;  /* last block of the body, once known */
+  uint16_t block_size;
+  coap_block_slot_t slots[COAP_BLOCK_WINDOW];
 } coap_request_state_t;
 
 
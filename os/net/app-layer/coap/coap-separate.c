@@ -87,9 +87,14 @@ coap_separate_accept(coap_message_t *coap_req, coap_separate_t *separate_store)
 {
   coap_transaction_t *const t = coap_get_transaction_by_mid(coap_req->mid);
 
-  LOG_DBG("Separate ACCEPT: /");
-  LOG_DBG_COAP_STRING(coap_req->uri_path, coap_req->uri_path_len);
-  LOG_DBG_(" MID %u\n", coap_req->mid);
+  if(LOG_DBG_ENABLED) {
+    const char *uri_path;
+    int uri_path_len = coap_get_header_uri_path(coap_req, &uri_path);
+
+    LOG_DBG("Separate ACCEPT: /");
+    LOG_DBG_COAP_STRING(uri_path, uri_path_len);
+    LOG_DBG_(" MID %u\n", coap_req->mid);
+  }
   if(t) {
     /* send separate ACK for CON */
     if(coap_req->type == COAP_TYPE_CON) {
@@ -119,11 +124,18 @@ coap_separate_accept(coap_message_t *coap_req, coap_separate_t *separate_store)
     memcpy(separate_store->token, coap_req->token, coap_req->token_len);
     separate_store->token_len = coap_req->token_len;
 
-    separate_store->block1_num = coap_req->block1_num;
-    separate_store->block1_size = coap_req->block1_size;
+    separate_store->block1_num = 0;
+    separate_store->block1_size = 0;
+    coap_get_header_block1(coap_req, &separate_store->block1_num, NULL,
+                           &separate_store->block1_size, NULL);
 
-    separate_store->block2_num = coap_req->block2_num;
-    separate_store->block2_size = coap_req->block2_size > 0 ? MIN(COAP_MAX_BLOCK_SIZE, coap_req->block2_size) : COAP_MAX_BLOCK_SIZE;
+    separate_store->block2_num = 0;
+    separate_store->block2_size = COAP_MAX_BLOCK_SIZE;
+    if(coap_get_header_block2(coap_req, &separate_store->block2_num, NULL,
+                              &separate_store->block2_size, NULL)) {
+      separate_store->block2_size = MIN(COAP_MAX_BLOCK_SIZE,
+                                        separate_store->block2_size);
+    }
 
     /* signal the engine to skip automatic response and clear transaction by engine */
     coap_status_code = MANUAL_RESPONSE;
@@ -0,0 +1,526 @@
+/*
+ * Copyright (c) 2026, Contiki-NG contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *      CoAP over TCP (RFC 8323) for the uIP transport. Messages keep the
+ *      UDP format of RFC 7252 inside the CoAP engine and are converted to
+ *      and from the length-prefixed TCP framing here: outgoing messages
+ *      lose their type and Message ID, incoming requests become NON
+ *      messages and incoming responses become ACKs for the transaction
+ *      with the same token.
+ */
+
+/**
+ * \addtogroup coap-transport
+ * @{
+ */
+
+#include "coap-engine.h"
+#include "coap-tcp.h"
+#include "coap-transactions.h"
+#include "tcp-socket.h"
+#include <string.h>
+
+/* Log configuration */
+#include "coap-log.h"
+#define LOG_MODULE "coap-tcp"
+#define LOG_LEVEL  LOG_LEVEL_COAP
+
+#if COAP_TCP
+
+#if !UIP_TCP
+#error "COAP_TCP needs UIP_CONF_TCP"
+#endif
+
+/* Room in front of a frame for the longer UDP header it is converted to */
+#define FRAME_HEADROOM (COAP_HEADER_LEN - 2)
+
+typedef enum {
+  STATE_IDLE,
+  STATE_CONNECTING,
+  STATE_CONNECTED,
+  STATE_CLOSING
+} connection_state_t;
+
+typedef struct {
+  struct tcp_socket socket;
+  coap_endpoint_t endpoint;
+  uint32_t peer_max_message_size;
+  uint16_t frame_len;
+  uint8_t state;
+  uint8_t frame[FRAME_HEADROOM + COAP_TCP_MAX_MESSAGE_SIZE];
+  uint8_t output[COAP_TCP_OUTPUT_SIZE];
+} coap_tcp_connection_t;
+
+static coap_tcp_connection_t connections[COAP_TCP_CONNECTIONS];
+
+/* Incoming segments are copied to the frame of their connection at once */
+static uint8_t input[64];
+
+/*---------------------------------------------------------------------------*/
+static int
+is_idle(coap_tcp_connection_t *conn)
+{
+  /* tcp-socket puts sockets back to listening when their connection ends */
+  return (conn->socket.flags & TCP_SOCKET_FLAGS_LISTENING) != 0;
+}
+/*---------------------------------------------------------------------------*/
+static coap_tcp_connection_t *
+find(const coap_endpoint_t *ep)
+{
+  coap_tcp_connection_t *conn;
+
+  for(conn = connections; conn < &connections[COAP_TCP_CONNECTIONS]; conn++) {
+    if(!is_idle(conn) && conn->state != STATE_CLOSING
+       && coap_endpoint_cmp(&conn->endpoint, ep)) {
+      return conn;
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+/* Writes the length, token length and code of a frame, returns its length */
+static int
+put_header(uint8_t *buf, uint16_t length, uint8_t token_len, uint8_t code)
+{
+  int n = 1;
+
+  if(length < 13) {
+    buf[0] = length << 4;
+  } else if(length < 269) {
+    buf[0] = 13 << 4;
+    buf[n++] = length - 13;
+  } else {
+    buf[0] = 14 << 4;
+    length -= 269;
+    buf[n++] = length >> 8;
+    buf[n++] = length;
+  }
+  buf[0] |= token_len;
+  buf[n++] = code;
+  return n;
+}
+/*---------------------------------------------------------------------------*/
+static int
+send_frame(coap_tcp_connection_t *conn, const uint8_t *header, int header_len,
+           const uint8_t *rest, uint16_t rest_len)
+{
+  if(header_len + rest_len > conn->peer_max_message_size) {
+    LOG_WARN("message of %u bytes exceeds Max-Message-Size of the peer\n",
+             header_len + rest_len);
+    return -1;
+  }
+  if(tcp_socket_max_sendlen(&conn->socket) < header_len + rest_len) {
+    LOG_WARN("output buffer full, dropping message\n");
+    return -1;
+  }
+  tcp_socket_send(&conn->socket, header, header_len);
+  if(rest_len > 0) {
+    tcp_socket_send(&conn->socket, rest, rest_len);
+  }
+  return header_len + rest_len;
+}
+/*---------------------------------------------------------------------------*/
+/* The CSM has to be the first message on a connection */
+static void
+send_csm(coap_tcp_connection_t *conn)
+{
+  uint8_t csm[8];
+  uint32_t size = COAP_TCP_MAX_MESSAGE_SIZE;
+  int value_len = size > 0xFFFF ? 4 : size > 0xFF ? 2 : 1;
+  int n = put_header(csm, 1 + value_len, 0, COAP_SIGNAL_CSM);
+  int i;
+
+  csm[n++] = (COAP_SIGNAL_OPTION_MAX_MESSAGE_SIZE << 4) | value_len;
+  for(i = value_len - 1; i >= 0; i--) {
+    csm[n++] = size >> (8 * i);
+  }
+  /* the peer assumes the default until it has seen this */
+  conn->peer_max_message_size = COAP_TCP_DEFAULT_MAX_MESSAGE_SIZE;
+  send_frame(conn, csm, n, NULL, 0);
+}
+/*---------------------------------------------------------------------------*/
+/* Clears what an earlier connection of the socket may have left */
+static void
+reset(coap_tcp_connection_t *conn)
+{
+  conn->socket.output_data_len = 0;
+  conn->socket.output_senddata_len = 0;
+  conn->socket.output_data_send_nxt = 0;
+  conn->frame_len = 0;
+}
+/*---------------------------------------------------------------------------*/
+static coap_tcp_connection_t *
+open_connection(const coap_endpoint_t *ep)
+{
+  coap_tcp_connection_t *conn;
+
+  for(conn = connections; conn < &connections[COAP_TCP_CONNECTIONS]; conn++) {
+    if(is_idle(conn)) {
+      /* no longer available for incoming connections */
+      conn->socket.flags &= ~TCP_SOCKET_FLAGS_LISTENING;
+      reset(conn);
+      coap_endpoint_copy(&conn->endpoint, ep);
+      conn->state = STATE_CONNECTING;
+      if(tcp_socket_connect(&conn->socket, &ep->ipaddr,
+                            uip_ntohs(ep->port)) < 0) {
+        conn->socket.flags |= TCP_SOCKET_FLAGS_LISTENING;
+        conn->state = STATE_IDLE;
+        return NULL;
+      }
+      send_csm(conn);
+      return conn;
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static void
+close_connection(coap_tcp_connection_t *conn)
+{
+  conn->state = STATE_CLOSING;
+  tcp_socket_close(&conn->socket);
+}
+/*---------------------------------------------------------------------------*/
+/* Returns the Max-Message-Size option of a CSM or max if it has none */
+static uint32_t
+csm_max_message_size(const uint8_t *option, const uint8_t *end, uint32_t max)
+{
+  unsigned int number = 0;
+
+  while(option < end && *option != 0xFF) {
+    unsigned int delta = *option >> 4;
+    unsigned int len = *option & 0x0F;
+
+    option++;
+    if(delta == 15 || len == 15) {
+      break;
+    }
+    if(delta == 13 || len == 13) {
+      if(option >= end) {
+        break;
+      }
+    }
+    if(delta == 13) {
+      delta = 13 + *option++;
+    } else if(delta == 14) {
+      if(end - option < 2) {
+        break;
+      }
+      delta = 269 + (option[0] << 8) + option[1];
+      option += 2;
+    }
+    if(len == 13) {
+      if(option >= end) {
+        break;
+      }
+      len = 13 + *option++;
+    } else if(len == 14) {
+      if(end - option < 2) {
+        break;
+      }
+      len = 269 + (option[0] << 8) + option[1];
+      option += 2;
+    }
+    if(len > end - option) {
+      break;
+    }
+    number += delta;
+    if(number == COAP_SIGNAL_OPTION_MAX_MESSAGE_SIZE && len <= 4) {
+      max = 0;
+      while(len-- > 0) {
+        max = (max << 8) | *option++;
+      }
+    }
+    option += len;
+  }
+  return max;
+}
+/*---------------------------------------------------------------------------*/
+static void
+handle_signal(coap_tcp_connection_t *conn, uint8_t code,
+              const uint8_t *token, uint8_t token_len,
+              const uint8_t *options, const uint8_t *end)
+{
+  uint8_t header[4];
+
+  switch(code) {
+  case COAP_SIGNAL_CSM:
+    conn->peer_max_message_size =
+      csm_max_message_size(options, end, conn->peer_max_message_size);
+    LOG_DBG("peer Max-Message-Size %lu\n",
+            (unsigned long)conn->peer_max_message_size);
+    break;
+  case COAP_SIGNAL_PING:
+    send_frame(conn, header, put_header(header, 0, token_len, COAP_SIGNAL_PONG),
+               token, token_len);
+    break;
+  case COAP_SIGNAL_RELEASE:
+  case COAP_SIGNAL_ABORT:
+    LOG_INFO("peer ended the connection\n");
+    close_connection(conn);
+    break;
+  default:
+    break;
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Passes a complete frame to the CoAP engine as a UDP message */
+static void
+handle_frame(coap_tcp_connection_t *conn)
+{
+  uint8_t *frame = &conn->frame[FRAME_HEADROOM];
+  uint8_t nibble = frame[0] >> 4;
+  uint8_t ext = nibble < 13 ? 0 : nibble == 13 ? 1 : 2;
+  uint8_t token_len = frame[0] & COAP_HEADER_TOKEN_LEN_MASK;
+  uint8_t code = frame[1 + ext];
+  uint8_t *token = &frame[2 + ext];
+  uint8_t *message = token - COAP_HEADER_LEN;
+  coap_message_type_t type = COAP_TYPE_NON;
+  coap_transaction_t *t;
+  uint16_t mid;
+
+  if(code == 0) {
+    /* Empty messages are to be ignored */
+    return;
+  }
+  if(code >> 5 == 7) {
+    handle_signal(conn, code, token, token_len, token + token_len,
+                  frame + conn->frame_len);
+    return;
+  }
+
+  if(code >= COAP_GET && code <= COAP_IPATCH) {
+    mid = coap_get_mid();
+  } else if((t = coap_get_transaction_by_token(&conn->endpoint,
+                                               token, token_len)) != NULL) {
+    /* completes the request like a piggybacked response */
+    type = COAP_TYPE_ACK;
+    mid = t->mid;
+  } else {
+    /* e.g. a notification */
+    mid = coap_get_mid();
+  }
+
+  message[0] = (1 << COAP_HEADER_VERSION_POSITION)
+    | (type << COAP_HEADER_TYPE_POSITION) | token_len;
+  message[1] = code;
+  message[2] = mid >> 8;
+  message[3] = mid;
+  coap_receive(&conn->endpoint, message,
+               conn->frame_len - (2 + ext) + COAP_HEADER_LEN);
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Returns how many more bytes the frame being received needs, to be
+ * complete or to tell its length, 0 if it is complete and negative if it
+ * cannot be received.
+ */
+static int
+frame_missing(coap_tcp_connection_t *conn)
+{
+  const uint8_t *frame = &conn->frame[FRAME_HEADROOM];
+  uint8_t nibble;
+  uint8_t ext;
+  uint32_t length;
+
+  if(conn->frame_len == 0) {
+    return 1;
+  }
+  nibble = frame[0] >> 4;
+  ext = nibble < 13 ? 0 : nibble == 13 ? 1 : nibble == 14 ? 2 : 4;
+  if((frame[0] & COAP_HEADER_TOKEN_LEN_MASK) > COAP_TOKEN_LEN) {
+    return -1;
+  }
+  if(conn->frame_len < 1 + ext) {
+    return 1 + ext - conn->frame_len;
+  }
+
+  if(nibble < 13) {
+    length = nibble;
+  } else if(nibble == 13) {
+    length = 13 + frame[1];
+  } else if(nibble == 14) {
+    length = 269 + ((uint16_t)frame[1] << 8) + frame[2];
+  } else {
+    return -1;
+  }
+  length += 2 + ext + (frame[0] & COAP_HEADER_TOKEN_LEN_MASK);
+
+  if(length > COAP_TCP_MAX_MESSAGE_SIZE) {
+    return -1;
+  }
+  return length - conn->frame_len;
+}
+/*---------------------------------------------------------------------------*/
+static int
+input_callback(struct tcp_socket *s, void *ptr,
+               const uint8_t *data, int len)
+{
+  coap_tcp_connection_t *conn = ptr;
+  int missing;
+
+  while(len > 0 && conn->state == STATE_CONNECTED) {
+    /* only ever one frame in the buffer, so that the engine may reuse it */
+    if((missing = frame_missing(conn)) < 0) {
+      LOG_WARN("invalid or too large message, closing\n");
+      close_connection(conn);
+      break;
+    }
+    missing = MIN(missing, len);
+    memcpy(&conn->frame[FRAME_HEADROOM + conn->frame_len], data, missing);
+    conn->frame_len += missing;
+    data += missing;
+    len -= missing;
+
+    if(frame_missing(conn) == 0) {
+      handle_frame(conn);
+      conn->frame_len = 0;
+    }
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+event_callback(struct tcp_socket *s, void *ptr, tcp_socket_event_t event)
+{
+  coap_tcp_connection_t *conn = ptr;
+
+  switch(event) {
+  case TCP_SOCKET_CONNECTED:
+    if(conn->state != STATE_CONNECTING) {
+      /* accepted while listening */
+      s->c = uip_conn;
+      reset(conn);
+      uip_ipaddr_copy(&conn->endpoint.ipaddr, &uip_conn->ripaddr);
+      conn->endpoint.port = uip_conn->rport;
+      conn->endpoint.secure = 0;
+      conn->endpoint.tcp = 1;
+      send_csm(conn);
+    }
+    conn->state = STATE_CONNECTED;
+    LOG_INFO("connected to ");
+    LOG_INFO_COAP_EP(&conn->endpoint);
+    LOG_INFO_("\n");
+    break;
+  case TCP_SOCKET_CLOSED:
+  case TCP_SOCKET_TIMEDOUT:
+  case TCP_SOCKET_ABORTED:
+    LOG_INFO("connection to ");
+    LOG_INFO_COAP_EP(&conn->endpoint);
+    LOG_INFO_(" ended (%d)\n", event);
+    conn->state = STATE_IDLE;
+    break;
+  default:
+    break;
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+coap_tcp_init(void)
+{
+  coap_tcp_connection_t *conn;
+
+  for(conn = connections; conn < &connections[COAP_TCP_CONNECTIONS]; conn++) {
+    conn->state = STATE_IDLE;
+    tcp_socket_register(&conn->socket, conn, input, sizeof(input),
+                        conn->output, sizeof(conn->output),
+                        input_callback, event_callback);
+    tcp_socket_listen(&conn->socket, COAP_DEFAULT_PORT);
+  }
+  LOG_INFO("Listening on TCP port %u\n", COAP_DEFAULT_PORT);
+}
+/*---------------------------------------------------------------------------*/
+int
+coap_tcp_sendto(const coap_endpoint_t *ep, const uint8_t *data, uint16_t len)
+{
+  coap_tcp_connection_t *conn;
+  uint8_t header[4];
+  uint8_t token_len;
+
+  if(len < COAP_HEADER_LEN
+     || len < COAP_HEADER_LEN + (token_len = data[0] & COAP_HEADER_TOKEN_LEN_MASK)) {
+    return -1;
+  }
+  if(data[1] == 0) {
+    /* ACKs, RSTs and pings are for unreliable transports */
+    return len;
+  }
+
+  if((conn = find(ep)) == NULL && (conn = open_connection(ep)) == NULL) {
+    LOG_WARN("no free connection for ");
+    LOG_WARN_COAP_EP(ep);
+    LOG_WARN_("\n");
+    return -1;
+  }
+
+  /* the token and what follows it stay as they are */
+  if(send_frame(conn, header,
+                put_header(header, len - COAP_HEADER_LEN - token_len,
+                           token_len, data[1]),
+                data + COAP_HEADER_LEN, len - COAP_HEADER_LEN) < 0) {
+    return -1;
+  }
+  LOG_INFO("sent to ");
+  LOG_INFO_COAP_EP(ep);
+  LOG_INFO_(" %u bytes\n", len);
+  return len;
+}
+/*---------------------------------------------------------------------------*/
+int
+coap_tcp_is_connected(const coap_endpoint_t *ep)
+{
+  coap_tcp_connection_t *conn = find(ep);
+
+  return conn != NULL && conn->state == STATE_CONNECTED;
+}
+/*---------------------------------------------------------------------------*/
+int
+coap_tcp_connect(const coap_endpoint_t *ep)
+{
+  return find(ep) != NULL || open_connection(ep) != NULL;
+}
+/*---------------------------------------------------------------------------*/
+void
+coap_tcp_disconnect(const coap_endpoint_t *ep)
+{
+  coap_tcp_connection_t *conn = find(ep);
+
+  if(conn != NULL) {
+    close_connection(conn);
+  }
+}
+/*---------------------------------------------------------------------------*/
+#endif /* COAP_TCP */
+/** @} */
@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2026, Contiki-NG contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *      CoAP over TCP (RFC 8323) for the uIP transport
+ */
+
+/**
+ * \addtogroup coap-transport
+ * @{
+ */
+
+#ifndef COAP_TCP_H_
+#define COAP_TCP_H_
+
+#include "coap-endpoint.h"
+
+/**
+ * \brief      Register the TCP connections and accept incoming ones.
+ *             Called from the CoAP engine process.
+ */
+void coap_tcp_init(void);
+
+/**
+ * \brief      Send a CoAP message to a coap+tcp endpoint, connecting to it
+ *             first if needed.
+ * \param ep   The endpoint
+ * \param data The message in the UDP format of RFC 7252, which is framed
+ *             for TCP as it is queued
+ * \param len  The length of the message
+ * \return     The number of bytes queued or negative if an error occurred.
+ */
+int coap_tcp_sendto(const coap_endpoint_t *ep, const uint8_t *data,
+                    uint16_t len);
+
+/**
+ * \brief      Check if the connection to a coap+tcp endpoint is established.
+ * \param ep   The endpoint
+ * \return     1 if the connection is established, 0 otherwise.
+ */
+int coap_tcp_is_connected(const coap_endpoint_t *ep);
+
+/**
+ * \brief      Start a connection to a coap+tcp endpoint, sending the CSM
+ *             once it is established.
+ * \param ep   The endpoint
+ * \return     1 if the endpoint is connected or being connected to, 0 if
+ *             no connection is free.
+ */
+int coap_tcp_connect(const coap_endpoint_t *ep);
+
+/**
+ * \brief      Close the connection to a coap+tcp endpoint once what is
+ *             queued for it has been sent.
+ * \param ep   The endpoint
+ */
+void coap_tcp_disconnect(const coap_endpoint_t *ep);
+
+#endif /* COAP_TCP_H_ */
+/** @} */
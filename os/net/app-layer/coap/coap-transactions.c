@@ -47,6 +47,7 @@
 #include "lib/memb.h"
 #include "lib/list.h"
 #include <stdlib.h>
+#include <string.h>
 
 /* Log configuration */
 #include "coap-log.h"
@@ -57,6 +58,48 @@
 MEMB(transactions_memb, coap_transaction_t, COAP_MAX_OPEN_TRANSACTIONS);
 LIST(transactions_list);
 
+#if (COAP_TRANSACTION_TABLE_SIZE & (COAP_TRANSACTION_TABLE_SIZE - 1)) != 0
+#error COAP_TRANSACTION_TABLE_SIZE must be a power of two
+#endif
+
+/* Open transactions hashed by MID */
+static coap_transaction_t *transaction_table[COAP_TRANSACTION_TABLE_SIZE];
+
+/* Requests waiting for room in the NSTART window */
+LIST(nstart_waiters);
+static coap_timer_t nstart_timer;
+
+#if COAP_COCOA
+/* CoCoA RTO estimates, all times in milliseconds */
+#define COCOA_INITIAL_RTO 2000
+#define COCOA_MAX_RTO     60000
+
+typedef struct {
+  coap_endpoint_t endpoint;
+  uint64_t updated;
+  uint32_t rto;
+  uint32_t srtt_strong;
+  uint32_t rttvar_strong;
+  uint32_t srtt_weak;
+  uint32_t rttvar_weak;
+} cocoa_estimate_t;
+
+static cocoa_estimate_t estimates[COAP_COCOA_ENDPOINTS];
+#endif /* COAP_COCOA */
+
+#if COAP_DEDUP_CACHE_SIZE
+/* Responses to recent confirmable requests, see coap_dedup_resend() */
+typedef struct {
+  coap_endpoint_t endpoint;
+  uint64_t expiration_time;
+  uint16_t mid;
+  uint16_t message_len;
+  uint8_t message[COAP_MAX_PACKET_SIZE];
+} coap_dedup_entry_t;
+
+static coap_dedup_entry_t dedup_cache[COAP_DEDUP_CACHE_SIZE];
+#endif /* COAP_DEDUP_CACHE_SIZE */
+
 /*---------------------------------------------------------------------------*/
 static void
 coap_retransmit_transaction(coap_timer_t *nt)
@@ -71,6 +114,159 @@ coap_retransmit_transaction(coap_timer_t *nt)
   coap_send_transaction(t);
 }
 /*---------------------------------------------------------------------------*/
+static coap_transaction_t **
+table_bucket(uint16_t mid)
+{
+  return &transaction_table[mid & (COAP_TRANSACTION_TABLE_SIZE - 1)];
+}
+/*---------------------------------------------------------------------------*/
+static void
+table_remove(coap_transaction_t *t)
+{
+  coap_transaction_t **p;
+
+  for(p = table_bucket(t->mid); *p != NULL; p = &(*p)->table_next) {
+    if(*p == t) {
+      *p = t->table_next;
+      return;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static int
+is_confirmable(const coap_transaction_t *t)
+{
+  return t->message_len > 0 && COAP_TYPE_CON ==
+    ((COAP_HEADER_TYPE_MASK & t->message[0]) >> COAP_HEADER_TYPE_POSITION);
+}
+/*---------------------------------------------------------------------------*/
+#if COAP_COCOA
+static cocoa_estimate_t *
+cocoa_lookup(const coap_endpoint_t *ep)
+{
+  cocoa_estimate_t *e;
+
+  for(e = estimates; e < &estimates[COAP_COCOA_ENDPOINTS]; e++) {
+    if(e->rto != 0 && coap_endpoint_cmp(&e->endpoint, ep)) {
+      return e;
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Returns the overall RTO of an endpoint. Estimates that have not been
+ * updated for a while age towards the initial RTO: a small RTO is doubled
+ * after 16 times its value, a large one halved towards 2 s after 4 times.
+ */
+static uint32_t
+cocoa_rto(const coap_endpoint_t *ep)
+{
+  cocoa_estimate_t *e = cocoa_lookup(ep);
+  uint64_t now = coap_timer_uptime();
+
+  if(e == NULL) {
+    return COCOA_INITIAL_RTO;
+  }
+  if(e->rto < 1000 && now - e->updated > 16ULL * e->rto) {
+    e->rto *= 2;
+    e->updated = now;
+  } else if(e->rto > 3000 && now - e->updated > 4ULL * e->rto) {
+    e->rto = (COCOA_INITIAL_RTO + e->rto) / 2;
+    e->updated = now;
+  }
+  return e->rto;
+}
+/*---------------------------------------------------------------------------*/
+/* RFC 6298 estimator, returns the new RTO estimate SRTT + K * RTTVAR */
+static uint32_t
+cocoa_estimate(uint32_t *srtt, uint32_t *rttvar, uint32_t rtt, unsigned k)
+{
+  if(*srtt == 0) {
+    *srtt = rtt;
+    *rttvar = rtt / 2;
+  } else {
+    *rttvar = (3 * *rttvar + (*srtt > rtt ? *srtt - rtt : rtt - *srtt)) / 4;
+    *srtt = (7 * *srtt + rtt) / 8;
+  }
+  return *srtt + k * *rttvar;
+}
+/*---------------------------------------------------------------------------*/
+static void
+cocoa_update(const coap_endpoint_t *ep, uint32_t rtt, uint8_t strong)
+{
+  cocoa_estimate_t *e = cocoa_lookup(ep);
+  uint32_t estimate;
+
+  if(e == NULL) {
+    /* replace the estimate that has not been used for the longest time */
+    cocoa_estimate_t *i;
+
+    e = estimates;
+    for(i = estimates; i < &estimates[COAP_COCOA_ENDPOINTS]; i++) {
+      if(i->updated < e->updated) {
+        e = i;
+      }
+    }
+    memset(e, 0, sizeof(*e));
+    coap_endpoint_copy(&e->endpoint, ep);
+    e->rto = COCOA_INITIAL_RTO;
+  }
+
+  if(rtt == 0) {
+    rtt = 1;
+  }
+  if(strong) {
+    estimate = cocoa_estimate(&e->srtt_strong, &e->rttvar_strong, rtt, 4);
+    e->rto = (estimate + e->rto) / 2;
+  } else {
+    estimate = cocoa_estimate(&e->srtt_weak, &e->rttvar_weak, rtt, 1);
+    e->rto = (estimate + 3 * e->rto) / 4;
+  }
+  if(e->rto > COCOA_MAX_RTO) {
+    e->rto = COCOA_MAX_RTO;
+  }
+  e->updated = coap_timer_uptime();
+
+  LOG_DBG("CoCoA %s RTT %lu ms, RTO %lu ms\n", strong ? "strong" : "weak",
+          (unsigned long)rtt, (unsigned long)e->rto);
+}
+/*---------------------------------------------------------------------------*/
+/* Applies the variable backoff factor chosen by the current RTO */
+static uint32_t
+cocoa_backoff(uint32_t interval, uint32_t rto)
+{
+  if(rto < 1000) {
+    return interval * 3;
+  } else if(rto > 3000) {
+    return interval + interval / 2;
+  }
+  return interval * 2;
+}
+#endif /* COAP_COCOA */
+/*---------------------------------------------------------------------------*/
+/*
+ * Lets waiting requests start while the window to their endpoint has room.
+ * Runs from a timer, so that a completed exchange has been handed to its
+ * callback before a new request reuses the buffers.
+ */
+static void
+nstart_resume(coap_timer_t *timer)
+{
+  coap_nstart_waiter_t *w;
+
+  for(w = list_head(nstart_waiters); w != NULL;) {
+    if(!coap_nstart_available(w->endpoint)) {
+      w = w->next;
+    } else {
+      list_remove(nstart_waiters, w);
+      w->resume(w->data);
+      /* the callback may have changed the list */
+      w = list_head(nstart_waiters);
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
 
 /*---------------------------------------------------------------------------*/
 /*- Internal API ------------------------------------------------------------*/
@@ -83,11 +279,16 @@ coap_new_transaction(uint16_t mid, const coap_endpoint_t *endpoint)
   if(t) {
     t->mid = mid;
     t->retrans_counter = 0;
+    t->message_len = 0;
 
     /* save client address */
     coap_endpoint_copy(&t->endpoint, endpoint);
 
     list_add(transactions_list, t); /* list itself makes sure same element is not added twice */
+
+    /* newest first, so that a reused MID finds the latest exchange */
+    t->table_next = *table_bucket(mid);
+    *table_bucket(mid) = t;
   }
 
   return t;
@@ -100,7 +301,21 @@ coap_send_transaction(coap_transaction_t *t)
 
   if(COAP_TYPE_CON ==
      ((COAP_HEADER_TYPE_MASK & t->message[0]) >> COAP_HEADER_TYPE_POSITION)) {
-    if(t->retrans_counter <= COAP_MAX_RETRANSMIT) {
+    if(t->retrans_counter == 0 && coap_endpoint_is_reliable(&t->endpoint)) {
+      /* the transport delivers the message, only a response is awaited */
+      coap_sendto(&t->endpoint, t->message, t->message_len);
+      if(t->callback == NULL) {
+        coap_clear_transaction(t);
+        return;
+      }
+      /* times out on the next timer expiration */
+      t->retrans_counter = COAP_MAX_RETRANSMIT;
+      t->retrans_interval = COAP_RESPONSE_TIMEOUT_TICKS
+        * ((1 << (COAP_MAX_RETRANSMIT + 1)) - 1);
+      coap_timer_set_callback(&t->retrans_timer, coap_retransmit_transaction);
+      coap_timer_set_user_data(&t->retrans_timer, t);
+      coap_timer_set(&t->retrans_timer, t->retrans_interval);
+    } else if(t->retrans_counter <= COAP_MAX_RETRANSMIT) {
       /* not timed out yet */
       coap_sendto(&t->endpoint, t->message, t->message_len);
       LOG_DBG("Keeping transaction %u\n", t->mid);
@@ -108,14 +323,26 @@ coap_send_transaction(coap_transaction_t *t)
       if(t->retrans_counter == 0) {
         coap_timer_set_callback(&t->retrans_timer, coap_retransmit_transaction);
         coap_timer_set_user_data(&t->retrans_timer, t);
+#if COAP_COCOA
+        /* random initial timeout between RTO and 1.5 * RTO */
+        t->start_time = (uint32_t)coap_timer_uptime();
+        t->retrans_interval = cocoa_rto(&t->endpoint);
+        t->retrans_interval += rand() % (t->retrans_interval / 2 + 1);
+#else /* COAP_COCOA */
         t->retrans_interval =
           COAP_RESPONSE_TIMEOUT_TICKS + (rand() %
                                          COAP_RESPONSE_TIMEOUT_BACKOFF_MASK);
+#endif /* COAP_COCOA */
         LOG_DBG("Initial interval %lu msec\n",
                 (unsigned long)t->retrans_interval);
       } else {
+#if COAP_COCOA
+        t->retrans_interval = cocoa_backoff(t->retrans_interval,
+                                            cocoa_rto(&t->endpoint));
+#else /* COAP_COCOA */
         t->retrans_interval <<= 1;  /* double */
-        LOG_DBG("Doubled (%u) interval %lu s\n", t->retrans_counter,
+#endif /* COAP_COCOA */
+        LOG_DBG("Backed off (%u) interval %lu s\n", t->retrans_counter,
                 (unsigned long)(t->retrans_interval / 1000));
       }
 
@@ -146,20 +373,29 @@ void
 coap_clear_transaction(coap_transaction_t *t)
 {
   if(t) {
+    int resume = is_confirmable(t) && list_head(nstart_waiters) != NULL;
+
     LOG_DBG("Freeing transaction %u: %p\n", t->mid, t);
 
     coap_timer_stop(&t->retrans_timer);
     list_remove(transactions_list, t);
+    table_remove(t);
     memb_free(&transactions_memb, t);
+
+    if(resume) {
+      /* a confirmable exchange completed, the window has room again */
+      coap_timer_set_callback(&nstart_timer, nstart_resume);
+      coap_timer_set(&nstart_timer, 0);
+    }
   }
 }
 /*---------------------------------------------------------------------------*/
 coap_transaction_t *
 coap_get_transaction_by_mid(uint16_t mid)
 {
-  coap_transaction_t *t = NULL;
+  coap_transaction_t *t;
 
-  for(t = (coap_transaction_t *)list_head(transactions_list); t; t = t->next) {
+  for(t = *table_bucket(mid); t; t = t->table_next) {
     if(t->mid == mid) {
       LOG_DBG("Found transaction for MID %u: %p\n", t->mid, t);
       return t;
@@ -168,4 +404,137 @@ coap_get_transaction_by_mid(uint16_t mid)
   return NULL;
 }
 /*---------------------------------------------------------------------------*/
+coap_transaction_t *
+coap_get_transaction(const coap_endpoint_t *ep, uint16_t mid)
+{
+  coap_transaction_t *t;
+
+  for(t = *table_bucket(mid); t; t = t->table_next) {
+    if(t->mid == mid && coap_endpoint_cmp(&t->endpoint, ep)) {
+      LOG_DBG("Found transaction for MID %u: %p\n", t->mid, t);
+      return t;
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+/* Finds the request a response on a reliable transport belongs to */
+coap_transaction_t *
+coap_get_transaction_by_token(const coap_endpoint_t *ep,
+                              const uint8_t *token, uint8_t token_len)
+{
+  coap_transaction_t *t;
+
+  for(t = list_head(transactions_list); t; t = t->next) {
+    if(t->message_len >= COAP_HEADER_LEN + token_len
+       && (t->message[0] & COAP_HEADER_TOKEN_LEN_MASK) == token_len
+       && memcmp(&t->message[COAP_HEADER_LEN], token, token_len) == 0
+       && coap_endpoint_cmp(&t->endpoint, ep)) {
+      return t;
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+/* Called when the response or ACK for a transaction has arrived */
+void
+coap_transaction_answered(coap_transaction_t *t)
+{
+#if COAP_COCOA
+  /* strong RTT samples come from the first transmission, weak ones from
+     the first two retransmissions, later ones are too ambiguous */
+  if(is_confirmable(t) && t->retrans_counter <= 2) {
+    cocoa_update(&t->endpoint, (uint32_t)coap_timer_uptime() - t->start_time,
+                 t->retrans_counter == 0);
+  }
+#endif /* COAP_COCOA */
+}
+/*---------------------------------------------------------------------------*/
+/*- NSTART window -----------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/* Returns non-zero if another confirmable exchange may start to ep */
+int
+coap_nstart_available(const coap_endpoint_t *ep)
+{
+  coap_transaction_t *t;
+  int outstanding = 0;
+
+  if(coap_endpoint_is_reliable(ep)) {
+    return 1;
+  }
+  for(t = list_head(transactions_list); t; t = t->next) {
+    if(is_confirmable(t) && coap_endpoint_cmp(&t->endpoint, ep)) {
+      outstanding++;
+    }
+  }
+  return outstanding < COAP_NSTART;
+}
+/*---------------------------------------------------------------------------*/
+/* Calls w->resume once an exchange to w->endpoint has completed */
+void
+coap_nstart_wait(coap_nstart_waiter_t *w)
+{
+  list_add(nstart_waiters, w);
+}
+/*---------------------------------------------------------------------------*/
+void
+coap_nstart_cancel(coap_nstart_waiter_t *w)
+{
+  list_remove(nstart_waiters, w);
+}
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*- Duplicate detection -----------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*
+ * Sends the cached response again if a confirmable request with this MID
+ * from this endpoint was answered during the last COAP_DEDUP_LIFETIME
+ * seconds. Returns 1 if the request is a duplicate and has been answered.
+ */
+int
+coap_dedup_resend(const coap_endpoint_t *ep, uint16_t mid)
+{
+#if COAP_DEDUP_CACHE_SIZE
+  coap_dedup_entry_t *e;
+  uint64_t now = coap_timer_uptime();
+
+  for(e = dedup_cache; e < &dedup_cache[COAP_DEDUP_CACHE_SIZE]; e++) {
+    if(e->message_len > 0 && e->expiration_time > now && e->mid == mid
+       && coap_endpoint_cmp(&e->endpoint, ep)) {
+      LOG_INFO("Duplicate request %u, resending response\n", mid);
+      coap_sendto(ep, e->message, e->message_len);
+      return 1;
+    }
+  }
+#endif /* COAP_DEDUP_CACHE_SIZE */
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+/* Keeps the response to a confirmable request, replacing the oldest entry */
+void
+coap_dedup_store(const coap_endpoint_t *ep, uint16_t mid,
+                 const uint8_t *message, uint16_t message_len)
+{
+#if COAP_DEDUP_CACHE_SIZE
+  coap_dedup_entry_t *e;
+  coap_dedup_entry_t *oldest = dedup_cache;
+
+  if(message_len > sizeof(oldest->message)) {
+    return;
+  }
+
+  for(e = dedup_cache; e < &dedup_cache[COAP_DEDUP_CACHE_SIZE]; e++) {
+    if(e->expiration_time < oldest->expiration_time) {
+      oldest = e;
+    }
+  }
+
+  coap_endpoint_copy(&oldest->endpoint, ep);
+  oldest->expiration_time = coap_timer_uptime() + 1000ULL * COAP_DEDUP_LIFETIME;
+  oldest->mid = mid;
+  oldest->message_len = message_len;
+  memcpy(oldest->message, message, message_len);
+#endif /* COAP_DEDUP_CACHE_SIZE */
+}
+/*---------------------------------------------------------------------------*/
 /** @} */
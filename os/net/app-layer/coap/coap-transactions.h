@@ -58,11 +58,15 @@
 /* container for transactions with message buffer and retransmission info */
 typedef struct coap_transaction {
   struct coap_transaction *next;        /* for LIST */
+  struct coap_transaction *table_next;  /* for the MID index */
 
   uint16_t mid;
   coap_timer_t retrans_timer;
   uint32_t retrans_interval;
   uint8_t retrans_counter;
+#if COAP_COCOA
+  uint32_t start_time;  /* first transmission, for RTT samples */
+#endif /* COAP_COCOA */
 
   coap_endpoint_t endpoint;
 
@@ -74,10 +78,33 @@ typedef struct coap_transaction {
                                                  * Use snprintf(buf, len+1, "", ...) to completely fill payload */
 } coap_transaction_t;
 
+/* a request waiting for room in the NSTART window of an endpoint */
+typedef struct coap_nstart_waiter {
+  struct coap_nstart_waiter *next;      /* for LIST */
+  const coap_endpoint_t *endpoint;
+  void (*resume)(void *data);
+  void *data;
+} coap_nstart_waiter_t;
+
 coap_transaction_t *coap_new_transaction(uint16_t mid, const coap_endpoint_t *ep);
 void coap_send_transaction(coap_transaction_t *t);
 void coap_clear_transaction(coap_transaction_t *t);
 coap_transaction_t *coap_get_transaction_by_mid(uint16_t mid);
+coap_transaction_t *coap_get_transaction(const coap_endpoint_t *ep,
+                                         uint16_t mid);
+coap_transaction_t *coap_get_transaction_by_token(const coap_endpoint_t *ep,
+                                                  const uint8_t *token,
+                                                  uint8_t token_len);
+
+void coap_transaction_answered(coap_transaction_t *t);
+
+int coap_nstart_available(const coap_endpoint_t *ep);
+void coap_nstart_wait(coap_nstart_waiter_t *w);
+void coap_nstart_cancel(coap_nstart_waiter_t *w);
+
+int coap_dedup_resend(const coap_endpoint_t *ep, uint16_t mid);
+void coap_dedup_store(const coap_endpoint_t *ep, uint16_t mid,
+                      const uint8_t *message, uint16_t message_len);
 
 #endif /* COAP_TRANSACTIONS_H_ */
 /** @} */
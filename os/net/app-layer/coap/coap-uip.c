@@ -58,6 +58,7 @@
 #include "coap-constants.h"
 #include "coap-keystore.h"
 #include "coap-keystore-simple.h"
+#include "coap-tcp.h"
 
 /* Log configuration */
 #include "coap-log.h"
@@ -107,6 +108,8 @@ coap_endpoint_log(const coap_endpoint_t *ep)
   }
   if(ep->secure) {
     LOG_OUTPUT("coaps://[");
+  } else if(ep->tcp) {
+    LOG_OUTPUT("coap+tcp://[");
   } else {
     LOG_OUTPUT("coap://[");
   }
@@ -123,6 +126,8 @@ coap_endpoint_print(const coap_endpoint_t *ep)
   }
   if(ep->secure) {
     printf("coaps://[");
+  } else if(ep->tcp) {
+    printf("coap+tcp://[");
   } else {
     printf("coap://[");
   }
@@ -142,6 +147,8 @@ coap_endpoint_snprint(char *buf, size_t size, const coap_endpoint_t *ep)
   } else {
     if(ep->secure) {
       n = snprintf(buf, size - 1, "coaps://[");
+    } else if(ep->tcp) {
+      n = snprintf(buf, size - 1, "coap+tcp://[");
     } else {
       n = snprintf(buf, size - 1, "coap://[");
     }
@@ -165,6 +172,7 @@ coap_endpoint_copy(coap_endpoint_t *destination,
   uip_ipaddr_copy(&destination->ipaddr, &from->ipaddr);
   destination->port = from->port;
   destination->secure = from->secure;
+  destination->tcp = from->tcp;
 }
 /*---------------------------------------------------------------------------*/
 int
@@ -173,7 +181,8 @@ coap_endpoint_cmp(const coap_endpoint_t *e1, const coap_endpoint_t *e2)
   if(!uip_ipaddr_cmp(&e1->ipaddr, &e2->ipaddr)) {
     return 0;
   }
-  return e1->port == e2->port && e1->secure == e2->secure;
+  return e1->port == e2->port && e1->secure == e2->secure
+    && e1->tcp == e2->tcp;
 }
 /*---------------------------------------------------------------------------*/
 static int
@@ -214,6 +223,7 @@ coap_endpoint_parse(const char *text, size_t size, coap_endpoint_t *ep)
   uint32_t port;
 
   ep->secure = strncmp(text, "coaps:", 6) == 0;
+  ep->tcp = COAP_TCP && strncmp(text, "coap+tcp:", 9) == 0;
   if(start >= 0 && end > start &&
      uiplib_ipaddrconv(&text[start], &ep->ipaddr)) {
     if(text[end + 1] == ':' &&
@@ -245,6 +255,7 @@ get_src_endpoint(uint8_t secure)
   uip_ipaddr_copy(&src.ipaddr, &UIP_IP_BUF->srcipaddr);
   src.port = UIP_UDP_BUF->srcport;
   src.secure = secure;
+  src.tcp = 0;
   return &src;
 }
 /*---------------------------------------------------------------------------*/
@@ -255,6 +266,12 @@ coap_endpoint_is_secure(const coap_endpoint_t *ep)
 }
 /*---------------------------------------------------------------------------*/
 int
+coap_endpoint_is_reliable(const coap_endpoint_t *ep)
+{
+  return COAP_TCP && ep->tcp;
+}
+/*---------------------------------------------------------------------------*/
+int
 coap_endpoint_is_connected(const coap_endpoint_t *ep)
 {
 #ifndef CONTIKI_TARGET_NATIVE
@@ -264,6 +281,12 @@ coap_endpoint_is_connected(const coap_endpoint_t *ep)
   }
 #endif
 
+#if COAP_TCP
+  if(ep != NULL && ep->tcp) {
+    return coap_tcp_is_connected(ep);
+  }
+#endif /* COAP_TCP */
+
 #ifdef WITH_DTLS
   if(ep != NULL && ep->secure != 0) {
     dtls_peer_t *peer;
@@ -294,6 +317,12 @@ coap_endpoint_is_connected(const coap_endpoint_t *ep)
 int
 coap_endpoint_connect(coap_endpoint_t *ep)
 {
+#if COAP_TCP
+  if(ep->tcp) {
+    return coap_tcp_connect(ep);
+  }
+#endif /* COAP_TCP */
+
   if(ep->secure == 0) {
     LOG_DBG("connect to ");
     LOG_DBG_COAP_EP(ep);
@@ -319,6 +348,11 @@ coap_endpoint_connect(coap_endpoint_t *ep)
 void
 coap_endpoint_disconnect(coap_endpoint_t *ep)
 {
+#if COAP_TCP
+  if(ep && ep->tcp) {
+    coap_tcp_disconnect(ep);
+  }
+#endif /* COAP_TCP */
 #ifdef WITH_DTLS
   if(ep && ep->secure && dtls_context) {
     dtls_close(dtls_context, ep);
@@ -381,6 +415,13 @@ coap_sendto(const coap_endpoint_t *ep, const uint8_t *data, uint16_t length)
     return -1;
   }
 
+#if COAP_TCP
+  if(ep->tcp) {
+    /* connects first if needed */
+    return coap_tcp_sendto(ep, data, length);
+  }
+#endif /* COAP_TCP */
+
   if(!coap_endpoint_is_connected(ep)) {
     LOG_WARN("endpoint ");
     LOG_WARN_COAP_EP(ep);
@@ -425,6 +466,10 @@ PROCESS_THREAD(coap_engine, ev, data)
   udp_bind(udp_conn, SERVER_LISTEN_PORT);
   LOG_INFO("Listening on port %u\n", uip_ntohs(udp_conn->lport));
 
+#if COAP_TCP
+  coap_tcp_init();
+#endif /* COAP_TCP */
+
 #ifdef WITH_DTLS
   /* create new context with app-data */
   dtls_conn = udp_new(NULL, 0, NULL);
@@ -45,6 +45,7 @@
  */
 
 
+#include <stddef.h>
 #include <string.h>
 #include <stdlib.h>
 #include "sys/cc.h"
@@ -64,6 +65,21 @@ static uint16_t current_mid = 0;
 
 coap_status_t coap_status_code = NO_ERROR;
 const char *coap_error_message = "";
+
+/* options decoded on first access: slot + 1, 0 for all other options */
+static const uint8_t option_slot[COAP_OPTION_SIZE1 + 1] = {
+  [COAP_OPTION_IF_MATCH] = COAP_SLOT_IF_MATCH + 1,
+  [COAP_OPTION_ETAG] = COAP_SLOT_ETAG + 1,
+  [COAP_OPTION_OBSERVE] = COAP_SLOT_OBSERVE + 1,
+  [COAP_OPTION_URI_PORT] = COAP_SLOT_URI_PORT + 1,
+  [COAP_OPTION_CONTENT_FORMAT] = COAP_SLOT_CONTENT_FORMAT + 1,
+  [COAP_OPTION_MAX_AGE] = COAP_SLOT_MAX_AGE + 1,
+  [COAP_OPTION_ACCEPT] = COAP_SLOT_ACCEPT + 1,
+  [COAP_OPTION_BLOCK2] = COAP_SLOT_BLOCK2 + 1,
+  [COAP_OPTION_BLOCK1] = COAP_SLOT_BLOCK1 + 1,
+  [COAP_OPTION_SIZE2] = COAP_SLOT_SIZE2 + 1,
+  [COAP_OPTION_SIZE1] = COAP_SLOT_SIZE1 + 1,
+};
 /*---------------------------------------------------------------------------*/
 /*- Local helper functions --------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
@@ -219,7 +235,7 @@ coap_serialize_array_option(unsigned int number, unsigned int current_number,
 }
 /*---------------------------------------------------------------------------*/
 static void
-coap_merge_multi_option(char **dst, size_t *dst_len, uint8_t *option,
+coap_merge_multi_option(char **dst, uint16_t *dst_len, uint8_t *option,
                         size_t option_len, char separator)
 {
   /* merge multiple options */
@@ -239,6 +255,91 @@ coap_merge_multi_option(char **dst, size_t *dst_len, uint8_t *option,
   }
 }
 /*---------------------------------------------------------------------------*/
+/* Decodes an option that coap_parse_message() left in the buffer */
+void
+coap_decode_option(coap_message_t *coap_pkt, unsigned int number)
+{
+  const unsigned int slot = option_slot[number] - 1;
+  uint8_t *value = coap_pkt->buffer + coap_pkt->option_offset[slot] - 1;
+  size_t length = coap_pkt->option_len[slot];
+
+  coap_pkt->option_offset[slot] = 0;
+
+  switch(number) {
+  case COAP_OPTION_CONTENT_FORMAT:
+    coap_pkt->content_format = coap_parse_int_option(value, length);
+    LOG_DBG("Content-Format [%u]\n", coap_pkt->content_format);
+    break;
+  case COAP_OPTION_MAX_AGE:
+    coap_pkt->max_age = coap_parse_int_option(value, length);
+    LOG_DBG("Max-Age [%"PRIu32"]\n", coap_pkt->max_age);
+    break;
+  case COAP_OPTION_ETAG:
+    coap_pkt->etag_len = MIN(COAP_ETAG_LEN, length);
+    memcpy(coap_pkt->etag, value, coap_pkt->etag_len);
+    LOG_DBG("ETag %u [0x%02X%02X%02X%02X%02X%02X%02X%02X]\n",
+            coap_pkt->etag_len, coap_pkt->etag[0], coap_pkt->etag[1],
+            coap_pkt->etag[2], coap_pkt->etag[3], coap_pkt->etag[4],
+            coap_pkt->etag[5], coap_pkt->etag[6], coap_pkt->etag[7]
+            );                 /*FIXME always prints 8 bytes */
+    break;
+  case COAP_OPTION_ACCEPT:
+    coap_pkt->accept = coap_parse_int_option(value, length);
+    LOG_DBG("Accept [%u]\n", coap_pkt->accept);
+    break;
+  case COAP_OPTION_IF_MATCH:
+    /* TODO support multiple ETags */
+    coap_pkt->if_match_len = MIN(COAP_ETAG_LEN, length);
+    memcpy(coap_pkt->if_match, value, coap_pkt->if_match_len);
+    LOG_DBG("If-Match %u [0x%02X%02X%02X%02X%02X%02X%02X%02X]\n",
+            coap_pkt->if_match_len, coap_pkt->if_match[0],
+            coap_pkt->if_match[1], coap_pkt->if_match[2],
+            coap_pkt->if_match[3], coap_pkt->if_match[4],
+            coap_pkt->if_match[5], coap_pkt->if_match[6],
+            coap_pkt->if_match[7]
+            ); /* FIXME always prints 8 bytes */
+    break;
+  case COAP_OPTION_URI_PORT:
+    coap_pkt->uri_port = coap_parse_int_option(value, length);
+    LOG_DBG("Uri-Port [%u]\n", coap_pkt->uri_port);
+    break;
+  case COAP_OPTION_OBSERVE:
+    coap_pkt->observe = coap_parse_int_option(value, length);
+    LOG_DBG("Observe [%"PRId32"]\n", coap_pkt->observe);
+    break;
+  case COAP_OPTION_BLOCK2:
+    coap_pkt->block2 = coap_parse_int_option(value, length);
+    LOG_DBG("Block2 [%lu%s (%u B/blk)]\n",
+            (unsigned long)(coap_pkt->block2 >> 4),
+            (coap_pkt->block2 & 0x08) ? "+" : "",
+            16 << (coap_pkt->block2 & 0x07));
+    break;
+  case COAP_OPTION_BLOCK1:
+    coap_pkt->block1 = coap_parse_int_option(value, length);
+    LOG_DBG("Block1 [%lu%s (%u B/blk)]\n",
+            (unsigned long)(coap_pkt->block1 >> 4),
+            (coap_pkt->block1 & 0x08) ? "+" : "",
+            16 << (coap_pkt->block1 & 0x07));
+    break;
+  case COAP_OPTION_SIZE2:
+    coap_pkt->size2 = coap_parse_int_option(value, length);
+    LOG_DBG("Size2 [%"PRIu32"]\n", coap_pkt->size2);
+    break;
+  case COAP_OPTION_SIZE1:
+    coap_pkt->size1 = coap_parse_int_option(value, length);
+    LOG_DBG("Size1 [%"PRIu32"]\n", coap_pkt->size1);
+    break;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+coap_set_decoded_option(coap_message_t *coap_pkt, unsigned int number)
+{
+  /* the value set by the application replaces the one in the buffer */
+  coap_pkt->option_offset[option_slot[number] - 1] = 0;
+  coap_set_option(coap_pkt, number);
+}
+/*---------------------------------------------------------------------------*/
 static int
 coap_get_variable(const char *buffer, size_t length, const char *name,
                   const char **output)
@@ -307,6 +408,9 @@ coap_serialize_message(coap_message_t *coap_pkt, uint8_t *buffer)
   uint8_t *option;
   unsigned int current_number = 0;
 
+  /* options of a parsed message must be read before the buffer changes */
+  coap_decode_options(coap_pkt);
+
   /* Initialize */
   coap_pkt->buffer = buffer;
   coap_pkt->version = 1;
@@ -414,8 +518,8 @@ coap_serialize_message(coap_message_t *coap_pkt, uint8_t *buffer)
 coap_status_t
 coap_parse_message(coap_message_t *coap_pkt, uint8_t *data, uint16_t data_len)
 {
-  /* initialize message */
-  memset(coap_pkt, 0, sizeof(coap_message_t));
+  /* initialize message, option values are written when decoded */
+  memset(coap_pkt, 0, offsetof(coap_message_t, content_format));
 
   /* pointer to message bytes */
   coap_pkt->buffer = data;
@@ -449,18 +553,18 @@ coap_parse_message(coap_message_t *coap_pkt, uint8_t *data, uint16_t data_len)
           coap_pkt->token[5], coap_pkt->token[6], coap_pkt->token[7]
           );                     /* FIXME always prints 8 bytes */
 
-  /* parse options */
-  memset(coap_pkt->options, 0, sizeof(coap_pkt->options));
+  /* validate the options, set the strings and record where the other values are */
   current_option += coap_pkt->token_len;
 
   unsigned int option_number = 0;
   unsigned int option_delta = 0;
   size_t option_length = 0;
+  unsigned int slot;
 
   while(current_option < data + data_len) {
     /* payload marker 0xFF, currently only checking for 0xF* because rest is reserved */
     if((current_option[0] & 0xF0) == 0xF0) {
-      coap_pkt->payload = ++current_option;
+      coap_pkt->payload = current_option + 1;
       coap_pkt->payload_len = data_len - (coap_pkt->payload - data);
 
       /* also for receiving, the Erbium upper bound is COAP_MAX_CHUNK_SIZE */
@@ -514,180 +618,135 @@ coap_parse_message(coap_message_t *coap_pkt, uint8_t *data, uint16_t data_len)
       return BAD_REQUEST_4_00;
     }
 
-    LOG_DBG("OPTION %u (delta %u, len %zu): ", option_number, option_delta,
+    LOG_DBG("OPTION %u (delta %u, len %zu)\n", option_number, option_delta,
             option_length);
 
-    coap_set_option(coap_pkt, option_number);
-
-    switch(option_number) {
-    case COAP_OPTION_CONTENT_FORMAT:
-      coap_pkt->content_format = coap_parse_int_option(current_option,
-                                                       option_length);
-      LOG_DBG_("Content-Format [%u]\n", coap_pkt->content_format);
-      break;
-    case COAP_OPTION_MAX_AGE:
-      coap_pkt->max_age = coap_parse_int_option(current_option,
-                                                option_length);
-      LOG_DBG_("Max-Age [%"PRIu32"]\n", coap_pkt->max_age);
-      break;
-    case COAP_OPTION_ETAG:
-      coap_pkt->etag_len = MIN(COAP_ETAG_LEN, option_length);
-      memcpy(coap_pkt->etag, current_option, coap_pkt->etag_len);
-      LOG_DBG_("ETag %u [0x%02X%02X%02X%02X%02X%02X%02X%02X]\n",
-               coap_pkt->etag_len, coap_pkt->etag[0], coap_pkt->etag[1],
-               coap_pkt->etag[2], coap_pkt->etag[3], coap_pkt->etag[4],
-               coap_pkt->etag[5], coap_pkt->etag[6], coap_pkt->etag[7]
-               );                 /*FIXME always prints 8 bytes */
-      break;
-    case COAP_OPTION_ACCEPT:
-      coap_pkt->accept = coap_parse_int_option(current_option, option_length);
-      LOG_DBG_("Accept [%u]\n", coap_pkt->accept);
-      break;
-    case COAP_OPTION_IF_MATCH:
-      /* TODO support multiple ETags */
-      coap_pkt->if_match_len = MIN(COAP_ETAG_LEN, option_length);
-      memcpy(coap_pkt->if_match, current_option, coap_pkt->if_match_len);
-      LOG_DBG_("If-Match %u [0x%02X%02X%02X%02X%02X%02X%02X%02X]\n",
-               coap_pkt->if_match_len, coap_pkt->if_match[0],
-               coap_pkt->if_match[1], coap_pkt->if_match[2],
-               coap_pkt->if_match[3], coap_pkt->if_match[4],
-               coap_pkt->if_match[5], coap_pkt->if_match[6],
-               coap_pkt->if_match[7]
-               ); /* FIXME always prints 8 bytes */
-      break;
-    case COAP_OPTION_IF_NONE_MATCH:
-      coap_pkt->if_none_match = 1;
-      LOG_DBG_("If-None-Match\n");
-      break;
+    slot = option_slot[option_number];
+    if(slot) {
+      /* the last one of repeated options is used, as if decoded in turn */
+      coap_pkt->option_offset[slot - 1] = current_option - data + 1;
+      coap_pkt->option_len[slot - 1] = MIN(option_length, UINT8_MAX);
+      coap_set_option(coap_pkt, option_number);
+    } else {
+      coap_set_option(coap_pkt, option_number);
+
+      switch(option_number) {
+      case COAP_OPTION_IF_NONE_MATCH:
+        LOG_DBG("If-None-Match\n");
+        break;
+
+      /* the strings are set right away, repeated ones follow with delta 0 */
+      case COAP_OPTION_URI_HOST:
+        coap_pkt->uri_host = (char *)current_option;
+        coap_pkt->uri_host_len = option_length;
+        LOG_DBG("Uri-Host [");
+        LOG_DBG_COAP_STRING(coap_pkt->uri_host, coap_pkt->uri_host_len);
+        LOG_DBG_("]\n");
+        break;
+      case COAP_OPTION_URI_PATH:
+        if(option_delta != 0) {
+          coap_pkt->uri_path_len = 0;
+        }
+        /* coap_merge_multi_option() operates in-place on the IPBUF, but final message field should be const string -> cast to string */
+        coap_merge_multi_option((char **)&(coap_pkt->uri_path),
+                                &(coap_pkt->uri_path_len), current_option,
+                                option_length, '/');
+        LOG_DBG("Uri-Path [");
+        LOG_DBG_COAP_STRING(coap_pkt->uri_path, coap_pkt->uri_path_len);
+        LOG_DBG_("]\n");
+        break;
+      case COAP_OPTION_URI_QUERY:
+        if(option_delta != 0) {
+          coap_pkt->uri_query_len = 0;
+        }
+        /* coap_merge_multi_option() operates in-place on the IPBUF, but final message field should be const string -> cast to string */
+        coap_merge_multi_option((char **)&(coap_pkt->uri_query),
+                                &(coap_pkt->uri_query_len), current_option,
+                                option_length, '&');
+        LOG_DBG("Uri-Query [");
+        LOG_DBG_COAP_STRING(coap_pkt->uri_query, coap_pkt->uri_query_len);
+        LOG_DBG_("]\n");
+        break;
+      case COAP_OPTION_LOCATION_PATH:
+        if(option_delta != 0) {
+          coap_pkt->location_path_len = 0;
+        }
+        /* coap_merge_multi_option() operates in-place on the IPBUF, but final message field should be const string -> cast to string */
+        coap_merge_multi_option((char **)&(coap_pkt->location_path),
+                                &(coap_pkt->location_path_len), current_option,
+                                option_length, '/');
+        LOG_DBG("Location-Path [");
+        LOG_DBG_COAP_STRING(coap_pkt->location_path, coap_pkt->location_path_len);
+        LOG_DBG_("]\n");
+        break;
+      case COAP_OPTION_LOCATION_QUERY:
+        if(option_delta != 0) {
+          coap_pkt->location_query_len = 0;
+        }
+        /* coap_merge_multi_option() operates in-place on the IPBUF, but final message field should be const string -> cast to string */
+        coap_merge_multi_option((char **)&(coap_pkt->location_query),
+                                &(coap_pkt->location_query_len), current_option,
+                                option_length, '&');
+        LOG_DBG("Location-Query [");
+        LOG_DBG_COAP_STRING(coap_pkt->location_query, coap_pkt->location_query_len);
+        LOG_DBG_("]\n");
+        break;
 
-    case COAP_OPTION_PROXY_URI:
+      case COAP_OPTION_PROXY_URI:
 #if COAP_PROXY_OPTION_PROCESSING
-      coap_pkt->proxy_uri = (char *)current_option;
-      coap_pkt->proxy_uri_len = option_length;
+        coap_pkt->proxy_uri = (char *)current_option;
+        coap_pkt->proxy_uri_len = option_length;
 #endif /* COAP_PROXY_OPTION_PROCESSING */
-      LOG_DBG_("Proxy-Uri NOT IMPLEMENTED [");
-      LOG_DBG_COAP_STRING(coap_pkt->proxy_uri, coap_pkt->proxy_uri_len);
-      LOG_DBG_("]\n");
+        LOG_DBG("Proxy-Uri NOT IMPLEMENTED [");
+        LOG_DBG_COAP_STRING((const char *)current_option, option_length);
+        LOG_DBG_("]\n");
 
-      coap_error_message = "This is a constrained server (Contiki)";
-      return PROXYING_NOT_SUPPORTED_5_05;
-      break;
-    case COAP_OPTION_PROXY_SCHEME:
+        coap_error_message = "This is a constrained server (Contiki)";
+        return PROXYING_NOT_SUPPORTED_5_05;
+        break;
+      case COAP_OPTION_PROXY_SCHEME:
 #if COAP_PROXY_OPTION_PROCESSING
-      coap_pkt->proxy_scheme = (char *)current_option;
-      coap_pkt->proxy_scheme_len = option_length;
+        coap_pkt->proxy_scheme = (char *)current_option;
+        coap_pkt->proxy_scheme_len = option_length;
 #endif
-      LOG_DBG_("Proxy-Scheme NOT IMPLEMENTED [");
-      LOG_DBG_COAP_STRING(coap_pkt->proxy_scheme, coap_pkt->proxy_scheme_len);
-      LOG_DBG_("]\n");
-      coap_error_message = "This is a constrained server (Contiki)";
-      return PROXYING_NOT_SUPPORTED_5_05;
-      break;
-
-    case COAP_OPTION_URI_HOST:
-      coap_pkt->uri_host = (char *)current_option;
-      coap_pkt->uri_host_len = option_length;
-      LOG_DBG_("Uri-Host [");
-      LOG_DBG_COAP_STRING(coap_pkt->uri_host, coap_pkt->uri_host_len);
-      LOG_DBG_("]\n");
-      break;
-    case COAP_OPTION_URI_PORT:
-      coap_pkt->uri_port = coap_parse_int_option(current_option,
-                                                 option_length);
-      LOG_DBG_("Uri-Port [%u]\n", coap_pkt->uri_port);
-      break;
-    case COAP_OPTION_URI_PATH:
-      /* coap_merge_multi_option() operates in-place on the IPBUF, but final message field should be const string -> cast to string */
-      coap_merge_multi_option((char **)&(coap_pkt->uri_path),
-                              &(coap_pkt->uri_path_len), current_option,
-                              option_length, '/');
-      LOG_DBG_("Uri-Path [");
-      LOG_DBG_COAP_STRING(coap_pkt->uri_path, coap_pkt->uri_path_len);
-      LOG_DBG_("]\n");
-      break;
-    case COAP_OPTION_URI_QUERY:
-      /* coap_merge_multi_option() operates in-place on the IPBUF, but final message field should be const string -> cast to string */
-      coap_merge_multi_option((char **)&(coap_pkt->uri_query),
-                              &(coap_pkt->uri_query_len), current_option,
-                              option_length, '&');
-      LOG_DBG_("Uri-Query[");
-      LOG_DBG_COAP_STRING(coap_pkt->uri_query, coap_pkt->uri_query_len);
-      LOG_DBG_("]\n");
-      break;
-
-    case COAP_OPTION_LOCATION_PATH:
-      /* coap_merge_multi_option() operates in-place on the IPBUF, but final message field should be const string -> cast to string */
-      coap_merge_multi_option((char **)&(coap_pkt->location_path),
-                              &(coap_pkt->location_path_len), current_option,
-                              option_length, '/');
-
-      LOG_DBG_("Location-Path [");
-      LOG_DBG_COAP_STRING(coap_pkt->location_path, coap_pkt->location_path_len);
-      LOG_DBG_("]\n");
-      break;
-    case COAP_OPTION_LOCATION_QUERY:
-      /* coap_merge_multi_option() operates in-place on the IPBUF, but final message field should be const string -> cast to string */
-      coap_merge_multi_option((char **)&(coap_pkt->location_query),
-                              &(coap_pkt->location_query_len), current_option,
-                              option_length, '&');
-      LOG_DBG_("Location-Query [");
-      LOG_DBG_COAP_STRING(coap_pkt->location_query, coap_pkt->location_query_len);
-      LOG_DBG_("]\n");
-      break;
-
-    case COAP_OPTION_OBSERVE:
-      coap_pkt->observe = coap_parse_int_option(current_option,
-                                                option_length);
-      LOG_DBG_("Observe [%"PRId32"]\n", coap_pkt->observe);
-      break;
-    case COAP_OPTION_BLOCK2:
-      coap_pkt->block2_num = coap_parse_int_option(current_option,
-                                                   option_length);
-      coap_pkt->block2_more = (coap_pkt->block2_num & 0x08) >> 3;
-      coap_pkt->block2_size = 16 << (coap_pkt->block2_num & 0x07);
-      coap_pkt->block2_offset = (coap_pkt->block2_num & ~0x0000000F)
-        << (coap_pkt->block2_num & 0x07);
-      coap_pkt->block2_num >>= 4;
-      LOG_DBG_("Block2 [%lu%s (%u B/blk)]\n",
-               (unsigned long)coap_pkt->block2_num,
-               coap_pkt->block2_more ? "+" : "", coap_pkt->block2_size);
-      break;
-    case COAP_OPTION_BLOCK1:
-      coap_pkt->block1_num = coap_parse_int_option(current_option,
-                                                   option_length);
-      coap_pkt->block1_more = (coap_pkt->block1_num & 0x08) >> 3;
-      coap_pkt->block1_size = 16 << (coap_pkt->block1_num & 0x07);
-      coap_pkt->block1_offset = (coap_pkt->block1_num & ~0x0000000F)
-        << (coap_pkt->block1_num & 0x07);
-      coap_pkt->block1_num >>= 4;
-      LOG_DBG_("Block1 [%lu%s (%u B/blk)]\n",
-               (unsigned long)coap_pkt->block1_num,
-               coap_pkt->block1_more ? "+" : "", coap_pkt->block1_size);
-      break;
-    case COAP_OPTION_SIZE2:
-      coap_pkt->size2 = coap_parse_int_option(current_option, option_length);
-      LOG_DBG_("Size2 [%"PRIu32"]\n", coap_pkt->size2);
-      break;
-    case COAP_OPTION_SIZE1:
-      coap_pkt->size1 = coap_parse_int_option(current_option, option_length);
-      LOG_DBG_("Size1 [%"PRIu32"]\n", coap_pkt->size1);
-      break;
-    default:
-      LOG_DBG_("unknown (%u)\n", option_number);
-      /* check if critical (odd) */
-      if(option_number & 1) {
-        coap_error_message = "Unsupported critical option";
-        return BAD_OPTION_4_02;
+        LOG_DBG("Proxy-Scheme NOT IMPLEMENTED [");
+        LOG_DBG_COAP_STRING((const char *)current_option, option_length);
+        LOG_DBG_("]\n");
+        coap_error_message = "This is a constrained server (Contiki)";
+        return PROXYING_NOT_SUPPORTED_5_05;
+        break;
+
+      default:
+        LOG_DBG("unknown (%u)\n", option_number);
+        /* check if critical (odd) */
+        if(option_number & 1) {
+          coap_error_message = "Unsupported critical option";
+          return BAD_OPTION_4_02;
+        }
       }
     }
 
     current_option += option_length;
   }                             /* for */
+
   LOG_DBG("-Done parsing-------\n");
 
   return NO_ERROR;
 }
 /*---------------------------------------------------------------------------*/
+void
+coap_decode_options(coap_message_t *coap_pkt)
+{
+  unsigned int number;
+
+  for(number = 0; number <= COAP_OPTION_SIZE1; number++) {
+    if(option_slot[number]
+       && coap_pkt->option_offset[option_slot[number] - 1] != 0) {
+      coap_decode_option(coap_pkt, number);
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
 /*- CoAP Engine API ---------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
 int
@@ -734,92 +793,47 @@ coap_set_token(coap_message_t *coap_pkt, const uint8_t *token, size_t token_len)
 /*- CoAP Implementation API -------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
 int
-coap_get_header_content_format(coap_message_t *coap_pkt, unsigned int *format)
-{
-  if(!coap_is_option(coap_pkt, COAP_OPTION_CONTENT_FORMAT)) {
-    return 0;
-  }
-  *format = coap_pkt->content_format;
-  return 1;
-}
-int
 coap_set_header_content_format(coap_message_t *coap_pkt, unsigned int format)
 {
   coap_pkt->content_format = format;
-  coap_set_option(coap_pkt, COAP_OPTION_CONTENT_FORMAT);
+  coap_set_decoded_option(coap_pkt, COAP_OPTION_CONTENT_FORMAT);
   return 1;
 }
 /*---------------------------------------------------------------------------*/
 int
-coap_get_header_accept(coap_message_t *coap_pkt, unsigned int *accept)
-{
-  if(!coap_is_option(coap_pkt, COAP_OPTION_ACCEPT)) {
-    return 0;
-  }
-  *accept = coap_pkt->accept;
-  return 1;
-}
-int
 coap_set_header_accept(coap_message_t *coap_pkt, unsigned int accept)
 {
   coap_pkt->accept = accept;
-  coap_set_option(coap_pkt, COAP_OPTION_ACCEPT);
+  coap_set_decoded_option(coap_pkt, COAP_OPTION_ACCEPT);
   return 1;
 }
 /*---------------------------------------------------------------------------*/
 int
-coap_get_header_max_age(coap_message_t *coap_pkt, uint32_t *age)
-{
-  if(!coap_is_option(coap_pkt, COAP_OPTION_MAX_AGE)) {
-    *age = COAP_DEFAULT_MAX_AGE;
-  } else {
-    *age = coap_pkt->max_age;
-  } return 1;
-}
-int
 coap_set_header_max_age(coap_message_t *coap_pkt, uint32_t age)
 {
   coap_pkt->max_age = age;
-  coap_set_option(coap_pkt, COAP_OPTION_MAX_AGE);
+  coap_set_decoded_option(coap_pkt, COAP_OPTION_MAX_AGE);
   return 1;
 }
 /*---------------------------------------------------------------------------*/
 int
-coap_get_header_etag(coap_message_t *coap_pkt, const uint8_t **etag)
-{
-  if(!coap_is_option(coap_pkt, COAP_OPTION_ETAG)) {
-    return 0;
-  }
-  *etag = coap_pkt->etag;
-  return coap_pkt->etag_len;
-}
-int
 coap_set_header_etag(coap_message_t *coap_pkt, const uint8_t *etag, size_t etag_len)
 {
   coap_pkt->etag_len = MIN(COAP_ETAG_LEN, etag_len);
   memcpy(coap_pkt->etag, etag, coap_pkt->etag_len);
 
-  coap_set_option(coap_pkt, COAP_OPTION_ETAG);
+  coap_set_decoded_option(coap_pkt, COAP_OPTION_ETAG);
   return coap_pkt->etag_len;
 }
 /*---------------------------------------------------------------------------*/
 /*FIXME support multiple ETags */
 int
-coap_get_header_if_match(coap_message_t *coap_pkt, const uint8_t **etag)
-{
-  if(!coap_is_option(coap_pkt, COAP_OPTION_IF_MATCH)) {
-    return 0;
-  }
-  *etag = coap_pkt->if_match;
-  return coap_pkt->if_match_len;
-}
-int
 coap_set_header_if_match(coap_message_t *coap_pkt, const uint8_t *etag, size_t etag_len)
 {
   coap_pkt->if_match_len = MIN(COAP_ETAG_LEN, etag_len);
   memcpy(coap_pkt->if_match, etag, coap_pkt->if_match_len);
 
-  coap_set_option(coap_pkt, COAP_OPTION_IF_MATCH);
+  coap_set_decoded_option(coap_pkt, COAP_OPTION_IF_MATCH);
   return coap_pkt->if_match_len;
 }
 /*---------------------------------------------------------------------------*/
@@ -857,15 +871,6 @@ coap_set_header_proxy_uri(coap_message_t *coap_pkt, const char *uri)
 }
 /*---------------------------------------------------------------------------*/
 int
-coap_get_header_uri_host(coap_message_t *coap_pkt, const char **host)
-{
-  if(!coap_is_option(coap_pkt, COAP_OPTION_URI_HOST)) {
-    return 0;
-  }
-  *host = coap_pkt->uri_host;
-  return coap_pkt->uri_host_len;
-}
-int
 coap_set_header_uri_host(coap_message_t *coap_pkt, const char *host)
 {
   coap_pkt->uri_host = host;
@@ -876,15 +881,6 @@ coap_set_header_uri_host(coap_message_t *coap_pkt, const char *host)
 }
 /*---------------------------------------------------------------------------*/
 int
-coap_get_header_uri_path(coap_message_t *coap_pkt, const char **path)
-{
-  if(!coap_is_option(coap_pkt, COAP_OPTION_URI_PATH)) {
-    return 0;
-  }
-  *path = coap_pkt->uri_path;
-  return coap_pkt->uri_path_len;
-}
-int
 coap_set_header_uri_path(coap_message_t *coap_pkt, const char *path)
 {
   while(path[0] == '/') {
@@ -899,15 +895,6 @@ coap_set_header_uri_path(coap_message_t *coap_pkt, const char *path)
 }
 /*---------------------------------------------------------------------------*/
 int
-coap_get_header_uri_query(coap_message_t *coap_pkt, const char **query)
-{
-  if(!coap_is_option(coap_pkt, COAP_OPTION_URI_QUERY)) {
-    return 0;
-  }
-  *query = coap_pkt->uri_query;
-  return coap_pkt->uri_query_len;
-}
-int
 coap_set_header_uri_query(coap_message_t *coap_pkt, const char *query)
 {
   while(query[0] == '?') {
@@ -922,15 +909,6 @@ coap_set_header_uri_query(coap_message_t *coap_pkt, const char *query)
 }
 /*---------------------------------------------------------------------------*/
 int
-coap_get_header_location_path(coap_message_t *coap_pkt, const char **path)
-{
-  if(!coap_is_option(coap_pkt, COAP_OPTION_LOCATION_PATH)) {
-    return 0;
-  }
-  *path = coap_pkt->location_path;
-  return coap_pkt->location_path_len;
-}
-int
 coap_set_header_location_path(coap_message_t *coap_pkt, const char *path)
 {
   char *query;
@@ -953,15 +931,6 @@ coap_set_header_location_path(coap_message_t *coap_pkt, const char *path)
 }
 /*---------------------------------------------------------------------------*/
 int
-coap_get_header_location_query(coap_message_t *coap_pkt, const char **query)
-{
-  if(!coap_is_option(coap_pkt, COAP_OPTION_LOCATION_QUERY)) {
-    return 0;
-  }
-  *query = coap_pkt->location_query;
-  return coap_pkt->location_query_len;
-}
-int
 coap_set_header_location_query(coap_message_t *coap_pkt, const char *query)
 {
   while(query[0] == '?') {
@@ -976,19 +945,10 @@ coap_set_header_location_query(coap_message_t *coap_pkt, const char *query)
 }
 /*---------------------------------------------------------------------------*/
 int
-coap_get_header_observe(coap_message_t *coap_pkt, uint32_t *observe)
-{
-  if(!coap_is_option(coap_pkt, COAP_OPTION_OBSERVE)) {
-    return 0;
-  }
-  *observe = coap_pkt->observe;
-  return 1;
-}
-int
 coap_set_header_observe(coap_message_t *coap_pkt, uint32_t observe)
 {
   coap_pkt->observe = observe;
-  coap_set_option(coap_pkt, COAP_OPTION_OBSERVE);
+  coap_set_decoded_option(coap_pkt, COAP_OPTION_OBSERVE);
   return 1;
 }
 /*---------------------------------------------------------------------------*/
@@ -996,21 +956,21 @@ int
 coap_get_header_block2(coap_message_t *coap_pkt, uint32_t *num, uint8_t *more,
                        uint16_t *size, uint32_t *offset)
 {
-  if(!coap_is_option(coap_pkt, COAP_OPTION_BLOCK2)) {
+  if(!COAP_GET_OPTION(coap_pkt, COAP_OPTION_BLOCK2, COAP_SLOT_BLOCK2)) {
     return 0;
   }
   /* pointers may be NULL to get only specific block parameters */
   if(num != NULL) {
-    *num = coap_pkt->block2_num;
+    *num = coap_pkt->block2 >> 4;
   }
   if(more != NULL) {
-    *more = coap_pkt->block2_more;
+    *more = (coap_pkt->block2 & 0x08) >> 3;
   }
   if(size != NULL) {
-    *size = coap_pkt->block2_size;
+    *size = 16 << (coap_pkt->block2 & 0x07);
   }
   if(offset != NULL) {
-    *offset = coap_pkt->block2_offset;
+    *offset = (coap_pkt->block2 & ~0x0000000F) << (coap_pkt->block2 & 0x07);
   }
   return 1;
 }
@@ -1027,11 +987,9 @@ coap_set_header_block2(coap_message_t *coap_pkt, uint32_t num, uint8_t more,
   if(num > 0x0FFFFF) {
     return 0;
   }
-  coap_pkt->block2_num = num;
-  coap_pkt->block2_more = more ? 1 : 0;
-  coap_pkt->block2_size = size;
+  coap_pkt->block2 = num << 4 | (more ? 0x08 : 0) | coap_log_2(size / 16);
 
-  coap_set_option(coap_pkt, COAP_OPTION_BLOCK2);
+  coap_set_decoded_option(coap_pkt, COAP_OPTION_BLOCK2);
   return 1;
 }
 /*---------------------------------------------------------------------------*/
@@ -1039,21 +997,21 @@ int
 coap_get_header_block1(coap_message_t *coap_pkt, uint32_t *num, uint8_t *more,
                        uint16_t *size, uint32_t *offset)
 {
-  if(!coap_is_option(coap_pkt, COAP_OPTION_BLOCK1)) {
+  if(!COAP_GET_OPTION(coap_pkt, COAP_OPTION_BLOCK1, COAP_SLOT_BLOCK1)) {
     return 0;
   }
   /* pointers may be NULL to get only specific block parameters */
   if(num != NULL) {
-    *num = coap_pkt->block1_num;
+    *num = coap_pkt->block1 >> 4;
   }
   if(more != NULL) {
-    *more = coap_pkt->block1_more;
+    *more = (coap_pkt->block1 & 0x08) >> 3;
   }
   if(size != NULL) {
-    *size = coap_pkt->block1_size;
+    *size = 16 << (coap_pkt->block1 & 0x07);
   }
   if(offset != NULL) {
-    *offset = coap_pkt->block1_offset;
+    *offset = (coap_pkt->block1 & ~0x0000000F) << (coap_pkt->block1 & 0x07);
   }
   return 1;
 }
@@ -1070,45 +1028,25 @@ coap_set_header_block1(coap_message_t *coap_pkt, uint32_t num, uint8_t more,
   if(num > 0x0FFFFF) {
     return 0;
   }
-  coap_pkt->block1_num = num;
-  coap_pkt->block1_more = more;
-  coap_pkt->block1_size = size;
+  coap_pkt->block1 = num << 4 | (more ? 0x08 : 0) | coap_log_2(size / 16);
 
-  coap_set_option(coap_pkt, COAP_OPTION_BLOCK1);
+  coap_set_decoded_option(coap_pkt, COAP_OPTION_BLOCK1);
   return 1;
 }
 /*---------------------------------------------------------------------------*/
 int
-coap_get_header_size2(coap_message_t *coap_pkt, uint32_t *size)
-{
-  if(!coap_is_option(coap_pkt, COAP_OPTION_SIZE2)) {
-    return 0;
-  }
-  *size = coap_pkt->size2;
-  return 1;
-}
-int
 coap_set_header_size2(coap_message_t *coap_pkt, uint32_t size)
 {
   coap_pkt->size2 = size;
-  coap_set_option(coap_pkt, COAP_OPTION_SIZE2);
+  coap_set_decoded_option(coap_pkt, COAP_OPTION_SIZE2);
   return 1;
 }
 /*---------------------------------------------------------------------------*/
 int
-coap_get_header_size1(coap_message_t *coap_pkt, uint32_t *size)
-{
-  if(!coap_is_option(coap_pkt, COAP_OPTION_SIZE1)) {
-    return 0;
-  }
-  *size = coap_pkt->size1;
-  return 1;
-}
-int
 coap_set_header_size1(coap_message_t *coap_pkt, uint32_t size)
 {
   coap_pkt->size1 = size;
-  coap_set_option(coap_pkt, COAP_OPTION_SIZE1);
+  coap_set_decoded_option(coap_pkt, COAP_OPTION_SIZE1);
   return 1;
 }
 /*---------------------------------------------------------------------------*/
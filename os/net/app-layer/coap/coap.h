@@ -73,59 +73,85 @@
 /* bitmap for set options */
 #define COAP_OPTION_MAP_SIZE  (sizeof(uint8_t) * 8)
 
-/* parsed message struct */
+/* options that coap_parse_message() leaves in the buffer until first access */
+typedef enum {
+  COAP_SLOT_IF_MATCH,
+  COAP_SLOT_ETAG,
+  COAP_SLOT_OBSERVE,
+  COAP_SLOT_URI_PORT,
+  COAP_SLOT_CONTENT_FORMAT,
+  COAP_SLOT_MAX_AGE,
+  COAP_SLOT_ACCEPT,
+  COAP_SLOT_BLOCK2,
+  COAP_SLOT_BLOCK1,
+  COAP_SLOT_SIZE2,
+  COAP_SLOT_SIZE1,
+  COAP_OPTION_SLOTS
+} coap_option_slot_t;
+
+/*
+ * Parsed message struct
+ *
+ * coap_parse_message() validates the options and sets the string options
+ * (Uri-Host, Uri-Path, Uri-Query, Location-Path, Location-Query) right
+ * away, merging repeated values in place. For the other options it only
+ * records where their values are in the message buffer; they are decoded on
+ * first access through the coap_get_header_*() functions, which do not
+ * modify the buffer.
+ *
+ * A parsed message is therefore only valid while its buffer is untouched:
+ * the strings and the payload point into it and pending options are read
+ * from it. Copy what is needed before the buffer is reused, and do not
+ * parse the same buffer twice. The option fields below must not be read
+ * directly on a parsed message.
+ */
 typedef struct {
   uint8_t *buffer; /* pointer to CoAP header / incoming message buffer / memory to serialize message */
+  const coap_endpoint_t *src_ep;
 
-  uint8_t version;
+  uint8_t *payload;
+  uint16_t payload_len;
+
+  uint16_t mid;
   coap_message_type_t type;
+  uint8_t version;
   uint8_t code;
-  uint16_t mid;
 
   uint8_t token_len;
   uint8_t token[COAP_TOKEN_LEN];
 
   uint8_t options[COAP_OPTION_SIZE1 / COAP_OPTION_MAP_SIZE + 1]; /* bitmap to check if option is set */
+  uint16_t option_offset[COAP_OPTION_SLOTS]; /* 1 + offset of the value of options not decoded yet, 0 if decoded */
+  uint8_t option_len[COAP_OPTION_SLOTS]; /* length of the values not decoded yet */
 
-  uint16_t content_format; /* parse options once and store; allows setting options in random order  */
-  uint32_t max_age;
+  /* option values: not cleared by coap_parse_message(), only valid if the option is set */
+  uint16_t content_format; /* decode options once and store; allows setting options in random order  */
+  uint16_t accept;
+  uint16_t uri_port;
   uint8_t etag_len;
   uint8_t etag[COAP_ETAG_LEN];
-  size_t proxy_uri_len;
+  uint8_t if_match_len;
+  uint8_t if_match[COAP_ETAG_LEN];
+  uint32_t max_age;
+  int32_t observe;
+  uint32_t block2; /* block option value: NUM << 4 | M << 3 | SZX */
+  uint32_t block1;
+  uint32_t size2;
+  uint32_t size1;
+  uint16_t proxy_uri_len;
+  uint16_t proxy_scheme_len;
+  uint16_t uri_host_len;
+  uint16_t location_path_len;
+  uint16_t location_query_len;
+  uint16_t uri_path_len;
+  uint16_t uri_query_len;
   const char *proxy_uri;
-  size_t proxy_scheme_len;
   const char *proxy_scheme;
-  size_t uri_host_len;
   const char *uri_host;
-  size_t location_path_len;
   const char *location_path;
-  uint16_t uri_port;
-  size_t location_query_len;
   const char *location_query;
-  size_t uri_path_len;
   const char *uri_path;
-  int32_t observe;
-  uint16_t accept;
-  uint8_t if_match_len;
-  uint8_t if_match[COAP_ETAG_LEN];
-  uint32_t block2_num;
-  uint8_t block2_more;
-  uint16_t block2_size;
-  uint32_t block2_offset;
-  uint32_t block1_num;
-  uint8_t block1_more;
-  uint16_t block1_size;
-  uint32_t block1_offset;
-  uint32_t size2;
-  uint32_t size1;
-  size_t uri_query_len;
   const char *uri_query;
-  uint8_t if_none_match;
-
-  const coap_endpoint_t *src_ep;
-
-  uint16_t payload_len;
-  uint8_t *payload;
 } coap_message_t;
 
 static inline int
@@ -145,6 +171,18 @@ coap_is_option(const coap_message_t *message, unsigned int opt)
     (message->options[opt / COAP_OPTION_MAP_SIZE] & (1 << (opt % COAP_OPTION_MAP_SIZE))) != 0;
 }
 
+void coap_decode_option(coap_message_t *message, unsigned int opt);
+
+/*
+ * Decodes an option left in the buffer on first access, evaluates to whether
+ * it is set. A macro, so that the check is inlined without optimization, too.
+ */
+#define COAP_GET_OPTION(message, opt, slot)                              \
+  (((message)->options[(opt) / COAP_OPTION_MAP_SIZE]                     \
+    & (1 << ((opt) % COAP_OPTION_MAP_SIZE))) != 0                        \
+   && ((message)->option_offset[slot] == 0                               \
+       || (coap_decode_option((message), (opt)), 1)))
+
 /* option format serialization */
 #define COAP_SERIALIZE_INT_OPTION(number, field, text) \
   if(coap_is_option(coap_pkt, number)) { \
@@ -177,12 +215,9 @@ coap_is_option(const coap_message_t *message, unsigned int opt)
   }
 #define COAP_SERIALIZE_BLOCK_OPTION(number, field, text) \
   if(coap_is_option(coap_pkt, number)) { \
-    LOG_DBG(text " [%lu%s (%u B/blk)]\n", (unsigned long)coap_pkt->field##_num, coap_pkt->field##_more ? "+" : "", coap_pkt->field##_size); \
-    uint32_t block = coap_pkt->field##_num << 4; \
-    if(coap_pkt->field##_more) { block |= 0x8; } \
-    block |= 0xF & coap_log_2(coap_pkt->field##_size / 16); \
-    LOG_DBG(text " encoded: 0x%lX\n", (unsigned long)block);		\
-    option += coap_serialize_int_option(number, current_number, option, block); \
+    LOG_DBG(text " [%lu%s (%u B/blk)]\n", (unsigned long)(coap_pkt->field >> 4), (coap_pkt->field & 0x8) ? "+" : "", 16 << (coap_pkt->field & 0x7)); \
+    LOG_DBG(text " encoded: 0x%lX\n", (unsigned long)coap_pkt->field);		\
+    option += coap_serialize_int_option(number, current_number, option, coap_pkt->field); \
     current_number = number; \
   }
 
@@ -198,6 +233,7 @@ void coap_init_message(coap_message_t *message, coap_message_type_t type,
 size_t coap_serialize_message(coap_message_t *message, uint8_t *buffer);
 coap_status_t coap_parse_message(coap_message_t *request, uint8_t *data,
                                  uint16_t data_len);
+void coap_decode_options(coap_message_t *message);
 
 int coap_get_query_variable(coap_message_t *message, const char *name,
                             const char **output);
@@ -228,20 +264,62 @@ int coap_set_status_code(coap_message_t *message, unsigned int code);
 int coap_set_token(coap_message_t *message, const uint8_t *token,
                    size_t token_len);
 
-int coap_get_header_content_format(coap_message_t *message, unsigned int *format);
+static inline int
+coap_get_header_content_format(coap_message_t *message, unsigned int *format)
+{
+  if(!COAP_GET_OPTION(message, COAP_OPTION_CONTENT_FORMAT,
+                      COAP_SLOT_CONTENT_FORMAT)) {
+    return 0;
+  }
+  *format = message->content_format;
+  return 1;
+}
 int coap_set_header_content_format(coap_message_t *message, unsigned int format);
 
-int coap_get_header_accept(coap_message_t *message, unsigned int *accept);
+static inline int
+coap_get_header_accept(coap_message_t *message, unsigned int *accept)
+{
+  if(!COAP_GET_OPTION(message, COAP_OPTION_ACCEPT, COAP_SLOT_ACCEPT)) {
+    return 0;
+  }
+  *accept = message->accept;
+  return 1;
+}
 int coap_set_header_accept(coap_message_t *message, unsigned int accept);
 
-int coap_get_header_max_age(coap_message_t *message, uint32_t *age);
+static inline int
+coap_get_header_max_age(coap_message_t *message, uint32_t *age)
+{
+  if(!COAP_GET_OPTION(message, COAP_OPTION_MAX_AGE, COAP_SLOT_MAX_AGE)) {
+    *age = COAP_DEFAULT_MAX_AGE;
+  } else {
+    *age = message->max_age;
+  }
+  return 1;
+}
 int coap_set_header_max_age(coap_message_t *message, uint32_t age);
 
-int coap_get_header_etag(coap_message_t *message, const uint8_t **etag);
+static inline int
+coap_get_header_etag(coap_message_t *message, const uint8_t **etag)
+{
+  if(!COAP_GET_OPTION(message, COAP_OPTION_ETAG, COAP_SLOT_ETAG)) {
+    return 0;
+  }
+  *etag = message->etag;
+  return message->etag_len;
+}
 int coap_set_header_etag(coap_message_t *message, const uint8_t *etag,
                          size_t etag_len);
 
-int coap_get_header_if_match(coap_message_t *message, const uint8_t **etag);
+static inline int
+coap_get_header_if_match(coap_message_t *message, const uint8_t **etag)
+{
+  if(!COAP_GET_OPTION(message, COAP_OPTION_IF_MATCH, COAP_SLOT_IF_MATCH)) {
+    return 0;
+  }
+  *etag = message->if_match;
+  return message->if_match_len;
+}
 int coap_set_header_if_match(coap_message_t *message, const uint8_t *etag,
                              size_t etag_len);
 
@@ -257,27 +335,75 @@ int coap_get_header_proxy_scheme(coap_message_t *message, const char **scheme);
 int coap_set_header_proxy_scheme(coap_message_t *message, const char *scheme);
 
 /* in-place string might not be 0-terminated. */
-int coap_get_header_uri_host(coap_message_t *message, const char **host);
+static inline int
+coap_get_header_uri_host(coap_message_t *message, const char **host)
+{
+  if(!coap_is_option(message, COAP_OPTION_URI_HOST)) {
+    return 0;
+  }
+  *host = message->uri_host;
+  return message->uri_host_len;
+}
 int coap_set_header_uri_host(coap_message_t *message, const char *host);
 
 /* in-place string might not be 0-terminated. */
-int coap_get_header_uri_path(coap_message_t *message, const char **path);
+static inline int
+coap_get_header_uri_path(coap_message_t *message, const char **path)
+{
+  if(!coap_is_option(message, COAP_OPTION_URI_PATH)) {
+    return 0;
+  }
+  *path = message->uri_path;
+  return message->uri_path_len;
+}
 int coap_set_header_uri_path(coap_message_t *message, const char *path);
 
 /* in-place string might not be 0-terminated. */
-int coap_get_header_uri_query(coap_message_t *message, const char **query);
+static inline int
+coap_get_header_uri_query(coap_message_t *message, const char **query)
+{
+  if(!coap_is_option(message, COAP_OPTION_URI_QUERY)) {
+    return 0;
+  }
+  *query = message->uri_query;
+  return message->uri_query_len;
+}
 int coap_set_header_uri_query(coap_message_t *message, const char *query);
 
 /* in-place string might not be 0-terminated. */
-int coap_get_header_location_path(coap_message_t *message, const char **path);
+static inline int
+coap_get_header_location_path(coap_message_t *message, const char **path)
+{
+  if(!coap_is_option(message, COAP_OPTION_LOCATION_PATH)) {
+    return 0;
+  }
+  *path = message->location_path;
+  return message->location_path_len;
+}
 /* also splits optional query into Location-Query option. */
 int coap_set_header_location_path(coap_message_t *message, const char *path);
 
 /* in-place string might not be 0-terminated. */
-int coap_get_header_location_query(coap_message_t *message, const char **query);
+static inline int
+coap_get_header_location_query(coap_message_t *message, const char **query)
+{
+  if(!coap_is_option(message, COAP_OPTION_LOCATION_QUERY)) {
+    return 0;
+  }
+  *query = message->location_query;
+  return message->location_query_len;
+}
 int coap_set_header_location_query(coap_message_t *message, const char *query);
 
-int coap_get_header_observe(coap_message_t *message, uint32_t *observe);
+static inline int
+coap_get_header_observe(coap_message_t *message, uint32_t *observe)
+{
+  if(!COAP_GET_OPTION(message, COAP_OPTION_OBSERVE, COAP_SLOT_OBSERVE)) {
+    return 0;
+  }
+  *observe = message->observe;
+  return 1;
+}
 int coap_set_header_observe(coap_message_t *message, uint32_t observe);
 
 int coap_get_header_block2(coap_message_t *message, uint32_t *num, uint8_t *more,
@@ -290,10 +416,26 @@ int coap_get_header_block1(coap_message_t *message, uint32_t *num, uint8_t *more
 int coap_set_header_block1(coap_message_t *message, uint32_t num, uint8_t more,
                            uint16_t size);
 
-int coap_get_header_size2(coap_message_t *message, uint32_t *size);
+static inline int
+coap_get_header_size2(coap_message_t *message, uint32_t *size)
+{
+  if(!COAP_GET_OPTION(message, COAP_OPTION_SIZE2, COAP_SLOT_SIZE2)) {
+    return 0;
+  }
+  *size = message->size2;
+  return 1;
+}
 int coap_set_header_size2(coap_message_t *message, uint32_t size);
 
-int coap_get_header_size1(coap_message_t *message, uint32_t *size);
+static inline int
+coap_get_header_size1(coap_message_t *message, uint32_t *size)
+{
+  if(!COAP_GET_OPTION(message, COAP_OPTION_SIZE1, COAP_SLOT_SIZE1)) {
+    return 0;
+  }
+  *size = message->size1;
+  return 1;
+}
 int coap_set_header_size1(coap_message_t *message, uint32_t size);
 
 int coap_get_payload(coap_message_t *message, const uint8_t **payload);
@@ -34,6 +34,9 @@
 
 #include <ctype.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
 
 #define MAX_PATHLEN 80
 #define MAX_HOSTLEN 40
@@ -41,6 +44,7 @@ PROCESS(http_socket_process, "HTTP socket process");
 LIST(socketlist);
 
 static void removesocket(struct http_socket *s);
+static int start_request(struct http_socket *s);
 /*---------------------------------------------------------------------------*/
 static void
 call_callback(struct http_socket *s, http_socket_event_t e,
@@ -53,227 +57,219 @@ call_callback(struct http_socket *s, http_socket_event_t e,
 }
 /*---------------------------------------------------------------------------*/
 static void
-parse_header_init(struct http_socket *s)
+start_timeout_timer(struct http_socket *s)
+{
+  PROCESS_CONTEXT_BEGIN(&http_socket_process);
+  etimer_set(&s->timeout_timer, HTTP_SOCKET_TIMEOUT);
+  PROCESS_CONTEXT_END(&http_socket_process);
+  s->timeout_timer_started = 1;
+}
+/*---------------------------------------------------------------------------*/
+enum {
+  PARSE_STATUS,
+  PARSE_HEADERS,
+  PARSE_BODY,
+  PARSE_CHUNK_SIZE,
+  PARSE_CHUNK_DATA,
+  PARSE_CHUNK_END,
+  PARSE_TRAILERS,
+  PARSE_DONE,
+};
+/*---------------------------------------------------------------------------*/
+static void
+parse_init(struct http_socket *s)
 {
-  PT_INIT(&s->headerpt);
+  s->parse_state = PARSE_STATUS;
+  s->line_len = 0;
+  s->chunked = 0;
+  s->keep_alive = 0;
+  memset(&s->header, -1, sizeof(s->header));
 }
 /*---------------------------------------------------------------------------*/
+/*
+ * Collects a line of the response in s->line, a block at a time. Returns
+ * 1 once the line is complete, without its line ending.
+ */
 static int
-parse_header_byte(struct http_socket *s, char c)
+read_line(struct http_socket *s, const uint8_t **data, int *len)
 {
-  PT_BEGIN(&s->headerpt);
+  const uint8_t *end = memchr(*data, '\n', *len);
+  int n = end != NULL ? end - *data + 1 : *len;
+  int copy = MIN(n, (int)sizeof(s->line) - 1 - s->line_len);
+
+  memcpy(&s->line[s->line_len], *data, copy);
+  s->line_len += copy;
+  *data += n;
+  *len -= n;
+  if(end == NULL) {
+    return 0;
+  }
 
-  memset(&s->header, -1, sizeof(s->header));
+  while(s->line_len > 0 && (s->line[s->line_len - 1] == '\n' ||
+                            s->line[s->line_len - 1] == '\r')) {
+    s->line_len--;
+  }
+  s->line[s->line_len] = '\0';
+  s->line_len = 0;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static const char *
+skip_lws(const char *p)
+{
+  while(*p == ' ' || *p == '\t') {
+    p++;
+  }
+  return p;
+}
+/*---------------------------------------------------------------------------*/
+/* Reads a decimal number, -1 if there is none */
+static int64_t
+parse_number(const char **p)
+{
+  int64_t n = -1;
 
-  /* Skip the HTTP response */
-  while(c != ' ') {
-    PT_YIELD(&s->headerpt);
+  *p = skip_lws(*p);
+  if(isdigit((int)**p)) {
+    n = 0;
+    while(isdigit((int)**p)) {
+      n = n * 10 + *(*p)++ - '0';
+    }
   }
+  *p = skip_lws(*p);
+  return n;
+}
+/*---------------------------------------------------------------------------*/
+static void
+parse_status_line(struct http_socket *s)
+{
+  const char *p = strchr(s->line, ' ');
+  int i;
+
+  /* HTTP/1.1 connections are persistent unless told otherwise */
+  s->keep_alive = HTTP_SOCKET_KEEP_ALIVE &&
+    strncmp(s->line, "HTTP/1.1", 8) == 0;
 
-  /* Skip the space */
-  PT_YIELD(&s->headerpt);
   /* Read three characters of HTTP status and convert to BCD */
   s->header.status_code = 0;
-  for(s->header_chars = 0; s->header_chars < 3; s->header_chars++) {
-    s->header.status_code = s->header.status_code << 4 | (c - '0');
-    PT_YIELD(&s->headerpt);
+  if(p != NULL) {
+    for(i = 1; i <= 3 && p[i] != '\0'; i++) {
+      s->header.status_code = s->header.status_code << 4 | (p[i] - '0');
+    }
   }
+}
+/*---------------------------------------------------------------------------*/
+static void
+parse_header_line(struct http_socket *s)
+{
+  char *value = strchr(s->line, ':');
+  const char *p;
 
-  if(s->header.status_code == 0x200 || s->header.status_code == 0x206) {
-    /* Read headers until data */
-
-    while(1) {
-      /* Skip characters until end of line */
-      do {
-        while(c != '\r') {
-          s->header_chars++;
-          PT_YIELD(&s->headerpt);
-        }
-        s->header_chars++;
-        PT_YIELD(&s->headerpt);
-      } while(c != '\n');
-      s->header_chars--;
-      PT_YIELD(&s->headerpt);
-
-      if(s->header_chars == 0) {
-        /* This was an empty line, i.e. the end of headers */
-        break;
-      }
-
-      /* Start of line */
-      s->header_chars = 0;
-
-      /* Read header field */
-      while(c != ' ' && c != '\t' && c != ':' && c != '\r' &&
-            s->header_chars < sizeof(s->header_field) - 1) {
-        s->header_field[s->header_chars++] = c;
-        PT_YIELD(&s->headerpt);
-      }
-      s->header_field[s->header_chars] = '\0';
-      /* Skip linear white spaces */
-      while(c == ' ' || c == '\t') {
-        s->header_chars++;
-        PT_YIELD(&s->headerpt);
-      }
-      if(c == ':') {
-        /* Skip the colon */
-        s->header_chars++;
-        PT_YIELD(&s->headerpt);
-        /* Skip linear white spaces */
-        while(c == ' ' || c == '\t') {
-          s->header_chars++;
-          PT_YIELD(&s->headerpt);
-        }
-        if(!strcmp(s->header_field, "Content-Length")) {
-          s->header.content_length = 0;
-          while(isdigit((int)c)) {
-            s->header.content_length = s->header.content_length * 10 + c - '0';
-            s->header_chars++;
-            PT_YIELD(&s->headerpt);
-          }
-        } else if(!strcmp(s->header_field, "Content-Range")) {
-          /* Skip the bytes-unit token */
-          while(c != ' ' && c != '\t') {
-            s->header_chars++;
-            PT_YIELD(&s->headerpt);
-          }
-          /* Skip linear white spaces */
-          while(c == ' ' || c == '\t') {
-            s->header_chars++;
-            PT_YIELD(&s->headerpt);
-          }
-          s->header.content_range.first_byte_pos = 0;
-          while(isdigit((int)c)) {
-            s->header.content_range.first_byte_pos =
-              s->header.content_range.first_byte_pos * 10 + c - '0';
-            s->header_chars++;
-            PT_YIELD(&s->headerpt);
-          }
-          /* Skip linear white spaces */
-          while(c == ' ' || c == '\t') {
-            s->header_chars++;
-            PT_YIELD(&s->headerpt);
-          }
-          if(c == '-') {
-            /* Skip the dash */
-            s->header_chars++;
-            PT_YIELD(&s->headerpt);
-            /* Skip linear white spaces */
-            while(c == ' ' || c == '\t') {
-              s->header_chars++;
-              PT_YIELD(&s->headerpt);
-            }
-            s->header.content_range.last_byte_pos = 0;
-            while(isdigit((int)c)) {
-              s->header.content_range.last_byte_pos =
-                s->header.content_range.last_byte_pos * 10 + c - '0';
-              s->header_chars++;
-              PT_YIELD(&s->headerpt);
-            }
-            /* Skip linear white spaces */
-            while(c == ' ' || c == '\t') {
-              s->header_chars++;
-              PT_YIELD(&s->headerpt);
-            }
-            if(c == '/') {
-              /* Skip the slash */
-              s->header_chars++;
-              PT_YIELD(&s->headerpt);
-              /* Skip linear white spaces */
-              while(c == ' ' || c == '\t') {
-                s->header_chars++;
-                PT_YIELD(&s->headerpt);
-              }
-              if(c != '*') {
-                s->header.content_range.instance_length = 0;
-                while(isdigit((int)c)) {
-                  s->header.content_range.instance_length =
-                    s->header.content_range.instance_length * 10 + c - '0';
-                  s->header_chars++;
-                  PT_YIELD(&s->headerpt);
-                }
-              }
-            }
-          }
-        }
+  if(value == NULL) {
+    return;
+  }
+  *value++ = '\0';
+  p = skip_lws(value);
+
+  if(!strcasecmp(s->line, "Content-Length")) {
+    s->header.content_length = parse_number(&p);
+  } else if(!strcasecmp(s->line, "Content-Range")) {
+    /* Skip the bytes-unit token */
+    while(*p != ' ' && *p != '\t' && *p != '\0') {
+      p++;
+    }
+    s->header.content_range.first_byte_pos = parse_number(&p);
+    if(*p == '-') {
+      p++;
+      s->header.content_range.last_byte_pos = parse_number(&p);
+      if(*p == '/') {
+        p++;
+        s->header.content_range.instance_length = parse_number(&p);
       }
     }
-
-    /* All headers read, now read data */
-    call_callback(s, HTTP_SOCKET_HEADER, (void *)&s->header, sizeof(s->header));
-
-    /* Should exit the pt here to indicate that all headers have been
-       read */
-    PT_EXIT(&s->headerpt);
+  } else if(!strcasecmp(s->line, "Transfer-Encoding")) {
+    s->chunked = strstr(p, "chunked") != NULL;
+  } else if(!strcasecmp(s->line, "Connection")) {
+    if(!strncasecmp(p, "close", 5)) {
+      s->keep_alive = 0;
+    } else if(!strncasecmp(p, "keep-alive", 10)) {
+      s->keep_alive = HTTP_SOCKET_KEEP_ALIVE;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+response_complete(struct http_socket *s)
+{
+  s->parse_state = PARSE_DONE;
+  if(s->keep_alive) {
+    /* Ready for the next request, possibly from the callback */
+    s->idle = 1;
+    PROCESS_CONTEXT_BEGIN(&http_socket_process);
+    etimer_set(&s->timeout_timer, HTTP_SOCKET_IDLE_TIMEOUT);
+    PROCESS_CONTEXT_END(&http_socket_process);
+    s->timeout_timer_started = 1;
   } else {
+    tcp_socket_close(&s->s);
+  }
+  call_callback(s, HTTP_SOCKET_COMPLETE, NULL, 0);
+}
+/*---------------------------------------------------------------------------*/
+/* Hands a block of the body to the callback */
+static void
+body_data(struct http_socket *s, const uint8_t **data, int *len)
+{
+  int n = *len;
+
+  if(s->parse_state != PARSE_BODY || s->body_left != (uint64_t)-1) {
+    n = MIN((uint64_t)n, s->body_left);
+    s->body_left -= n;
+  }
+  if(n > 0) {
+    s->bodylen += n;
+    call_callback(s, HTTP_SOCKET_DATA, *data, n);
+  }
+  *data += n;
+  *len -= n;
+}
+/*---------------------------------------------------------------------------*/
+/* Returns 1 if there is no body to read */
+static int
+headers_done(struct http_socket *s)
+{
+  if(s->header.status_code != 0x200 && s->header.status_code != 0x206) {
     if(s->header.status_code == 0x404) {
       printf("File not found\n");
     } else if(s->header.status_code == 0x301 || s->header.status_code == 0x302) {
       printf("File moved (not handled)\n");
     }
 
+    s->parse_state = PARSE_DONE;
     call_callback(s, HTTP_SOCKET_ERR, (void *)&s->header, sizeof(s->header));
     tcp_socket_close(&s->s);
     removesocket(s);
-    PT_EXIT(&s->headerpt);
+    return 1;
   }
 
-
-  PT_END(&s->headerpt);
-}
-/*---------------------------------------------------------------------------*/
-static int
-input_pt(struct http_socket *s,
-         const uint8_t *inputptr, int inputdatalen)
-{
-  int i;
-  PT_BEGIN(&s->pt);
-
-  /* Parse the header */
-  s->header_received = 0;
-  do {
-    for(i = 0; i < inputdatalen; i++) {
-      if(!PT_SCHEDULE(parse_header_byte(s, inputptr[i]))) {
-        s->header_received = 1;
-        break;
-      }
-    }
-    inputdatalen -= i;
-    inputptr += i;
-
-    if(s->header_received == 0) {
-      /* If we have not yet received the full header, we wait for the
-         next packet to arrive. */
-      PT_YIELD(&s->pt);
-    }
-  } while(s->header_received == 0);
+  call_callback(s, HTTP_SOCKET_HEADER, (void *)&s->header, sizeof(s->header));
 
   s->bodylen = 0;
-  do {
-    /* Receive the data */
-    call_callback(s, HTTP_SOCKET_DATA, inputptr, inputdatalen);
-
-    /* Close the connection if the expected content length has been received */
-    if(s->header.content_length >= 0 && s->bodylen < s->header.content_length) {
-      s->bodylen += inputdatalen;
-      if(s->bodylen >= s->header.content_length) {
-        tcp_socket_close(&s->s);
-      }
+  if(s->chunked) {
+    s->parse_state = PARSE_CHUNK_SIZE;
+  } else if(s->header.content_length >= 0) {
+    s->parse_state = PARSE_BODY;
+    s->body_left = s->header.content_length;
+    if(s->body_left == 0) {
+      response_complete(s);
+      return 1;
     }
-
-    PT_YIELD(&s->pt);
-  } while(inputdatalen > 0);
-
-  PT_END(&s->pt);
-}
-/*---------------------------------------------------------------------------*/
-static void
-start_timeout_timer(struct http_socket *s)
-{
-  PROCESS_CONTEXT_BEGIN(&http_socket_process);
-  etimer_set(&s->timeout_timer, HTTP_SOCKET_TIMEOUT);
-  PROCESS_CONTEXT_END(&http_socket_process);
-  s->timeout_timer_started = 1;
+  } else {
+    /* The body ends when the server closes the connection */
+    s->parse_state = PARSE_BODY;
+    s->body_left = (uint64_t)-1;
+    s->keep_alive = 0;
+  }
+  return 0;
 }
 /*---------------------------------------------------------------------------*/
 static int
@@ -282,9 +278,65 @@ input(struct tcp_socket *tcps, void *ptr,
 {
   struct http_socket *s = ptr;
 
-  input_pt(s, inputptr, inputdatalen);
   start_timeout_timer(s);
 
+  /* Anything after the response is dropped, as the callback may already
+     have sent the next request */
+  while(inputdatalen > 0) {
+    switch(s->parse_state) {
+    case PARSE_STATUS:
+      if(read_line(s, &inputptr, &inputdatalen)) {
+        parse_status_line(s);
+        s->parse_state = PARSE_HEADERS;
+      }
+      break;
+    case PARSE_HEADERS:
+      if(read_line(s, &inputptr, &inputdatalen)) {
+        if(s->line[0] == '\0') {
+          if(headers_done(s)) {
+            return 0;
+          }
+        } else {
+          parse_header_line(s);
+        }
+      }
+      break;
+    case PARSE_BODY:
+      body_data(s, &inputptr, &inputdatalen);
+      if(s->body_left == 0) {
+        response_complete(s);
+        return 0;
+      }
+      break;
+    case PARSE_CHUNK_SIZE:
+      if(read_line(s, &inputptr, &inputdatalen)) {
+        /* Chunk extensions after the size are ignored */
+        s->body_left = strtoul(s->line, NULL, 16);
+        s->parse_state = s->body_left > 0 ? PARSE_CHUNK_DATA : PARSE_TRAILERS;
+      }
+      break;
+    case PARSE_CHUNK_DATA:
+      body_data(s, &inputptr, &inputdatalen);
+      if(s->body_left == 0) {
+        s->parse_state = PARSE_CHUNK_END;
+      }
+      break;
+    case PARSE_CHUNK_END:
+      if(read_line(s, &inputptr, &inputdatalen)) {
+        s->parse_state = PARSE_CHUNK_SIZE;
+      }
+      break;
+    case PARSE_TRAILERS:
+      if(read_line(s, &inputptr, &inputdatalen) && s->line[0] == '\0') {
+        response_complete(s);
+        return 0;
+      }
+      break;
+    default:
+      return 0;
+    }
+  }
+
   return 0; /* all data consumed */
 }
 /*---------------------------------------------------------------------------*/
@@ -394,82 +446,123 @@ removesocket(struct http_socket *s)
 }
 /*---------------------------------------------------------------------------*/
 static void
-event(struct tcp_socket *tcps, void *ptr,
-      tcp_socket_event_t e)
+send_request(struct http_socket *s)
 {
-  struct http_socket *s = ptr;
+  struct tcp_socket *tcps = &s->s;
   char host[MAX_HOSTLEN];
   char path[MAX_PATHLEN];
   uint16_t port;
   char str[42];
   int len;
 
-  if(e == TCP_SOCKET_CONNECTED) {
-    printf("Connected\n");
-    if(parse_url(s->url, host, &port, path)) {
-      tcp_socket_send_str(tcps, s->postdata != NULL ? "POST " : "GET ");
-      if(s->proxy_port != 0) {
-        /* If we are configured to route through a proxy, we should
-           provide the full URL as the path. */
-        tcp_socket_send_str(tcps, s->url);
-      } else {
-        tcp_socket_send_str(tcps, path);
-      }
-      tcp_socket_send_str(tcps, " HTTP/1.1\r\n");
+  if(parse_url(s->url, host, &port, path)) {
+    tcp_socket_send_str(tcps, s->postdata != NULL ? "POST " : "GET ");
+    if(s->proxy_port != 0) {
+      /* If we are configured to route through a proxy, we should
+         provide the full URL as the path. */
+      tcp_socket_send_str(tcps, s->url);
+    } else {
+      tcp_socket_send_str(tcps, path);
+    }
+    tcp_socket_send_str(tcps, " HTTP/1.1\r\n");
+    if(!HTTP_SOCKET_KEEP_ALIVE) {
       tcp_socket_send_str(tcps, "Connection: close\r\n");
-      tcp_socket_send_str(tcps, "Host: ");
-      /* If we have IPv6 host, add the '[' and the ']' characters
-         to the host. As in rfc2732. */
-      if(memchr(host, ':', MAX_HOSTLEN)) {
-        tcp_socket_send_str(tcps, "[");
-      }
-      tcp_socket_send_str(tcps, host);
-      if(memchr(host, ':', MAX_HOSTLEN)) {
-        tcp_socket_send_str(tcps, "]");
+    }
+    tcp_socket_send_str(tcps, "Host: ");
+    /* If we have IPv6 host, add the '[' and the ']' characters
+       to the host. As in rfc2732. */
+    if(memchr(host, ':', MAX_HOSTLEN)) {
+      tcp_socket_send_str(tcps, "[");
+    }
+    tcp_socket_send_str(tcps, host);
+    if(memchr(host, ':', MAX_HOSTLEN)) {
+      tcp_socket_send_str(tcps, "]");
+    }
+    tcp_socket_send_str(tcps, "\r\n");
+    if(s->postdata != NULL) {
+      if(s->content_type) {
+        tcp_socket_send_str(tcps, "Content-Type: ");
+        tcp_socket_send_str(tcps, s->content_type);
+        tcp_socket_send_str(tcps, "\r\n");
       }
+      tcp_socket_send_str(tcps, "Content-Length: ");
+      sprintf(str, "%u", s->postdatalen);
+      tcp_socket_send_str(tcps, str);
       tcp_socket_send_str(tcps, "\r\n");
-      if(s->postdata != NULL) {
-        if(s->content_type) {
-          tcp_socket_send_str(tcps, "Content-Type: ");
-          tcp_socket_send_str(tcps, s->content_type);
-          tcp_socket_send_str(tcps, "\r\n");
-        }
-        tcp_socket_send_str(tcps, "Content-Length: ");
-        sprintf(str, "%u", s->postdatalen);
-        tcp_socket_send_str(tcps, str);
-        tcp_socket_send_str(tcps, "\r\n");
-      } else if(s->length || s->pos > 0) {
-        tcp_socket_send_str(tcps, "Range: bytes=");
-        if(s->length) {
-          if(s->pos >= 0) {
-            sprintf(str, "%llu-%llu",
-              (long long unsigned int)s->pos, (long long unsigned int)s->pos + s->length - 1);
-          } else {
-            sprintf(str, "-%llu", (long long unsigned int)s->length);
-          }
+    } else if(s->length || s->pos > 0) {
+      tcp_socket_send_str(tcps, "Range: bytes=");
+      if(s->length) {
+        if(s->pos >= 0) {
+          sprintf(str, "%llu-%llu",
+            (long long unsigned int)s->pos, (long long unsigned int)s->pos + s->length - 1);
         } else {
-          sprintf(str, "%llu-", (long long unsigned int)s->pos);
+          sprintf(str, "-%llu", (long long unsigned int)s->length);
         }
-        tcp_socket_send_str(tcps, str);
-        tcp_socket_send_str(tcps, "\r\n");
+      } else {
+        sprintf(str, "%llu-", (long long unsigned int)s->pos);
       }
+      tcp_socket_send_str(tcps, str);
       tcp_socket_send_str(tcps, "\r\n");
-      if(s->postdata != NULL && s->postdatalen) {
-        len = tcp_socket_send(tcps, s->postdata, s->postdatalen);
-        s->postdata += len;
-        s->postdatalen -= len;
-      }
     }
-    parse_header_init(s);
+    tcp_socket_send_str(tcps, "\r\n");
+    if(s->postdata != NULL && s->postdatalen) {
+      len = tcp_socket_send(tcps, s->postdata, s->postdatalen);
+      s->postdata += len;
+      s->postdatalen -= len;
+    }
+  }
+  parse_init(s);
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * A server may close a kept-alive connection just as a request goes out on
+ * it. A GET that got no response yet is then sent again on a new
+ * connection, other requests are not repeated.
+ */
+static int
+retry_request(struct http_socket *s)
+{
+  if(!s->reused || s->postdata != NULL ||
+     s->parse_state != PARSE_STATUS || s->line_len > 0) {
+    return 0;
+  }
+  printf("Kept-alive connection lost, retrying\n");
+  s->reused = 0;
+  s->did_tcp_connect = 0;
+  return start_request(s) == HTTP_SOCKET_OK;
+}
+/*---------------------------------------------------------------------------*/
+static void
+event(struct tcp_socket *tcps, void *ptr,
+      tcp_socket_event_t e)
+{
+  struct http_socket *s = ptr;
+  int len;
+
+  if(e == TCP_SOCKET_CONNECTED) {
+    printf("Connected\n");
+    send_request(s);
   } else if(e == TCP_SOCKET_CLOSED) {
+    s->idle = 0;
+    if(retry_request(s)) {
+      return;
+    }
     call_callback(s, HTTP_SOCKET_CLOSED, NULL, 0);
     removesocket(s);
     printf("Closed\n");
   } else if(e == TCP_SOCKET_TIMEDOUT) {
+    s->idle = 0;
+    if(retry_request(s)) {
+      return;
+    }
     call_callback(s, HTTP_SOCKET_TIMEDOUT, NULL, 0);
     removesocket(s);
     printf("Timedout\n");
   } else if(e == TCP_SOCKET_ABORTED) {
+    s->idle = 0;
+    if(retry_request(s)) {
+      return;
+    }
     call_callback(s, HTTP_SOCKET_ABORTED, NULL, 0);
     removesocket(s);
     printf("Aborted\n");
@@ -478,12 +571,32 @@ event(struct tcp_socket *tcps, void *ptr,
       len = tcp_socket_send(tcps, s->postdata, s->postdatalen);
       s->postdata += len;
       s->postdatalen -= len;
-    } else {
+    } else if(!s->idle) {
       start_timeout_timer(s);
     }
   }
 }
 /*---------------------------------------------------------------------------*/
+/* Sends the request on the kept-alive connection if it goes to the same
+   server, otherwise connects */
+static void
+connect_or_reuse(struct http_socket *s, const uip_ipaddr_t *addr, uint16_t port)
+{
+  s->did_tcp_connect = 1;
+  if(s->idle && s->s.c != NULL &&
+     uip_ipaddr_cmp(&s->s.c->ripaddr, addr) &&
+     s->s.c->rport == UIP_HTONS(port)) {
+    s->idle = 0;
+    s->reused = 1;
+    start_timeout_timer(s);
+    send_request(s);
+    return;
+  }
+  s->idle = 0;
+  s->reused = 0;
+  tcp_socket_connect(&s->s, addr, port);
+}
+/*---------------------------------------------------------------------------*/
 static int
 start_request(struct http_socket *s)
 {
@@ -520,15 +633,14 @@ start_request(struct http_socket *s)
           return HTTP_SOCKET_OK;
         }
         if(addr != NULL) {
-          s->did_tcp_connect = 1;
-          tcp_socket_connect(&s->s, addr, port);
+          connect_or_reuse(s, addr, port);
           return HTTP_SOCKET_OK;
         } else {
           return HTTP_SOCKET_ERR;
         }
       }
     }
-    tcp_socket_connect(&s->s, &ip6addr, port);
+    connect_or_reuse(s, &ip6addr, port);
     return HTTP_SOCKET_OK;
   } else {
     return HTTP_SOCKET_ERR;
@@ -581,6 +693,11 @@ PROCESS_THREAD(http_socket_process, ev, data)
           s = list_item_next(s)) {
         if(timeout_timer == &s->timeout_timer && s->timeout_timer_started) {
           tcp_socket_close(&s->s);
+          if(s->idle) {
+            /* Unused for HTTP_SOCKET_IDLE_TIMEOUT */
+            s->idle = 0;
+            removesocket(s);
+          }
           break;
         }
       }
@@ -607,6 +724,8 @@ http_socket_init(struct http_socket *s)
   init();
   uip_create_unspecified(&s->proxy_addr);
   s->proxy_port = 0;
+  s->idle = 0;
+  s->reused = 0;
 }
 /*---------------------------------------------------------------------------*/
 static void
@@ -617,11 +736,12 @@ initialize_socket(struct http_socket *s)
   s->postdata = NULL;
   s->postdatalen = 0;
   s->timeout_timer_started = 0;
-  PT_INIT(&s->pt);
-  tcp_socket_register(&s->s, s,
-                      s->inputbuf, sizeof(s->inputbuf),
-                      s->outputbuf, sizeof(s->outputbuf),
-                      input, event);
+  if(!s->idle) {
+    tcp_socket_register(&s->s, s,
+                        s->inputbuf, sizeof(s->inputbuf),
+                        s->outputbuf, sizeof(s->outputbuf),
+                        input, event);
+  }
 }
 /*---------------------------------------------------------------------------*/
 int
@@ -680,6 +800,7 @@ http_socket_close(struct http_socket *socket)
       s = list_item_next(s)) {
     if(s == socket) {
       tcp_socket_close(&s->s);
+      s->idle = 0;
       removesocket(s);
       return 1;
     }
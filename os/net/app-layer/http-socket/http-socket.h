@@ -45,6 +45,7 @@ typedef enum {
   HTTP_SOCKET_TIMEDOUT,
   HTTP_SOCKET_ABORTED,
   HTTP_SOCKET_HOSTNAME_NOT_FOUND,
+  HTTP_SOCKET_COMPLETE,
 } http_socket_event_t;
 
 struct http_socket_header {
@@ -70,6 +71,28 @@ typedef void (* http_socket_callback_t)(struct http_socket *s,
 
 #define HTTP_SOCKET_TIMEOUT       ((2 * 60 + 30) * CLOCK_SECOND)
 
+/* Longest response line kept, the rest of a longer line is skipped */
+#define HTTP_SOCKET_LINELEN       64
+
+/*
+ * Keep the connection open after a response, unless the server closes it,
+ * and send the next request of the same socket to the same server on it.
+ * With keep-alive, HTTP_SOCKET_COMPLETE rather than HTTP_SOCKET_CLOSED
+ * marks the end of a response.
+ */
+#ifdef HTTP_SOCKET_CONF_KEEP_ALIVE
+#define HTTP_SOCKET_KEEP_ALIVE HTTP_SOCKET_CONF_KEEP_ALIVE
+#else
+#define HTTP_SOCKET_KEEP_ALIVE 0
+#endif
+
+/* How long an unused kept-alive connection stays open */
+#ifdef HTTP_SOCKET_CONF_IDLE_TIMEOUT
+#define HTTP_SOCKET_IDLE_TIMEOUT HTTP_SOCKET_CONF_IDLE_TIMEOUT
+#else
+#define HTTP_SOCKET_IDLE_TIMEOUT (30 * CLOCK_SECOND)
+#endif
+
 struct http_socket {
   struct http_socket *next;
   struct tcp_socket s;
@@ -88,15 +111,27 @@ struct http_socket {
 
   struct etimer timeout_timer;
   uint8_t timeout_timer_started;
-  struct pt pt, headerpt;
-  int header_chars;
-  char header_field[15];
+  uint8_t parse_state;
+  uint16_t line_len;
+  char line[HTTP_SOCKET_LINELEN];
   struct http_socket_header header;
-  uint8_t header_received;
   uint64_t bodylen;
+  /* Bytes left of the body, or of the current chunk */
+  uint64_t body_left;
   const char *content_type;
+
+  uint8_t chunked;
+  /* The server keeps the connection open after the response */
+  uint8_t keep_alive;
+  /* Connected, with no request outstanding */
+  uint8_t idle;
+  /* The request went out on a kept-alive connection */
+  uint8_t reused;
 };
 
+/*
+ * Call once per socket: a later call forgets a kept-alive connection.
+ */
 void http_socket_init(struct http_socket *s);
 
 int http_socket_get(struct http_socket *s, const char *url,
@@ -0,0 +1,1174 @@
+/*
+ * Copyright (c) 2026, Contiki-NG contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/*---------------------------------------------------------------------------*/
+/**
+ * \addtogroup mqtt-sn
+ * @{
+ */
+/**
+ * \file
+ *    Implementation of the MQTT-SN gateway
+ */
+/*---------------------------------------------------------------------------*/
+#include "mqtt-sn-gateway.h"
+#include "mqtt.h"
+#include "lib/list.h"
+#include "lib/memb.h"
+
+#include <string.h>
+
+#include "sys/log.h"
+#define LOG_MODULE "MQTT-SN GW"
+#define LOG_LEVEL LOG_LEVEL_MQTT_SN
+/*---------------------------------------------------------------------------*/
+#if MQTT_SN_GATEWAY_MAX_TOPICS > 32
+#error "MQTT_SN_GATEWAY_MAX_TOPICS must not exceed 32"
+#endif
+
+#define GET_16(p) ((uint16_t)((p)[0] << 8 | (p)[1]))
+#define PUT_16(p, v) do { (p)[0] = (v) >> 8; (p)[1] = (v) & 0xFF; } while(0)
+
+#define BROKER_KEEP_ALIVE 60
+#define BROKER_MAX_SEGMENT_SIZE 128
+#define SUPERVISION_INTERVAL (5 * CLOCK_SECOND)
+
+/* Largest payload of a PUBLISH with a short header */
+#define MAX_PAYLOAD (MQTT_SN_MAX_PACKET_SIZE - 7)
+/*---------------------------------------------------------------------------*/
+typedef enum {
+  CLIENT_ACTIVE,
+  CLIENT_ASLEEP,
+  CLIENT_AWAKE,
+} client_state_t;
+
+struct client {
+  struct client *next;
+  uip_ipaddr_t addr;
+  uint16_t port;
+  char id[MQTT_SN_CLIENT_ID_MAX_LEN + 1];
+  client_state_t state;
+  /* Keep-alive or sleep duration, in seconds */
+  uint16_t duration;
+  unsigned long last_seen;
+  /* Topics the client knows the normal topic ID of, by index */
+  uint32_t known_topics;
+  uint16_t msg_id_counter;
+  /* Incoming QoS 2 message waiting for its PUBREL */
+  uint16_t rec_msg_id;
+  uint8_t rec_pending;
+};
+
+struct topic {
+  uint8_t used;
+  mqtt_sn_topic_type_t type;
+  /* The index plus one for normal topics */
+  uint16_t id;
+  char name[MQTT_SN_MAX_TOPIC_LENGTH + 1];
+};
+
+typedef enum {
+  FILTER_UNSUBSCRIBED,
+  FILTER_SUBSCRIBING,
+  FILTER_SUBSCRIBED,
+  FILTER_UNSUBSCRIBING,
+} filter_state_t;
+
+/* A topic filter at the broker, shared by the subscriptions to it */
+struct filter {
+  uint8_t refs;
+  filter_state_t state;
+  char name[MQTT_SN_MAX_TOPIC_LENGTH + 1];
+};
+
+struct subscription {
+  struct subscription *next;
+  struct client *client;
+  struct filter *filter;
+  mqtt_sn_topic_type_t topic_type;
+  uint16_t topic_id;
+  uint8_t qos;
+  /* SUBACK to send once the broker has the filter */
+  uint8_t suback_pending;
+  uint16_t suback_msg_id;
+};
+
+typedef enum {
+  MESSAGE_QUEUED,
+  MESSAGE_SENT,
+} message_state_t;
+
+/* A client message for the broker */
+struct message {
+  struct message *next;
+  /* NULL for QoS -1 messages and clients that went away */
+  struct client *client;
+  message_state_t state;
+  uint16_t msg_id;
+  uint16_t topic_id;
+  uint16_t broker_mid;
+  mqtt_sn_qos_level_t qos;
+  mqtt_retain_t retain;
+  char topic[MQTT_SN_MAX_TOPIC_LENGTH + 1];
+  uint16_t payload_length;
+  uint8_t payload[MAX_PAYLOAD];
+};
+
+/* A broker message held for a sleeping client */
+struct held {
+  struct held *next;
+  struct client *client;
+  mqtt_sn_topic_type_t topic_type;
+  uint16_t topic_id;
+  uint8_t retain;
+  uint16_t payload_length;
+  uint8_t payload[MAX_PAYLOAD];
+};
+/*---------------------------------------------------------------------------*/
+MEMB(clients_memb, struct client, MQTT_SN_GATEWAY_MAX_CLIENTS);
+LIST(clients);
+MEMB(subscriptions_memb, struct subscription,
+     MQTT_SN_GATEWAY_MAX_SUBSCRIPTIONS);
+LIST(subscriptions);
+MEMB(messages_memb, struct message, MQTT_SN_GATEWAY_QUEUE_SIZE);
+LIST(messages);
+MEMB(held_memb, struct held, MQTT_SN_GATEWAY_SLEEP_QUEUE_SIZE);
+LIST(held);
+
+static struct topic topics[MQTT_SN_GATEWAY_MAX_TOPICS];
+static struct filter filters[MQTT_SN_GATEWAY_MAX_SUBSCRIPTIONS];
+
+static struct simple_udp_connection udp;
+static struct mqtt_connection broker;
+static char *broker_host;
+static uint16_t broker_port;
+static char *broker_client_id;
+
+/* The filter with a SUBSCRIBE or UNSUBSCRIBE at the broker */
+static struct filter *filter_op;
+/* The QoS 0 message the MQTT engine is sending */
+static struct message *sending;
+
+static uint8_t packet[MQTT_SN_MAX_PACKET_SIZE];
+
+PROCESS(mqtt_sn_gateway_process, "MQTT-SN gateway");
+/*---------------------------------------------------------------------------*/
+static void
+send_to(struct client *c, uint16_t length)
+{
+  simple_udp_sendto_port(&udp, packet, length, &c->addr, c->port);
+}
+/*---------------------------------------------------------------------------*/
+static void
+send_to_addr(const uip_ipaddr_t *addr, uint16_t port, uint16_t length)
+{
+  simple_udp_sendto_port(&udp, packet, length, addr, port);
+}
+/*---------------------------------------------------------------------------*/
+/* Builds PUBACK and REGACK */
+static uint16_t
+build_ack(uint8_t type, uint16_t topic_id, uint16_t msg_id,
+          uint8_t return_code)
+{
+  int hdr = mqtt_sn_header(packet, 5, type);
+
+  PUT_16(&packet[hdr], topic_id);
+  PUT_16(&packet[hdr + 2], msg_id);
+  packet[hdr + 4] = return_code;
+  return hdr + 5;
+}
+/*---------------------------------------------------------------------------*/
+static uint16_t
+build_msg_id(uint8_t type, uint16_t msg_id)
+{
+  int hdr = mqtt_sn_header(packet, 2, type);
+
+  PUT_16(&packet[hdr], msg_id);
+  return hdr + 2;
+}
+/*---------------------------------------------------------------------------*/
+static uint16_t
+build_suback(uint8_t qos, uint16_t topic_id, uint16_t msg_id,
+             uint8_t return_code)
+{
+  int hdr = mqtt_sn_header(packet, 6, MQTT_SN_TYPE_SUBACK);
+
+  packet[hdr] = qos << MQTT_SN_FLAG_QOS_SHIFT;
+  PUT_16(&packet[hdr + 1], topic_id);
+  PUT_16(&packet[hdr + 3], msg_id);
+  packet[hdr + 5] = return_code;
+  return hdr + 6;
+}
+/*---------------------------------------------------------------------------*/
+static uint16_t
+next_msg_id(struct client *c)
+{
+  if(++c->msg_id_counter == 0) {
+    c->msg_id_counter = 1;
+  }
+  return c->msg_id_counter;
+}
+/*---------------------------------------------------------------------------*/
+static int
+has_wildcard(const char *name)
+{
+  return strpbrk(name, "+#") != NULL;
+}
+/*---------------------------------------------------------------------------*/
+/* MQTT topic filter matching, '+' is one level and '#' the rest */
+static int
+topic_matches(const char *filter, const char *topic)
+{
+  if(topic[0] == '$' && (filter[0] == '+' || filter[0] == '#')) {
+    return 0;
+  }
+  while(*filter != '\0') {
+    if(*filter == '#') {
+      return 1;
+    }
+    if(*filter == '+') {
+      while(*topic != '\0' && *topic != '/') {
+        topic++;
+      }
+      filter++;
+      continue;
+    }
+    if(*topic == '\0') {
+      /* "a/#" matches "a" as well */
+      return strcmp(filter, "/#") == 0;
+    }
+    if(*filter != *topic) {
+      return 0;
+    }
+    filter++;
+    topic++;
+  }
+  return *topic == '\0';
+}
+/*---------------------------------------------------------------------------*/
+static struct topic *
+topic_lookup(mqtt_sn_topic_type_t type, uint16_t id)
+{
+  int i;
+
+  if(type == MQTT_SN_TOPIC_TYPE_NORMAL) {
+    if(id == 0 || id > MQTT_SN_GATEWAY_MAX_TOPICS ||
+       !topics[id - 1].used || topics[id - 1].type != type) {
+      return NULL;
+    }
+    return &topics[id - 1];
+  }
+  for(i = 0; i < MQTT_SN_GATEWAY_MAX_TOPICS; i++) {
+    if(topics[i].used && topics[i].type == type && topics[i].id == id) {
+      return &topics[i];
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static struct topic *
+topic_find_name(mqtt_sn_topic_type_t type, const char *name)
+{
+  int i;
+
+  for(i = 0; i < MQTT_SN_GATEWAY_MAX_TOPICS; i++) {
+    if(topics[i].used && topics[i].type == type &&
+       strcmp(topics[i].name, name) == 0) {
+      return &topics[i];
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+/* Finds or adds the normal topic ID of a topic name */
+static struct topic *
+topic_register(const char *name)
+{
+  struct topic *t;
+  int i;
+
+  t = topic_find_name(MQTT_SN_TOPIC_TYPE_NORMAL, name);
+  if(t != NULL) {
+    return t;
+  }
+  if(strlen(name) > MQTT_SN_MAX_TOPIC_LENGTH) {
+    return NULL;
+  }
+  for(i = 0; i < MQTT_SN_GATEWAY_MAX_TOPICS; i++) {
+    if(!topics[i].used) {
+      t = &topics[i];
+      t->used = 1;
+      t->type = MQTT_SN_TOPIC_TYPE_NORMAL;
+      t->id = i + 1;
+      strcpy(t->name, name);
+      return t;
+    }
+  }
+  LOG_WARN("No room for topic %s\n", name);
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+int
+mqtt_sn_gateway_predefine(uint16_t topic_id, const char *topic)
+{
+  int i;
+
+  if(strlen(topic) > MQTT_SN_MAX_TOPIC_LENGTH) {
+    return 0;
+  }
+  for(i = 0; i < MQTT_SN_GATEWAY_MAX_TOPICS; i++) {
+    if(!topics[i].used) {
+      topics[i].used = 1;
+      topics[i].type = MQTT_SN_TOPIC_TYPE_PREDEFINED;
+      topics[i].id = topic_id;
+      strcpy(topics[i].name, topic);
+      return 1;
+    }
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+/* Resolves the topic of a PUBLISH, name must have room for a short name */
+static const char *
+topic_name(mqtt_sn_topic_type_t type, uint16_t id, char *name)
+{
+  struct topic *t;
+
+  if(type == MQTT_SN_TOPIC_TYPE_SHORT) {
+    name[0] = id >> 8;
+    name[1] = id & 0xFF;
+    name[2] = '\0';
+    return name;
+  }
+  t = topic_lookup(type, id);
+  return t != NULL ? t->name : NULL;
+}
+/*---------------------------------------------------------------------------*/
+static struct client *
+client_find(const uip_ipaddr_t *addr, uint16_t port)
+{
+  struct client *c;
+
+  for(c = list_head(clients); c != NULL; c = c->next) {
+    if(c->port == port && uip_ipaddr_cmp(&c->addr, addr)) {
+      return c;
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static struct client *
+client_find_id(const char *id)
+{
+  struct client *c;
+
+  for(c = list_head(clients); c != NULL; c = c->next) {
+    if(strcmp(c->id, id) == 0) {
+      return c;
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static void
+subscription_free(struct subscription *s)
+{
+  s->filter->refs--;
+  list_remove(subscriptions, s);
+  memb_free(&subscriptions_memb, s);
+  process_poll(&mqtt_sn_gateway_process);
+}
+/*---------------------------------------------------------------------------*/
+/* Forgets the session of a client: subscriptions and held messages */
+static void
+client_clear(struct client *c)
+{
+  struct subscription *s;
+  struct subscription *next_s;
+  struct held *h;
+  struct held *next_h;
+
+  for(s = list_head(subscriptions); s != NULL; s = next_s) {
+    next_s = s->next;
+    if(s->client == c) {
+      subscription_free(s);
+    }
+  }
+  for(h = list_head(held); h != NULL; h = next_h) {
+    next_h = h->next;
+    if(h->client == c) {
+      list_remove(held, h);
+      memb_free(&held_memb, h);
+    }
+  }
+  c->known_topics = 0;
+  c->rec_pending = 0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+client_free(struct client *c)
+{
+  struct message *m;
+
+  client_clear(c);
+  for(m = list_head(messages); m != NULL; m = m->next) {
+    if(m->client == c) {
+      m->client = NULL;
+    }
+  }
+  list_remove(clients, c);
+  memb_free(&clients_memb, c);
+}
+/*---------------------------------------------------------------------------*/
+static void
+message_free(struct message *m)
+{
+  list_remove(messages, m);
+  memb_free(&messages_memb, m);
+}
+/*---------------------------------------------------------------------------*/
+/* Sends a PUBLISH to a client, preceded by a REGISTER of its topic ID */
+static void
+send_publish(struct client *c, mqtt_sn_topic_type_t topic_type,
+             uint16_t topic_id, uint8_t retain, const uint8_t *payload,
+             uint16_t payload_length)
+{
+  struct topic *t;
+  uint16_t name_length;
+  int hdr;
+
+  if(topic_type == MQTT_SN_TOPIC_TYPE_NORMAL &&
+     !(c->known_topics & (1UL << (topic_id - 1)))) {
+    t = &topics[topic_id - 1];
+    name_length = strlen(t->name);
+    hdr = mqtt_sn_header(packet, 4 + name_length, MQTT_SN_TYPE_REGISTER);
+    PUT_16(&packet[hdr], topic_id);
+    PUT_16(&packet[hdr + 2], next_msg_id(c));
+    memcpy(&packet[hdr + 4], t->name, name_length);
+    send_to(c, hdr + 4 + name_length);
+  }
+
+  hdr = mqtt_sn_header(packet, 5 + payload_length, MQTT_SN_TYPE_PUBLISH);
+  packet[hdr] = topic_type | (retain ? MQTT_SN_FLAG_RETAIN : 0);
+  PUT_16(&packet[hdr + 1], topic_id);
+  PUT_16(&packet[hdr + 3], 0);
+  memcpy(&packet[hdr + 5], payload, payload_length);
+  send_to(c, hdr + 5 + payload_length);
+}
+/*---------------------------------------------------------------------------*/
+static void
+hold(struct client *c, mqtt_sn_topic_type_t topic_type, uint16_t topic_id,
+     uint8_t retain, const uint8_t *payload, uint16_t payload_length)
+{
+  struct held *h = memb_alloc(&held_memb);
+
+  if(h == NULL) {
+    LOG_WARN("No room to hold a message for %s\n", c->id);
+    return;
+  }
+  h->client = c;
+  h->topic_type = topic_type;
+  h->topic_id = topic_id;
+  h->retain = retain;
+  h->payload_length = payload_length;
+  memcpy(h->payload, payload, payload_length);
+  list_add(held, h);
+}
+/*---------------------------------------------------------------------------*/
+/* Passes a message from the broker on to the subscribed clients */
+static void
+deliver(struct mqtt_message *msg)
+{
+  struct client *c;
+  struct subscription *s;
+  struct topic *t;
+  mqtt_sn_topic_type_t topic_type;
+  uint16_t topic_id;
+
+  if(!msg->first_chunk || msg->payload_chunk_length != msg->payload_length ||
+     msg->payload_length > MAX_PAYLOAD) {
+    LOG_WARN("Dropping a message of %u bytes on %s\n", msg->payload_length,
+             msg->topic);
+    return;
+  }
+
+  for(c = list_head(clients); c != NULL; c = c->next) {
+    for(s = list_head(subscriptions); s != NULL; s = s->next) {
+      if(s->client == c && !s->suback_pending &&
+         topic_matches(s->filter->name, msg->topic)) {
+        break;
+      }
+    }
+    if(s == NULL) {
+      continue;
+    }
+
+    /* Use the topic ID of the subscription unless it was a filter */
+    topic_type = s->topic_type;
+    topic_id = s->topic_id;
+    if(topic_type == MQTT_SN_TOPIC_TYPE_NORMAL && topic_id == 0) {
+      t = topic_find_name(MQTT_SN_TOPIC_TYPE_PREDEFINED, msg->topic);
+      if(t == NULL) {
+        t = topic_register(msg->topic);
+      }
+      if(t == NULL) {
+        continue;
+      }
+      topic_type = t->type;
+      topic_id = t->id;
+    }
+
+    if(c->state == CLIENT_ASLEEP) {
+      hold(c, topic_type, topic_id, 0, msg->payload_chunk,
+           msg->payload_length);
+    } else {
+      send_publish(c, topic_type, topic_id, 0, msg->payload_chunk,
+                   msg->payload_length);
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+send_subacks(struct filter *f, uint8_t return_code)
+{
+  struct subscription *s;
+  struct subscription *next;
+
+  for(s = list_head(subscriptions); s != NULL; s = next) {
+    next = s->next;
+    if(s->filter == f && s->suback_pending) {
+      s->suback_pending = 0;
+      send_to(s->client, build_suback(s->qos, s->topic_id, s->suback_msg_id,
+                                      return_code));
+      if(return_code != MQTT_SN_RC_ACCEPTED) {
+        subscription_free(s);
+      }
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Hands queued messages and filter changes to the MQTT engine */
+static void
+poll_broker(void)
+{
+  struct message *m;
+  mqtt_status_t status;
+  mqtt_qos_level_t qos;
+  int i;
+
+  if(!mqtt_connected(&broker)) {
+    return;
+  }
+
+  if(sending != NULL && mqtt_ready(&broker)) {
+    message_free(sending);
+    sending = NULL;
+  }
+  if(filter_op != NULL && mqtt_ready(&broker)) {
+    /* The MQTT engine gave up waiting for the SUBACK or UNSUBACK */
+    filter_op->state = filter_op->state == FILTER_SUBSCRIBING ?
+      FILTER_UNSUBSCRIBED : FILTER_SUBSCRIBED;
+    filter_op = NULL;
+  }
+
+  for(m = list_head(messages); m != NULL; m = m->next) {
+    if(m->state != MESSAGE_QUEUED) {
+      continue;
+    }
+    qos = m->qos == MQTT_SN_QOS_LEVEL_MINUS_1 ?
+      MQTT_QOS_LEVEL_0 : (mqtt_qos_level_t)m->qos;
+    if(qos == MQTT_QOS_LEVEL_0 && sending != NULL) {
+      continue;
+    }
+    status = mqtt_publish(&broker, &m->broker_mid, m->topic, m->payload,
+                          m->payload_length, qos, m->retain);
+    if(status != MQTT_STATUS_OK) {
+      continue;
+    }
+    m->state = MESSAGE_SENT;
+    if(qos == MQTT_QOS_LEVEL_0) {
+      sending = m;
+    }
+  }
+
+  if(filter_op != NULL || !mqtt_ready(&broker)) {
+    return;
+  }
+  for(i = 0; i < MQTT_SN_GATEWAY_MAX_SUBSCRIPTIONS; i++) {
+    if(filters[i].refs > 0 && filters[i].state == FILTER_UNSUBSCRIBED) {
+      if(mqtt_subscribe(&broker, NULL, filters[i].name,
+                        MQTT_QOS_LEVEL_0) == MQTT_STATUS_OK) {
+        filters[i].state = FILTER_SUBSCRIBING;
+        filter_op = &filters[i];
+      }
+      return;
+    }
+    if(filters[i].refs == 0 && filters[i].state == FILTER_SUBSCRIBED) {
+      if(mqtt_unsubscribe(&broker, NULL, filters[i].name) ==
+         MQTT_STATUS_OK) {
+        filters[i].state = FILTER_UNSUBSCRIBING;
+        filter_op = &filters[i];
+      }
+      return;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static struct message *
+message_find_mid(uint16_t mid)
+{
+  struct message *m;
+
+  for(m = list_head(messages); m != NULL; m = m->next) {
+    if(m->state == MESSAGE_SENT && m->broker_mid == mid && m != sending) {
+      return m;
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static void
+broker_event(struct mqtt_connection *m, mqtt_event_t event, void *data)
+{
+  struct mqtt_suback_event *suback;
+  struct message *msg;
+  int i;
+
+  switch(event) {
+  case MQTT_EVENT_CONNECTED:
+    LOG_INFO("Connected to the broker\n");
+    /* A clean session starts without subscriptions */
+    for(i = 0; i < MQTT_SN_GATEWAY_MAX_SUBSCRIPTIONS; i++) {
+      filters[i].state = FILTER_UNSUBSCRIBED;
+    }
+    filter_op = NULL;
+    break;
+  case MQTT_EVENT_DISCONNECTED:
+    LOG_WARN("Disconnected from the broker\n");
+    /* The MQTT engine dropped the QoS 0 message it was sending */
+    if(sending != NULL) {
+      message_free(sending);
+      sending = NULL;
+    }
+    break;
+  case MQTT_EVENT_SUBACK:
+    suback = data;
+    if(filter_op != NULL && filter_op->state == FILTER_SUBSCRIBING) {
+      if(suback->qos_level & 0x80) {
+        LOG_WARN("Broker refused %s\n", filter_op->name);
+        filter_op->state = FILTER_UNSUBSCRIBED;
+        send_subacks(filter_op, MQTT_SN_RC_NOT_SUPPORTED);
+      } else {
+        filter_op->state = FILTER_SUBSCRIBED;
+        send_subacks(filter_op, MQTT_SN_RC_ACCEPTED);
+      }
+      filter_op = NULL;
+    }
+    break;
+  case MQTT_EVENT_UNSUBACK:
+    if(filter_op != NULL && filter_op->state == FILTER_UNSUBSCRIBING) {
+      filter_op->state = FILTER_UNSUBSCRIBED;
+      filter_op = NULL;
+    }
+    break;
+  case MQTT_EVENT_PUBLISH:
+    deliver(data);
+    break;
+  case MQTT_EVENT_PUBACK:
+  case MQTT_EVENT_PUBCOMP:
+    msg = message_find_mid(*(uint16_t *)data);
+    if(msg == NULL) {
+      break;
+    }
+    if(msg->client != NULL && msg->qos == MQTT_SN_QOS_LEVEL_1) {
+      send_to(msg->client, build_ack(MQTT_SN_TYPE_PUBACK, msg->topic_id,
+                                     msg->msg_id, MQTT_SN_RC_ACCEPTED));
+    }
+    message_free(msg);
+    break;
+  case MQTT_EVENT_PUBLISH_FAILED:
+    msg = message_find_mid(*(uint16_t *)data);
+    if(msg == NULL) {
+      break;
+    }
+    if(msg->client != NULL && msg->qos == MQTT_SN_QOS_LEVEL_1) {
+      send_to(msg->client, build_ack(MQTT_SN_TYPE_PUBACK, msg->topic_id,
+                                     msg->msg_id, MQTT_SN_RC_CONGESTION));
+    }
+    message_free(msg);
+    break;
+  default:
+    break;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+flush_held(struct client *c)
+{
+  struct held *h;
+  struct held *next;
+
+  for(h = list_head(held); h != NULL; h = next) {
+    next = h->next;
+    if(h->client == c) {
+      send_publish(c, h->topic_type, h->topic_id, h->retain, h->payload,
+                   h->payload_length);
+      list_remove(held, h);
+      memb_free(&held_memb, h);
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+handle_connect(const uip_ipaddr_t *addr, uint16_t port, const uint8_t *data,
+               uint16_t length)
+{
+  struct client *c;
+  uint16_t id_length;
+  int hdr;
+
+  hdr = mqtt_sn_header(packet, 1, MQTT_SN_TYPE_CONNACK);
+  if(length < 5 || data[1] != MQTT_SN_PROTOCOL_ID ||
+     length - 4 > MQTT_SN_CLIENT_ID_MAX_LEN || (data[0] & MQTT_SN_FLAG_WILL)) {
+    packet[hdr] = MQTT_SN_RC_NOT_SUPPORTED;
+    send_to_addr(addr, port, hdr + 1);
+    return;
+  }
+  id_length = length - 4;
+
+  /* The same client may be back from another port */
+  c = client_find(addr, port);
+  if(c == NULL || strncmp(c->id, (const char *)&data[4], id_length) != 0 ||
+     c->id[id_length] != '\0') {
+    if(c != NULL) {
+      client_free(c);
+    }
+    memcpy(packet + hdr, &data[4], id_length);
+    packet[hdr + id_length] = '\0';
+    c = client_find_id((const char *)packet + hdr);
+  }
+  if(c == NULL) {
+    c = memb_alloc(&clients_memb);
+    if(c == NULL) {
+      LOG_WARN("No room for another client\n");
+      packet[hdr] = MQTT_SN_RC_CONGESTION;
+      send_to_addr(addr, port, hdr + 1);
+      return;
+    }
+    memset(c, 0, sizeof(*c));
+    memcpy(c->id, &data[4], id_length);
+    c->id[id_length] = '\0';
+    list_add(clients, c);
+  }
+  if(data[0] & MQTT_SN_FLAG_CLEAN_SESSION) {
+    client_clear(c);
+  }
+
+  uip_ipaddr_copy(&c->addr, addr);
+  c->port = port;
+  c->state = CLIENT_ACTIVE;
+  c->duration = GET_16(&data[2]);
+  c->last_seen = clock_seconds();
+  LOG_INFO("Client %s connected\n", c->id);
+
+  packet[hdr] = MQTT_SN_RC_ACCEPTED;
+  send_to(c, hdr + 1);
+  flush_held(c);
+}
+/*---------------------------------------------------------------------------*/
+static void
+handle_publish(struct client *c, const uip_ipaddr_t *addr, uint16_t port,
+               const uint8_t *data, uint16_t length)
+{
+  struct message *m;
+  const char *name;
+  char short_name[3];
+  mqtt_sn_topic_type_t topic_type;
+  mqtt_sn_qos_level_t qos;
+  uint16_t topic_id;
+  uint16_t msg_id;
+
+  if(length < 5) {
+    return;
+  }
+  qos = (data[0] & MQTT_SN_FLAG_QOS_MASK) >> MQTT_SN_FLAG_QOS_SHIFT;
+  topic_type = data[0] & MQTT_SN_FLAG_TOPIC_TYPE;
+  topic_id = GET_16(&data[1]);
+  msg_id = GET_16(&data[3]);
+
+  if(c == NULL && (qos != MQTT_SN_QOS_LEVEL_MINUS_1 ||
+                   topic_type == MQTT_SN_TOPIC_TYPE_NORMAL)) {
+    send_to_addr(addr, port,
+                 mqtt_sn_header(packet, 0, MQTT_SN_TYPE_DISCONNECT));
+    return;
+  }
+
+  name = topic_name(topic_type, topic_id, short_name);
+  if(name == NULL) {
+    if(c != NULL) {
+      send_to(c, build_ack(MQTT_SN_TYPE_PUBACK, topic_id, msg_id,
+                           MQTT_SN_RC_INVALID_TOPIC_ID));
+    }
+    return;
+  }
+
+  if(qos == MQTT_SN_QOS_LEVEL_2) {
+    /* PUBREC once the message is queued, and again for duplicates */
+    if(c->rec_pending && c->rec_msg_id == msg_id) {
+      send_to(c, build_msg_id(MQTT_SN_TYPE_PUBREC, msg_id));
+      return;
+    }
+  } else if(qos == MQTT_SN_QOS_LEVEL_1) {
+    /* Retransmitted while the broker has not acknowledged it yet */
+    for(m = list_head(messages); m != NULL; m = m->next) {
+      if(m->client == c && m->qos == qos && m->msg_id == msg_id) {
+        return;
+      }
+    }
+  }
+
+  m = memb_alloc(&messages_memb);
+  if(m == NULL || length - 5 > MAX_PAYLOAD) {
+    LOG_WARN("Dropping a message on %s\n", name);
+    if(m != NULL) {
+      memb_free(&messages_memb, m);
+    }
+    if(qos == MQTT_SN_QOS_LEVEL_1 || qos == MQTT_SN_QOS_LEVEL_2) {
+      send_to(c, build_ack(MQTT_SN_TYPE_PUBACK, topic_id, msg_id,
+                           MQTT_SN_RC_CONGESTION));
+    }
+    return;
+  }
+  m->client = qos == MQTT_SN_QOS_LEVEL_MINUS_1 ? NULL : c;
+  m->state = MESSAGE_QUEUED;
+  m->msg_id = msg_id;
+  m->topic_id = topic_id;
+  m->qos = qos;
+  m->retain = (data[0] & MQTT_SN_FLAG_RETAIN) ?
+    MQTT_RETAIN_ON : MQTT_RETAIN_OFF;
+  strcpy(m->topic, name);
+  m->payload_length = length - 5;
+  memcpy(m->payload, &data[5], m->payload_length);
+  list_add(messages, m);
+
+  if(qos == MQTT_SN_QOS_LEVEL_2) {
+    c->rec_pending = 1;
+    c->rec_msg_id = msg_id;
+    send_to(c, build_msg_id(MQTT_SN_TYPE_PUBREC, msg_id));
+  }
+  process_poll(&mqtt_sn_gateway_process);
+}
+/*---------------------------------------------------------------------------*/
+static struct filter *
+filter_get(const char *name)
+{
+  struct filter *free_filter = NULL;
+  int i;
+
+  for(i = 0; i < MQTT_SN_GATEWAY_MAX_SUBSCRIPTIONS; i++) {
+    if((filters[i].refs > 0 || filters[i].state != FILTER_UNSUBSCRIBED) &&
+       strcmp(filters[i].name, name) == 0) {
+      return &filters[i];
+    }
+    if(free_filter == NULL && filters[i].refs == 0 &&
+       filters[i].state == FILTER_UNSUBSCRIBED) {
+      free_filter = &filters[i];
+    }
+  }
+  if(free_filter != NULL) {
+    strcpy(free_filter->name, name);
+  }
+  return free_filter;
+}
+/*---------------------------------------------------------------------------*/
+static void
+handle_subscribe(struct client *c, uint8_t type, const uint8_t *data,
+                 uint16_t length)
+{
+  struct subscription *s;
+  struct filter *f;
+  struct topic *t;
+  char name[MQTT_SN_MAX_TOPIC_LENGTH + 1];
+  mqtt_sn_topic_type_t topic_type;
+  uint16_t topic_id = 0;
+  uint16_t msg_id;
+
+  if(length < 5) {
+    return;
+  }
+  topic_type = data[0] & MQTT_SN_FLAG_TOPIC_TYPE;
+  msg_id = GET_16(&data[1]);
+
+  if(topic_type == MQTT_SN_TOPIC_TYPE_PREDEFINED) {
+    topic_id = GET_16(&data[3]);
+    t = topic_lookup(topic_type, topic_id);
+    if(t == NULL) {
+      send_to(c, build_suback(0, topic_id, msg_id,
+                              MQTT_SN_RC_INVALID_TOPIC_ID));
+      return;
+    }
+    strcpy(name, t->name);
+  } else if(length - 3 > MQTT_SN_MAX_TOPIC_LENGTH) {
+    send_to(c, build_suback(0, 0, msg_id, MQTT_SN_RC_NOT_SUPPORTED));
+    return;
+  } else {
+    memcpy(name, &data[3], length - 3);
+    name[length - 3] = '\0';
+    if(topic_type == MQTT_SN_TOPIC_TYPE_SHORT && length - 3 == 2) {
+      topic_id = GET_16(&data[3]);
+    }
+  }
+
+  for(s = list_head(subscriptions); s != NULL; s = s->next) {
+    if(s->client == c && strcmp(s->filter->name, name) == 0) {
+      break;
+    }
+  }
+
+  if(type == MQTT_SN_TYPE_UNSUBSCRIBE) {
+    if(s != NULL) {
+      subscription_free(s);
+    }
+    send_to(c, build_msg_id(MQTT_SN_TYPE_UNSUBACK, msg_id));
+    return;
+  }
+
+  if(topic_type == MQTT_SN_TOPIC_TYPE_NORMAL && !has_wildcard(name)) {
+    t = topic_find_name(MQTT_SN_TOPIC_TYPE_PREDEFINED, name);
+    if(t == NULL) {
+      t = topic_register(name);
+    }
+    if(t == NULL) {
+      send_to(c, build_suback(0, 0, msg_id, MQTT_SN_RC_CONGESTION));
+      return;
+    }
+    topic_type = t->type;
+    topic_id = t->id;
+    if(topic_type == MQTT_SN_TOPIC_TYPE_NORMAL) {
+      c->known_topics |= 1UL << (topic_id - 1);
+    }
+  }
+
+  if(s == NULL) {
+    f = filter_get(name);
+    s = f != NULL ? memb_alloc(&subscriptions_memb) : NULL;
+    if(s == NULL) {
+      LOG_WARN("No room for a subscription to %s\n", name);
+      send_to(c, build_suback(0, 0, msg_id, MQTT_SN_RC_CONGESTION));
+      return;
+    }
+    s->client = c;
+    s->filter = f;
+    f->refs++;
+    list_add(subscriptions, s);
+  }
+  s->topic_type = topic_type;
+  s->topic_id = topic_id;
+  /* Messages are passed on with QoS 0 */
+  s->qos = MQTT_SN_QOS_LEVEL_0;
+  s->suback_msg_id = msg_id;
+  s->suback_pending = 1;
+
+  if(s->filter->state == FILTER_SUBSCRIBED) {
+    send_subacks(s->filter, MQTT_SN_RC_ACCEPTED);
+  } else {
+    process_poll(&mqtt_sn_gateway_process);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+udp_input(struct simple_udp_connection *conn, const uip_ipaddr_t *sender_addr,
+          uint16_t sender_port, const uip_ipaddr_t *receiver_addr,
+          uint16_t receiver_port, const uint8_t *data, uint16_t datalen)
+{
+  struct client *c;
+  uint16_t length;
+  uint16_t topic_id;
+  char name[MQTT_SN_MAX_TOPIC_LENGTH + 1];
+  uint8_t type;
+  struct topic *t;
+  int hdr;
+
+  hdr = mqtt_sn_parse_header(data, datalen, &length, &type);
+  if(hdr < 0) {
+    return;
+  }
+  data += hdr;
+  length -= hdr;
+
+  if(type == MQTT_SN_TYPE_CONNECT) {
+    handle_connect(sender_addr, sender_port, data, length);
+    return;
+  }
+
+  c = client_find(sender_addr, sender_port);
+  if(type == MQTT_SN_TYPE_PUBLISH) {
+    handle_publish(c, sender_addr, sender_port, data, length);
+    if(c != NULL) {
+      c->last_seen = clock_seconds();
+    }
+    return;
+  }
+  if(c == NULL) {
+    /* Unknown clients are told to connect first */
+    if(type != MQTT_SN_TYPE_DISCONNECT) {
+      send_to_addr(sender_addr, sender_port,
+                   mqtt_sn_header(packet, 0, MQTT_SN_TYPE_DISCONNECT));
+    }
+    return;
+  }
+  c->last_seen = clock_seconds();
+
+  switch(type) {
+  case MQTT_SN_TYPE_REGISTER:
+    if(length < 5 || length - 4 > MQTT_SN_MAX_TOPIC_LENGTH) {
+      send_to(c, build_ack(MQTT_SN_TYPE_REGACK, 0,
+                           length < 4 ? 0 : GET_16(&data[2]),
+                           MQTT_SN_RC_NOT_SUPPORTED));
+      break;
+    }
+    memcpy(name, &data[4], length - 4);
+    name[length - 4] = '\0';
+    t = has_wildcard(name) ? NULL : topic_register(name);
+    if(t == NULL) {
+      send_to(c, build_ack(MQTT_SN_TYPE_REGACK, 0, GET_16(&data[2]),
+                           MQTT_SN_RC_CONGESTION));
+      break;
+    }
+    c->known_topics |= 1UL << (t->id - 1);
+    send_to(c, build_ack(MQTT_SN_TYPE_REGACK, t->id, GET_16(&data[2]),
+                         MQTT_SN_RC_ACCEPTED));
+    break;
+
+  case MQTT_SN_TYPE_REGACK:
+    /* For a REGISTER sent ahead of a PUBLISH */
+    if(length >= 5 && data[4] == MQTT_SN_RC_ACCEPTED) {
+      topic_id = GET_16(&data[0]);
+      if(topic_id > 0 && topic_id <= MQTT_SN_GATEWAY_MAX_TOPICS) {
+        c->known_topics |= 1UL << (topic_id - 1);
+      }
+    }
+    break;
+
+  case MQTT_SN_TYPE_PUBREL:
+    if(length >= 2) {
+      if(c->rec_pending && c->rec_msg_id == GET_16(data)) {
+        c->rec_pending = 0;
+      }
+      send_to(c, build_msg_id(MQTT_SN_TYPE_PUBCOMP, GET_16(data)));
+    }
+    break;
+
+  case MQTT_SN_TYPE_SUBSCRIBE:
+  case MQTT_SN_TYPE_UNSUBSCRIBE:
+    handle_subscribe(c, type, data, length);
+    break;
+
+  case MQTT_SN_TYPE_PINGREQ:
+    if(length > 0 && c->state == CLIENT_ASLEEP) {
+      /* A sleeping client checking for messages */
+      c->state = CLIENT_AWAKE;
+      flush_held(c);
+      c->state = CLIENT_ASLEEP;
+    }
+    send_to(c, mqtt_sn_header(packet, 0, MQTT_SN_TYPE_PINGRESP));
+    break;
+
+  case MQTT_SN_TYPE_DISCONNECT:
+    send_to(c, mqtt_sn_header(packet, 0, MQTT_SN_TYPE_DISCONNECT));
+    if(length >= 2 && GET_16(data) > 0) {
+      c->state = CLIENT_ASLEEP;
+      c->duration = GET_16(data);
+      LOG_INFO("Client %s asleep for %u s\n", c->id, c->duration);
+    } else {
+      LOG_INFO("Client %s disconnected\n", c->id);
+      client_free(c);
+    }
+    break;
+
+  default:
+    break;
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Drops clients that have been silent for 1.5 times their duration */
+static void
+supervise(void)
+{
+  struct client *c;
+  struct client *next;
+  unsigned long now = clock_seconds();
+
+  for(c = list_head(clients); c != NULL; c = next) {
+    next = c->next;
+    if(c->duration > 0 &&
+       now - c->last_seen > c->duration + c->duration / 2) {
+      LOG_INFO("Client %s lost\n", c->id);
+      client_free(c);
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(mqtt_sn_gateway_process, ev, data)
+{
+  static struct etimer supervision;
+
+  PROCESS_BEGIN();
+
+  simple_udp_register(&udp, MQTT_SN_GATEWAY_PORT, NULL, 0, udp_input);
+
+  mqtt_register(&broker, &mqtt_sn_gateway_process, broker_client_id,
+                broker_event, BROKER_MAX_SEGMENT_SIZE);
+  mqtt_connect(&broker, broker_host, broker_port, BROKER_KEEP_ALIVE);
+
+  etimer_set(&supervision, SUPERVISION_INTERVAL);
+
+  while(1) {
+    PROCESS_WAIT_EVENT();
+
+    if(ev == PROCESS_EVENT_TIMER && data == &supervision) {
+      supervise();
+      etimer_reset(&supervision);
+    }
+    poll_broker();
+  }
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
+void
+mqtt_sn_gateway_init(char *broker, uint16_t port, char *client_id)
+{
+  broker_host = broker;
+  broker_port = port;
+  broker_client_id = client_id;
+  process_start(&mqtt_sn_gateway_process, NULL);
+}
+/*---------------------------------------------------------------------------*/
+/** @} */
@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2026, Contiki-NG contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/*---------------------------------------------------------------------------*/
+/**
+ * \addtogroup mqtt-sn
+ * @{
+ */
+/**
+ * \file
+ *    An aggregating MQTT-SN gateway, meant to run on a border router.
+ *
+ *    All clients share a single MQTT connection to the broker, made with
+ *    the MQTT engine, so this module also needs os/net/app-layer/mqtt,
+ *    os/net/app-layer/mqtt-sn and UIP_CONF_TCP. The gateway subscribes at the broker to each topic
+ *    filter some client subscribed to, and forwards client messages with
+ *    the QoS they were sent with, QoS -1 as 0. A QoS 1 message is
+ *    acknowledged to the client once the broker acknowledged it.
+ *
+ *    Messages from the broker are passed on to clients with QoS 0. Those
+ *    for sleeping clients are held until the client wakes up, or dropped
+ *    when MQTT_SN_GATEWAY_SLEEP_QUEUE_SIZE of them are held already.
+ */
+/*---------------------------------------------------------------------------*/
+#ifndef MQTT_SN_GATEWAY_H_
+#define MQTT_SN_GATEWAY_H_
+/*---------------------------------------------------------------------------*/
+#include "mqtt-sn.h"
+/*---------------------------------------------------------------------------*/
+#ifdef MQTT_SN_GATEWAY_CONF_PORT
+#define MQTT_SN_GATEWAY_PORT MQTT_SN_GATEWAY_CONF_PORT
+#else
+#define MQTT_SN_GATEWAY_PORT MQTT_SN_DEFAULT_PORT
+#endif
+
+#ifdef MQTT_SN_GATEWAY_CONF_MAX_CLIENTS
+#define MQTT_SN_GATEWAY_MAX_CLIENTS MQTT_SN_GATEWAY_CONF_MAX_CLIENTS
+#else
+#define MQTT_SN_GATEWAY_MAX_CLIENTS 8
+#endif
+
+/* Registered and predefined topics, at most 32 */
+#ifdef MQTT_SN_GATEWAY_CONF_MAX_TOPICS
+#define MQTT_SN_GATEWAY_MAX_TOPICS MQTT_SN_GATEWAY_CONF_MAX_TOPICS
+#else
+#define MQTT_SN_GATEWAY_MAX_TOPICS 16
+#endif
+
+/* Subscriptions of all clients, and distinct filters at the broker */
+#ifdef MQTT_SN_GATEWAY_CONF_MAX_SUBSCRIPTIONS
+#define MQTT_SN_GATEWAY_MAX_SUBSCRIPTIONS MQTT_SN_GATEWAY_CONF_MAX_SUBSCRIPTIONS
+#else
+#define MQTT_SN_GATEWAY_MAX_SUBSCRIPTIONS 8
+#endif
+
+/* Client messages waiting to be sent to, or acknowledged by, the broker */
+#ifdef MQTT_SN_GATEWAY_CONF_QUEUE_SIZE
+#define MQTT_SN_GATEWAY_QUEUE_SIZE MQTT_SN_GATEWAY_CONF_QUEUE_SIZE
+#else
+#define MQTT_SN_GATEWAY_QUEUE_SIZE 4
+#endif
+
+/* Broker messages held for sleeping clients */
+#ifdef MQTT_SN_GATEWAY_CONF_SLEEP_QUEUE_SIZE
+#define MQTT_SN_GATEWAY_SLEEP_QUEUE_SIZE MQTT_SN_GATEWAY_CONF_SLEEP_QUEUE_SIZE
+#else
+#define MQTT_SN_GATEWAY_SLEEP_QUEUE_SIZE 4
+#endif
+/*---------------------------------------------------------------------------*/
+/**
+ * \brief Starts the gateway.
+ * \param broker The IPv6 address of the MQTT broker, as a string.
+ * \param broker_port The TCP port of the broker.
+ * \param client_id The client ID of the gateway at the broker.
+ *
+ * The gateway listens on UDP port MQTT_SN_GATEWAY_PORT and keeps
+ * reconnecting to the broker when the connection is lost.
+ */
+void mqtt_sn_gateway_init(char *broker, uint16_t broker_port,
+                          char *client_id);
+/*---------------------------------------------------------------------------*/
+/**
+ * \brief Adds a predefined topic.
+ * \param topic_id The topic ID clients use for it.
+ * \param topic A pointer to the topic name.
+ * \return 1 if the topic was added, 0 if there was no room
+ *
+ * Clients publish and subscribe to predefined topics without registering
+ * them, and can use them with QoS -1.
+ */
+int mqtt_sn_gateway_predefine(uint16_t topic_id, const char *topic);
+/*---------------------------------------------------------------------------*/
+#endif /* MQTT_SN_GATEWAY_H_ */
+/*---------------------------------------------------------------------------*/
+/** @} */
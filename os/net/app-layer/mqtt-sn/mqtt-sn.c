@@ -0,0 +1,836 @@
+/*
+ * Copyright (c) 2026, Contiki-NG contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/*---------------------------------------------------------------------------*/
+/**
+ * \addtogroup mqtt-sn
+ * @{
+ */
+/**
+ * \file
+ *    Implementation of the Contiki MQTT-SN client
+ */
+/*---------------------------------------------------------------------------*/
+#include "mqtt-sn.h"
+
+#include <string.h>
+
+#include "sys/log.h"
+#define LOG_MODULE "MQTT-SN"
+#define LOG_LEVEL LOG_LEVEL_MQTT_SN
+/*---------------------------------------------------------------------------*/
+#define GET_16(p) ((uint16_t)((p)[0] << 8 | (p)[1]))
+#define PUT_16(p, v) do { (p)[0] = (v) >> 8; (p)[1] = (v) & 0xFF; } while(0)
+/*---------------------------------------------------------------------------*/
+process_event_t mqtt_sn_update_event;
+
+/* Packets that are not retransmitted are built here */
+static uint8_t scratch[MQTT_SN_MAX_PACKET_SIZE];
+/*---------------------------------------------------------------------------*/
+int
+mqtt_sn_header(uint8_t *buf, uint16_t body_length, uint8_t type)
+{
+  uint16_t length;
+
+  if(body_length + 2 < 256) {
+    buf[0] = body_length + 2;
+    buf[1] = type;
+    return 2;
+  }
+  length = body_length + 4;
+  buf[0] = 0x01;
+  PUT_16(&buf[1], length);
+  buf[3] = type;
+  return 4;
+}
+/*---------------------------------------------------------------------------*/
+int
+mqtt_sn_parse_header(const uint8_t *data, uint16_t datalen,
+                     uint16_t *length, uint8_t *type)
+{
+  if(datalen < 2) {
+    return -1;
+  }
+  if(data[0] != 0x01) {
+    *length = data[0];
+    *type = data[1];
+    return *length < 2 || *length > datalen ? -1 : 2;
+  }
+  if(datalen < 4) {
+    return -1;
+  }
+  *length = GET_16(&data[1]);
+  *type = data[3];
+  return *length < 4 || *length > datalen ? -1 : 4;
+}
+/*---------------------------------------------------------------------------*/
+static void
+call_event(struct mqtt_sn_connection *conn, mqtt_sn_event_t event,
+           void *data)
+{
+  conn->event_callback(conn, event, data);
+  process_post(conn->app_process, mqtt_sn_update_event, NULL);
+}
+/*---------------------------------------------------------------------------*/
+static uint16_t
+next_msg_id(struct mqtt_sn_connection *conn)
+{
+  if(++conn->msg_id_counter == 0) {
+    conn->msg_id_counter = 1;
+  }
+  return conn->msg_id_counter;
+}
+/*---------------------------------------------------------------------------*/
+static void
+remember_topic(struct mqtt_sn_connection *conn, uint16_t id, const char *name)
+{
+  struct mqtt_sn_topic *t = NULL;
+  int i;
+
+  if(strlen(name) > MQTT_SN_MAX_TOPIC_LENGTH) {
+    return;
+  }
+  for(i = 0; i < MQTT_SN_MAX_TOPICS; i++) {
+    if(conn->topics[i].id == id) {
+      t = &conn->topics[i];
+      break;
+    }
+  }
+  if(t == NULL) {
+    /* Replace the oldest entry */
+    t = &conn->topics[conn->topic_next];
+    conn->topic_next = (conn->topic_next + 1) % MQTT_SN_MAX_TOPICS;
+  }
+  t->id = id;
+  strcpy(t->name, name);
+}
+/*---------------------------------------------------------------------------*/
+const char *
+mqtt_sn_topic_name(struct mqtt_sn_connection *conn, uint16_t topic_id)
+{
+  int i;
+
+  for(i = 0; i < MQTT_SN_MAX_TOPICS; i++) {
+    if(conn->topics[i].id == topic_id && topic_id != 0) {
+      return conn->topics[i].name;
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static void send_pingreq(void *ptr);
+
+static void
+send_packet(struct mqtt_sn_connection *conn, const uint8_t *buf,
+            uint16_t length)
+{
+  simple_udp_sendto_port(&conn->udp, buf, length,
+                         &conn->gateway_addr, conn->gateway_port);
+
+  /* Anything sent counts as a sign of life */
+  if(conn->state == MQTT_SN_STATE_CONNECTED && conn->keep_alive > 0) {
+    ctimer_set(&conn->keep_alive_timer, conn->keep_alive * CLOCK_SECOND,
+               send_pingreq, conn);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+finish_request(struct mqtt_sn_connection *conn)
+{
+  conn->out_reply = 0;
+  ctimer_stop(&conn->retry_timer);
+}
+/*---------------------------------------------------------------------------*/
+static void
+gateway_lost(struct mqtt_sn_connection *conn)
+{
+  mqtt_sn_state_t state = conn->state;
+
+  LOG_WARN("No reply from the gateway\n");
+  finish_request(conn);
+  ctimer_stop(&conn->keep_alive_timer);
+  conn->state = MQTT_SN_STATE_NOT_CONNECTED;
+  call_event(conn, state == MQTT_SN_STATE_DISCONNECTING ?
+             MQTT_SN_EVENT_DISCONNECTED : MQTT_SN_EVENT_GATEWAY_LOST_ERROR,
+             NULL);
+}
+/*---------------------------------------------------------------------------*/
+static void
+retry(void *ptr)
+{
+  struct mqtt_sn_connection *conn = ptr;
+  int hdr;
+  uint16_t length;
+  uint8_t type;
+
+  if(conn->out_retries == MQTT_SN_MAX_RETRIES) {
+    gateway_lost(conn);
+    return;
+  }
+  conn->out_retries++;
+
+  hdr = mqtt_sn_parse_header(conn->out_buffer, conn->out_length,
+                             &length, &type);
+  if(hdr > 0 && type == MQTT_SN_TYPE_PUBLISH) {
+    conn->out_buffer[hdr] |= MQTT_SN_FLAG_DUP;
+  }
+  LOG_DBG("Retransmitting message type 0x%02x\n", type);
+  send_packet(conn, conn->out_buffer, conn->out_length);
+  ctimer_reset(&conn->retry_timer);
+}
+/*---------------------------------------------------------------------------*/
+/* Sends out_buffer and retransmits it until the reply arrives */
+static void
+start_request(struct mqtt_sn_connection *conn, uint8_t reply,
+              uint16_t msg_id)
+{
+  conn->out_reply = reply;
+  conn->out_msg_id = msg_id;
+  conn->out_retries = 0;
+  send_packet(conn, conn->out_buffer, conn->out_length);
+  ctimer_set(&conn->retry_timer, MQTT_SN_RETRY_TIMEOUT, retry, conn);
+}
+/*---------------------------------------------------------------------------*/
+static int
+expecting(struct mqtt_sn_connection *conn, uint8_t reply, uint16_t msg_id)
+{
+  return conn->out_reply == reply && conn->out_msg_id == msg_id;
+}
+/*---------------------------------------------------------------------------*/
+/* Builds a packet with no payload but a message ID, PUBREL and the like */
+static uint16_t
+build_msg_id(uint8_t *buf, uint8_t type, uint16_t msg_id)
+{
+  int hdr = mqtt_sn_header(buf, 2, type);
+
+  PUT_16(&buf[hdr], msg_id);
+  return hdr + 2;
+}
+/*---------------------------------------------------------------------------*/
+/* Builds PUBACK and REGACK */
+static uint16_t
+build_ack(uint8_t *buf, uint8_t type, uint16_t topic_id, uint16_t msg_id,
+          uint8_t return_code)
+{
+  int hdr = mqtt_sn_header(buf, 5, type);
+
+  PUT_16(&buf[hdr], topic_id);
+  PUT_16(&buf[hdr + 2], msg_id);
+  buf[hdr + 4] = return_code;
+  return hdr + 5;
+}
+/*---------------------------------------------------------------------------*/
+static void
+send_pingreq(void *ptr)
+{
+  struct mqtt_sn_connection *conn = ptr;
+
+  if(conn->state != MQTT_SN_STATE_CONNECTED) {
+    return;
+  }
+  if(conn->out_reply != 0) {
+    /* The retransmissions keep the connection alive */
+    ctimer_reset(&conn->keep_alive_timer);
+    return;
+  }
+  conn->out_length = mqtt_sn_header(conn->out_buffer, 0,
+                                    MQTT_SN_TYPE_PINGREQ);
+  start_request(conn, MQTT_SN_TYPE_PINGRESP, 0);
+}
+/*---------------------------------------------------------------------------*/
+static void
+handle_publish(struct mqtt_sn_connection *conn, const uint8_t *data,
+               uint16_t length)
+{
+  struct mqtt_sn_message msg;
+  uint8_t flags;
+  uint16_t reply_length;
+
+  if(length < 5) {
+    return;
+  }
+  flags = data[0];
+  msg.topic_id = GET_16(&data[1]);
+  msg.msg_id = GET_16(&data[3]);
+  msg.topic_type = flags & MQTT_SN_FLAG_TOPIC_TYPE;
+  msg.qos = (flags & MQTT_SN_FLAG_QOS_MASK) >> MQTT_SN_FLAG_QOS_SHIFT;
+  msg.retain = (flags & MQTT_SN_FLAG_RETAIN) != 0;
+  msg.dup = (flags & MQTT_SN_FLAG_DUP) != 0;
+  msg.payload = &data[5];
+  msg.payload_length = length - 5;
+  msg.topic = msg.topic_type == MQTT_SN_TOPIC_TYPE_NORMAL ?
+    mqtt_sn_topic_name(conn, msg.topic_id) : NULL;
+
+  if(msg.qos == MQTT_SN_QOS_LEVEL_2) {
+    reply_length = build_msg_id(scratch, MQTT_SN_TYPE_PUBREC, msg.msg_id);
+    send_packet(conn, scratch, reply_length);
+    if(conn->rec_pending && conn->rec_msg_id == msg.msg_id) {
+      /* Delivered already, the PUBREC was lost */
+      return;
+    }
+    conn->rec_pending = 1;
+    conn->rec_msg_id = msg.msg_id;
+  } else if(msg.qos == MQTT_SN_QOS_LEVEL_1) {
+    reply_length = build_ack(scratch, MQTT_SN_TYPE_PUBACK, msg.topic_id,
+                             msg.msg_id, MQTT_SN_RC_ACCEPTED);
+    send_packet(conn, scratch, reply_length);
+  }
+
+  call_event(conn, MQTT_SN_EVENT_PUBLISH, &msg);
+}
+/*---------------------------------------------------------------------------*/
+static void
+handle_ack(struct mqtt_sn_connection *conn, uint8_t type,
+           const uint8_t *data, uint16_t length)
+{
+  struct mqtt_sn_ack_event ack;
+  mqtt_sn_event_t event;
+
+  memset(&ack, 0, sizeof(ack));
+
+  switch(type) {
+  case MQTT_SN_TYPE_REGACK:
+  case MQTT_SN_TYPE_PUBACK:
+    if(length < 5) {
+      return;
+    }
+    ack.topic_id = GET_16(&data[0]);
+    ack.msg_id = GET_16(&data[2]);
+    ack.return_code = data[4];
+    event = type == MQTT_SN_TYPE_REGACK ?
+      MQTT_SN_EVENT_REGACK : MQTT_SN_EVENT_PUBACK;
+    break;
+  case MQTT_SN_TYPE_SUBACK:
+    if(length < 6) {
+      return;
+    }
+    ack.qos = (data[0] & MQTT_SN_FLAG_QOS_MASK) >> MQTT_SN_FLAG_QOS_SHIFT;
+    ack.topic_id = GET_16(&data[1]);
+    ack.msg_id = GET_16(&data[3]);
+    ack.return_code = data[5];
+    event = MQTT_SN_EVENT_SUBACK;
+    break;
+  case MQTT_SN_TYPE_UNSUBACK:
+  case MQTT_SN_TYPE_PUBCOMP:
+    if(length < 2) {
+      return;
+    }
+    ack.msg_id = GET_16(&data[0]);
+    event = type == MQTT_SN_TYPE_UNSUBACK ?
+      MQTT_SN_EVENT_UNSUBACK : MQTT_SN_EVENT_PUBCOMP;
+    break;
+  default:
+    return;
+  }
+
+  if(type == MQTT_SN_TYPE_PUBACK && expecting(conn, MQTT_SN_TYPE_PUBREC,
+                                              ack.msg_id) &&
+     ack.return_code != MQTT_SN_RC_ACCEPTED) {
+    /* A QoS 2 PUBLISH the gateway rejected */
+    conn->out_reply = MQTT_SN_TYPE_PUBACK;
+  }
+  if(!expecting(conn, type, ack.msg_id)) {
+    /* The gateway rejects QoS 0 messages to unknown topic IDs this way */
+    if(type == MQTT_SN_TYPE_PUBACK &&
+       ack.return_code != MQTT_SN_RC_ACCEPTED) {
+      call_event(conn, MQTT_SN_EVENT_REJECTED_ERROR, &ack);
+    }
+    return;
+  }
+  finish_request(conn);
+
+  if(ack.return_code != MQTT_SN_RC_ACCEPTED) {
+    LOG_WARN("Message %u rejected with %u\n", ack.msg_id, ack.return_code);
+    ack.topic_id = ack.topic_id ? ack.topic_id : conn->out_topic_id;
+    call_event(conn, MQTT_SN_EVENT_REJECTED_ERROR, &ack);
+    return;
+  }
+
+  if(type == MQTT_SN_TYPE_REGACK ||
+     (type == MQTT_SN_TYPE_SUBACK && conn->out_topic != NULL &&
+      ack.topic_id != 0)) {
+    remember_topic(conn, ack.topic_id, conn->out_topic);
+  }
+  if(type == MQTT_SN_TYPE_PUBACK) {
+    ack.qos = MQTT_SN_QOS_LEVEL_1;
+  }
+  call_event(conn, event, &ack);
+}
+/*---------------------------------------------------------------------------*/
+static void
+udp_input(struct simple_udp_connection *c, const uip_ipaddr_t *sender_addr,
+          uint16_t sender_port, const uip_ipaddr_t *receiver_addr,
+          uint16_t receiver_port, const uint8_t *data, uint16_t datalen)
+{
+  /* The UDP connection comes first */
+  struct mqtt_sn_connection *conn = (struct mqtt_sn_connection *)c;
+  uint16_t length;
+  uint16_t reply_length;
+  uint16_t topic_id;
+  uint16_t msg_id;
+  uint8_t type;
+  char name[MQTT_SN_MAX_TOPIC_LENGTH + 1];
+  int hdr;
+
+  if(!uip_ipaddr_cmp(sender_addr, &conn->gateway_addr) ||
+     sender_port != conn->gateway_port) {
+    return;
+  }
+  hdr = mqtt_sn_parse_header(data, datalen, &length, &type);
+  if(hdr < 0) {
+    LOG_WARN("Malformed packet\n");
+    return;
+  }
+  data += hdr;
+  length -= hdr;
+
+  LOG_DBG("Got message type 0x%02x in state %u\n", type, conn->state);
+
+  if(conn->state == MQTT_SN_STATE_NOT_CONNECTED) {
+    return;
+  }
+
+  switch(type) {
+  case MQTT_SN_TYPE_CONNACK:
+    if(length < 1 || conn->out_reply != MQTT_SN_TYPE_CONNACK) {
+      break;
+    }
+    finish_request(conn);
+    if(data[0] != MQTT_SN_RC_ACCEPTED) {
+      conn->state = MQTT_SN_STATE_NOT_CONNECTED;
+      call_event(conn, MQTT_SN_EVENT_CONNECTION_REFUSED_ERROR,
+                 (void *)&data[0]);
+      break;
+    }
+    conn->state = MQTT_SN_STATE_CONNECTED;
+    if(conn->keep_alive > 0) {
+      ctimer_set(&conn->keep_alive_timer, conn->keep_alive * CLOCK_SECOND,
+                 send_pingreq, conn);
+    }
+    call_event(conn, MQTT_SN_EVENT_CONNECTED, NULL);
+    break;
+
+  case MQTT_SN_TYPE_REGISTER:
+    if(length < 5) {
+      break;
+    }
+    topic_id = GET_16(&data[0]);
+    msg_id = GET_16(&data[2]);
+    if(length - 4 > MQTT_SN_MAX_TOPIC_LENGTH) {
+      reply_length = build_ack(scratch, MQTT_SN_TYPE_REGACK, topic_id, msg_id,
+                               MQTT_SN_RC_NOT_SUPPORTED);
+    } else {
+      memcpy(name, &data[4], length - 4);
+      name[length - 4] = '\0';
+      remember_topic(conn, topic_id, name);
+      reply_length = build_ack(scratch, MQTT_SN_TYPE_REGACK, topic_id, msg_id,
+                               MQTT_SN_RC_ACCEPTED);
+    }
+    send_packet(conn, scratch, reply_length);
+    break;
+
+  case MQTT_SN_TYPE_PUBLISH:
+    if(conn->state == MQTT_SN_STATE_CONNECTED ||
+       conn->state == MQTT_SN_STATE_AWAKE) {
+      handle_publish(conn, data, length);
+    }
+    break;
+
+  case MQTT_SN_TYPE_PUBREC:
+    if(length < 2 || !expecting(conn, MQTT_SN_TYPE_PUBREC, GET_16(data))) {
+      break;
+    }
+    /* Second half of QoS 2, retransmitted in turn */
+    finish_request(conn);
+    conn->out_length = build_msg_id(conn->out_buffer, MQTT_SN_TYPE_PUBREL,
+                                    conn->out_msg_id);
+    start_request(conn, MQTT_SN_TYPE_PUBCOMP, conn->out_msg_id);
+    break;
+
+  case MQTT_SN_TYPE_PUBREL:
+    if(length < 2) {
+      break;
+    }
+    msg_id = GET_16(data);
+    if(conn->rec_pending && conn->rec_msg_id == msg_id) {
+      conn->rec_pending = 0;
+    }
+    reply_length = build_msg_id(scratch, MQTT_SN_TYPE_PUBCOMP, msg_id);
+    send_packet(conn, scratch, reply_length);
+    break;
+
+  case MQTT_SN_TYPE_REGACK:
+  case MQTT_SN_TYPE_PUBACK:
+  case MQTT_SN_TYPE_PUBCOMP:
+  case MQTT_SN_TYPE_SUBACK:
+  case MQTT_SN_TYPE_UNSUBACK:
+    handle_ack(conn, type, data, length);
+    break;
+
+  case MQTT_SN_TYPE_PINGREQ:
+    reply_length = mqtt_sn_header(scratch, 0, MQTT_SN_TYPE_PINGRESP);
+    send_packet(conn, scratch, reply_length);
+    break;
+
+  case MQTT_SN_TYPE_PINGRESP:
+    if(conn->out_reply != MQTT_SN_TYPE_PINGRESP) {
+      break;
+    }
+    finish_request(conn);
+    if(conn->state == MQTT_SN_STATE_AWAKE) {
+      /* No more buffered messages */
+      conn->state = MQTT_SN_STATE_ASLEEP;
+      call_event(conn, MQTT_SN_EVENT_ASLEEP, NULL);
+    }
+    break;
+
+  case MQTT_SN_TYPE_DISCONNECT:
+    finish_request(conn);
+    ctimer_stop(&conn->keep_alive_timer);
+    if(conn->state == MQTT_SN_STATE_GOING_TO_SLEEP) {
+      conn->state = MQTT_SN_STATE_ASLEEP;
+      call_event(conn, MQTT_SN_EVENT_ASLEEP, NULL);
+    } else {
+      conn->state = MQTT_SN_STATE_NOT_CONNECTED;
+      call_event(conn, MQTT_SN_EVENT_DISCONNECTED, NULL);
+    }
+    break;
+
+  default:
+    LOG_DBG("Ignoring message type 0x%02x\n", type);
+    break;
+  }
+}
+/*---------------------------------------------------------------------------*/
+mqtt_sn_status_t
+mqtt_sn_register(struct mqtt_sn_connection *conn, struct process *app_process,
+                 char *client_id, const uip_ipaddr_t *gateway_addr,
+                 uint16_t gateway_port, mqtt_sn_event_callback_t event_callback)
+{
+  static uint8_t inited = 0;
+
+  if(client_id == NULL || strlen(client_id) > MQTT_SN_CLIENT_ID_MAX_LEN ||
+     gateway_addr == NULL) {
+    return MQTT_SN_STATUS_INVALID_ARGS_ERROR;
+  }
+  if(!inited) {
+    mqtt_sn_update_event = process_alloc_event();
+    inited = 1;
+  }
+
+  memset(conn, 0, sizeof(*conn));
+  conn->app_process = app_process;
+  conn->client_id = client_id;
+  conn->event_callback = event_callback;
+  uip_ipaddr_copy(&conn->gateway_addr, gateway_addr);
+  conn->gateway_port = gateway_port;
+  conn->clean_session = 1;
+  conn->state = MQTT_SN_STATE_NOT_CONNECTED;
+
+  if(!simple_udp_register(&conn->udp, 0, NULL, 0, udp_input)) {
+    return MQTT_SN_STATUS_ERROR;
+  }
+  return MQTT_SN_STATUS_OK;
+}
+/*---------------------------------------------------------------------------*/
+mqtt_sn_status_t
+mqtt_sn_connect(struct mqtt_sn_connection *conn, uint16_t keep_alive)
+{
+  uint16_t id_length = strlen(conn->client_id);
+  uint8_t *p;
+
+  if(conn->state != MQTT_SN_STATE_NOT_CONNECTED &&
+     conn->state != MQTT_SN_STATE_ASLEEP) {
+    return MQTT_SN_STATUS_ERROR;
+  }
+
+  conn->keep_alive = keep_alive;
+  p = conn->out_buffer + mqtt_sn_header(conn->out_buffer, 4 + id_length,
+                                        MQTT_SN_TYPE_CONNECT);
+  /* Waking up keeps the session, and the messages buffered for it */
+  *p++ = conn->clean_session && conn->state == MQTT_SN_STATE_NOT_CONNECTED ?
+    MQTT_SN_FLAG_CLEAN_SESSION : 0;
+  *p++ = MQTT_SN_PROTOCOL_ID;
+  PUT_16(p, keep_alive);
+  p += 2;
+  memcpy(p, conn->client_id, id_length);
+  conn->out_length = p + id_length - conn->out_buffer;
+
+  finish_request(conn);
+  conn->state = MQTT_SN_STATE_CONNECTING;
+  start_request(conn, MQTT_SN_TYPE_CONNACK, 0);
+  return MQTT_SN_STATUS_OK;
+}
+/*---------------------------------------------------------------------------*/
+static void
+send_disconnect(struct mqtt_sn_connection *conn, uint16_t duration)
+{
+  int hdr;
+
+  if(duration > 0) {
+    hdr = mqtt_sn_header(conn->out_buffer, 2, MQTT_SN_TYPE_DISCONNECT);
+    PUT_16(&conn->out_buffer[hdr], duration);
+    conn->out_length = hdr + 2;
+  } else {
+    conn->out_length = mqtt_sn_header(conn->out_buffer, 0,
+                                      MQTT_SN_TYPE_DISCONNECT);
+  }
+  ctimer_stop(&conn->keep_alive_timer);
+  finish_request(conn);
+  start_request(conn, MQTT_SN_TYPE_DISCONNECT, 0);
+}
+/*---------------------------------------------------------------------------*/
+void
+mqtt_sn_disconnect(struct mqtt_sn_connection *conn)
+{
+  if(conn->state == MQTT_SN_STATE_NOT_CONNECTED ||
+     conn->state == MQTT_SN_STATE_DISCONNECTING) {
+    return;
+  }
+  conn->state = MQTT_SN_STATE_DISCONNECTING;
+  send_disconnect(conn, 0);
+}
+/*---------------------------------------------------------------------------*/
+mqtt_sn_status_t
+mqtt_sn_sleep(struct mqtt_sn_connection *conn, uint16_t duration)
+{
+  if(conn->state != MQTT_SN_STATE_CONNECTED) {
+    return MQTT_SN_STATUS_NOT_CONNECTED_ERROR;
+  }
+  if(conn->out_reply != 0) {
+    return MQTT_SN_STATUS_OUT_QUEUE_FULL;
+  }
+  if(duration == 0) {
+    return MQTT_SN_STATUS_INVALID_ARGS_ERROR;
+  }
+  conn->sleep_duration = duration;
+  conn->state = MQTT_SN_STATE_GOING_TO_SLEEP;
+  send_disconnect(conn, duration);
+  return MQTT_SN_STATUS_OK;
+}
+/*---------------------------------------------------------------------------*/
+mqtt_sn_status_t
+mqtt_sn_wake(struct mqtt_sn_connection *conn)
+{
+  uint16_t id_length = strlen(conn->client_id);
+  int hdr;
+
+  if(conn->state != MQTT_SN_STATE_ASLEEP) {
+    return MQTT_SN_STATUS_ERROR;
+  }
+  /* A PINGREQ with the client ID makes the gateway flush the buffer */
+  hdr = mqtt_sn_header(conn->out_buffer, id_length, MQTT_SN_TYPE_PINGREQ);
+  memcpy(&conn->out_buffer[hdr], conn->client_id, id_length);
+  conn->out_length = hdr + id_length;
+
+  conn->state = MQTT_SN_STATE_AWAKE;
+  start_request(conn, MQTT_SN_TYPE_PINGRESP, 0);
+  return MQTT_SN_STATUS_OK;
+}
+/*---------------------------------------------------------------------------*/
+mqtt_sn_status_t
+mqtt_sn_register_topic(struct mqtt_sn_connection *conn, uint16_t *msg_id,
+                       const char *topic)
+{
+  uint16_t topic_length;
+  uint16_t id;
+  uint8_t *p;
+
+  if(conn->state != MQTT_SN_STATE_CONNECTED) {
+    return MQTT_SN_STATUS_NOT_CONNECTED_ERROR;
+  }
+  if(conn->out_reply != 0) {
+    return MQTT_SN_STATUS_OUT_QUEUE_FULL;
+  }
+  topic_length = strlen(topic);
+  if(topic_length == 0 || topic_length > MQTT_SN_MAX_TOPIC_LENGTH) {
+    return MQTT_SN_STATUS_INVALID_ARGS_ERROR;
+  }
+
+  id = next_msg_id(conn);
+  p = conn->out_buffer + mqtt_sn_header(conn->out_buffer, 4 + topic_length,
+                                        MQTT_SN_TYPE_REGISTER);
+  PUT_16(p, 0);
+  PUT_16(p + 2, id);
+  memcpy(p + 4, topic, topic_length);
+  conn->out_length = p + 4 + topic_length - conn->out_buffer;
+  conn->out_topic = topic;
+  conn->out_topic_id = 0;
+
+  if(msg_id != NULL) {
+    *msg_id = id;
+  }
+  start_request(conn, MQTT_SN_TYPE_REGACK, id);
+  return MQTT_SN_STATUS_OK;
+}
+/*---------------------------------------------------------------------------*/
+mqtt_sn_status_t
+mqtt_sn_publish(struct mqtt_sn_connection *conn, uint16_t *msg_id,
+                uint16_t topic_id, mqtt_sn_topic_type_t topic_type,
+                const uint8_t *payload, uint16_t payload_size,
+                mqtt_sn_qos_level_t qos_level, mqtt_sn_retain_t retain)
+{
+  uint8_t *buf;
+  uint8_t *p;
+  uint16_t id = 0;
+
+  if(payload_size + 9 > MQTT_SN_MAX_PACKET_SIZE ||
+     topic_type > MQTT_SN_TOPIC_TYPE_SHORT) {
+    return MQTT_SN_STATUS_INVALID_ARGS_ERROR;
+  }
+
+  if(qos_level == MQTT_SN_QOS_LEVEL_MINUS_1) {
+    /* Needs no connection, but a topic ID the gateway knows without one */
+    if(topic_type == MQTT_SN_TOPIC_TYPE_NORMAL) {
+      return MQTT_SN_STATUS_INVALID_ARGS_ERROR;
+    }
+  } else if(conn->state != MQTT_SN_STATE_CONNECTED) {
+    return MQTT_SN_STATUS_NOT_CONNECTED_ERROR;
+  }
+
+  if(qos_level == MQTT_SN_QOS_LEVEL_1 || qos_level == MQTT_SN_QOS_LEVEL_2) {
+    if(conn->out_reply != 0) {
+      return MQTT_SN_STATUS_OUT_QUEUE_FULL;
+    }
+    id = next_msg_id(conn);
+    buf = conn->out_buffer;
+  } else {
+    buf = scratch;
+  }
+
+  p = buf + mqtt_sn_header(buf, 5 + payload_size, MQTT_SN_TYPE_PUBLISH);
+  *p++ = (qos_level << MQTT_SN_FLAG_QOS_SHIFT) | topic_type |
+    (retain == MQTT_SN_RETAIN_ON ? MQTT_SN_FLAG_RETAIN : 0);
+  PUT_16(p, topic_id);
+  PUT_16(p + 2, id);
+  memcpy(p + 4, payload, payload_size);
+  p += 4 + payload_size;
+
+  if(msg_id != NULL) {
+    *msg_id = id;
+  }
+
+  if(buf == scratch) {
+    send_packet(conn, scratch, p - scratch);
+    return MQTT_SN_STATUS_OK;
+  }
+
+  conn->out_length = p - buf;
+  conn->out_topic = NULL;
+  conn->out_topic_id = topic_id;
+  start_request(conn, qos_level == MQTT_SN_QOS_LEVEL_1 ?
+                MQTT_SN_TYPE_PUBACK : MQTT_SN_TYPE_PUBREC, id);
+  return MQTT_SN_STATUS_OK;
+}
+/*---------------------------------------------------------------------------*/
+static mqtt_sn_status_t
+subscribe(struct mqtt_sn_connection *conn, uint8_t type, uint16_t *msg_id,
+          const char *topic, uint16_t topic_id, mqtt_sn_qos_level_t qos_level)
+{
+  mqtt_sn_topic_type_t topic_type = MQTT_SN_TOPIC_TYPE_PREDEFINED;
+  uint16_t topic_length = 2;
+  uint16_t id;
+  uint8_t *p;
+
+  if(conn->state != MQTT_SN_STATE_CONNECTED) {
+    return MQTT_SN_STATUS_NOT_CONNECTED_ERROR;
+  }
+  if(conn->out_reply != 0) {
+    return MQTT_SN_STATUS_OUT_QUEUE_FULL;
+  }
+  if(topic != NULL) {
+    topic_length = strlen(topic);
+    if(topic_length == 0 || topic_length > MQTT_SN_MAX_TOPIC_LENGTH) {
+      return MQTT_SN_STATUS_INVALID_ARGS_ERROR;
+    }
+    topic_type = topic_length == 2 && strpbrk(topic, "+#") == NULL ?
+      MQTT_SN_TOPIC_TYPE_SHORT : MQTT_SN_TOPIC_TYPE_NORMAL;
+  }
+  if(qos_level == MQTT_SN_QOS_LEVEL_MINUS_1) {
+    qos_level = MQTT_SN_QOS_LEVEL_0;
+  }
+
+  id = next_msg_id(conn);
+  p = conn->out_buffer + mqtt_sn_header(conn->out_buffer, 3 + topic_length,
+                                        type);
+  *p++ = (qos_level << MQTT_SN_FLAG_QOS_SHIFT) | topic_type;
+  PUT_16(p, id);
+  p += 2;
+  if(topic != NULL) {
+    memcpy(p, topic, topic_length);
+  } else {
+    PUT_16(p, topic_id);
+  }
+  conn->out_length = p + topic_length - conn->out_buffer;
+
+  /* Only names without wildcards get a topic ID */
+  conn->out_topic = topic_type == MQTT_SN_TOPIC_TYPE_NORMAL &&
+    strpbrk(topic, "+#") == NULL ? topic : NULL;
+  conn->out_topic_id = topic_id;
+
+  if(msg_id != NULL) {
+    *msg_id = id;
+  }
+  start_request(conn, type == MQTT_SN_TYPE_SUBSCRIBE ?
+                MQTT_SN_TYPE_SUBACK : MQTT_SN_TYPE_UNSUBACK, id);
+  return MQTT_SN_STATUS_OK;
+}
+/*---------------------------------------------------------------------------*/
+mqtt_sn_status_t
+mqtt_sn_subscribe(struct mqtt_sn_connection *conn, uint16_t *msg_id,
+                  const char *topic, mqtt_sn_qos_level_t qos_level)
+{
+  if(topic == NULL) {
+    return MQTT_SN_STATUS_INVALID_ARGS_ERROR;
+  }
+  return subscribe(conn, MQTT_SN_TYPE_SUBSCRIBE, msg_id, topic, 0,
+                   qos_level);
+}
+/*---------------------------------------------------------------------------*/
+mqtt_sn_status_t
+mqtt_sn_subscribe_predefined(struct mqtt_sn_connection *conn,
+                             uint16_t *msg_id, uint16_t topic_id,
+                             mqtt_sn_qos_level_t qos_level)
+{
+  return subscribe(conn, MQTT_SN_TYPE_SUBSCRIBE, msg_id, NULL, topic_id,
+                   qos_level);
+}
+/*---------------------------------------------------------------------------*/
+mqtt_sn_status_t
+mqtt_sn_unsubscribe(struct mqtt_sn_connection *conn, uint16_t *msg_id,
+                    const char *topic)
+{
+  if(topic == NULL) {
+    return MQTT_SN_STATUS_INVALID_ARGS_ERROR;
+  }
+  return subscribe(conn, MQTT_SN_TYPE_UNSUBSCRIBE, msg_id, topic, 0,
+                   MQTT_SN_QOS_LEVEL_0);
+}
+/*---------------------------------------------------------------------------*/
+/** @} */
@@ -0,0 +1,466 @@
+/*
+ * Copyright (c) 2026, Contiki-NG contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/*---------------------------------------------------------------------------*/
+/**
+ * \addtogroup apps
+ * @{
+ *
+ * \defgroup mqtt-sn An implementation of MQTT-SN v1.2
+ * @{
+ *
+ * MQTT-SN is MQTT for sensor networks: the same publish/subscribe model,
+ * carried in UDP datagrams instead of a TCP stream. Topic names are
+ * replaced by two-byte topic IDs, either registered with the gateway,
+ * predefined by both ends, or two-character short topic names, so that a
+ * PUBLISH costs seven bytes of header. A gateway, see mqtt-sn-gateway.h,
+ * translates to MQTT towards the broker.
+ *
+ * The client supports:
+ * - CONNECT with keep-alive, topic registration in both directions,
+ *   SUBSCRIBE and UNSUBSCRIBE, PUBLISH with QoS -1, 0, 1 and 2.
+ * - QoS -1 publishing with predefined or short topic IDs without being
+ *   connected.
+ * - Sleeping: the gateway buffers messages for a client that went to sleep
+ *   with mqtt_sn_sleep() until it calls mqtt_sn_wake().
+ *
+ * As the specification suggests, a client has one message waiting for a
+ * reply at a time. It is retransmitted every MQTT_SN_RETRY_TIMEOUT and the
+ * gateway is considered lost after MQTT_SN_MAX_RETRIES attempts. Gateway
+ * discovery and Last Will are not supported, the gateway address is given
+ * to mqtt_sn_register().
+ *
+ * The specification can be found here: https://mqtt.org
+ */
+/**
+ * \file
+ *    Header file for the Contiki MQTT-SN client
+ */
+/*---------------------------------------------------------------------------*/
+#ifndef MQTT_SN_H_
+#define MQTT_SN_H_
+/*---------------------------------------------------------------------------*/
+#include "contiki.h"
+#include "net/ipv6/simple-udp.h"
+#include "sys/ctimer.h"
+/*---------------------------------------------------------------------------*/
+/* Protocol constants */
+#define MQTT_SN_DEFAULT_PORT 1883
+#define MQTT_SN_PROTOCOL_ID 0x01
+#define MQTT_SN_CLIENT_ID_MAX_LEN 23
+
+#define MQTT_SN_TYPE_ADVERTISE    0x00
+#define MQTT_SN_TYPE_SEARCHGW     0x01
+#define MQTT_SN_TYPE_GWINFO       0x02
+#define MQTT_SN_TYPE_CONNECT      0x04
+#define MQTT_SN_TYPE_CONNACK      0x05
+#define MQTT_SN_TYPE_REGISTER     0x0A
+#define MQTT_SN_TYPE_REGACK       0x0B
+#define MQTT_SN_TYPE_PUBLISH      0x0C
+#define MQTT_SN_TYPE_PUBACK       0x0D
+#define MQTT_SN_TYPE_PUBCOMP      0x0E
+#define MQTT_SN_TYPE_PUBREC       0x0F
+#define MQTT_SN_TYPE_PUBREL       0x10
+#define MQTT_SN_TYPE_SUBSCRIBE    0x12
+#define MQTT_SN_TYPE_SUBACK       0x13
+#define MQTT_SN_TYPE_UNSUBSCRIBE  0x14
+#define MQTT_SN_TYPE_UNSUBACK     0x15
+#define MQTT_SN_TYPE_PINGREQ      0x16
+#define MQTT_SN_TYPE_PINGRESP     0x17
+#define MQTT_SN_TYPE_DISCONNECT   0x18
+
+#define MQTT_SN_FLAG_DUP           0x80
+#define MQTT_SN_FLAG_QOS_MASK      0x60
+#define MQTT_SN_FLAG_QOS_SHIFT     5
+#define MQTT_SN_FLAG_RETAIN        0x10
+#define MQTT_SN_FLAG_WILL          0x08
+#define MQTT_SN_FLAG_CLEAN_SESSION 0x04
+#define MQTT_SN_FLAG_TOPIC_TYPE    0x03
+
+#define MQTT_SN_RC_ACCEPTED          0x00
+#define MQTT_SN_RC_CONGESTION        0x01
+#define MQTT_SN_RC_INVALID_TOPIC_ID  0x02
+#define MQTT_SN_RC_NOT_SUPPORTED     0x03
+
+/* Topic IDs of short topic names are their two characters */
+#define MQTT_SN_SHORT_TOPIC(a, b) ((uint16_t)(((uint8_t)(a) << 8) | (uint8_t)(b)))
+
+/* Largest packet sent or received, including the header */
+#ifdef MQTT_SN_CONF_MAX_PACKET_SIZE
+#define MQTT_SN_MAX_PACKET_SIZE MQTT_SN_CONF_MAX_PACKET_SIZE
+#else
+#define MQTT_SN_MAX_PACKET_SIZE 128
+#endif
+
+#ifdef MQTT_SN_CONF_MAX_TOPIC_LENGTH
+#define MQTT_SN_MAX_TOPIC_LENGTH MQTT_SN_CONF_MAX_TOPIC_LENGTH
+#else
+#define MQTT_SN_MAX_TOPIC_LENGTH 32
+#endif
+
+/*
+ * Topic names the client remembers the ID of, registered by the client or
+ * the gateway, so that incoming messages carry their topic name.
+ */
+#ifdef MQTT_SN_CONF_MAX_TOPICS
+#define MQTT_SN_MAX_TOPICS MQTT_SN_CONF_MAX_TOPICS
+#else
+#define MQTT_SN_MAX_TOPICS 4
+#endif
+
+/* Tretry and Nretry of the specification */
+#ifdef MQTT_SN_CONF_RETRY_TIMEOUT
+#define MQTT_SN_RETRY_TIMEOUT MQTT_SN_CONF_RETRY_TIMEOUT
+#else
+#define MQTT_SN_RETRY_TIMEOUT (10 * CLOCK_SECOND)
+#endif
+
+#ifdef MQTT_SN_CONF_MAX_RETRIES
+#define MQTT_SN_MAX_RETRIES MQTT_SN_CONF_MAX_RETRIES
+#else
+#define MQTT_SN_MAX_RETRIES 4
+#endif
+/*---------------------------------------------------------------------------*/
+extern process_event_t mqtt_sn_update_event;
+
+/* Forward declaration */
+struct mqtt_sn_connection;
+
+/**
+ * \brief MQTT-SN client events
+ */
+typedef enum {
+  MQTT_SN_EVENT_CONNECTED,
+  MQTT_SN_EVENT_DISCONNECTED,
+  MQTT_SN_EVENT_ASLEEP,
+  MQTT_SN_EVENT_REGACK,
+  MQTT_SN_EVENT_SUBACK,
+  MQTT_SN_EVENT_UNSUBACK,
+  MQTT_SN_EVENT_PUBLISH,
+  MQTT_SN_EVENT_PUBACK,
+  MQTT_SN_EVENT_PUBCOMP,
+
+  /* Errors */
+  MQTT_SN_EVENT_ERROR = 0x80,
+  MQTT_SN_EVENT_CONNECTION_REFUSED_ERROR,
+  MQTT_SN_EVENT_REJECTED_ERROR,
+  MQTT_SN_EVENT_GATEWAY_LOST_ERROR,
+} mqtt_sn_event_t;
+
+typedef enum {
+  MQTT_SN_STATUS_OK,
+
+  MQTT_SN_STATUS_OUT_QUEUE_FULL,
+
+  /* Errors */
+  MQTT_SN_STATUS_ERROR = 0x80,
+  MQTT_SN_STATUS_NOT_CONNECTED_ERROR,
+  MQTT_SN_STATUS_INVALID_ARGS_ERROR,
+} mqtt_sn_status_t;
+
+/* The values are the QoS flag bits of the protocol */
+typedef enum {
+  MQTT_SN_QOS_LEVEL_0,
+  MQTT_SN_QOS_LEVEL_1,
+  MQTT_SN_QOS_LEVEL_2,
+  MQTT_SN_QOS_LEVEL_MINUS_1,
+} mqtt_sn_qos_level_t;
+
+typedef enum {
+  MQTT_SN_TOPIC_TYPE_NORMAL,
+  MQTT_SN_TOPIC_TYPE_PREDEFINED,
+  MQTT_SN_TOPIC_TYPE_SHORT,
+} mqtt_sn_topic_type_t;
+
+typedef enum {
+  MQTT_SN_RETAIN_OFF,
+  MQTT_SN_RETAIN_ON,
+} mqtt_sn_retain_t;
+
+typedef enum {
+  MQTT_SN_STATE_NOT_CONNECTED,
+  MQTT_SN_STATE_CONNECTING,
+  MQTT_SN_STATE_CONNECTED,
+  MQTT_SN_STATE_DISCONNECTING,
+  MQTT_SN_STATE_GOING_TO_SLEEP,
+  MQTT_SN_STATE_ASLEEP,
+  MQTT_SN_STATE_AWAKE,
+} mqtt_sn_state_t;
+/*---------------------------------------------------------------------------*/
+/*
+ * The data of MQTT_SN_EVENT_REGACK, SUBACK, UNSUBACK, PUBACK, PUBCOMP and
+ * REJECTED_ERROR. The topic ID is set for REGACK and SUBACK, and for
+ * PUBACK and REJECTED_ERROR when the request was a PUBLISH.
+ */
+struct mqtt_sn_ack_event {
+  uint16_t msg_id;
+  uint16_t topic_id;
+  uint8_t return_code;
+  mqtt_sn_qos_level_t qos;
+};
+
+/* The data of MQTT_SN_EVENT_PUBLISH */
+struct mqtt_sn_message {
+  uint16_t msg_id;
+  uint16_t topic_id;
+  mqtt_sn_topic_type_t topic_type;
+  /* NULL unless the name of a normal topic ID is known */
+  const char *topic;
+  mqtt_sn_qos_level_t qos;
+  uint8_t retain;
+  uint8_t dup;
+  const uint8_t *payload;
+  uint16_t payload_length;
+};
+
+typedef void (*mqtt_sn_event_callback_t)(struct mqtt_sn_connection *m,
+                                         mqtt_sn_event_t event,
+                                         void *data);
+
+struct mqtt_sn_topic {
+  uint16_t id;
+  char name[MQTT_SN_MAX_TOPIC_LENGTH + 1];
+};
+
+struct mqtt_sn_connection {
+  struct simple_udp_connection udp;
+  struct process *app_process;
+  mqtt_sn_event_callback_t event_callback;
+  char *client_id;
+  uip_ipaddr_t gateway_addr;
+  uint16_t gateway_port;
+
+  mqtt_sn_state_t state;
+  uint8_t clean_session;
+  uint16_t keep_alive;
+  uint16_t sleep_duration;
+  uint16_t msg_id_counter;
+
+  /* The message waiting for a reply */
+  uint8_t out_buffer[MQTT_SN_MAX_PACKET_SIZE];
+  uint16_t out_length;
+  uint8_t out_reply;
+  uint16_t out_msg_id;
+  uint16_t out_topic_id;
+  const char *out_topic;
+  uint8_t out_retries;
+  struct ctimer retry_timer;
+
+  /* Sends PINGREQ while connected */
+  struct ctimer keep_alive_timer;
+
+  /* Incoming QoS 2 message waiting for its PUBREL */
+  uint16_t rec_msg_id;
+  uint8_t rec_pending;
+
+  struct mqtt_sn_topic topics[MQTT_SN_MAX_TOPICS];
+  uint8_t topic_next;
+};
+/*---------------------------------------------------------------------------*/
+/* API */
+/*---------------------------------------------------------------------------*/
+/**
+ * \brief Initializes a MQTT-SN connection.
+ * \param conn A pointer to the MQTT-SN connection.
+ * \param app_process A pointer to the application process handling the
+ *        connection, it gets mqtt_sn_update_event after each event.
+ * \param client_id A pointer to a unique client ID, at most
+ *        MQTT_SN_CLIENT_ID_MAX_LEN characters.
+ * \param gateway_addr The address of the gateway.
+ * \param gateway_port The UDP port of the gateway, usually
+ *        MQTT_SN_DEFAULT_PORT.
+ * \param event_callback Callback function responsible for handling the
+ *        events of the connection.
+ * \return MQTT_SN_STATUS_OK or MQTT_SN_STATUS_INVALID_ARGS_ERROR
+ */
+mqtt_sn_status_t mqtt_sn_register(struct mqtt_sn_connection *conn,
+                                  struct process *app_process,
+                                  char *client_id,
+                                  const uip_ipaddr_t *gateway_addr,
+                                  uint16_t gateway_port,
+                                  mqtt_sn_event_callback_t event_callback);
+/*---------------------------------------------------------------------------*/
+/**
+ * \brief Connects to the gateway.
+ * \param conn A pointer to the MQTT-SN connection.
+ * \param keep_alive Keep alive time in seconds, a PINGREQ is sent when
+ *        nothing else was for that long.
+ * \return MQTT_SN_STATUS_OK or an error status
+ *
+ * Also wakes a sleeping client up for good, keeping its subscriptions and
+ * collecting the messages the gateway buffered. MQTT_SN_EVENT_CONNECTED or
+ * MQTT_SN_EVENT_CONNECTION_REFUSED_ERROR follows.
+ */
+mqtt_sn_status_t mqtt_sn_connect(struct mqtt_sn_connection *conn,
+                                 uint16_t keep_alive);
+/*---------------------------------------------------------------------------*/
+/**
+ * \brief Disconnects from the gateway.
+ * \param conn A pointer to the MQTT-SN connection.
+ *
+ * MQTT_SN_EVENT_DISCONNECTED follows.
+ */
+void mqtt_sn_disconnect(struct mqtt_sn_connection *conn);
+/*---------------------------------------------------------------------------*/
+/**
+ * \brief Goes to sleep.
+ * \param conn A pointer to the MQTT-SN connection.
+ * \param duration The longest time, in seconds, the client sleeps without
+ *        calling mqtt_sn_wake().
+ * \return MQTT_SN_STATUS_OK or an error status
+ *
+ * The gateway buffers messages for the client while it sleeps.
+ * MQTT_SN_EVENT_ASLEEP follows, after which nothing is sent until
+ * mqtt_sn_wake() or mqtt_sn_connect().
+ */
+mqtt_sn_status_t mqtt_sn_sleep(struct mqtt_sn_connection *conn,
+                               uint16_t duration);
+/*---------------------------------------------------------------------------*/
+/**
+ * \brief Collects the messages the gateway buffered for a sleeping client.
+ * \param conn A pointer to the MQTT-SN connection.
+ * \return MQTT_SN_STATUS_OK or an error status
+ *
+ * The buffered messages arrive as MQTT_SN_EVENT_PUBLISH events, followed
+ * by MQTT_SN_EVENT_ASLEEP when the client goes back to sleep.
+ */
+mqtt_sn_status_t mqtt_sn_wake(struct mqtt_sn_connection *conn);
+/*---------------------------------------------------------------------------*/
+/**
+ * \brief Registers a topic name to get its topic ID.
+ * \param conn A pointer to the MQTT-SN connection.
+ * \param msg_id A pointer to message ID.
+ * \param topic A pointer to the topic name, valid until MQTT_SN_EVENT_REGACK.
+ * \return MQTT_SN_STATUS_OK or some error status
+ *
+ * The topic ID is the topic_id of the MQTT_SN_EVENT_REGACK event.
+ */
+mqtt_sn_status_t mqtt_sn_register_topic(struct mqtt_sn_connection *conn,
+                                        uint16_t *msg_id,
+                                        const char *topic);
+/*---------------------------------------------------------------------------*/
+/**
+ * \brief Publishes to a topic ID.
+ * \param conn A pointer to the MQTT-SN connection.
+ * \param msg_id A pointer to message ID.
+ * \param topic_id The topic ID, from mqtt_sn_register_topic(), predefined
+ *        or made with MQTT_SN_SHORT_TOPIC().
+ * \param topic_type The type of topic_id.
+ * \param payload A pointer to the payload, copied.
+ * \param payload_size Payload size.
+ * \param qos_level Quality Of Service level to use. Supports -1, 0, 1 and 2.
+ * \param retain Whether the broker should retain the message.
+ * \return MQTT_SN_STATUS_OK or some error status
+ *
+ * QoS -1 messages can be sent without being connected, to predefined and
+ * short topic IDs. QoS 1 and 2 messages are acknowledged with
+ * MQTT_SN_EVENT_PUBACK and MQTT_SN_EVENT_PUBCOMP respectively.
+ */
+mqtt_sn_status_t mqtt_sn_publish(struct mqtt_sn_connection *conn,
+                                 uint16_t *msg_id,
+                                 uint16_t topic_id,
+                                 mqtt_sn_topic_type_t topic_type,
+                                 const uint8_t *payload,
+                                 uint16_t payload_size,
+                                 mqtt_sn_qos_level_t qos_level,
+                                 mqtt_sn_retain_t retain);
+/*---------------------------------------------------------------------------*/
+/**
+ * \brief Subscribes to a topic name or filter.
+ * \param conn A pointer to the MQTT-SN connection.
+ * \param msg_id A pointer to message ID.
+ * \param topic A pointer to the topic name or filter, valid until
+ *        MQTT_SN_EVENT_SUBACK. Names of two characters are short topics.
+ * \param qos_level The highest QoS to receive messages with.
+ * \return MQTT_SN_STATUS_OK or some error status
+ *
+ * The MQTT_SN_EVENT_SUBACK event has the topic ID of a topic name and the
+ * granted QoS. Messages matching a filter are preceded by a REGISTER of
+ * their topic from the gateway.
+ */
+mqtt_sn_status_t mqtt_sn_subscribe(struct mqtt_sn_connection *conn,
+                                   uint16_t *msg_id,
+                                   const char *topic,
+                                   mqtt_sn_qos_level_t qos_level);
+/*---------------------------------------------------------------------------*/
+/**
+ * \brief Subscribes to a predefined topic ID.
+ * \param conn A pointer to the MQTT-SN connection.
+ * \param msg_id A pointer to message ID.
+ * \param topic_id The predefined topic ID.
+ * \param qos_level The highest QoS to receive messages with.
+ * \return MQTT_SN_STATUS_OK or some error status
+ */
+mqtt_sn_status_t mqtt_sn_subscribe_predefined(struct mqtt_sn_connection *conn,
+                                              uint16_t *msg_id,
+                                              uint16_t topic_id,
+                                              mqtt_sn_qos_level_t qos_level);
+/*---------------------------------------------------------------------------*/
+/**
+ * \brief Unsubscribes from a topic name or filter.
+ * \param conn A pointer to the MQTT-SN connection.
+ * \param msg_id A pointer to message ID.
+ * \param topic A pointer to the topic name or filter.
+ * \return MQTT_SN_STATUS_OK or some error status
+ */
+mqtt_sn_status_t mqtt_sn_unsubscribe(struct mqtt_sn_connection *conn,
+                                     uint16_t *msg_id,
+                                     const char *topic);
+/*---------------------------------------------------------------------------*/
+/**
+ * \brief Looks up the topic name of a topic ID the client knows.
+ * \param conn A pointer to the MQTT-SN connection.
+ * \param topic_id A normal topic ID.
+ * \return The topic name or NULL
+ */
+const char *mqtt_sn_topic_name(struct mqtt_sn_connection *conn,
+                               uint16_t topic_id);
+/*---------------------------------------------------------------------------*/
+#define mqtt_sn_connected(conn) \
+  ((conn)->state == MQTT_SN_STATE_CONNECTED ? 1 : 0)
+
+#define mqtt_sn_ready(conn) \
+  ((conn)->out_reply == 0 && mqtt_sn_connected((conn)))
+/*---------------------------------------------------------------------------*/
+/*
+ * Helpers shared with the gateway. mqtt_sn_header() writes the header of a
+ * packet with body_length bytes after the type and returns its length, the
+ * length field is one byte, or 0x01 followed by two bytes from 256 bytes
+ * on. mqtt_sn_parse_header() returns the header length, or -1.
+ */
+int mqtt_sn_header(uint8_t *buf, uint16_t body_length, uint8_t type);
+int mqtt_sn_parse_header(const uint8_t *data, uint16_t datalen,
+                         uint16_t *length, uint8_t *type);
+/*---------------------------------------------------------------------------*/
+#endif /* MQTT_SN_H_ */
+/*---------------------------------------------------------------------------*/
+/**
+ * @}
+ * @}
+ */
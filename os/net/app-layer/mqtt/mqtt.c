@@ -56,8 +56,13 @@
 
 #include "lib/assert.h"
 #include "lib/list.h"
+#include "lib/memb.h"
 #include "sys/cc.h"
 
+#if MQTT_IN_FLIGHT_CFS
+#include "cfs/cfs.h"
+#endif
+
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -115,6 +120,9 @@ typedef enum {
   MQTT_VHDR_CONN_REJECTED_BAD_USER_PASS,
   MQTT_VHDR_CONN_REJECTED_UNAUTHORIZED,
 } mqtt_vhdr_connack_fields_t;
+
+/* Connect Acknowledge Flags of the CONNACK */
+#define MQTT_CONNACK_SESSION_PRESENT 0x01
 /*---------------------------------------------------------------------------*/
 #define MQTT_CONNECT_VHDR_FLAGS_SIZE 12
 
@@ -169,6 +177,7 @@ static process_event_t mqtt_do_subscribe_event;
 static process_event_t mqtt_do_unsubscribe_event;
 static process_event_t mqtt_do_publish_event;
 static process_event_t mqtt_do_pingreq_event;
+static process_event_t mqtt_do_in_flight_event;
 static process_event_t mqtt_continue_send_event;
 static process_event_t mqtt_abort_now_event;
 process_event_t mqtt_update_event;
@@ -192,6 +201,7 @@ static void tcp_event(struct tcp_socket *s, void *ptr,
 static void reset_packet(struct mqtt_in_packet *packet);
 /*---------------------------------------------------------------------------*/
 LIST(mqtt_conn_list);
+MEMB(in_flight_memb, struct mqtt_in_flight, MQTT_MAX_IN_FLIGHT);
 /*---------------------------------------------------------------------------*/
 PROCESS(mqtt_process, "MQTT process");
 /*---------------------------------------------------------------------------*/
@@ -204,6 +214,158 @@ call_event(struct mqtt_connection *conn,
   process_post(conn->app_process, mqtt_update_event, NULL);
 }
 /*---------------------------------------------------------------------------*/
+static struct mqtt_in_flight *
+in_flight_find(struct mqtt_connection *conn, uint16_t mid)
+{
+  struct mqtt_in_flight *m;
+
+  for(m = list_head(conn->in_flight); m != NULL; m = m->next) {
+    if(m->mid == mid) {
+      return m;
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+#if MQTT_IN_FLIGHT_CFS
+static void
+in_flight_filename(struct mqtt_in_flight *m, char *name)
+{
+  sprintf(name, "mqtt-msg%u",
+          (unsigned)(m - (struct mqtt_in_flight *)in_flight_memb.mem));
+}
+/*---------------------------------------------------------------------------*/
+static int
+store_payload(struct mqtt_in_flight *m, uint8_t *payload,
+              uint32_t payload_size)
+{
+  char name[16];
+  int fd;
+  int written;
+
+  in_flight_filename(m, name);
+  cfs_remove(name);
+  fd = cfs_open(name, CFS_WRITE);
+  if(fd < 0) {
+    return -1;
+  }
+  written = cfs_write(fd, payload, payload_size);
+  cfs_close(fd);
+
+  return written == (int)payload_size ? 0 : -1;
+}
+#endif /* MQTT_IN_FLIGHT_CFS */
+/*---------------------------------------------------------------------------*/
+static void
+close_stored(struct mqtt_connection *conn)
+{
+#if MQTT_IN_FLIGHT_CFS
+  if(conn->in_flight_fd >= 0) {
+    cfs_close(conn->in_flight_fd);
+    conn->in_flight_fd = -1;
+  }
+#endif
+}
+/*---------------------------------------------------------------------------*/
+static void
+in_flight_free(struct mqtt_connection *conn, struct mqtt_in_flight *m)
+{
+#if MQTT_IN_FLIGHT_CFS
+  char name[16];
+
+  in_flight_filename(m, name);
+  cfs_remove(name);
+#endif
+  list_remove(conn->in_flight, m);
+  memb_free(&in_flight_memb, m);
+}
+/*---------------------------------------------------------------------------*/
+static uint16_t
+next_mid(struct mqtt_connection *conn)
+{
+  /* Skip IDs still taken by in-flight messages once the counter wraps */
+  do {
+    INCREMENT_MID(conn);
+  } while(in_flight_find(conn, conn->mid_counter) != NULL);
+
+  return conn->mid_counter;
+}
+/*---------------------------------------------------------------------------*/
+static void
+queue_ack(struct mqtt_connection *conn, uint8_t fhdr, uint16_t mid)
+{
+  if(conn->ack_count == MQTT_MAX_PENDING_ACKS) {
+    PRINTF("MQTT - Ack queue full, dropping ack for message %u\n", mid);
+    return;
+  }
+  conn->acks[conn->ack_count].fhdr = fhdr;
+  conn->acks[conn->ack_count].mid = mid;
+  conn->ack_count++;
+
+  process_post(&mqtt_process, mqtt_do_in_flight_event, conn);
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Sets up in_flight_packet with the next packet to send: queued acks first,
+ * then the PUBLISH or PUBREL of in-flight messages in the order they were
+ * published. Returns 0 if there is nothing to send.
+ */
+static int
+next_in_flight(struct mqtt_connection *conn)
+{
+  struct mqtt_out_packet *packet = &conn->in_flight_packet;
+  struct mqtt_in_flight *m;
+#if MQTT_IN_FLIGHT_CFS
+  char name[16];
+#endif
+
+  if(conn->ack_count > 0) {
+    packet->fhdr = conn->acks[0].fhdr;
+    packet->mid = conn->acks[0].mid;
+    conn->ack_count--;
+    memmove(&conn->acks[0], &conn->acks[1],
+            conn->ack_count * sizeof(conn->acks[0]));
+    return 1;
+  }
+
+  for(m = list_head(conn->in_flight); m != NULL; m = m->next) {
+    if(!m->pending) {
+      continue;
+    }
+    m->pending = 0;
+    packet->mid = m->mid;
+
+    if(m->qos_state == MQTT_QOS_STATE_GOT_REC) {
+      packet->fhdr = MQTT_FHDR_MSG_TYPE_PUBREL | MQTT_FHDR_QOS_LEVEL_1;
+      return 1;
+    }
+
+    packet->fhdr = MQTT_FHDR_MSG_TYPE_PUBLISH;
+    packet->topic = m->topic;
+    packet->topic_length = strlen(m->topic);
+    packet->payload_size = m->payload_size;
+    packet->qos = m->qos;
+    packet->retain = m->retain;
+    packet->dup = m->dup;
+    packet->producer = m->producer;
+    packet->producer_ptr = m->producer_ptr;
+    packet->payload = NULL;
+#if MQTT_IN_FLIGHT_CFS
+    if(m->producer == NULL) {
+      in_flight_filename(m, name);
+      conn->in_flight_fd = cfs_open(name, CFS_READ);
+    }
+#else
+    packet->payload = m->payload;
+#endif
+    /* Any later transmission is a duplicate */
+    m->dup = 1;
+    return 1;
+  }
+
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
 static void
 reset_defaults(struct mqtt_connection *conn)
 {
@@ -224,6 +386,10 @@ abort_connection(struct mqtt_connection *conn)
   /* Reset outgoing packet */
   memset(&conn->out_packet, 0, sizeof(conn->out_packet));
 
+  /* In-flight messages stay until the next connection, acks are moot */
+  close_stored(conn);
+  conn->ack_count = 0;
+
   tcp_socket_close(&conn->socket);
   tcp_socket_unregister(&conn->socket);
 
@@ -331,6 +497,49 @@ write_bytes(struct mqtt_connection *conn, uint8_t *data, uint16_t len)
   }
 }
 /*---------------------------------------------------------------------------*/
+/*
+ * Like write_bytes(), but the payload is written in place by the producer
+ * of the packet or, without one, read from in_flight_fd. Returns -1 if
+ * that came short.
+ */
+static int
+write_produced(struct mqtt_connection *conn, struct mqtt_out_packet *packet)
+{
+  int write_bytes;
+  int produced = 0;
+
+  write_bytes =
+    MIN(&conn->out_buffer[MQTT_TCP_OUTPUT_BUFF_SIZE] - conn->out_buffer_ptr,
+        packet->payload_size - conn->out_write_pos);
+
+  if(write_bytes > 0) {
+    if(packet->producer != NULL) {
+      produced = packet->producer(conn, packet->producer_ptr,
+                                  conn->out_write_pos, conn->out_buffer_ptr,
+                                  write_bytes);
+    }
+#if MQTT_IN_FLIGHT_CFS
+    else {
+      produced = cfs_read(conn->in_flight_fd, conn->out_buffer_ptr,
+                          write_bytes);
+    }
+#endif
+  }
+  if(produced < write_bytes) {
+    return -1;
+  }
+  conn->out_write_pos += write_bytes;
+  conn->out_buffer_ptr += write_bytes;
+
+  if(packet->payload_size - conn->out_write_pos == 0) {
+    conn->out_write_pos = 0;
+    return 0;
+  } else {
+    send_out_buffer(conn);
+    return packet->payload_size - conn->out_write_pos;
+  }
+}
+/*---------------------------------------------------------------------------*/
 static void
 encode_remaining_length(uint8_t *remaining_length,
                         uint8_t *remaining_length_bytes,
@@ -507,6 +716,9 @@ PT_THREAD(subscribe_pt(struct pt *pt, struct mqtt_connection *conn))
 {
   PT_BEGIN(pt);
 
+  /* Wait for the previous packet to leave the buffer */
+  PT_WAIT_UNTIL(pt, conn->out_buffer_sent);
+
   DBG("MQTT - Sending subscribe message! topic %s topic_length %i\n",
       conn->out_packet.topic,
       conn->out_packet.topic_length);
@@ -534,7 +746,7 @@ PT_THREAD(subscribe_pt(struct pt *pt, struct mqtt_connection *conn))
                       conn->out_packet.remaining_length_enc,
                       conn->out_packet.remaining_length_enc_bytes);
   /* Write Variable Header */
-  PT_MQTT_WRITE_BYTE(conn, (conn->out_packet.mid << 8));
+  PT_MQTT_WRITE_BYTE(conn, (conn->out_packet.mid >> 8));
   PT_MQTT_WRITE_BYTE(conn, (conn->out_packet.mid & 0x00FF));
   /* Write Payload */
   PT_MQTT_WRITE_BYTE(conn, (conn->out_packet.topic_length >> 8));
@@ -570,6 +782,9 @@ PT_THREAD(unsubscribe_pt(struct pt *pt, struct mqtt_connection *conn))
 {
   PT_BEGIN(pt);
 
+  /* Wait for the previous packet to leave the buffer */
+  PT_WAIT_UNTIL(pt, conn->out_buffer_sent);
+
   DBG("MQTT - Sending unsubscribe message on topic %s topic_length %i\n",
       conn->out_packet.topic,
       conn->out_packet.topic_length);
@@ -596,7 +811,7 @@ PT_THREAD(unsubscribe_pt(struct pt *pt, struct mqtt_connection *conn))
   PT_MQTT_WRITE_BYTES(conn, (uint8_t *)conn->out_packet.remaining_length_enc,
                       conn->out_packet.remaining_length_enc_bytes);
   /* Write Variable Header */
-  PT_MQTT_WRITE_BYTE(conn, (conn->out_packet.mid << 8));
+  PT_MQTT_WRITE_BYTE(conn, (conn->out_packet.mid >> 8));
   PT_MQTT_WRITE_BYTE(conn, (conn->out_packet.mid & 0x00FF));
   /* Write Payload */
   PT_MQTT_WRITE_BYTE(conn, (conn->out_packet.topic_length >> 8));
@@ -627,94 +842,122 @@ PT_THREAD(unsubscribe_pt(struct pt *pt, struct mqtt_connection *conn))
   PT_END(pt);
 }
 /*---------------------------------------------------------------------------*/
+/*
+ * Drops the connection in the middle of a PUBLISH whose payload came short,
+ * the remaining length is already sent. The message is given up, it would
+ * only come short again.
+ */
+static void
+fail_publish(struct mqtt_connection *conn, struct mqtt_out_packet *packet)
+{
+  struct mqtt_in_flight *m;
+  uint16_t mid;
+
+  PRINTF("MQTT - Error, payload of message %u is short\n", packet->mid);
+
+  mid = packet->mid;
+  m = packet->qos > MQTT_QOS_LEVEL_0 ? in_flight_find(conn, mid) : NULL;
+
+  tcp_event(&conn->socket, conn, TCP_SOCKET_ABORTED);
+
+  if(m != NULL) {
+    in_flight_free(conn, m);
+  }
+  call_event(conn, MQTT_EVENT_PUBLISH_FAILED, &mid);
+}
+/*---------------------------------------------------------------------------*/
 static
-PT_THREAD(publish_pt(struct pt *pt, struct mqtt_connection *conn))
+PT_THREAD(publish_pt(struct pt *pt, struct mqtt_connection *conn,
+                     struct mqtt_out_packet *packet))
 {
+  int left;
+
   PT_BEGIN(pt);
 
+  /* Wait for the previous packet to leave the buffer */
+  PT_WAIT_UNTIL(pt, conn->out_buffer_sent);
+
   DBG("MQTT - Sending publish message! topic %s topic_length %i\n",
-      conn->out_packet.topic,
-      conn->out_packet.topic_length);
+      packet->topic,
+      packet->topic_length);
   DBG("MQTT - Buffer space is %i \n",
       &conn->out_buffer[MQTT_TCP_OUTPUT_BUFF_SIZE] - conn->out_buffer_ptr);
 
   /* Set up FHDR */
-  conn->out_packet.fhdr = MQTT_FHDR_MSG_TYPE_PUBLISH |
-    conn->out_packet.qos << 1;
-  if(conn->out_packet.retain == MQTT_RETAIN_ON) {
-    conn->out_packet.fhdr |= MQTT_FHDR_RETAIN_FLAG;
+  packet->fhdr = MQTT_FHDR_MSG_TYPE_PUBLISH | packet->qos << 1;
+  if(packet->retain == MQTT_RETAIN_ON) {
+    packet->fhdr |= MQTT_FHDR_RETAIN_FLAG;
   }
-  conn->out_packet.remaining_length = MQTT_STRING_LEN_SIZE +
-    conn->out_packet.topic_length +
-    conn->out_packet.payload_size;
-  if(conn->out_packet.qos > MQTT_QOS_LEVEL_0) {
-    conn->out_packet.remaining_length += MQTT_MID_SIZE;
+  if(packet->dup) {
+    packet->fhdr |= MQTT_FHDR_DUP_FLAG;
   }
-  encode_remaining_length(conn->out_packet.remaining_length_enc,
-                          &conn->out_packet.remaining_length_enc_bytes,
-                          conn->out_packet.remaining_length);
-  if(conn->out_packet.remaining_length_enc_bytes > 4) {
+  packet->remaining_length = MQTT_STRING_LEN_SIZE +
+    packet->topic_length +
+    packet->payload_size;
+  if(packet->qos > MQTT_QOS_LEVEL_0) {
+    packet->remaining_length += MQTT_MID_SIZE;
+  }
+  encode_remaining_length(packet->remaining_length_enc,
+                          &packet->remaining_length_enc_bytes,
+                          packet->remaining_length);
+  if(packet->remaining_length_enc_bytes > 4) {
     call_event(conn, MQTT_EVENT_PROTOCOL_ERROR, NULL);
     PRINTF("MQTT - Error, remaining length > 4 bytes\n");
     PT_EXIT(pt);
   }
 
   /* Write Fixed Header */
-  PT_MQTT_WRITE_BYTE(conn, conn->out_packet.fhdr);
-  PT_MQTT_WRITE_BYTES(conn, (uint8_t *)conn->out_packet.remaining_length_enc,
-                      conn->out_packet.remaining_length_enc_bytes);
+  PT_MQTT_WRITE_BYTE(conn, packet->fhdr);
+  PT_MQTT_WRITE_BYTES(conn, (uint8_t *)packet->remaining_length_enc,
+                      packet->remaining_length_enc_bytes);
   /* Write Variable Header */
-  PT_MQTT_WRITE_BYTE(conn, (conn->out_packet.topic_length >> 8));
-  PT_MQTT_WRITE_BYTE(conn, (conn->out_packet.topic_length & 0x00FF));
-  PT_MQTT_WRITE_BYTES(conn, (uint8_t *)conn->out_packet.topic,
-                      conn->out_packet.topic_length);
-  if(conn->out_packet.qos > MQTT_QOS_LEVEL_0) {
-    PT_MQTT_WRITE_BYTE(conn, (conn->out_packet.mid << 8));
-    PT_MQTT_WRITE_BYTE(conn, (conn->out_packet.mid & 0x00FF));
+  PT_MQTT_WRITE_BYTE(conn, (packet->topic_length >> 8));
+  PT_MQTT_WRITE_BYTE(conn, (packet->topic_length & 0x00FF));
+  PT_MQTT_WRITE_BYTES(conn, (uint8_t *)packet->topic,
+                      packet->topic_length);
+  if(packet->qos > MQTT_QOS_LEVEL_0) {
+    PT_MQTT_WRITE_BYTE(conn, (packet->mid >> 8));
+    PT_MQTT_WRITE_BYTE(conn, (packet->mid & 0x00FF));
   }
   /* Write Payload */
-  PT_MQTT_WRITE_BYTES(conn,
-                      conn->out_packet.payload,
-                      conn->out_packet.payload_size);
-
-  send_out_buffer(conn);
-  timer_set(&conn->t, RESPONSE_WAIT_TIMEOUT);
-
-  /*
-   * If QoS is zero then wait until the message has been sent, since there is
-   * no ACK to wait for.
-   *
-   * Also notify the app will not be notified via PUBACK or PUBCOMP
-   */
-  if(conn->out_packet.qos == 0) {
-    process_post(conn->app_process, mqtt_update_event, NULL);
-  } else if(conn->out_packet.qos == 1) {
-    /* Wait for PUBACK */
-    reset_packet(&conn->in_packet);
-    PT_WAIT_UNTIL(pt, conn->out_packet.qos_state == MQTT_QOS_STATE_GOT_ACK ||
-                  timer_expired(&conn->t));
-    if(timer_expired(&conn->t)) {
-      DBG("Timeout waiting for PUBACK\n");
+  if(packet->payload == NULL) {
+    conn->out_write_pos = 0;
+    while((left = write_produced(conn, packet)) > 0) {
+      PT_WAIT_UNTIL(pt, conn->out_buffer_sent);
     }
-    if(conn->in_packet.mid != conn->out_packet.mid) {
-      DBG("MQTT - Warning, got PUBACK with none matching MID. Currently there "
-          "is no support for several concurrent PUBLISH messages.\n");
+    if(left < 0) {
+      fail_publish(conn, packet);
+      PT_EXIT(pt);
     }
-  } else if(conn->out_packet.qos == 2) {
-    DBG("MQTT - QoS not implemented yet.\n");
-    /* Should wait for PUBREC, send PUBREL and then wait for PUBCOMP */
+  } else {
+    PT_MQTT_WRITE_BYTES(conn, packet->payload, packet->payload_size);
   }
 
-  reset_packet(&conn->in_packet);
-
-  /* This is clear after the entire transaction is complete */
-  conn->out_queue_full = 0;
+  send_out_buffer(conn);
 
   DBG("MQTT - Publish Enqueued\n");
 
   PT_END(pt);
 }
 /*---------------------------------------------------------------------------*/
+/* Sends the PUBREL or ack set up in in_flight_packet */
+static
+PT_THREAD(ack_pt(struct pt *pt, struct mqtt_connection *conn))
+{
+  PT_BEGIN(pt);
+
+  PT_WAIT_UNTIL(pt, conn->out_buffer_sent);
+
+  PT_MQTT_WRITE_BYTE(conn, conn->in_flight_packet.fhdr);
+  PT_MQTT_WRITE_BYTE(conn, MQTT_MID_SIZE);
+  PT_MQTT_WRITE_BYTE(conn, (conn->in_flight_packet.mid >> 8));
+  PT_MQTT_WRITE_BYTE(conn, (conn->in_flight_packet.mid & 0x00FF));
+
+  send_out_buffer(conn);
+
+  PT_END(pt);
+}
+/*---------------------------------------------------------------------------*/
 static
 PT_THREAD(pingreq_pt(struct pt *pt, struct mqtt_connection *conn))
 {
@@ -747,6 +990,9 @@ PT_THREAD(pingreq_pt(struct pt *pt, struct mqtt_connection *conn))
 static void
 handle_connack(struct mqtt_connection *conn)
 {
+  struct mqtt_in_flight *m;
+  uint16_t mid;
+
   DBG("MQTT - Got CONNACK\n");
 
   if(conn->in_packet.payload[1] != 0) {
@@ -766,6 +1012,27 @@ handle_connack(struct mqtt_connection *conn)
 
   /* Always reset packet before callback since it might be used directly */
   conn->state = MQTT_CONN_STATE_CONNECTED_TO_BROKER;
+
+  if(!(conn->connect_vhdr_flags & MQTT_VHDR_CLEAN_SESSION_FLAG) &&
+     (conn->in_packet.payload[0] & MQTT_CONNACK_SESSION_PRESENT)) {
+    /* Resend whatever was left unacknowledged on the previous connection */
+    for(m = list_head(conn->in_flight); m != NULL; m = m->next) {
+      m->pending = 1;
+    }
+    if(list_head(conn->in_flight) != NULL) {
+      process_post(&mqtt_process, mqtt_do_in_flight_event, conn);
+    }
+  } else {
+    /* The broker has no session, so it does not expect the PUBRELs of
+       QoS 2 messages, nor will it release those it had received */
+    memset(conn->rec_mid, 0, sizeof(conn->rec_mid));
+    while((m = list_head(conn->in_flight)) != NULL) {
+      mid = m->mid;
+      in_flight_free(conn, m);
+      call_event(conn, MQTT_EVENT_PUBLISH_FAILED, &mid);
+    }
+  }
+
   call_event(conn, MQTT_EVENT_CONNECTED, NULL);
 }
 /*---------------------------------------------------------------------------*/
@@ -824,29 +1091,100 @@ handle_unsuback(struct mqtt_connection *conn)
 static void
 handle_puback(struct mqtt_connection *conn)
 {
+  struct mqtt_in_flight *m;
+
   DBG("MQTT - Got PUBACK\n");
 
-  conn->out_packet.qos_state = MQTT_QOS_STATE_GOT_ACK;
   conn->in_packet.mid = (conn->in_packet.payload[0] << 8) |
     (conn->in_packet.payload[1]);
 
+  m = in_flight_find(conn, conn->in_packet.mid);
+  if(m == NULL || m->qos != MQTT_QOS_LEVEL_1) {
+    DBG("MQTT - Warning, got PUBACK for unknown MID %u\n",
+        conn->in_packet.mid);
+    return;
+  }
+  in_flight_free(conn, m);
+
   call_event(conn, MQTT_EVENT_PUBACK, &conn->in_packet.mid);
 }
 /*---------------------------------------------------------------------------*/
 static void
+handle_pubrec(struct mqtt_connection *conn)
+{
+  struct mqtt_in_flight *m;
+
+  DBG("MQTT - Got PUBREC\n");
+
+  conn->in_packet.mid = (conn->in_packet.payload[0] << 8) |
+    (conn->in_packet.payload[1]);
+
+  m = in_flight_find(conn, conn->in_packet.mid);
+  if(m == NULL || m->qos != MQTT_QOS_LEVEL_2) {
+    /* Release it anyway so that the broker can drop its state */
+    queue_ack(conn, MQTT_FHDR_MSG_TYPE_PUBREL | MQTT_FHDR_QOS_LEVEL_1,
+              conn->in_packet.mid);
+    return;
+  }
+  m->qos_state = MQTT_QOS_STATE_GOT_REC;
+  m->pending = 1;
+  process_post(&mqtt_process, mqtt_do_in_flight_event, conn);
+}
+/*---------------------------------------------------------------------------*/
+static void
+handle_pubcomp(struct mqtt_connection *conn)
+{
+  struct mqtt_in_flight *m;
+
+  DBG("MQTT - Got PUBCOMP\n");
+
+  conn->in_packet.mid = (conn->in_packet.payload[0] << 8) |
+    (conn->in_packet.payload[1]);
+
+  m = in_flight_find(conn, conn->in_packet.mid);
+  if(m == NULL || m->qos_state != MQTT_QOS_STATE_GOT_REC) {
+    DBG("MQTT - Warning, got PUBCOMP for unknown MID %u\n",
+        conn->in_packet.mid);
+    return;
+  }
+  in_flight_free(conn, m);
+
+  call_event(conn, MQTT_EVENT_PUBCOMP, &conn->in_packet.mid);
+}
+/*---------------------------------------------------------------------------*/
+static void
+handle_pubrel(struct mqtt_connection *conn)
+{
+  int i;
+
+  DBG("MQTT - Got PUBREL\n");
+
+  conn->in_packet.mid = (conn->in_packet.payload[0] << 8) |
+    (conn->in_packet.payload[1]);
+
+  for(i = 0; i < MQTT_MAX_INBOUND_QOS2; i++) {
+    if(conn->rec_mid[i] == conn->in_packet.mid) {
+      conn->rec_mid[i] = 0;
+    }
+  }
+  queue_ack(conn, MQTT_FHDR_MSG_TYPE_PUBCOMP, conn->in_packet.mid);
+}
+/*---------------------------------------------------------------------------*/
+static void
 handle_publish(struct mqtt_connection *conn)
 {
+  uint8_t qos;
+
   DBG("MQTT - Got PUBLISH, called once per manageable chunk of message.\n");
   DBG("MQTT - Handling publish on topic '%s'\n", conn->in_publish_msg.topic);
 
   DBG("MQTT - This chunk is %i bytes\n", conn->in_packet.payload_pos);
 
-  if(((conn->in_packet.fhdr & 0x09) >> 1) > 0) {
-    PRINTF("MQTT - Error, got incoming PUBLISH with QoS > 0, not supported atm!\n");
+  /* A QoS 2 message we have already delivered is only acknowledged again */
+  if(!conn->in_packet.duplicate) {
+    call_event(conn, MQTT_EVENT_PUBLISH, &conn->in_publish_msg);
   }
 
-  call_event(conn, MQTT_EVENT_PUBLISH, &conn->in_publish_msg);
-
   if(conn->in_publish_msg.first_chunk == 1) {
     conn->in_publish_msg.first_chunk = 0;
   }
@@ -856,12 +1194,45 @@ handle_publish(struct mqtt_connection *conn)
 
     /* Check for QoS and initiate the reply, do not rely on the data in the
      * in_packet being untouched. */
+    qos = (conn->in_packet.fhdr & 0x06) >> 1;
+    if(qos == MQTT_QOS_LEVEL_1) {
+      queue_ack(conn, MQTT_FHDR_MSG_TYPE_PUBACK, conn->in_packet.mid);
+    } else if(qos == MQTT_QOS_LEVEL_2) {
+      queue_ack(conn, MQTT_FHDR_MSG_TYPE_PUBREC, conn->in_packet.mid);
+    }
 
     DBG("MQTT - (handle_publish) resetting packet.\n");
     reset_packet(&conn->in_packet);
   }
 }
 /*---------------------------------------------------------------------------*/
+/*
+ * Remembers the ID of an incoming QoS 2 message until its PUBREL so that a
+ * retransmission is not delivered twice.
+ */
+static void
+check_qos2_duplicate(struct mqtt_connection *conn)
+{
+  int i;
+  int free_slot = -1;
+
+  for(i = 0; i < MQTT_MAX_INBOUND_QOS2; i++) {
+    if(conn->rec_mid[i] == conn->in_packet.mid) {
+      conn->in_packet.duplicate = 1;
+      return;
+    }
+    if(conn->rec_mid[i] == 0 && free_slot < 0) {
+      free_slot = i;
+    }
+  }
+
+  if(free_slot < 0) {
+    PRINTF("MQTT - No room to track QoS 2 message %u\n", conn->in_packet.mid);
+    return;
+  }
+  conn->rec_mid[free_slot] = conn->in_packet.mid;
+}
+/*---------------------------------------------------------------------------*/
 static void
 parse_publish_vhdr(struct mqtt_connection *conn,
                    uint32_t *pos,
@@ -911,29 +1282,51 @@ parse_publish_vhdr(struct mqtt_connection *conn,
     /* Set this once per incomming publish message */
     conn->in_publish_msg.first_chunk = 1;
   }
+
+  /* Read out the message ID of QoS 1 and 2 messages */
+  if(conn->in_packet.topic_received == 1 &&
+     conn->in_packet.vhdr_received == 0) {
+    if(conn->in_packet.fhdr & 0x06) {
+      while(conn->in_packet.mid_bytes < MQTT_MID_SIZE &&
+            *pos < input_data_len) {
+        conn->in_packet.mid = (conn->in_packet.mid << 8) |
+          input_data_ptr[(*pos)++];
+        conn->in_packet.byte_counter++;
+        conn->in_packet.mid_bytes++;
+      }
+      if(conn->in_packet.mid_bytes < MQTT_MID_SIZE) {
+        return;
+      }
+      conn->in_publish_msg.payload_length -= MQTT_MID_SIZE;
+      conn->in_publish_msg.payload_left = conn->in_publish_msg.payload_length;
+
+      if((conn->in_packet.fhdr & 0x06) == MQTT_FHDR_QOS_LEVEL_2) {
+        check_qos2_duplicate(conn);
+      }
+    }
+    conn->in_publish_msg.mid = conn->in_packet.mid;
+    conn->in_packet.vhdr_received = 1;
+  }
 }
 /*---------------------------------------------------------------------------*/
-static int
-tcp_input(struct tcp_socket *s,
-          void *ptr,
-          const uint8_t *input_data_ptr,
-          int input_data_len)
+/*
+ * Reads the packet, or the part of it, starting at pos. Returns the position
+ * following it.
+ */
+static uint32_t
+input_packet(struct mqtt_connection *conn,
+             const uint8_t *input_data_ptr,
+             int input_data_len,
+             uint32_t pos)
 {
-  struct mqtt_connection *conn = ptr;
-  uint32_t pos = 0;
   uint32_t copy_bytes = 0;
+  uint32_t packet_length;
   uint8_t byte;
 
-  if(input_data_len == 0) {
-    return 0;
-  }
-
   if(conn->in_packet.packet_received) {
     reset_packet(&conn->in_packet);
   }
 
-  DBG("tcp_input with %i bytes of data:\n", input_data_len);
-
   /* Read the fixed header field, if we do not have it */
   if(!conn->in_packet.fhdr) {
     conn->in_packet.fhdr = input_data_ptr[pos++];
@@ -942,7 +1335,7 @@ tcp_input(struct tcp_socket *s,
     DBG("MQTT - Read VHDR '%02X'\n", conn->in_packet.fhdr);
 
     if(pos >= input_data_len) {
-      return 0;
+      return pos;
     }
   }
 
@@ -950,7 +1343,7 @@ tcp_input(struct tcp_socket *s,
   if(!conn->in_packet.has_remaining_length) {
     do {
       if(pos >= input_data_len) {
-        return 0;
+        return pos;
       }
 
       byte = input_data_ptr[pos++];
@@ -961,7 +1354,7 @@ tcp_input(struct tcp_socket *s,
       if(conn->in_packet.byte_counter > 5) {
         call_event(conn, MQTT_EVENT_ERROR, NULL);
         DBG("Received more then 4 byte 'remaining lenght'.");
-        return 0;
+        return input_data_len;
       }
 
       conn->in_packet.remaining_length +=
@@ -972,6 +1365,8 @@ tcp_input(struct tcp_socket *s,
     DBG("MQTT - Finished reading remaining length byte\n");
     conn->in_packet.has_remaining_length = 1;
   }
+  packet_length = MQTT_FHDR_SIZE + conn->in_packet.remaining_length_bytes +
+    conn->in_packet.remaining_length;
 
   /*
    * Check for unsupported payload length. Will read all incoming data from the
@@ -984,12 +1379,13 @@ tcp_input(struct tcp_socket *s,
 
     PRINTF("MQTT - Error, unsupported payload size for non-PUBLISH message\n");
 
-    conn->in_packet.byte_counter += input_data_len;
-    if(conn->in_packet.byte_counter >=
-       (MQTT_FHDR_SIZE + conn->in_packet.remaining_length)) {
+    copy_bytes = MIN(input_data_len - pos,
+                     packet_length - conn->in_packet.byte_counter);
+    conn->in_packet.byte_counter += copy_bytes;
+    if(conn->in_packet.byte_counter >= packet_length) {
       conn->in_packet.packet_received = 1;
     }
-    return 0;
+    return pos + copy_bytes;
   }
 
   /*
@@ -998,17 +1394,17 @@ tcp_input(struct tcp_socket *s,
    * Note: There will always be at least one byte left to read when we enter
    *       this loop.
    */
-  while(conn->in_packet.byte_counter <
-        (MQTT_FHDR_SIZE + conn->in_packet.remaining_length)) {
+  while(conn->in_packet.byte_counter < packet_length) {
 
     if((conn->in_packet.fhdr & 0xF0) == MQTT_FHDR_MSG_TYPE_PUBLISH &&
-       conn->in_packet.topic_received == 0) {
+       conn->in_packet.vhdr_received == 0) {
       parse_publish_vhdr(conn, &pos, input_data_ptr, input_data_len);
     }
 
     /* Read in as much as we can into the packet payload */
     copy_bytes = MIN(input_data_len - pos,
                      MQTT_INPUT_BUFF_SIZE - conn->in_packet.payload_pos);
+    copy_bytes = MIN(copy_bytes, packet_length - conn->in_packet.byte_counter);
     DBG("- Copied %lu payload bytes\n", copy_bytes);
     memcpy(&conn->in_packet.payload[conn->in_packet.payload_pos],
            &input_data_ptr[pos],
@@ -1032,13 +1428,19 @@ tcp_input(struct tcp_socket *s,
 
       handle_publish(conn);
 
+      /* The packet is reset once the last chunk has been handled */
+      if(conn->in_publish_msg.payload_left == 0) {
+        conn->in_packet.packet_received = 1;
+        return pos;
+      }
+
       conn->in_publish_msg.payload_chunk = conn->in_packet.payload;
       conn->in_packet.payload_pos = 0;
     }
 
     if(pos >= input_data_len &&
-       (conn->in_packet.byte_counter < (MQTT_FHDR_SIZE + conn->in_packet.remaining_length))) {
-      return 0;
+       conn->in_packet.byte_counter < packet_length) {
+      return pos;
     }
   }
 
@@ -1047,8 +1449,7 @@ tcp_input(struct tcp_socket *s,
   /* Take care of input */
   DBG("MQTT - Finished reading packet!\n");
   /* What to return? */
-  DBG("MQTT - total data was %i bytes of data. \n",
-      (MQTT_FHDR_SIZE + conn->in_packet.remaining_length));
+  DBG("MQTT - total data was %lu bytes of data. \n", packet_length);
 
   /* Handle packet here. */
   switch(conn->in_packet.fhdr & 0xF0) {
@@ -1074,14 +1475,14 @@ tcp_input(struct tcp_socket *s,
   case MQTT_FHDR_MSG_TYPE_PINGRESP:
     handle_pingresp(conn);
     break;
-
-  /* QoS 2 not implemented yet */
   case MQTT_FHDR_MSG_TYPE_PUBREC:
+    handle_pubrec(conn);
+    break;
   case MQTT_FHDR_MSG_TYPE_PUBREL:
+    handle_pubrel(conn);
+    break;
   case MQTT_FHDR_MSG_TYPE_PUBCOMP:
-    call_event(conn, MQTT_EVENT_NOT_IMPLEMENTED_ERROR, NULL);
-    PRINTF("MQTT - Got unhandled MQTT Message Type '%i'",
-           (conn->in_packet.fhdr & 0xF0));
+    handle_pubcomp(conn);
     break;
 
   default:
@@ -1092,6 +1493,25 @@ tcp_input(struct tcp_socket *s,
 
   conn->in_packet.packet_received = 1;
 
+  return pos;
+}
+/*---------------------------------------------------------------------------*/
+static int
+tcp_input(struct tcp_socket *s,
+          void *ptr,
+          const uint8_t *input_data_ptr,
+          int input_data_len)
+{
+  struct mqtt_connection *conn = ptr;
+  uint32_t pos = 0;
+
+  DBG("tcp_input with %i bytes of data:\n", input_data_len);
+
+  /* A segment can carry several packets, e.g. the PUBACKs of a window */
+  while(pos < input_data_len) {
+    pos = input_packet(conn, input_data_ptr, input_data_len, pos);
+  }
+
   return 0;
 }
 /*---------------------------------------------------------------------------*/
@@ -1118,10 +1538,8 @@ tcp_event(struct tcp_socket *s, void *ptr, tcp_socket_event_t event)
     call_event(conn, MQTT_EVENT_DISCONNECTED, &event);
     abort_connection(conn);
 
-    /* If connecting retry */
-    if(conn->auto_reconnect == 1) {
-      connect_tcp(conn);
-    }
+    /* Reconnecting is left to the abort event, which would otherwise tear
+     * down the new connection */
     break;
   }
   case TCP_SOCKET_CONNECTED: {
@@ -1165,6 +1583,11 @@ PROCESS_THREAD(mqtt_process, ev, data)
       conn->state = MQTT_CONN_STATE_ABORT_IMMEDIATE;
 
       abort_connection(conn);
+
+      /* If connecting retry */
+      if(conn->auto_reconnect == 1) {
+        connect_tcp(conn);
+      }
     }
     if(ev == mqtt_do_connect_tcp_event) {
       conn = data;
@@ -1220,8 +1643,7 @@ PROCESS_THREAD(mqtt_process, ev, data)
       conn = data;
       DBG("MQTT - Got mqtt_do_subscribe_mqtt_event!\n");
 
-      if(conn->out_buffer_sent == 1 &&
-         conn->state == MQTT_CONN_STATE_CONNECTED_TO_BROKER) {
+      if(conn->state == MQTT_CONN_STATE_CONNECTED_TO_BROKER) {
         PT_INIT(&conn->out_proto_thread);
         while(conn->state == MQTT_CONN_STATE_CONNECTED_TO_BROKER &&
               subscribe_pt(&conn->out_proto_thread, conn) < PT_EXITED) {
@@ -1233,8 +1655,7 @@ PROCESS_THREAD(mqtt_process, ev, data)
       conn = data;
       DBG("MQTT - Got mqtt_do_unsubscribe_mqtt_event!\n");
 
-      if(conn->out_buffer_sent == 1 &&
-         conn->state == MQTT_CONN_STATE_CONNECTED_TO_BROKER) {
+      if(conn->state == MQTT_CONN_STATE_CONNECTED_TO_BROKER) {
         PT_INIT(&conn->out_proto_thread);
         while(conn->state == MQTT_CONN_STATE_CONNECTED_TO_BROKER &&
               unsubscribe_pt(&conn->out_proto_thread, conn) < PT_EXITED) {
@@ -1246,13 +1667,40 @@ PROCESS_THREAD(mqtt_process, ev, data)
       conn = data;
       DBG("MQTT - Got mqtt_do_publish_mqtt_event!\n");
 
-      if(conn->out_buffer_sent == 1 &&
-         conn->state == MQTT_CONN_STATE_CONNECTED_TO_BROKER) {
+      if(conn->state == MQTT_CONN_STATE_CONNECTED_TO_BROKER) {
         PT_INIT(&conn->out_proto_thread);
         while(conn->state == MQTT_CONN_STATE_CONNECTED_TO_BROKER &&
-              publish_pt(&conn->out_proto_thread, conn) < PT_EXITED) {
+              publish_pt(&conn->out_proto_thread, conn,
+                         &conn->out_packet) < PT_EXITED) {
           PT_MQTT_WAIT_SEND();
         }
+
+        /* QoS 0, there is no ACK to wait for */
+        conn->out_queue_full = 0;
+        process_post(conn->app_process, mqtt_update_event, NULL);
+      }
+    }
+    if(ev == mqtt_do_in_flight_event) {
+      conn = data;
+      DBG("MQTT - Got mqtt_do_in_flight_event!\n");
+
+      while(conn->state == MQTT_CONN_STATE_CONNECTED_TO_BROKER &&
+            next_in_flight(conn)) {
+        PT_INIT(&conn->out_proto_thread);
+        if((conn->in_flight_packet.fhdr & 0xF0) ==
+           MQTT_FHDR_MSG_TYPE_PUBLISH) {
+          while(conn->state == MQTT_CONN_STATE_CONNECTED_TO_BROKER &&
+                publish_pt(&conn->out_proto_thread, conn,
+                           &conn->in_flight_packet) < PT_EXITED) {
+            PT_MQTT_WAIT_SEND();
+          }
+          close_stored(conn);
+        } else {
+          while(conn->state == MQTT_CONN_STATE_CONNECTED_TO_BROKER &&
+                ack_pt(&conn->out_proto_thread, conn) < PT_EXITED) {
+            PT_MQTT_WAIT_SEND();
+          }
+        }
       }
     }
   }
@@ -1273,6 +1721,7 @@ mqtt_init(void)
     mqtt_do_unsubscribe_event = process_alloc_event();
     mqtt_do_publish_event = process_alloc_event();
     mqtt_do_pingreq_event = process_alloc_event();
+    mqtt_do_in_flight_event = process_alloc_event();
     mqtt_update_event = process_alloc_event();
     mqtt_abort_now_event = process_alloc_event();
     mqtt_event_max = mqtt_abort_now_event;
@@ -1280,6 +1729,7 @@ mqtt_init(void)
     mqtt_continue_send_event = process_alloc_event();
 
     list_init(mqtt_conn_list);
+    memb_init(&in_flight_memb);
     process_start(&mqtt_process, NULL);
     inited = 1;
   }
@@ -1301,6 +1751,11 @@ mqtt_register(struct mqtt_connection *conn, struct process *app_process,
   conn->app_process = app_process;
   conn->auto_reconnect = 1;
   conn->max_segment_size = max_segment_size;
+  conn->connect_vhdr_flags = MQTT_VHDR_CLEAN_SESSION_FLAG;
+  LIST_STRUCT_INIT(conn, in_flight);
+#if MQTT_IN_FLIGHT_CFS
+  conn->in_flight_fd = -1;
+#endif
   reset_defaults(conn);
 
   mqtt_init();
@@ -1334,7 +1789,6 @@ mqtt_connect(struct mqtt_connection *conn, char *host, uint16_t port,
   conn->server_port = port;
   conn->out_buffer_ptr = conn->out_buffer;
   conn->out_packet.qos_state = MQTT_QOS_STATE_NO_ACK;
-  conn->connect_vhdr_flags |= MQTT_VHDR_CLEAN_SESSION_FLAG;
 
   /* convert the string IPv6 address to a numeric IPv6 address */
   if(uiplib_ip6addrconv(host, &ip6addr) == 0) {
@@ -1418,18 +1872,58 @@ mqtt_unsubscribe(struct mqtt_connection *conn, uint16_t *mid, char *topic)
   return MQTT_STATUS_OK;
 }
 /*----------------------------------------------------------------------------*/
-mqtt_status_t
-mqtt_publish(struct mqtt_connection *conn, uint16_t *mid, char *topic,
-             uint8_t *payload, uint32_t payload_size,
-             mqtt_qos_level_t qos_level, mqtt_retain_t retain)
+static mqtt_status_t
+publish(struct mqtt_connection *conn, uint16_t *mid, char *topic,
+        uint8_t *payload, uint32_t payload_size,
+        mqtt_payload_producer_t producer, void *ptr,
+        mqtt_qos_level_t qos_level, mqtt_retain_t retain)
 {
+  struct mqtt_in_flight *m;
+
   if(conn->state != MQTT_CONN_STATE_CONNECTED_TO_BROKER) {
     return MQTT_STATUS_NOT_CONNECTED_ERROR;
   }
 
   DBG("MQTT - Call to mqtt_publish...\n");
 
-  /* Currently don't have a queue, so only one item at a time */
+  /* QoS 1 and 2 messages go through the in-flight window */
+  if(qos_level > MQTT_QOS_LEVEL_0) {
+    m = memb_alloc(&in_flight_memb);
+    if(m == NULL) {
+      DBG("MQTT - Not accepted, in-flight window full!\n");
+      return MQTT_STATUS_OUT_QUEUE_FULL;
+    }
+#if MQTT_IN_FLIGHT_CFS
+    if(producer == NULL && store_payload(m, payload, payload_size) < 0) {
+      PRINTF("MQTT - Error, could not store the payload\n");
+      memb_free(&in_flight_memb, m);
+      return MQTT_STATUS_ERROR;
+    }
+#else
+    m->payload = payload;
+#endif
+    m->mid = next_mid(conn);
+    m->topic = topic;
+    m->payload_size = payload_size;
+    m->producer = producer;
+    m->producer_ptr = ptr;
+    m->qos = qos_level;
+    m->qos_state = MQTT_QOS_STATE_NO_ACK;
+    m->retain = retain;
+    m->pending = 1;
+    m->dup = 0;
+    list_add(conn->in_flight, m);
+
+    if(mid != NULL) {
+      *mid = m->mid;
+    }
+    DBG("MQTT - Accepted, MID %u!\n", m->mid);
+
+    process_post(&mqtt_process, mqtt_do_in_flight_event, conn);
+    return MQTT_STATUS_OK;
+  }
+
+  /* QoS 0 messages share the single outgoing packet */
   if(conn->out_queue_full) {
     DBG("MQTT - Not accepted!\n");
     return MQTT_STATUS_OUT_QUEUE_FULL;
@@ -1443,13 +1937,42 @@ mqtt_publish(struct mqtt_connection *conn, uint16_t *mid, char *topic,
   conn->out_packet.topic_length = strlen(topic);
   conn->out_packet.payload = payload;
   conn->out_packet.payload_size = payload_size;
+  conn->out_packet.producer = producer;
+  conn->out_packet.producer_ptr = ptr;
   conn->out_packet.qos = qos_level;
   conn->out_packet.qos_state = MQTT_QOS_STATE_NO_ACK;
+  conn->out_packet.dup = 0;
+
+  if(mid != NULL) {
+    *mid = conn->out_packet.mid;
+  }
 
   process_post(&mqtt_process, mqtt_do_publish_event, conn);
   return MQTT_STATUS_OK;
 }
 /*----------------------------------------------------------------------------*/
+mqtt_status_t
+mqtt_publish(struct mqtt_connection *conn, uint16_t *mid, char *topic,
+             uint8_t *payload, uint32_t payload_size,
+             mqtt_qos_level_t qos_level, mqtt_retain_t retain)
+{
+  return publish(conn, mid, topic, payload, payload_size, NULL, NULL,
+                 qos_level, retain);
+}
+/*----------------------------------------------------------------------------*/
+mqtt_status_t
+mqtt_publish_stream(struct mqtt_connection *conn, uint16_t *mid, char *topic,
+                    uint32_t payload_size, mqtt_qos_level_t qos_level,
+                    mqtt_retain_t retain, mqtt_payload_producer_t producer,
+                    void *ptr)
+{
+  if(producer == NULL) {
+    return MQTT_STATUS_INVALID_ARGS_ERROR;
+  }
+  return publish(conn, mid, topic, NULL, payload_size, producer, ptr,
+                 qos_level, retain);
+}
+/*----------------------------------------------------------------------------*/
 void
 mqtt_set_username_password(struct mqtt_connection *conn, char *username,
                            char *password)
@@ -1472,6 +1995,16 @@ mqtt_set_username_password(struct mqtt_connection *conn, char *username,
 }
 /*----------------------------------------------------------------------------*/
 void
+mqtt_set_clean_session(struct mqtt_connection *conn, uint8_t clean_session)
+{
+  if(clean_session) {
+    conn->connect_vhdr_flags |= MQTT_VHDR_CLEAN_SESSION_FLAG;
+  } else {
+    conn->connect_vhdr_flags &= ~MQTT_VHDR_CLEAN_SESSION_FLAG;
+  }
+}
+/*----------------------------------------------------------------------------*/
+void
 mqtt_set_last_will(struct mqtt_connection *conn, char *topic, char *message,
                    mqtt_qos_level_t qos)
 {
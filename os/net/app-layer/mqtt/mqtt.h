@@ -60,8 +60,7 @@
  *  can occur.
  *  -- "Exactly once" (2), where message are assured to arrive exactly once.
  *  This level could be used, for example, with billing systems where duplicate
- *  or lost messages could lead to incorrect charges being applied. This QoS
- *  level is currently not supported in this implementation.
+ *  or lost messages could lead to incorrect charges being applied.
  *
  * - A small transport overhead and protocol exchanges minimized to reduce
  *   network traffic.
@@ -116,6 +115,53 @@
 #define MQTT_PROTOCOL_VERSION 3
 #define MQTT_PROTOCOL_NAME "MQIsdp"
 #define MQTT_TOPIC_MAX_LENGTH 128
+
+/*
+ * Number of outgoing QoS 1 and 2 PUBLISH messages kept until the broker has
+ * acknowledged them, shared by all connections. mqtt_publish() accepts a new
+ * message while there is room, without waiting for the PUBACK or PUBCOMP of
+ * the previous one. Unacknowledged messages are sent again, with the DUP
+ * flag, after a reconnect to a session the broker kept (Clean Session off
+ * and Session Present in the CONNACK). Otherwise they are dropped with an
+ * MQTT_EVENT_PUBLISH_FAILED event each.
+ */
+#ifdef MQTT_CONF_MAX_IN_FLIGHT
+#define MQTT_MAX_IN_FLIGHT MQTT_CONF_MAX_IN_FLIGHT
+#else
+#define MQTT_MAX_IN_FLIGHT 1
+#endif
+
+/*
+ * Copy the payload of in-flight messages to a CFS file of their own instead
+ * of referencing the caller's buffer, which can then be reused as soon as
+ * mqtt_publish() returns. Costs a file write per message.
+ */
+#ifdef MQTT_CONF_IN_FLIGHT_CFS
+#define MQTT_IN_FLIGHT_CFS MQTT_CONF_IN_FLIGHT_CFS
+#else
+#define MQTT_IN_FLIGHT_CFS 0
+#endif
+
+/*
+ * Acknowledgements for incoming QoS 1 and 2 messages waiting to be sent.
+ * The broker sends a message again after a reconnect if its ack is dropped.
+ */
+#ifdef MQTT_CONF_MAX_PENDING_ACKS
+#define MQTT_MAX_PENDING_ACKS MQTT_CONF_MAX_PENDING_ACKS
+#else
+#define MQTT_MAX_PENDING_ACKS 4
+#endif
+
+/*
+ * Incoming QoS 2 messages per connection whose IDs are kept from PUBLISH
+ * to PUBREL, so that a retransmission is not delivered twice. Messages
+ * beyond this are delivered again if the broker retransmits them.
+ */
+#ifdef MQTT_CONF_MAX_INBOUND_QOS2
+#define MQTT_MAX_INBOUND_QOS2 MQTT_CONF_MAX_INBOUND_QOS2
+#else
+#define MQTT_MAX_INBOUND_QOS2 4
+#endif
 /*---------------------------------------------------------------------------*/
 /*
  * Debug configuration, this is similar but not exactly like the Debugging
@@ -150,6 +196,7 @@ typedef enum {
   MQTT_EVENT_UNSUBACK,
   MQTT_EVENT_PUBLISH,
   MQTT_EVENT_PUBACK,
+  MQTT_EVENT_PUBCOMP,
 
   /* Errors */
   MQTT_EVENT_ERROR = 0x80,
@@ -157,6 +204,8 @@ typedef enum {
   MQTT_EVENT_CONNECTION_REFUSED_ERROR,
   MQTT_EVENT_DNS_ERROR,
   MQTT_EVENT_NOT_IMPLEMENTED_ERROR,
+  /* A message was dropped unacknowledged, with its message ID */
+  MQTT_EVENT_PUBLISH_FAILED,
   /* Add more */
 } mqtt_event_t;
 
@@ -182,7 +231,8 @@ typedef enum {
   MQTT_QOS_STATE_NO_ACK,
   MQTT_QOS_STATE_GOT_ACK,
 
-  /* Expand for QoS 2 */
+  /* QoS 2: PUBREC received, PUBREL sent or to be sent */
+  MQTT_QOS_STATE_GOT_REC,
 } mqtt_qos_state_t;
 /*---------------------------------------------------------------------------*/
 /*
@@ -265,8 +315,32 @@ struct mqtt_in_packet {
   uint16_t topic_pos;
   uint8_t topic_len_received;
   uint8_t topic_received;
+  uint8_t mid_bytes;
+  uint8_t vhdr_received;
+  uint8_t duplicate;
 };
 
+/**
+ * \brief Producer of a streamed PUBLISH payload
+ * \param m A pointer to the MQTT connection
+ * \param ptr The pointer passed to mqtt_publish_stream()
+ * \param offset The offset of buf in the payload
+ * \param buf Where to write the payload, inside the TCP output buffer
+ * \param len The number of bytes to write
+ * \return The number of bytes written, len unless there was an error
+ *
+ * Called with consecutive chunks of at most MQTT_TCP_OUTPUT_BUFF_SIZE bytes
+ * as the output buffer drains. The payload length is already on the wire,
+ * so a short chunk drops the connection and the message, with an
+ * MQTT_EVENT_PUBLISH_FAILED event. A QoS 1 or 2 message that is sent
+ * again after a reconnect is produced again from offset 0.
+ */
+typedef int (*mqtt_payload_producer_t)(struct mqtt_connection *m,
+                                       void *ptr,
+                                       uint32_t offset,
+                                       uint8_t *buf,
+                                       uint16_t len);
+
 /* This struct represents a packet sent to the MQTT server. */
 struct mqtt_out_packet {
   uint8_t fhdr;
@@ -278,9 +352,40 @@ struct mqtt_out_packet {
   uint16_t topic_length;
   uint8_t *payload;
   uint32_t payload_size;
+  mqtt_payload_producer_t producer;
+  void *producer_ptr;
   mqtt_qos_level_t qos;
   mqtt_qos_state_t qos_state;
   mqtt_retain_t retain;
+  uint8_t dup;
+};
+
+/* An outgoing QoS 1 or 2 PUBLISH the broker has not acknowledged yet. */
+struct mqtt_in_flight {
+  struct mqtt_in_flight *next;
+  char *topic;
+#if !MQTT_IN_FLIGHT_CFS
+  uint8_t *payload;
+#endif
+  uint32_t payload_size;
+  /* Streamed payloads are produced again rather than stored */
+  mqtt_payload_producer_t producer;
+  void *producer_ptr;
+  uint16_t mid;
+  mqtt_qos_level_t qos;
+  mqtt_qos_state_t qos_state;
+  mqtt_retain_t retain;
+
+  /* Set when the PUBLISH or PUBREL has to be (re)sent */
+  uint8_t pending;
+  /* Set once the PUBLISH has been sent */
+  uint8_t dup;
+};
+
+/* A PUBACK, PUBREC or PUBCOMP for an incoming message */
+struct mqtt_ack {
+  uint8_t fhdr;
+  uint16_t mid;
 };
 /*---------------------------------------------------------------------------*/
 /**
@@ -347,6 +452,17 @@ struct mqtt_connection {
   uint32_t out_write_pos;
   uint16_t max_segment_size;
 
+  /* QoS 1 and 2 exchanges, sent from a packet of their own */
+  LIST_STRUCT(in_flight);
+  struct mqtt_out_packet in_flight_packet;
+  struct mqtt_ack acks[MQTT_MAX_PENDING_ACKS];
+  uint8_t ack_count;
+  /* Incoming QoS 2 messages delivered but not released yet */
+  uint16_t rec_mid[MQTT_MAX_INBOUND_QOS2];
+#if MQTT_IN_FLIGHT_CFS
+  int in_flight_fd;
+#endif
+
   /* Incoming data related */
   uint8_t in_buffer[MQTT_TCP_INPUT_BUFF_SIZE];
   struct mqtt_in_packet in_packet;
@@ -411,7 +527,7 @@ void mqtt_disconnect(struct mqtt_connection *conn);
  * \param conn A pointer to the MQTT connection.
  * \param mid A pointer to message ID.
  * \param topic A pointer to the topic to subscribe to.
- * \param qos_level Quality Of Service level to use. Currently supports 0, 1.
+ * \param qos_level Quality Of Service level to use. Supports 0, 1 and 2.
  * \return MQTT_STATUS_OK or some error status
  *
  * This function subscribes to a topic on a MQTT broker.
@@ -441,7 +557,7 @@ mqtt_status_t mqtt_unsubscribe(struct mqtt_connection *conn,
  * \param topic A pointer to the topic to subscribe to.
  * \param payload A pointer to the topic payload.
  * \param payload_size Payload size.
- * \param qos_level Quality Of Service level to use. Currently supports 0, 1.
+ * \param qos_level Quality Of Service level to use. Supports 0, 1 and 2.
  * \param retain If the RETAIN flag is set to 1, in a PUBLISH Packet sent by a
  *        Client to a Server, the Server MUST store the Application Message
  *        and its QoS, so that it can be delivered to future subscribers whose
@@ -449,6 +565,12 @@ mqtt_status_t mqtt_unsubscribe(struct mqtt_connection *conn,
  * \return MQTT_STATUS_OK or some error status
  *
  * This function publishes to a topic on a MQTT broker.
+ *
+ * QoS 1 and 2 messages take a slot of the in-flight window until the
+ * MQTT_EVENT_PUBACK, MQTT_EVENT_PUBCOMP or MQTT_EVENT_PUBLISH_FAILED event
+ * with their message ID, *mid is set to it. The topic, and the payload unless MQTT_IN_FLIGHT_CFS is set,
+ * must stay valid until then. MQTT_STATUS_OUT_QUEUE_FULL is returned while
+ * the window is full.
  */
 mqtt_status_t mqtt_publish(struct mqtt_connection *conn,
                            uint16_t *mid,
@@ -458,6 +580,32 @@ mqtt_status_t mqtt_publish(struct mqtt_connection *conn,
                            mqtt_qos_level_t qos_level,
                            mqtt_retain_t retain);
 /*---------------------------------------------------------------------------*/
+/**
+ * \brief Publish to a MQTT topic, producing the payload as it is sent.
+ * \param conn A pointer to the MQTT connection.
+ * \param mid A pointer to message ID.
+ * \param topic A pointer to the topic to publish to.
+ * \param payload_size Payload size.
+ * \param qos_level Quality Of Service level to use. Supports 0, 1 and 2.
+ * \param retain The RETAIN flag, as for mqtt_publish()
+ * \param producer The function writing the payload
+ * \param ptr A user-defined pointer passed to the producer
+ * \return MQTT_STATUS_OK or some error status
+ *
+ * Like mqtt_publish(), but the payload is written chunk by chunk straight
+ * into the TCP output buffer by the producer, so it never has to be held in
+ * RAM as a whole. The producer and ptr must stay valid as long as the topic,
+ * streamed payloads are not copied to CFS.
+ */
+mqtt_status_t mqtt_publish_stream(struct mqtt_connection *conn,
+                                  uint16_t *mid,
+                                  char *topic,
+                                  uint32_t payload_size,
+                                  mqtt_qos_level_t qos_level,
+                                  mqtt_retain_t retain,
+                                  mqtt_payload_producer_t producer,
+                                  void *ptr);
+/*---------------------------------------------------------------------------*/
 /**
  * \brief Set the user name and password for a MQTT client.
  * \param conn A pointer to the MQTT connection.
@@ -471,6 +619,18 @@ void mqtt_set_username_password(struct mqtt_connection *conn,
                                 char *username,
                                 char *password);
 /*---------------------------------------------------------------------------*/
+/**
+ * \brief Set the Clean Session flag of a MQTT client.
+ * \param conn A pointer to the MQTT connection.
+ * \param clean_session 0 to ask the broker to keep the session state, such
+ *        as subscriptions and unacknowledged QoS 1 and 2 messages, across
+ *        connections. Set by default.
+ *
+ * Takes effect on the next connection to the broker.
+ */
+void mqtt_set_clean_session(struct mqtt_connection *conn,
+                            uint8_t clean_session);
+/*---------------------------------------------------------------------------*/
 /**
  * \brief Set the last will topic and message for a MQTT client.
  * \param conn A pointer to the MQTT connection.
@@ -224,6 +224,10 @@ int tcp_socket_unlisten(struct tcp_socket *s);
  *             data has been acknowledged by the remote host, the
  *             event callback is sent with the TCP_SOCKET_DATA_SENT
  *             event.
+ *
+ *             Data that the caller has already written to the free
+ *             part of the output buffer, at the offset of
+ *             tcp_socket_queuelen(), is queued without being copied.
  */
 int tcp_socket_send(struct tcp_socket *s,
                     const uint8_t *dataptr,
@@ -119,6 +119,7 @@ void uip_ds6_notification_rm(struct uip_ds6_notification *n);
 #define RPL_ROUTE_ENTRY_NOPATH_RECEIVED   0x01
 #define RPL_ROUTE_ENTRY_DAO_PENDING       0x02
 #define RPL_ROUTE_ENTRY_DAO_NACK          0x04
+#define RPL_ROUTE_ENTRY_DAO_AGGREGATE     0x08
 
 #define RPL_ROUTE_IS_NOPATH_RECEIVED(route)                             \
   (((route)->state.state_flags & RPL_ROUTE_ENTRY_NOPATH_RECEIVED) != 0)
@@ -147,6 +148,15 @@ void uip_ds6_notification_rm(struct uip_ds6_notification *n);
     (route)->state.state_flags &= ~RPL_ROUTE_ENTRY_DAO_NACK;            \
   } while(0)
 
+#define RPL_ROUTE_IS_DAO_AGGREGATE(route)                               \
+  (((route)->state.state_flags & RPL_ROUTE_ENTRY_DAO_AGGREGATE) != 0)
+#define RPL_ROUTE_SET_DAO_AGGREGATE(route) do {                         \
+    (route)->state.state_flags |= RPL_ROUTE_ENTRY_DAO_AGGREGATE;        \
+  } while(0)
+#define RPL_ROUTE_CLEAR_DAO_AGGREGATE(route) do {                       \
+    (route)->state.state_flags &= ~RPL_ROUTE_ENTRY_DAO_AGGREGATE;       \
+  } while(0)
+
 #define RPL_ROUTE_CLEAR_DAO(route) do {                                 \
     (route)->state.state_flags &= ~(RPL_ROUTE_ENTRY_DAO_NACK|RPL_ROUTE_ENTRY_DAO_PENDING); \
   } while(0)
@@ -51,6 +51,10 @@
 #define LOG_MODULE "IPv6 SR"
 #define LOG_LEVEL LOG_LEVEL_IPV6
 
+#if UIP_SR_LINK_NUM >= 0xffff
+#error "UIP_SR_LINK_NUM must fit the 16-bit heap index"
+#endif
+
 /* Total number of nodes */
 static int num_nodes;
 
@@ -58,6 +62,131 @@ static int num_nodes;
 LIST(nodelist);
 MEMB(nodememb, uip_sr_node_t, UIP_SR_LINK_NUM);
 
+/* Seconds elapsed, as accounted by uip_sr_periodic */
+static uint32_t sr_clock;
+
+/* Binary min-heap of all nodes with a finite expiration time (and of
+ * expired nodes that are waiting for removal), ordered by expiration.
+ * Indices start at 1, 0 is used for "not in the heap". */
+static uip_sr_node_t *expiration_heap[UIP_SR_LINK_NUM + 1];
+static uint16_t heap_len;
+
+/*---------------------------------------------------------------------------*/
+static void
+heap_set(uint16_t index, uip_sr_node_t *node)
+{
+  expiration_heap[index] = node;
+  node->heap_index = index;
+}
+/*---------------------------------------------------------------------------*/
+static void
+heap_sift_up(uint16_t index)
+{
+  uip_sr_node_t *node = expiration_heap[index];
+  while(index > 1 && expiration_heap[index / 2]->expiration > node->expiration) {
+    heap_set(index, expiration_heap[index / 2]);
+    index /= 2;
+  }
+  heap_set(index, node);
+}
+/*---------------------------------------------------------------------------*/
+static void
+heap_sift_down(uint16_t index)
+{
+  uip_sr_node_t *node = expiration_heap[index];
+  uint16_t child;
+  while((child = 2 * index) <= heap_len) {
+    if(child < heap_len
+       && expiration_heap[child + 1]->expiration < expiration_heap[child]->expiration) {
+      child++;
+    }
+    if(expiration_heap[child]->expiration >= node->expiration) {
+      break;
+    }
+    heap_set(index, expiration_heap[child]);
+    index = child;
+  }
+  heap_set(index, node);
+}
+/*---------------------------------------------------------------------------*/
+static void
+heap_remove(uip_sr_node_t *node)
+{
+  uint16_t index = node->heap_index;
+  uip_sr_node_t *last;
+
+  if(index == 0) {
+    return;
+  }
+  node->heap_index = 0;
+  last = expiration_heap[heap_len--];
+  if(last != node) {
+    heap_set(index, last);
+    heap_sift_up(index);
+    heap_sift_down(last->heap_index);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+node_set_lifetime(uip_sr_node_t *node, uint32_t lifetime)
+{
+  if(lifetime == UIP_SR_INFINITE_LIFETIME) {
+    node->expiration = UIP_SR_INFINITE_LIFETIME;
+    heap_remove(node);
+    return;
+  }
+
+  if(lifetime >= UIP_SR_INFINITE_LIFETIME - sr_clock) {
+    lifetime = UIP_SR_INFINITE_LIFETIME - sr_clock - 1;
+  }
+  node->expiration = sr_clock + lifetime;
+  if(node->heap_index == 0) {
+    heap_set(++heap_len, node);
+    heap_sift_up(heap_len);
+  } else {
+    heap_sift_up(node->heap_index);
+    heap_sift_down(node->heap_index);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static int
+node_is_expired(const uip_sr_node_t *node)
+{
+  return node->expiration != UIP_SR_INFINITE_LIFETIME
+         && node->expiration <= sr_clock;
+}
+/*---------------------------------------------------------------------------*/
+static void
+node_set_parent(uip_sr_node_t *node, uip_sr_node_t *parent)
+{
+  uip_sr_node_t *old_parent = node->parent;
+
+  if(old_parent == parent) {
+    return;
+  }
+  node->parent = parent;
+  if(parent != NULL) {
+    parent->num_children++;
+  }
+  if(old_parent != NULL) {
+    old_parent->num_children--;
+    /* An expired node kept alive by its children is queued for removal
+     * at the next period once its last child is gone */
+    if(old_parent->num_children == 0 && node_is_expired(old_parent)) {
+      node_set_lifetime(old_parent, 0);
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+uint32_t
+uip_sr_node_lifetime(const uip_sr_node_t *node)
+{
+  if(node->expiration == UIP_SR_INFINITE_LIFETIME) {
+    return UIP_SR_INFINITE_LIFETIME;
+  }
+  return node->expiration > sr_clock ? node->expiration - sr_clock : 0;
+}
+
 /*---------------------------------------------------------------------------*/
 int
 uip_sr_num_nodes(void)
@@ -115,7 +244,7 @@ uip_sr_expire_parent(void *graph, const uip_ipaddr_t *child, const uip_ipaddr_t
   uip_sr_node_t *l = uip_sr_get_node(graph, child);
   /* Check if parent matches */
   if(l != NULL && node_matches_address(graph, l->parent, parent)) {
-    l->lifetime = UIP_SR_REMOVAL_DELAY;
+    node_set_lifetime(l, UIP_SR_REMOVAL_DELAY);
   }
 }
 /*---------------------------------------------------------------------------*/
@@ -148,29 +277,32 @@ uip_sr_update_node(void *graph, const uip_ipaddr_t *child, const uip_ipaddr_t *p
       return NULL;
     }
     child_node->parent = NULL;
+    child_node->expiration = UIP_SR_INFINITE_LIFETIME;
+    child_node->heap_index = 0;
+    child_node->num_children = 0;
     list_add(nodelist, child_node);
     num_nodes++;
   }
 
   /* Initialize node */
   child_node->graph = graph;
-  child_node->lifetime = lifetime;
+  node_set_lifetime(child_node, lifetime);
   memcpy(child_node->link_identifier, ((const unsigned char *)child) + 8, 8);
 
   /* Is the node reachable before the update? */
   if(uip_sr_is_addr_reachable(graph, child)) {
     old_parent_node = child_node->parent;
     /* Update node */
-    child_node->parent = parent_node;
+    node_set_parent(child_node, parent_node);
     /* Has the node become unreachable? May happen if we create a loop. */
     if(!uip_sr_is_addr_reachable(graph, child)) {
       /* The new parent makes the node unreachable, restore old parent.
        * We will take the update next time, with chances we know more of
        * the topology and the loop is gone. */
-      child_node->parent = old_parent_node;
+      node_set_parent(child_node, old_parent_node);
     }
   } else {
-    child_node->parent = parent_node;
+    node_set_parent(child_node, parent_node);
   }
 
   LOG_INFO("NS: updating link, child ");
@@ -186,6 +318,8 @@ void
 uip_sr_init(void)
 {
   num_nodes = 0;
+  sr_clock = 0;
+  heap_len = 0;
   memb_init(&nodememb);
   list_init(nodelist);
 }
@@ -206,32 +340,30 @@ void
 uip_sr_periodic(unsigned seconds)
 {
   uip_sr_node_t *l;
-  uip_sr_node_t *next;
 
-  /* First pass, for all expired nodes, deallocate them iff no child points to them */
-  for(l = list_head(nodelist); l != NULL; l = next) {
-    next = list_item_next(l);
-    if(l->lifetime == 0) {
-      uip_sr_node_t *l2;
-      for(l2 = list_head(nodelist); l2 != NULL; l2 = list_item_next(l2)) {
-        if(l2->parent == l) {
-          break;
-        }
-      }
-      if(LOG_INFO_ENABLED) {
-        uip_ipaddr_t node_addr;
-        NETSTACK_ROUTING.get_sr_node_ipaddr(&node_addr, l);
-        LOG_INFO("NS: removing expired node ");
-        LOG_INFO_6ADDR(&node_addr);
-        LOG_INFO_("\n");
-      }
-      /* No child found, deallocate node */
-      list_remove(nodelist, l);
-      memb_free(&nodememb, l);
-      num_nodes--;
-    } else if(l->lifetime != UIP_SR_INFINITE_LIFETIME) {
-      l->lifetime = l->lifetime > seconds ? l->lifetime - seconds : 0;
+  sr_clock += seconds;
+
+  /* Only visit expired nodes, deallocate them iff no child points to them.
+   * Nodes that still have children are removed from the heap, and queued
+   * again by node_set_parent when their last child leaves. */
+  while(heap_len > 0 && node_is_expired(expiration_heap[1])) {
+    l = expiration_heap[1];
+    heap_remove(l);
+    if(l->num_children > 0) {
+      continue;
+    }
+    if(LOG_INFO_ENABLED) {
+      uip_ipaddr_t node_addr;
+      NETSTACK_ROUTING.get_sr_node_ipaddr(&node_addr, l);
+      LOG_INFO("NS: removing expired node ");
+      LOG_INFO_6ADDR(&node_addr);
+      LOG_INFO_("\n");
     }
+    /* No child found, deallocate node */
+    node_set_parent(l, NULL);
+    list_remove(nodelist, l);
+    memb_free(&nodememb, l);
+    num_nodes--;
   }
 }
 /*---------------------------------------------------------------------------*/
@@ -246,6 +378,7 @@ uip_sr_free_all(void)
     memb_free(&nodememb, l);
     num_nodes--;
   }
+  heap_len = 0;
 }
 /*---------------------------------------------------------------------------*/
 int
@@ -286,9 +419,10 @@ uip_sr_link_snprint(char *buf, int buflen, uip_sr_node_t *link)
       return index;
     }
   }
-  if(link->lifetime != UIP_SR_INFINITE_LIFETIME) {
+  if(link->expiration != UIP_SR_INFINITE_LIFETIME) {
     index += snprintf(buf+index, buflen-index,
-              " (lifetime: %lu seconds)", (unsigned long)link->lifetime);
+              " (lifetime: %lu seconds)",
+              (unsigned long)uip_sr_node_lifetime(link));
     if(index >= buflen) {
       return index;
     }
@@ -91,7 +91,12 @@
  * all child-parent relationship. Used to build source routes */
 typedef struct uip_sr_node {
   struct uip_sr_node *next;
-  uint32_t lifetime;
+  /* Expiration time, in uip-sr seconds, or UIP_SR_INFINITE_LIFETIME */
+  uint32_t expiration;
+  /* Position in the expiration heap, 0 if not queued */
+  uint16_t heap_index;
+  /* Number of nodes that have this node as parent */
+  uint16_t num_children;
   /* Protocol-specific graph structure */
   void *graph;
   /* Store only IPv6 link identifiers, the routing protocol will provide
@@ -163,8 +168,17 @@ uip_sr_node_t *uip_sr_get_node(void *graph, const uip_ipaddr_t *addr);
 int uip_sr_is_addr_reachable(void *graph, const uip_ipaddr_t *addr);
 
 /**
- * A function called periodically. Used to age the links (decrease lifetime
- * and expire links accordingly)
+ * Tells the remaining lifetime of a node
+ *
+ * \param node The node
+ * \return The remaining lifetime in seconds, or UIP_SR_INFINITE_LIFETIME
+*/
+uint32_t uip_sr_node_lifetime(const uip_sr_node_t *node);
+
+/**
+ * A function called periodically. Used to age the links. Nodes are kept
+ * in a heap ordered by expiration time, so that only the expired ones are
+ * visited.
  *
  * \param seconds The number of seconds elapsted since last call
 */
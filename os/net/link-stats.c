@@ -74,6 +74,10 @@ NBR_TABLE(struct link_stats, link_stats);
 /* Called at a period of FRESHNESS_HALF_LIFE */
 struct ctimer periodic_timer;
 
+#ifdef LINK_STATS_CALLBACK_UPDATED
+void LINK_STATS_CALLBACK_UPDATED(const linkaddr_t *lladdr);
+#endif /* LINK_STATS_CALLBACK_UPDATED */
+
 /*---------------------------------------------------------------------------*/
 /* Returns the neighbor's link stats */
 const struct link_stats *
@@ -191,6 +195,10 @@ link_stats_packet_sent(const linkaddr_t *lladdr, int status, int numtx)
   stats->etx = ((uint32_t)stats->etx * (EWMA_SCALE - ewma_alpha) +
       (uint32_t)packet_etx * ewma_alpha) / EWMA_SCALE;
 #endif /* LINK_STATS_ETX_FROM_PACKET_COUNT */
+
+#ifdef LINK_STATS_CALLBACK_UPDATED
+  LINK_STATS_CALLBACK_UPDATED(lladdr);
+#endif /* LINK_STATS_CALLBACK_UPDATED */
 }
 /*---------------------------------------------------------------------------*/
 /* Packet input callback. Updates statistics for receptions on a given link */
@@ -212,6 +220,9 @@ link_stats_input_callback(const linkaddr_t *lladdr)
 #else /* LINK_STATS_INIT_ETX_FROM_RSSI */
       stats->etx = ETX_DEFAULT * ETX_DIVISOR;
 #endif /* LINK_STATS_INIT_ETX_FROM_RSSI */
+#ifdef LINK_STATS_CALLBACK_UPDATED
+      LINK_STATS_CALLBACK_UPDATED(lladdr);
+#endif /* LINK_STATS_CALLBACK_UPDATED */
     }
     return;
   }
@@ -240,7 +251,14 @@ link_stats_reset(void)
   struct link_stats *stats;
   stats = nbr_table_head(link_stats);
   while(stats != NULL) {
+#ifdef LINK_STATS_CALLBACK_UPDATED
+    linkaddr_t lladdr;
+    linkaddr_copy(&lladdr, nbr_table_get_lladdr(link_stats, stats));
+#endif /* LINK_STATS_CALLBACK_UPDATED */
     nbr_table_remove(link_stats, stats);
+#ifdef LINK_STATS_CALLBACK_UPDATED
+    LINK_STATS_CALLBACK_UPDATED(&lladdr);
+#endif /* LINK_STATS_CALLBACK_UPDATED */
     stats = nbr_table_next(link_stats, stats);
   }
 }
@@ -56,6 +56,15 @@
 #define LINK_STATS_ETX_FROM_PACKET_COUNT           0
 #endif /* LINK_STATS_ETX_FROM_PACKET_COUNT */
 
+/* A configurable function called whenever the ETX of a link may have changed,
+ * so that a routing protocol caching path costs can refresh them. RPL Lite
+ * installs its own unless configured otherwise. */
+#ifdef LINK_STATS_CONF_CALLBACK_UPDATED
+#define LINK_STATS_CALLBACK_UPDATED LINK_STATS_CONF_CALLBACK_UPDATED
+#elif ROUTING_CONF_RPL_LITE
+#define LINK_STATS_CALLBACK_UPDATED rpl_link_stats_callback
+#endif /* LINK_STATS_CONF_CALLBACK_UPDATED */
+
 /* All statistics of a given link */
 struct link_stats {
   clock_time_t last_tx_time;  /* Last Tx timestamp */
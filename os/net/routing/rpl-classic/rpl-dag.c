@@ -257,6 +257,11 @@ rpl_set_preferred_parent(rpl_dag_t *dag, rpl_parent_t *p)
     nbr_table_unlock(rpl_parents, dag->preferred_parent);
     nbr_table_lock(rpl_parents, p);
     dag->preferred_parent = p;
+#if RPL_WITH_STORING && RPL_DAO_AGGREGATION
+    if(p != NULL && dag->instance != NULL) {
+      dao_aggregation_resume(dag->instance);
+    }
+#endif /* RPL_WITH_STORING && RPL_DAO_AGGREGATION */
   }
 }
 /*---------------------------------------------------------------------------*/
@@ -648,6 +653,9 @@ rpl_free_instance(rpl_instance_t *instance)
   ctimer_stop(&instance->dio_timer);
   ctimer_stop(&instance->dao_timer);
   ctimer_stop(&instance->dao_lifetime_timer);
+#if RPL_WITH_STORING && RPL_DAO_AGGREGATION
+  ctimer_stop(&instance->dao_aggregation_timer);
+#endif /* RPL_WITH_STORING && RPL_DAO_AGGREGATION */
 
   if(default_instance == instance) {
     default_instance = NULL;
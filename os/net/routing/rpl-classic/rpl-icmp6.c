@@ -631,6 +631,189 @@ dio_output(rpl_instance_t *instance, uip_ipaddr_t *uc_addr)
 #endif /* RPL_LEAF_ONLY */
 }
 /*---------------------------------------------------------------------------*/
+#if RPL_WITH_STORING
+/* Returns the lifetime that applies to the target option at offset
+ * target_pos: the one of the first Transit Information option after it
+ * (RFC 6550, section 6.7.8), or else the last one before it. */
+static uint8_t
+dao_target_lifetime(unsigned char *buffer, int pos, int target_pos,
+                    int buffer_length, uint8_t lifetime)
+{
+  int len;
+
+  for(; pos < buffer_length; pos += len) {
+    if(buffer[pos] == RPL_OPTION_PAD1) {
+      len = 1;
+    } else {
+      len = 2 + buffer[pos + 1];
+    }
+    if(buffer[pos] == RPL_OPTION_TRANSIT) {
+      lifetime = buffer[pos + 5];
+      if(pos > target_pos) {
+        break;
+      }
+    }
+  }
+  return lifetime;
+}
+/*---------------------------------------------------------------------------*/
+#if RPL_DAO_AGGREGATION
+/* Aggregated DAOs must fit both in uip_buf and in a single IPv6 packet,
+ * leaving room for a RPL hop-by-hop option */
+#define DAO_AGGREGATION_MAX_LEN (MIN(UIP_LINK_MTU, UIP_BUFSIZE) \
+                                 - UIP_IPICMPH_LEN - RPL_HOP_BY_HOP_LEN)
+/* Length of a Transit Information option without parent address */
+#define DAO_TRANSIT_LEN 6
+
+static void handle_dao_aggregation_timer(void *ptr);
+/*---------------------------------------------------------------------------*/
+static int
+add_transit(unsigned char *buffer, int pos, uint8_t lifetime)
+{
+  buffer[pos++] = RPL_OPTION_TRANSIT;
+  buffer[pos++] = 4;
+  buffer[pos++] = 0; /* flags - ignored */
+  buffer[pos++] = 0; /* path control - ignored */
+  buffer[pos++] = 0; /* path seq - ignored */
+  buffer[pos++] = lifetime;
+  return pos;
+}
+/*---------------------------------------------------------------------------*/
+static void
+handle_dao_aggregation_timer(void *ptr)
+{
+  rpl_instance_t *instance = ptr;
+  rpl_dag_t *dag = instance->current_dag;
+  uip_ipaddr_t *parent_ipaddr = NULL;
+  uip_ds6_route_t *r;
+  unsigned char *buffer;
+  int pos;
+  int num_targets;
+  int group_size;
+  uint8_t group_lifetime;
+
+  if(dag != NULL && dag->preferred_parent != NULL) {
+    parent_ipaddr = rpl_parent_get_ipaddr(dag->preferred_parent);
+  }
+  if(parent_ipaddr == NULL) {
+    /* Nobody to send to. Keep the routes pending, they are advertised
+       as soon as we have a preferred parent (dao_aggregation_resume). */
+    return;
+  }
+
+  buffer = UIP_ICMP_PAYLOAD;
+  pos = 0;
+
+  buffer[pos++] = instance->instance_id;
+#if RPL_DAO_SPECIFY_DAG
+  buffer[pos++] = RPL_DAO_D_FLAG;
+#else /* RPL_DAO_SPECIFY_DAG */
+  buffer[pos++] = 0;
+#endif /* RPL_DAO_SPECIFY_DAG */
+  buffer[pos++] = 0; /* reserved */
+  buffer[pos++] = 0; /* sequence number, set once there is something to send */
+#if RPL_DAO_SPECIFY_DAG
+  memcpy(buffer + pos, &dag->dag_id, sizeof(dag->dag_id));
+  pos += sizeof(dag->dag_id);
+#endif /* RPL_DAO_SPECIFY_DAG */
+
+  num_targets = 0;
+  group_size = 0;
+  group_lifetime = 0;
+  for(r = uip_ds6_route_head(); r != NULL; r = uip_ds6_route_next(r)) {
+    uint8_t lifetime;
+    int target_len;
+
+    if(!RPL_ROUTE_IS_DAO_AGGREGATE(r) || r->state.dag != dag) {
+      continue;
+    }
+
+    /* Advertise the remaining lifetime of the route */
+    if(RPL_ROUTE_IS_NOPATH_RECEIVED(r)) {
+      lifetime = RPL_ZERO_LIFETIME;
+    } else if(r->state.lifetime == RPL_ROUTE_INFINITE_LIFETIME) {
+      lifetime = RPL_INFINITE_LIFETIME;
+    } else {
+      lifetime = MIN((r->state.lifetime + instance->lifetime_unit - 1)
+                     / instance->lifetime_unit, RPL_INFINITE_LIFETIME - 1);
+    }
+
+    /* The target, the transit option closing the current group if the
+       lifetime differs, and the transit option closing this DAO */
+    target_len = 4 + (r->length + 7) / CHAR_BIT;
+    if(num_targets == RPL_DAO_AGGREGATION_MAX_TARGETS ||
+       pos + target_len + 2 * DAO_TRANSIT_LEN > DAO_AGGREGATION_MAX_LEN) {
+      /* This DAO is full, send the remaining targets in the next one */
+      ctimer_set(&instance->dao_aggregation_timer,
+                 RPL_DAO_AGGREGATION_DELAY / 4,
+                 handle_dao_aggregation_timer, instance);
+      break;
+    }
+    RPL_ROUTE_CLEAR_DAO_AGGREGATE(r);
+
+    if(group_size > 0 && lifetime != group_lifetime) {
+      /* Close the current group of targets with its transit option */
+      pos = add_transit(buffer, pos, group_lifetime);
+      group_size = 0;
+    }
+
+    buffer[pos++] = RPL_OPTION_TARGET;
+    buffer[pos++] = 2 + ((r->length + 7) / CHAR_BIT);
+    buffer[pos++] = 0; /* reserved */
+    buffer[pos++] = r->length;
+    memcpy(buffer + pos, &r->ipaddr, (r->length + 7) / CHAR_BIT);
+    pos += ((r->length + 7) / CHAR_BIT);
+
+    group_lifetime = lifetime;
+    group_size++;
+    num_targets++;
+  }
+
+  if(num_targets == 0) {
+    return;
+  }
+
+  pos = add_transit(buffer, pos, group_lifetime);
+
+  RPL_LOLLIPOP_INCREMENT(dao_sequence);
+  buffer[3] = dao_sequence;
+
+  LOG_INFO("Sending an aggregated DAO with sequence number %u, %u targets, to ",
+           dao_sequence, num_targets);
+  LOG_INFO_6ADDR(parent_ipaddr);
+  LOG_INFO_("\n");
+
+  uip_icmp6_send(parent_ipaddr, ICMP6_RPL, RPL_CODE_DAO, pos);
+}
+/*---------------------------------------------------------------------------*/
+static void
+schedule_dao_aggregation(rpl_instance_t *instance, uip_ds6_route_t *rep)
+{
+  RPL_ROUTE_SET_DAO_AGGREGATE(rep);
+  if(ctimer_expired(&instance->dao_aggregation_timer)) {
+    clock_time_t expiration_time = RPL_DAO_AGGREGATION_DELAY / 2
+      + (random_rand() % (RPL_DAO_AGGREGATION_DELAY));
+    ctimer_set(&instance->dao_aggregation_timer, expiration_time,
+               handle_dao_aggregation_timer, instance);
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+dao_aggregation_resume(rpl_instance_t *instance)
+{
+  uip_ds6_route_t *r;
+
+  /* Advertise the routes left pending while we had no preferred parent */
+  for(r = uip_ds6_route_head(); r != NULL; r = uip_ds6_route_next(r)) {
+    if(RPL_ROUTE_IS_DAO_AGGREGATE(r) && r->state.dag == instance->current_dag) {
+      schedule_dao_aggregation(instance, r);
+      return;
+    }
+  }
+}
+#endif /* RPL_DAO_AGGREGATION */
+#endif /* RPL_WITH_STORING */
+/*---------------------------------------------------------------------------*/
 static void
 dao_input_storing(void)
 {
@@ -651,6 +834,7 @@ dao_input_storing(void)
   */
   uip_ipaddr_t prefix;
   uip_ds6_route_t *rep;
+  uip_ds6_route_t *fwd_rep;
   uint8_t buffer_length;
   int pos;
   int len;
@@ -659,9 +843,18 @@ dao_input_storing(void)
   rpl_parent_t *parent;
   uip_ds6_nbr_t *nbr;
   int is_root;
+  int aggregate;
+  int fwd_nopath;
+  int fwd_route;
+  int fwd_as_is;
 
   prefixlen = 0;
   parent = NULL;
+  nbr = NULL;
+  fwd_rep = NULL;
+  fwd_nopath = 0;
+  fwd_route = 0;
+  fwd_as_is = 0;
   memset(&prefix, 0, sizeof(prefix));
 
   uip_ipaddr_copy(&dao_sender_addr, &UIP_IP_BUF->srcipaddr);
@@ -674,8 +867,6 @@ dao_input_storing(void)
 
   instance = rpl_get_instance(instance_id);
 
-  lifetime = instance->default_lifetime;
-
   flags = buffer[pos++];
   /* reserved */
   pos++;
@@ -725,7 +916,12 @@ dao_input_storing(void)
     }
   }
 
-  /* Check if there are any RPL options present. */
+  /* Routes learned from DAOs that do not request an ACK can be advertised
+     to our parent in aggregated DAOs. The root has no parent. */
+  aggregate = RPL_DAO_AGGREGATION && !is_root && !(flags & RPL_DAO_K_FLAG);
+
+  /* Handle every target option. A DAO may carry several targets, each group
+     of targets being followed by the transit option that applies to it. */
   for(i = pos; i < buffer_length; i += len) {
     subopt_type = buffer[i];
     if(subopt_type == RPL_OPTION_PAD1) {
@@ -735,157 +931,171 @@ dao_input_storing(void)
       len = 2 + buffer[i + 1];
     }
 
-    switch(subopt_type) {
-      case RPL_OPTION_TARGET:
-        /* Handle the target option. */
-        prefixlen = buffer[i + 3];
-        memset(&prefix, 0, sizeof(prefix));
-        memcpy(&prefix, buffer + i + 4, (prefixlen + 7) / CHAR_BIT);
-        break;
-      case RPL_OPTION_TRANSIT:
-        /* The path sequence and control are ignored. */
-        /*      pathcontrol = buffer[i + 3];
-                pathsequence = buffer[i + 4];*/
-        lifetime = buffer[i + 5];
-        /* The parent address is also ignored. */
-        break;
+    if(subopt_type != RPL_OPTION_TARGET) {
+      /* The path sequence and control of the transit option are ignored,
+         and so is the parent address. */
+      continue;
     }
-  }
 
-  LOG_INFO("DAO lifetime: %u, prefix length: %u prefix: ",
-         (unsigned)lifetime, (unsigned)prefixlen);
-  LOG_INFO_6ADDR(&prefix);
-  LOG_INFO_("\n");
+    prefixlen = buffer[i + 3];
+    memset(&prefix, 0, sizeof(prefix));
+    memcpy(&prefix, buffer + i + 4, (prefixlen + 7) / CHAR_BIT);
+    lifetime = dao_target_lifetime(buffer, pos, i, buffer_length,
+                                   instance->default_lifetime);
+
+    LOG_INFO("DAO lifetime: %u, prefix length: %u prefix: ",
+           (unsigned)lifetime, (unsigned)prefixlen);
+    LOG_INFO_6ADDR(&prefix);
+    LOG_INFO_("\n");
 
 #if RPL_WITH_MULTICAST
-  if(uip_is_addr_mcast_global(&prefix)) {
-    /*
-     * "rep" is used for a unicast route which we don't need now; so set NULL so
-     * that operations on "rep" will be skipped.
-     */
-    rep = NULL;
-    mcast_group = uip_mcast6_route_add(&prefix);
-    if(mcast_group) {
-      mcast_group->dag = dag;
-      mcast_group->lifetime = RPL_LIFETIME(instance, lifetime);
+    if(uip_is_addr_mcast_global(&prefix)) {
+      mcast_group = uip_mcast6_route_add(&prefix);
+      if(mcast_group) {
+        mcast_group->dag = dag;
+        mcast_group->lifetime = RPL_LIFETIME(instance, lifetime);
+      }
+      /* There is no unicast route to aggregate, forward the DAO as is */
+      fwd_route = 1;
+      fwd_as_is = 1;
+      continue;
     }
-    goto fwd_dao;
-  }
 #endif
 
-  rep = uip_ds6_route_lookup(&prefix);
-
-  if(lifetime == RPL_ZERO_LIFETIME) {
-    LOG_INFO("No-Path DAO received\n");
-    /* No-Path DAO received; invoke the route purging routine. */
-    if(rep != NULL &&
-       !RPL_ROUTE_IS_NOPATH_RECEIVED(rep) &&
-       rep->length == prefixlen &&
-       uip_ds6_route_nexthop(rep) != NULL &&
-       uip_ipaddr_cmp(uip_ds6_route_nexthop(rep), &dao_sender_addr)) {
-      LOG_DBG("Setting expiration timer for prefix ");
-      LOG_DBG_6ADDR(&prefix);
-      LOG_DBG_("\n");
-      RPL_ROUTE_SET_NOPATH_RECEIVED(rep);
-      rep->state.lifetime = RPL_NOPATH_REMOVAL_DELAY;
-
-      /* We forward the incoming No-Path DAO to our parent, if we have
-         one. */
-      if(dag->preferred_parent != NULL &&
-         rpl_parent_get_ipaddr(dag->preferred_parent) != NULL) {
-        uint8_t out_seq;
-        out_seq = prepare_for_dao_fwd(sequence, rep);
-
-        LOG_DBG("Forwarding No-path DAO to parent - out_seq:%d",
-               out_seq);
-        LOG_DBG_6ADDR(rpl_parent_get_ipaddr(dag->preferred_parent));
+    rep = uip_ds6_route_lookup(&prefix);
+
+    if(lifetime == RPL_ZERO_LIFETIME) {
+      LOG_INFO("No-Path DAO received\n");
+      /* No-Path DAO received; invoke the route purging routine. */
+      if(rep != NULL &&
+         !RPL_ROUTE_IS_NOPATH_RECEIVED(rep) &&
+         rep->length == prefixlen &&
+         uip_ds6_route_nexthop(rep) != NULL &&
+         uip_ipaddr_cmp(uip_ds6_route_nexthop(rep), &dao_sender_addr)) {
+        LOG_DBG("Setting expiration timer for prefix ");
+        LOG_DBG_6ADDR(&prefix);
         LOG_DBG_("\n");
+        RPL_ROUTE_SET_NOPATH_RECEIVED(rep);
+        rep->state.lifetime = RPL_NOPATH_REMOVAL_DELAY;
+        /* The No-Path DAO is to be forwarded to our parent */
+        fwd_nopath = 1;
+        if(fwd_rep == NULL) {
+          fwd_rep = rep;
+        }
+#if RPL_DAO_AGGREGATION
+        if(aggregate) {
+          schedule_dao_aggregation(instance, rep);
+        }
+#endif /* RPL_DAO_AGGREGATION */
+      }
+      continue;
+    }
 
-        buffer = UIP_ICMP_PAYLOAD;
-        buffer[3] = out_seq; /* add an outgoing seq no before fwd */
-        uip_icmp6_send(rpl_parent_get_ipaddr(dag->preferred_parent),
-                       ICMP6_RPL, RPL_CODE_DAO, buffer_length);
+    LOG_INFO("Adding DAO route\n");
+
+    /* Update and add neighbor - if no room - fail. */
+    if(nbr == NULL &&
+       (nbr = rpl_icmp6_update_nbr_table(&dao_sender_addr, NBR_TABLE_REASON_RPL_DAO, instance)) == NULL) {
+      LOG_ERR("Out of Memory, dropping DAO from ");
+      LOG_ERR_6ADDR(&dao_sender_addr);
+      LOG_ERR_(", ");
+      LOG_ERR_LLADDR(packetbuf_addr(PACKETBUF_ADDR_SENDER));
+      LOG_ERR_("\n");
+      if(flags & RPL_DAO_K_FLAG) {
+        /* signal the failure to add the node */
+        dao_ack_output(instance, &dao_sender_addr, sequence,
+                       is_root ? RPL_DAO_ACK_UNABLE_TO_ADD_ROUTE_AT_ROOT :
+                       RPL_DAO_ACK_UNABLE_TO_ACCEPT);
       }
+      return;
     }
-    /* independent if we remove or not - ACK the request */
-    if(flags & RPL_DAO_K_FLAG) {
-      /* indicate that we accepted the no-path DAO */
-      uip_clear_buf();
-      dao_ack_output(instance, &dao_sender_addr, sequence,
-                     RPL_DAO_ACK_UNCONDITIONAL_ACCEPT);
+
+    rep = rpl_add_route(dag, &prefix, prefixlen, &dao_sender_addr);
+    if(rep == NULL) {
+      RPL_STAT(rpl_stats.mem_overflows++);
+      LOG_ERR("Could not add a route after receiving a DAO\n");
+      if(flags & RPL_DAO_K_FLAG) {
+        /* signal the failure to add the node */
+        dao_ack_output(instance, &dao_sender_addr, sequence,
+                       is_root ? RPL_DAO_ACK_UNABLE_TO_ADD_ROUTE_AT_ROOT :
+                       RPL_DAO_ACK_UNABLE_TO_ACCEPT);
+      }
+      return;
     }
-    return;
-  }
 
-  LOG_INFO("Adding DAO route\n");
+    /* set lifetime and clear NOPATH bit */
+    rep->state.lifetime = RPL_LIFETIME(instance, lifetime);
+    RPL_ROUTE_CLEAR_NOPATH_RECEIVED(rep);
 
-  /* Update and add neighbor - if no room - fail. */
-  if((nbr = rpl_icmp6_update_nbr_table(&dao_sender_addr, NBR_TABLE_REASON_RPL_DAO, instance)) == NULL) {
-    LOG_ERR("Out of Memory, dropping DAO from ");
-    LOG_ERR_6ADDR(&dao_sender_addr);
-    LOG_ERR_(", ");
-    LOG_ERR_LLADDR(packetbuf_addr(PACKETBUF_ADDR_SENDER));
-    LOG_ERR_("\n");
-    if(flags & RPL_DAO_K_FLAG) {
-      /* signal the failure to add the node */
-      dao_ack_output(instance, &dao_sender_addr, sequence,
-                     is_root ? RPL_DAO_ACK_UNABLE_TO_ADD_ROUTE_AT_ROOT :
-                     RPL_DAO_ACK_UNABLE_TO_ACCEPT);
+    fwd_route = 1;
+    fwd_rep = rep;
+#if RPL_DAO_AGGREGATION
+    if(aggregate && learned_from == RPL_ROUTE_FROM_UNICAST_DAO) {
+      schedule_dao_aggregation(instance, rep);
     }
-    return;
+#endif /* RPL_DAO_AGGREGATION */
   }
 
-  rep = rpl_add_route(dag, &prefix, prefixlen, &dao_sender_addr);
-  if(rep == NULL) {
-    RPL_STAT(rpl_stats.mem_overflows++);
-    LOG_ERR("Could not add a route after receiving a DAO\n");
+  if(!fwd_route) {
+    /* We forward the incoming No-Path DAO to our parent, if we have
+       one. */
+    if(fwd_nopath && !aggregate &&
+       dag->preferred_parent != NULL &&
+       rpl_parent_get_ipaddr(dag->preferred_parent) != NULL) {
+      uint8_t out_seq;
+      out_seq = prepare_for_dao_fwd(sequence, fwd_rep);
+
+      LOG_DBG("Forwarding No-path DAO to parent - out_seq:%d",
+             out_seq);
+      LOG_DBG_6ADDR(rpl_parent_get_ipaddr(dag->preferred_parent));
+      LOG_DBG_("\n");
+
+      buffer = UIP_ICMP_PAYLOAD;
+      buffer[3] = out_seq; /* add an outgoing seq no before fwd */
+      uip_icmp6_send(rpl_parent_get_ipaddr(dag->preferred_parent),
+                     ICMP6_RPL, RPL_CODE_DAO, buffer_length);
+    }
+    /* independent if we remove or not - ACK the request */
     if(flags & RPL_DAO_K_FLAG) {
-      /* signal the failure to add the node */
+      /* indicate that we accepted the no-path DAO */
+      uip_clear_buf();
       dao_ack_output(instance, &dao_sender_addr, sequence,
-                     is_root ? RPL_DAO_ACK_UNABLE_TO_ADD_ROUTE_AT_ROOT :
-                     RPL_DAO_ACK_UNABLE_TO_ACCEPT);
+                     RPL_DAO_ACK_UNCONDITIONAL_ACCEPT);
     }
     return;
   }
 
-  /* set lifetime and clear NOPATH bit */
-  rep->state.lifetime = RPL_LIFETIME(instance, lifetime);
-  RPL_ROUTE_CLEAR_NOPATH_RECEIVED(rep);
-
-#if RPL_WITH_MULTICAST
-fwd_dao:
-#endif
-
   if(learned_from == RPL_ROUTE_FROM_UNICAST_DAO) {
     int should_ack = 0;
 
     if(flags & RPL_DAO_K_FLAG) {
-      if(rep != NULL) {
+      if(fwd_rep != NULL) {
         /*
          * check if this route is already installed and we can ack now!
          * not pending - and same seq-no means that we can ack.
          * (e.g. the route is installed already so it will not take any
          * more room that it already takes - so should be ok!)
          */
-        if((!RPL_ROUTE_IS_DAO_PENDING(rep) &&
-            rep->state.dao_seqno_in == sequence) ||
+        if((!RPL_ROUTE_IS_DAO_PENDING(fwd_rep) &&
+            fwd_rep->state.dao_seqno_in == sequence) ||
            dag->rank == ROOT_RANK(instance)) {
           should_ack = 1;
         }
       }
     }
 
-    if(dag->preferred_parent != NULL &&
+    if((!aggregate || fwd_as_is) &&
+       dag->preferred_parent != NULL &&
        rpl_parent_get_ipaddr(dag->preferred_parent) != NULL) {
       uint8_t out_seq = 0;
-      if(rep != NULL) {
+      if(fwd_rep != NULL) {
         /* if this is pending and we get the same seq no it is a retrans */
-        if(RPL_ROUTE_IS_DAO_PENDING(rep) &&
-           rep->state.dao_seqno_in == sequence) {
+        if(RPL_ROUTE_IS_DAO_PENDING(fwd_rep) &&
+           fwd_rep->state.dao_seqno_in == sequence) {
           /* keep the same seq-no as before for parent also */
-          out_seq = rep->state.dao_seqno_out;
+          out_seq = fwd_rep->state.dao_seqno_out;
         } else {
-          out_seq = prepare_for_dao_fwd(sequence, rep);
+          out_seq = prepare_for_dao_fwd(sequence, fwd_rep);
         }
       }
 
@@ -116,14 +116,17 @@ void
 rpl_purge_routes(void)
 {
   uip_ds6_route_t *r;
+  uip_ds6_route_t *next;
   uip_ipaddr_t prefix;
   rpl_dag_t *dag;
+  int num_expired;
 #if RPL_WITH_MULTICAST
   uip_mcast6_route_t *mcast_route;
 #endif
 
   /* First pass, decrement lifetime */
   r = uip_ds6_route_head();
+  num_expired = 0;
 
   while(r != NULL) {
     if(r->state.lifetime >= 1 && r->state.lifetime != RPL_ROUTE_INFINITE_LIFETIME) {
@@ -134,19 +137,25 @@ rpl_purge_routes(void)
        */
       r->state.lifetime--;
     }
+    if(r->state.lifetime < 1) {
+      num_expired++;
+    }
     r = uip_ds6_route_next(r);
   }
 
-  /* Second pass, remove dead routes */
-  r = uip_ds6_route_head();
+  /* Second pass, remove dead routes. Skipped altogether when nothing expired,
+   * and resumes from the next entry after a removal rather than restarting
+   * from the head of the table. */
+  r = num_expired > 0 ? uip_ds6_route_head() : NULL;
 
-  while(r != NULL) {
+  while(r != NULL && num_expired > 0) {
+    next = uip_ds6_route_next(r);
     if(r->state.lifetime < 1) {
       /* Routes with lifetime == 1 have only just been decremented from 2 to 1,
        * thus we want to keep them. Hence < and not <= */
       uip_ipaddr_copy(&prefix, &r->ipaddr);
       uip_ds6_route_rm(r);
-      r = uip_ds6_route_head();
+      num_expired--;
       LOG_INFO("No more routes to ");
       LOG_INFO_6ADDR(&prefix);
       dag = default_instance->current_dag;
@@ -158,9 +167,8 @@ rpl_purge_routes(void)
         return;
       }
       LOG_INFO_("\n");
-    } else {
-      r = uip_ds6_route_next(r);
     }
+    r = next;
   }
 
 #if RPL_WITH_MULTICAST
@@ -262,6 +262,9 @@ struct rpl_instance {
 #if RPL_WITH_DAO_ACK
   struct ctimer dao_retransmit_timer;
 #endif /* RPL_WITH_DAO_ACK */
+#if RPL_WITH_STORING && RPL_DAO_AGGREGATION
+  struct ctimer dao_aggregation_timer;
+#endif /* RPL_WITH_STORING && RPL_DAO_AGGREGATION */
 };
 
 /*---------------------------------------------------------------------------*/
@@ -158,11 +158,25 @@
 #define RPL_WITH_PROBING 1
 #endif
 
+/*
+ * Targeted probing. When enabled, probes are spent on the candidate parents
+ * whose rank is the most uncertain, as estimated from link-stats freshness
+ * and from the variation of their link metric. The probing interval backs
+ * off while all candidate parents are known with enough confidence.
+ */
+#ifdef RPL_CONF_PROBING_TARGETED
+#define RPL_PROBING_TARGETED RPL_CONF_PROBING_TARGETED
+#else
+#define RPL_PROBING_TARGETED 0
+#endif
+
 /*
  * Function used to select the next neighbor to be probed.
  */
 #ifdef RPL_CONF_PROBING_SELECT_FUNC
 #define RPL_PROBING_SELECT_FUNC RPL_CONF_PROBING_SELECT_FUNC
+#elif RPL_PROBING_TARGETED
+#define RPL_PROBING_SELECT_FUNC get_targeted_probing_target
 #else
 #define RPL_PROBING_SELECT_FUNC get_probing_target
 #endif
@@ -282,10 +296,32 @@
  */
 #ifdef RPL_CONF_PROBING_DELAY_FUNC
 #define RPL_PROBING_DELAY_FUNC RPL_CONF_PROBING_DELAY_FUNC
+#elif RPL_PROBING_TARGETED
+#define RPL_PROBING_DELAY_FUNC get_targeted_probing_delay
 #else
 #define RPL_PROBING_DELAY_FUNC get_probing_delay
 #endif
 
+/*
+ * With targeted probing, the probing interval is doubled every time no
+ * neighbor needs probing, up to RPL_PROBING_INTERVAL << RPL_PROBING_MAX_BACKOFF.
+ */
+#ifdef RPL_CONF_PROBING_MAX_BACKOFF
+#define RPL_PROBING_MAX_BACKOFF RPL_CONF_PROBING_MAX_BACKOFF
+#else
+#define RPL_PROBING_MAX_BACKOFF 3
+#endif
+
+/*
+ * With targeted probing, rank uncertainty (in rank units) under which a
+ * neighbor is considered known with enough confidence not to be probed.
+ */
+#ifdef RPL_CONF_PROBING_MIN_UNCERTAINTY
+#define RPL_PROBING_MIN_UNCERTAINTY RPL_CONF_PROBING_MIN_UNCERTAINTY
+#else
+#define RPL_PROBING_MIN_UNCERTAINTY (LINK_STATS_ETX_DIVISOR / 4)
+#endif
+
 /* Poisoining duration, before leaving the DAG  */
 #ifdef RPL_CONF_DELAY_BEFORE_LEAVING
 #define RPL_DELAY_BEFORE_LEAVING        RPL_CONF_DELAY_BEFORE_LEAVING
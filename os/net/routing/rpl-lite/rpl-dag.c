@@ -278,26 +278,16 @@ rpl_dag_update_state(void)
     }
   } else if(!rpl_dag_root_is_root()) {
     rpl_nbr_t *old_parent = curr_instance.dag.preferred_parent;
-    rpl_nbr_t *nbr;
 
     /* Select and set preferred parent */
     rpl_neighbor_set_preferred_parent(rpl_neighbor_select_best());
     /* Update rank  */
     curr_instance.dag.rank = rpl_neighbor_rank_via_nbr(curr_instance.dag.preferred_parent);
 
-    /* Update better_parent_since flag for each neighbor */
-    nbr = nbr_table_head(rpl_neighbors);
-    while(nbr != NULL) {
-      if(rpl_neighbor_rank_via_nbr(nbr) < curr_instance.dag.rank) {
-        /* This neighbor would be a better parent than our current.
-        Set 'better_parent_since' if not already set. */
-        if(nbr->better_parent_since == 0) {
-          nbr->better_parent_since = clock_time(); /* Initialize */
-        }
-      } else {
-        nbr->better_parent_since = 0; /* Not a better parent */
-      }
-      nbr = nbr_table_next(rpl_neighbors, nbr);
+    /* Neighbors update their better_parent_since flag as their path cost
+    changes. When our own rank changes, re-evaluate all of them. */
+    if(curr_instance.dag.rank != old_rank) {
+      rpl_neighbor_update_better_parent_since();
     }
 
     if(old_parent == NULL || curr_instance.dag.rank < curr_instance.dag.lowest_rank) {
@@ -382,6 +372,7 @@ update_nbr_from_dio(uip_ipaddr_t *from, rpl_dio_t *dio)
 #if RPL_WITH_MC
   memcpy(&nbr->mc, &dio->mc, sizeof(nbr->mc));
 #endif /* RPL_WITH_MC */
+  rpl_neighbor_update_path_cost(nbr);
 
   return nbr;
 }
@@ -679,6 +670,7 @@ rpl_process_hbh(rpl_nbr_t *sender, uint16_t sender_rank, int loop_detected, int
      * the sender's rank from ext header */
     if(sender != NULL) {
       sender->rank = sender_rank;
+      rpl_neighbor_update_path_cost(sender);
       /* Select DAG and preferred parent. In case of a parent switch,
       the new parent will be used to forward the current packet. */
       rpl_dag_update_state();
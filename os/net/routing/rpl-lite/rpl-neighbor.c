@@ -64,6 +64,18 @@ static rpl_nbr_t * best_parent(int fresh_only);
 /* Per-neighbor RPL information */
 NBR_TABLE_GLOBAL(rpl_nbr_t, rpl_neighbors);
 
+/* The parent set: a binary min-heap of all RPL neighbors, ordered by the
+ * path cost cached in each neighbor. Only the neighbor whose rank or link
+ * metric changed is moved in the heap (rpl_neighbor_update_path_cost), so
+ * that best parent selection does not have to go through the OF for every
+ * neighbor. Positions are 1-based, a heap_index of 0 means not in the heap. */
+static rpl_nbr_t *parent_heap[NBR_TABLE_MAX_NEIGHBORS + 1];
+static uint16_t parent_heap_len;
+
+/* Max depth of the parent set explored when looking for the best parent.
+ * Enough for any realistic neighbor table size. */
+#define PARENT_HEAP_MAX_DEPTH 16
+
 /*---------------------------------------------------------------------------*/
 static int
 max_acceptable_rank(void)
@@ -191,6 +203,126 @@ rpl_get_ds6_nbr(rpl_nbr_t *nbr)
 #endif /* UIP_ND6_SEND_NS */
 /*---------------------------------------------------------------------------*/
 static void
+heap_set(uint16_t index, rpl_nbr_t *nbr)
+{
+  parent_heap[index] = nbr;
+  nbr->heap_index = index;
+}
+/*---------------------------------------------------------------------------*/
+static void
+heap_sift_up(uint16_t index)
+{
+  rpl_nbr_t *nbr = parent_heap[index];
+
+  while(index > 1 && parent_heap[index / 2]->path_cost > nbr->path_cost) {
+    heap_set(index, parent_heap[index / 2]);
+    index /= 2;
+  }
+  heap_set(index, nbr);
+}
+/*---------------------------------------------------------------------------*/
+static void
+heap_sift_down(uint16_t index)
+{
+  rpl_nbr_t *nbr = parent_heap[index];
+  uint16_t child;
+
+  while((child = 2 * index) <= parent_heap_len) {
+    if(child < parent_heap_len
+       && parent_heap[child + 1]->path_cost < parent_heap[child]->path_cost) {
+      child++;
+    }
+    if(parent_heap[child]->path_cost >= nbr->path_cost) {
+      break;
+    }
+    heap_set(index, parent_heap[child]);
+    index = child;
+  }
+  heap_set(index, nbr);
+}
+/*---------------------------------------------------------------------------*/
+static void
+parent_set_remove(rpl_nbr_t *nbr)
+{
+  uint16_t index = nbr->heap_index;
+  rpl_nbr_t *last;
+
+  if(index == 0) {
+    return;
+  }
+
+  last = parent_heap[parent_heap_len];
+  parent_heap[parent_heap_len] = NULL;
+  parent_heap_len--;
+  nbr->heap_index = 0;
+
+  if(last != nbr) {
+    /* Fill the hole with the last element and restore heap order */
+    heap_set(index, last);
+    heap_sift_up(index);
+    heap_sift_down(last->heap_index);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+update_better_parent_since(rpl_nbr_t *nbr)
+{
+  if(nbr->rank_via < curr_instance.dag.rank) {
+    /* This neighbor would be a better parent than our current.
+    Set 'better_parent_since' if not already set. */
+    if(nbr->better_parent_since == 0) {
+      nbr->better_parent_since = clock_time(); /* Initialize */
+    }
+  } else {
+    nbr->better_parent_since = 0; /* Not a better parent */
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+rpl_neighbor_update_better_parent_since(void)
+{
+  rpl_nbr_t *nbr;
+
+  /* Only uses the rank cached in each neighbor, no OF involved */
+  for(nbr = nbr_table_head(rpl_neighbors);
+      nbr != NULL;
+      nbr = nbr_table_next(rpl_neighbors, nbr)) {
+    update_better_parent_since(nbr);
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+rpl_neighbor_update_path_cost(rpl_nbr_t *nbr)
+{
+  uint16_t old_cost;
+
+  if(nbr == NULL || !curr_instance.used) {
+    return;
+  }
+
+  old_cost = nbr->path_cost;
+  nbr->path_cost = curr_instance.of->nbr_path_cost(nbr);
+  nbr->rank_via = rpl_neighbor_rank_via_nbr(nbr);
+  if(curr_instance.dag.state != DAG_POISONING && !rpl_dag_root_is_root()) {
+    update_better_parent_since(nbr);
+  }
+
+  if(nbr->heap_index == 0) {
+    if(parent_heap_len >= NBR_TABLE_MAX_NEIGHBORS) {
+      LOG_ERR("parent set full\n");
+      return;
+    }
+    parent_heap_len++;
+    heap_set(parent_heap_len, nbr);
+    heap_sift_up(parent_heap_len);
+  } else if(nbr->path_cost < old_cost) {
+    heap_sift_up(nbr->heap_index);
+  } else if(nbr->path_cost > old_cost) {
+    heap_sift_down(nbr->heap_index);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
 remove_neighbor(rpl_nbr_t *nbr)
 {
   /* Make sure we don't point to a removed neighbor. Note that we do not need
@@ -202,6 +334,7 @@ remove_neighbor(rpl_nbr_t *nbr)
   if(nbr == curr_instance.dag.unicast_dio_target) {
     curr_instance.dag.unicast_dio_target = NULL;
   }
+  parent_set_remove(nbr);
   nbr_table_remove(rpl_neighbors, nbr);
   rpl_timers_schedule_state_update(); /* Updating from here is unsafe; postpone */
 }
@@ -344,41 +477,84 @@ rpl_neighbor_get_from_ipaddr(uip_ipaddr_t *addr)
   return nbr_table_get_from_lladdr(rpl_neighbors, (linkaddr_t *)lladdr);
 }
 /*---------------------------------------------------------------------------*/
+static int
+is_candidate_parent(rpl_nbr_t *nbr, int fresh_only)
+{
+  if(!acceptable_rank(nbr->rank) || !curr_instance.of->nbr_is_acceptable_parent(nbr)) {
+    /* Exclude neighbors with a rank that is not acceptable) */
+    return 0;
+  }
+
+  if(fresh_only && !rpl_neighbor_is_fresh(nbr)) {
+    /* Filter out non-fresh nerighbors if fresh_only is set */
+    return 0;
+  }
+
+#if UIP_ND6_SEND_NS
+  {
+  uip_ds6_nbr_t *ds6_nbr = rpl_get_ds6_nbr(nbr);
+  /* Exclude links to a neighbor that is not reachable at a NUD level */
+  if(ds6_nbr == NULL || ds6_nbr->state != NBR_REACHABLE) {
+    return 0;
+  }
+  }
+#endif /* UIP_ND6_SEND_NS */
+
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
 static rpl_nbr_t *
 best_parent(int fresh_only)
 {
-  rpl_nbr_t *nbr;
+  uint16_t stack[PARENT_HEAP_MAX_DEPTH + 1];
+  int stack_len = 0;
   rpl_nbr_t *best = NULL;
+  rpl_nbr_t *preferred;
 
   if(curr_instance.used == 0) {
     return NULL;
   }
 
-  /* Search for the best parent according to the OF */
-  for(nbr = nbr_table_head(rpl_neighbors); nbr != NULL; nbr = nbr_table_next(rpl_neighbors, nbr)) {
+  /* Look for the candidate with the lowest path cost. Explore the parent set
+  depth-first, skipping any subtree whose root is costlier than the best
+  candidate found so far. Candidates of equal cost go through the OF, which
+  breaks the tie. When the cheapest neighbor is a candidate, which is the
+  common case, this only looks at the top of the heap and its ties. */
+  if(parent_heap_len > 0) {
+    stack[stack_len++] = 1;
+  }
+  while(stack_len > 0) {
+    uint16_t index = stack[--stack_len];
+    rpl_nbr_t *nbr = parent_heap[index];
 
-    if(!acceptable_rank(nbr->rank) || !curr_instance.of->nbr_is_acceptable_parent(nbr)) {
-      /* Exclude neighbors with a rank that is not acceptable) */
+    if(best != NULL && nbr->path_cost > best->path_cost) {
       continue;
     }
-
-    if(fresh_only && !rpl_neighbor_is_fresh(nbr)) {
-      /* Filter out non-fresh nerighbors if fresh_only is set */
-      continue;
+    if(is_candidate_parent(nbr, fresh_only)) {
+      if(best == NULL || nbr->path_cost < best->path_cost) {
+        best = nbr;
+      } else {
+        best = curr_instance.of->best_parent(best, nbr);
+      }
     }
-
-#if UIP_ND6_SEND_NS
-    {
-    uip_ds6_nbr_t *ds6_nbr = rpl_get_ds6_nbr(nbr);
-    /* Exclude links to a neighbor that is not reachable at a NUD level */
-    if(ds6_nbr == NULL || ds6_nbr->state != NBR_REACHABLE) {
-      continue;
+    if(stack_len + 2 > PARENT_HEAP_MAX_DEPTH + 1) {
+      LOG_ERR("parent set too deep\n");
+      break;
     }
+    if(2 * index + 1 <= parent_heap_len) {
+      stack[stack_len++] = 2 * index + 1;
     }
-#endif /* UIP_ND6_SEND_NS */
+    if(2 * index <= parent_heap_len) {
+      stack[stack_len++] = 2 * index;
+    }
+  }
 
-    /* Now we have an acceptable parent, check if it is the new best */
-    best = curr_instance.of->best_parent(best, nbr);
+  /* Let the OF apply its hysteresis between the cheapest candidate
+  and our current preferred parent */
+  preferred = curr_instance.dag.preferred_parent;
+  if(preferred != NULL && preferred != best
+     && preferred->heap_index != 0 && is_candidate_parent(preferred, fresh_only)) {
+    best = curr_instance.of->best_parent(best, preferred);
   }
 
   return best;
@@ -185,6 +185,20 @@ void rpl_neighbor_print_list(const char *str);
 */
 void rpl_neighbor_remove_all(void);
 
+/**
+ * Updates the position of a neighbor in the parent set. Must be called
+ * whenever the neighbor's rank or link metric may have changed.
+ *
+ * \param nbr The neighbor
+*/
+void rpl_neighbor_update_path_cost(rpl_nbr_t *nbr);
+
+/**
+ * Re-evaluates, for every neighbor, whether it would be a better parent
+ * than our current one. Must be called whenever our own rank changed.
+*/
+void rpl_neighbor_update_better_parent_since(void);
+
 /**
  * Returns the best candidate for preferred parent
  *
@@ -414,6 +414,125 @@ get_probing_target(void)
 
   return probing_target;
 }
+#if RPL_PROBING_TARGETED
+/*---------------------------------------------------------------------------*/
+/* Current probing interval back-off exponent, see RPL_PROBING_MAX_BACKOFF */
+static uint8_t probing_backoff;
+/*---------------------------------------------------------------------------*/
+void
+rpl_probing_link_update(rpl_nbr_t *nbr)
+{
+  uint16_t link_metric = rpl_neighbor_get_link_metric(nbr);
+  uint16_t variation;
+
+  if(nbr->last_link_metric == 0) {
+    /* First update: nothing to compare with, assume a high variation */
+    nbr->link_metric_dev = LINK_STATS_ETX_DIVISOR;
+  } else {
+    variation = link_metric > nbr->last_link_metric ?
+      link_metric - nbr->last_link_metric : nbr->last_link_metric - link_metric;
+    /* EWMA with alpha 1/4 */
+    nbr->link_metric_dev = ((uint32_t)nbr->link_metric_dev * 3 + variation) / 4;
+  }
+  nbr->last_link_metric = link_metric;
+}
+/*---------------------------------------------------------------------------*/
+static uint16_t
+rank_uncertainty(rpl_nbr_t *nbr, clock_time_t clock_now)
+{
+  const struct link_stats *stats = rpl_neighbor_get_link_stats(nbr);
+  uint32_t uncertainty;
+
+  if(stats == NULL || stats->last_tx_time == 0 || nbr->last_link_metric == 0) {
+    /* We never transmitted to this neighbor, its link metric is unknown */
+    return 0xffff;
+  }
+
+  /* Observed link metric variation, weighted by how many transmissions
+  recently contributed to the estimate: twice the variation without recent
+  transmission, the variation itself at the freshness target (4), and less
+  above that. */
+  uncertainty = (uint32_t)nbr->link_metric_dev * 8 / (stats->freshness + 4);
+
+  if(!link_stats_is_fresh(stats)) {
+    /* Stale estimate: add one ETX unit per probing interval since last tx */
+    uncertainty += (uint32_t)LINK_STATS_ETX_DIVISOR
+      * (1 + (clock_now - stats->last_tx_time) / RPL_PROBING_INTERVAL);
+  }
+
+  return MIN(uncertainty, 0xffff);
+}
+/*---------------------------------------------------------------------------*/
+clock_time_t
+get_targeted_probing_delay(void)
+{
+  clock_time_t interval = RPL_PROBING_INTERVAL << probing_backoff;
+  return interval / 2 + (interval / 256) * (random_rand() % 256);
+}
+/*---------------------------------------------------------------------------*/
+rpl_nbr_t *
+get_targeted_probing_target(void)
+{
+  /* Returns the next probing target. The urgent probing target and a non-fresh
+   * preferred parent come first. Otherwise, pick the neighbor which might
+   * offer a rank better than or close to our preferred parent's, given the
+   * uncertainty on its link metric, and which has the largest such
+   * uncertainty. Neighbors whose rank is known with enough confidence are not
+   * probed, and the probing interval backs off while there is none to probe.
+   */
+
+  rpl_nbr_t *nbr;
+  rpl_nbr_t *probing_target = NULL;
+  uint16_t probing_target_score = RPL_PROBING_MIN_UNCERTAINTY;
+  rpl_rank_t preferred_rank;
+  clock_time_t clock_now = clock_time();
+
+  if(curr_instance.used == 0) {
+    return NULL;
+  }
+
+  /* There is an urgent probing target */
+  if(curr_instance.dag.urgent_probing_target != NULL) {
+    probing_backoff = 0;
+    return curr_instance.dag.urgent_probing_target;
+  }
+
+  /* The preferred parent needs probing */
+  if(curr_instance.dag.preferred_parent != NULL && !rpl_neighbor_is_fresh(curr_instance.dag.preferred_parent)) {
+    probing_backoff = 0;
+    return curr_instance.dag.preferred_parent;
+  }
+
+  preferred_rank = rpl_neighbor_rank_via_nbr(curr_instance.dag.preferred_parent);
+
+  nbr = nbr_table_head(rpl_neighbors);
+  while(nbr != NULL) {
+    if(nbr->rank != RPL_INFINITE_RANK) {
+      rpl_rank_t nbr_rank = rpl_neighbor_rank_via_nbr(nbr);
+      uint16_t uncertainty = rank_uncertainty(nbr, clock_now);
+      /* How much worse than our preferred parent this neighbor looks */
+      uint16_t margin = nbr_rank > preferred_rank ? nbr_rank - preferred_rank : 0;
+
+      /* Only neighbors that might turn out to be as good as our preferred
+      parent are worth probing */
+      if(uncertainty > margin
+         && uncertainty - margin > probing_target_score) {
+        probing_target = nbr;
+        probing_target_score = uncertainty - margin;
+      }
+    }
+    nbr = nbr_table_next(rpl_neighbors, nbr);
+  }
+
+  if(probing_target != NULL) {
+    probing_backoff = 0;
+  } else if(probing_backoff < RPL_PROBING_MAX_BACKOFF) {
+    probing_backoff++;
+  }
+
+  return probing_target;
+}
+#endif /* RPL_PROBING_TARGETED */
 /*---------------------------------------------------------------------------*/
 static void
 handle_probing_timer(void *ptr)
@@ -456,6 +575,9 @@ void
 rpl_schedule_probing_now(void)
 {
   if(curr_instance.used) {
+#if RPL_PROBING_TARGETED
+    probing_backoff = 0;
+#endif /* RPL_PROBING_TARGETED */
     ctimer_set(&curr_instance.dag.probing_timer,
       random_rand() % (CLOCK_SECOND * 4), handle_probing_timer, NULL);
   }
@@ -109,6 +109,14 @@ void rpl_schedule_probing(void);
 */
 void rpl_schedule_probing_now(void);
 
+/**
+ * Update the link metric variation of a neighbor, used by targeted probing
+ * to estimate rank uncertainty. Called after every link-stats update.
+ *
+ * \param nbr The neighbor whose link statistics were updated
+*/
+void rpl_probing_link_update(rpl_nbr_t *nbr);
+
 /**
  * Schedule a state update ASAP. Useful to force an update from a context
  * where updating directly would be unsafe.
@@ -141,6 +141,15 @@ struct rpl_nbr {
   rpl_metric_container_t mc;
 #endif /* RPL_WITH_MC */
   rpl_rank_t rank;
+  uint16_t path_cost; /* Path cost through this neighbor, as last computed
+  by the OF. Used as key in the parent set. */
+  rpl_rank_t rank_via; /* Our rank through this neighbor, computed along
+  with path_cost */
+  uint16_t heap_index; /* Position in the parent set, 0 if not in the set */
+#if RPL_WITH_PROBING && RPL_PROBING_TARGETED
+  uint16_t last_link_metric; /* Link metric at the last link update */
+  uint16_t link_metric_dev; /* EWMA of the link metric variation */
+#endif /* RPL_WITH_PROBING && RPL_PROBING_TARGETED */
   uint8_t dtsn;
 };
 typedef struct rpl_nbr rpl_nbr_t;
@@ -109,6 +109,23 @@ rpl_link_callback(const linkaddr_t *addr, int status, int numtx)
       LOG_INFO("packet sent to ");
       LOG_INFO_LLADDR(addr);
       LOG_INFO_(", status %u, tx %u, new link metric %u\n", status, numtx, rpl_neighbor_get_link_metric(nbr));
+#if RPL_WITH_PROBING && RPL_PROBING_TARGETED
+      rpl_probing_link_update(nbr);
+#endif /* RPL_WITH_PROBING && RPL_PROBING_TARGETED */
+      rpl_timers_schedule_state_update();
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+rpl_link_stats_callback(const linkaddr_t *addr)
+{
+  if(curr_instance.used == 1) {
+    rpl_nbr_t *nbr = rpl_neighbor_get_from_lladdr((uip_lladdr_t *)addr);
+    if(nbr != NULL) {
+      /* Keep the path cost cached in the parent set in sync with the link
+      metric, whichever lower layer updated it */
+      rpl_neighbor_update_path_cost(nbr);
       rpl_timers_schedule_state_update();
     }
   }
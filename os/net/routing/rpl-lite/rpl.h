@@ -76,6 +76,14 @@ extern uip_ipaddr_t rpl_multicast_addr;
  */
 void rpl_link_callback(const linkaddr_t *addr, int status, int numtx);
 
+/**
+ * Called by link-stats whenever the link metric to a neighbor may have
+ * changed (see LINK_STATS_CALLBACK_UPDATED)
+ *
+ * \param addr The link-layer addrress of the neighbor
+ */
+void rpl_link_stats_callback(const linkaddr_t *addr);
+
 /**
  * Set prefix from an prefix data structure (from DIO)
  *
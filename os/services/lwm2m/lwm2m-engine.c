@@ -47,6 +47,8 @@
 #include "lwm2m-device.h"
 #include "lwm2m-plain-text.h"
 #include "lwm2m-json.h"
+#include "lwm2m-senml-cbor.h"
+#include "lwm2m-notification-attributes.h"
 #include "coap-constants.h"
 #include "coap-engine.h"
 #include "lwm2m-tlv.h"
@@ -80,6 +82,35 @@
 #define USE_RD_CLIENT 1
 #endif /* LWM2M_ENGINE_CONF_USE_RD_CLIENT */
 
+/* Content format of reads of objects and object instances that come
+   without an Accept option, such as notifications */
+#ifdef LWM2M_ENGINE_CONF_MULTI_READ_FORMAT
+#define MULTI_READ_FORMAT LWM2M_ENGINE_CONF_MULTI_READ_FORMAT
+#else
+#define MULTI_READ_FORMAT LWM2M_JSON
+#endif /* LWM2M_ENGINE_CONF_MULTI_READ_FORMAT */
+
+/* Expected number of registered object instances. The object and
+   instance indices get this many buckets, rounded up to a power of two,
+   so lookups do not depend on the number of instances as long as it
+   stays in the order of this. */
+#ifdef LWM2M_ENGINE_CONF_EXPECTED_INSTANCES
+#define EXPECTED_INSTANCES LWM2M_ENGINE_CONF_EXPECTED_INSTANCES
+#else
+#define EXPECTED_INSTANCES 8
+#endif /* LWM2M_ENGINE_CONF_EXPECTED_INSTANCES */
+
+#if EXPECTED_INSTANCES < 1 || EXPECTED_INSTANCES > 1024
+#error "LWM2M_ENGINE_CONF_EXPECTED_INSTANCES must be between 1 and 1024"
+#endif
+
+#define OBJECT_TABLE_SIZE                                             \
+  (EXPECTED_INSTANCES <= 4 ? 4 : EXPECTED_INSTANCES <= 8 ? 8 :        \
+   EXPECTED_INSTANCES <= 16 ? 16 : EXPECTED_INSTANCES <= 32 ? 32 :    \
+   EXPECTED_INSTANCES <= 64 ? 64 : EXPECTED_INSTANCES <= 128 ? 128 :  \
+   EXPECTED_INSTANCES <= 256 ? 256 : EXPECTED_INSTANCES <= 512 ? 512 : \
+   1024)
+
 
 #if LWM2M_QUEUE_MODE_ENABLED
  /* Queue Mode is handled using the RD Client and the Q-Mode object */
@@ -144,37 +175,78 @@ static struct {
 } created;
 
 COAP_HANDLER(lwm2m_handler, lwm2m_handler_callback);
+/* Both lists are sorted by ID, which gives discovery and the /rd payload
+   a stable order. */
 LIST(object_list);
 LIST(generic_object_list);
 
+/* Instances of object_list hashed by object and instance ID, the first
+   instance of each object in object_list and the generic objects hashed
+   by object ID. */
+static lwm2m_object_instance_t *instance_table[OBJECT_TABLE_SIZE];
+static lwm2m_object_instance_t *first_instance_table[OBJECT_TABLE_SIZE];
+static lwm2m_object_t *generic_object_table[OBJECT_TABLE_SIZE];
+
+/*---------------------------------------------------------------------------*/
+static unsigned
+object_hash(uint16_t object_id)
+{
+  return (object_id ^ (object_id >> 8)) & (OBJECT_TABLE_SIZE - 1);
+}
+/*---------------------------------------------------------------------------*/
+static unsigned
+instance_hash(uint16_t object_id, uint16_t instance_id)
+{
+  return (object_hash(object_id) + instance_id) & (OBJECT_TABLE_SIZE - 1);
+}
 /*---------------------------------------------------------------------------*/
 static lwm2m_object_t *
 get_object(uint16_t object_id)
 {
   lwm2m_object_t *object;
-  for(object = list_head(generic_object_list);
+  for(object = generic_object_table[object_hash(object_id)];
       object != NULL;
-      object = object->next) {
-    if(object->impl && object->impl->object_id == object_id) {
+      object = object->table_next) {
+    if(object->impl->object_id == object_id) {
       return object;
     }
   }
   return NULL;
 }
 /*---------------------------------------------------------------------------*/
-static int
-has_non_generic_object(uint16_t object_id)
+static lwm2m_object_instance_t *
+get_first_instance(uint16_t object_id)
 {
   lwm2m_object_instance_t *instance;
-  for(instance = list_head(object_list);
+  for(instance = first_instance_table[object_hash(object_id)];
       instance != NULL;
-      instance = instance->next) {
+      instance = instance->object_table_next) {
     if(instance->object_id == object_id) {
-      return 1;
+      return instance;
     }
   }
-
-  return 0;
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static lwm2m_object_instance_t *
+get_non_generic_instance(uint16_t object_id, uint16_t instance_id)
+{
+  lwm2m_object_instance_t *instance;
+  for(instance = instance_table[instance_hash(object_id, instance_id)];
+      instance != NULL;
+      instance = instance->table_next) {
+    if(instance->object_id == object_id &&
+       instance->instance_id == instance_id) {
+      return instance;
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static int
+has_non_generic_object(uint16_t object_id)
+{
+  return get_first_instance(object_id) != NULL;
 }
 /*---------------------------------------------------------------------------*/
 static lwm2m_object_instance_t *
@@ -187,15 +259,13 @@ get_instance(uint16_t object_id, uint16_t instance_id, lwm2m_object_t **o)
     *o = NULL;
   }
 
-  for(instance = list_head(object_list);
-      instance != NULL;
-      instance = instance->next) {
-    if(instance->object_id == object_id) {
-      if(instance->instance_id == instance_id ||
-         instance_id == LWM2M_OBJECT_INSTANCE_NONE) {
-        return instance;
-      }
-    }
+  if(instance_id == LWM2M_OBJECT_INSTANCE_NONE) {
+    instance = get_first_instance(object_id);
+  } else {
+    instance = get_non_generic_instance(object_id, instance_id);
+  }
+  if(instance != NULL) {
+    return instance;
   }
 
   object = get_object(object_id);
@@ -285,7 +355,7 @@ get_method_as_string(coap_resource_flags_t method)
 static const char *
 get_status_as_string(lwm2m_status_t status)
 {
-  static char buffer[8];
+  static char buffer[13];
   switch(status) {
   case LWM2M_STATUS_OK:
     return "OK";
@@ -314,7 +384,7 @@ get_status_as_string(lwm2m_status_t status)
   case LWM2M_STATUS_SERVICE_UNAVAILABLE:
     return "SERVICE UNAVAILABLE";
   default:
-    snprintf(buffer, sizeof(buffer) - 1, "<%u>", status);
+    snprintf(buffer, sizeof(buffer), "<%u>", status);
     return buffer;
   }
 }
@@ -358,6 +428,32 @@ parse_path(const char *path, int path_len,
   return ret;
 }
 /*--------------------------------------------------------------------------*/
+/* Parses the path of a SenML record, the base name followed by the name */
+static int
+parse_record_path(const lwm2m_senml_cbor_record_t *record,
+                  uint16_t *oid, uint16_t *iid, uint16_t *rid)
+{
+  char path[32];
+  int path_len;
+  int i;
+
+  path_len = record->base_name_len + record->name_len;
+  if(path_len >= sizeof(path)) {
+    return -1;
+  }
+  if(record->base_name_len > 0) {
+    memcpy(path, record->base_name, record->base_name_len);
+  }
+  if(record->name_len > 0) {
+    memcpy(&path[record->base_name_len], record->name, record->name_len);
+  }
+  i = path_len > 0 && path[0] == '/' ? 1 : 0;
+  if(i >= path_len) {
+    return -1;
+  }
+  return parse_path(&path[i], path_len - i, oid, iid, rid);
+}
+/*--------------------------------------------------------------------------*/
 static int
 lwm2m_engine_parse_context(const char *path, int path_len,
                            coap_message_t *request, coap_message_t *response,
@@ -508,6 +604,13 @@ lwm2m_engine_init(void)
 {
   list_init(object_list);
   list_init(generic_object_list);
+  memset(instance_table, 0, sizeof(instance_table));
+  memset(first_instance_table, 0, sizeof(first_instance_table));
+  memset(generic_object_table, 0, sizeof(generic_object_table));
+  lwm2m_notification_attributes_init();
+#if LWM2M_QUEUE_MODE_ENABLED
+  lwm2m_notification_queue_init();
+#endif
 
 #ifdef LWM2M_ENGINE_CLIENT_ENDPOINT_NAME
   const char *endpoint = LWM2M_ENGINE_CLIENT_ENDPOINT_NAME;
@@ -598,6 +701,9 @@ lwm2m_engine_select_writer(lwm2m_context_t *context, unsigned int accept)
     case APPLICATION_JSON:
       context->writer = &lwm2m_json_writer;
       break;
+    case LWM2M_SENML_CBOR:
+      context->writer = &lwm2m_senml_cbor_writer;
+      break;
     default:
       LOG_WARN("Unknown Accept type %u, using LWM2M plain text\n", accept);
       context->writer = &lwm2m_plain_text_writer;
@@ -627,6 +733,9 @@ lwm2m_engine_select_reader(lwm2m_context_t *context, unsigned int content_format
     case LWM2M_OLD_JSON:
       context->reader = &lwm2m_plain_text_reader;
       break;
+    case LWM2M_SENML_CBOR:
+      context->reader = &lwm2m_senml_cbor_reader;
+      break;
     case LWM2M_TEXT_PLAIN:
     case TEXT_PLAIN:
       context->reader = &lwm2m_plain_text_reader;
@@ -748,6 +857,13 @@ perform_multi_resource_read_op(lwm2m_object_t *object,
               len += snprintf((char *) &ctx->outbuf->buffer[ctx->outbuf->len + len],
                               ctx->outbuf->size - ctx->outbuf->len - len,  ";dim=%d", dim);
             }
+            if(len > 0 && ctx->outbuf->len + len < ctx->outbuf->size) {
+              len += lwm2m_notification_attributes_write_link(instance->object_id,
+                                                              instance->instance_id,
+                                                              RSC_ID(instance->resource_ids[last_rsc_pos]),
+                                                              &ctx->outbuf->buffer[ctx->outbuf->len + len],
+                                                              ctx->outbuf->size - ctx->outbuf->len - len);
+            }
             /* here we have "read" out something */
             num_read++;
             ctx->outbuf->len += len;
@@ -889,6 +1005,12 @@ perform_multi_resource_read_op(lwm2m_object_t *object,
       last_instance_id = NO_INSTANCE;
     }
     if(ctx->operation == LWM2M_OP_READ) {
+      /* Writers that put all instances into one document close it last */
+      if(instance != NULL) {
+        ctx->writer_flags |= WRITER_MORE_INSTANCES;
+      } else {
+        ctx->writer_flags &= ~WRITER_MORE_INSTANCES;
+      }
       LOG_DBG("END Writer %d ->", ctx->outbuf->len);
       len = ctx->writer->end_write(ctx);
       ctx->outbuf->len += len;
@@ -924,6 +1046,134 @@ perform_multi_resource_read_op(lwm2m_object_t *object,
   return LWM2M_STATUS_OK;
 }
 /*---------------------------------------------------------------------------*/
+/* Opens a SenML pack of several paths, keeping room for its end */
+static void
+init_composite(lwm2m_context_t *ctx)
+{
+  ctx->writer = &lwm2m_senml_cbor_writer;
+  ctx->content_type = LWM2M_SENML_CBOR;
+  ctx->operation = LWM2M_OP_READ;
+  ctx->writer_flags = 0;
+  ctx->outbuf->len += ctx->writer->init_write(ctx);
+  ctx->outbuf->size--;
+}
+/*---------------------------------------------------------------------------*/
+static void
+end_composite(lwm2m_context_t *ctx)
+{
+  ctx->outbuf->size++;
+  ctx->writer_flags = 0;
+  ctx->outbuf->len += ctx->writer->end_write(ctx);
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Appends the resources of a path to the pack opened by init_composite.
+ * The multi read writes them to the rest of the output buffer, and all of
+ * the composite has to fit into it - there is no blockwise transfer.
+ */
+static lwm2m_status_t
+read_composite_path(lwm2m_context_t *ctx, uint16_t oid, uint16_t iid,
+                    uint16_t rid, int level)
+{
+  lwm2m_buffer_t *outbuf = ctx->outbuf;
+  lwm2m_buffer_t rest;
+  lwm2m_object_t *object;
+  lwm2m_object_instance_t *instance;
+  lwm2m_status_t status;
+
+  ctx->object_id = oid;
+  ctx->object_instance_id = iid;
+  ctx->resource_id = rid;
+  ctx->level = level;
+  ctx->offset = 0;
+  ctx->writer_flags = WRITER_COMPOSITE;
+
+  instance = get_instance_by_context(ctx, &object);
+  if(instance == NULL) {
+    return LWM2M_STATUS_NOT_FOUND;
+  }
+
+  memset(&rest, 0, sizeof(rest));
+  rest.buffer = &outbuf->buffer[outbuf->len];
+  rest.size = outbuf->size - outbuf->len;
+  ctx->outbuf = &rest;
+  status = perform_multi_resource_read_op(object, instance, ctx);
+  ctx->outbuf = outbuf;
+
+  if(status == LWM2M_STATUS_OK && (ctx->writer_flags & WRITER_HAS_MORE)) {
+    LOG_WARN("Composite does not fit into %u bytes\n", outbuf->size);
+    lwm2m_buf_lock[0] = 0;
+    lwm2m_buf.len = 0;
+    return LWM2M_STATUS_ERROR;
+  }
+  outbuf->len += rest.len;
+  return status;
+}
+/*---------------------------------------------------------------------------*/
+/* Read-Composite (LwM2M 1.1): a FETCH with the paths as a SenML pack */
+static lwm2m_status_t
+perform_composite_read_op(lwm2m_context_t *ctx)
+{
+  lwm2m_senml_cbor_record_t record;
+  lwm2m_status_t status;
+  uint16_t oid = 0;
+  uint16_t iid = 0;
+  uint16_t rid = 0;
+  int level;
+
+  init_composite(ctx);
+  memset(&record, 0, sizeof(record));
+  while(lwm2m_senml_cbor_next_path(ctx, &record)) {
+    level = parse_record_path(&record, &oid, &iid, &rid);
+    if(level < 1 || level > 3) {
+      return LWM2M_STATUS_BAD_REQUEST;
+    }
+    LOG_DBG("Read-Composite: %u/%u/%u lv:%d\n", oid, iid, rid, level);
+    status = read_composite_path(ctx, oid, iid, rid, level);
+    /* Paths that do not exist are left out */
+    if(status != LWM2M_STATUS_OK && status != LWM2M_STATUS_NOT_FOUND) {
+      return status;
+    }
+  }
+  end_composite(ctx);
+  return LWM2M_STATUS_OK;
+}
+/*---------------------------------------------------------------------------*/
+int
+lwm2m_engine_write_composite(const lwm2m_path_t *paths, int count,
+                             uint8_t *buffer, uint16_t size)
+{
+  lwm2m_context_t ctx;
+  lwm2m_buffer_t outbuf;
+  lwm2m_status_t status;
+  int i;
+
+  if(size < 2) {
+    return -1;
+  }
+  memset(&ctx, 0, sizeof(ctx));
+  memset(&outbuf, 0, sizeof(outbuf));
+  outbuf.buffer = buffer;
+  outbuf.size = size;
+  ctx.outbuf = &outbuf;
+  ctx.inbuf = &outbuf;
+
+  init_composite(&ctx);
+  for(i = 0; i < count; i++) {
+    status = read_composite_path(&ctx, paths[i].object_id,
+                                 paths[i].instance_id, paths[i].resource_id,
+                                 paths[i].level);
+    if(status != LWM2M_STATUS_OK && status != LWM2M_STATUS_NOT_FOUND) {
+      LOG_WARN("Composite failed at %u/%u/%u: %s\n", paths[i].object_id,
+               paths[i].instance_id, paths[i].resource_id,
+               get_status_as_string(status));
+      return -1;
+    }
+  }
+  end_composite(&ctx);
+  return outbuf.len;
+}
+/*---------------------------------------------------------------------------*/
 static lwm2m_object_instance_t *
 create_instance(lwm2m_context_t *context, lwm2m_object_t *object)
 {
@@ -1047,7 +1297,7 @@ perform_multi_resource_write_op(lwm2m_object_t *object,
                                 lwm2m_object_instance_t *instance,
                                 lwm2m_context_t *ctx, int format)
 {
-  /* Only for JSON and TLV formats */
+  /* Only for JSON, SenML-CBOR and TLV formats */
   uint16_t oid = 0, iid = 0, rid = 0;
   uint8_t olv = 0;
   uint8_t mode = 0;
@@ -1120,6 +1370,47 @@ perform_multi_resource_write_op(lwm2m_object_t *object,
         ctx->level = olv;
       }
     }
+  } else if(format == LWM2M_SENML_CBOR) {
+    lwm2m_senml_cbor_record_t record;
+    uint16_t target_iid = ctx->object_instance_id;
+    uint16_t target_rid = ctx->resource_id;
+    lwm2m_status_t status;
+
+    memset(&record, 0, sizeof(record));
+    while(lwm2m_senml_cbor_next_record(ctx, &record)) {
+      if(parse_record_path(&record, &oid, &iid, &rid) != 3
+         || oid != ctx->object_id
+         || (olv >= 2 && iid != target_iid)
+         || (olv == 3 && rid != target_rid)) {
+        LOG_DBG("SenML record outside of the target or not a resource\n");
+        return LWM2M_STATUS_BAD_REQUEST;
+      }
+
+      ctx->level = 3;
+      ctx->object_instance_id = iid;
+      ctx->resource_id = rid;
+      instance = get_or_create_instance(ctx, object, &created);
+      if(instance == NULL || instance->callback == NULL) {
+        return LWM2M_STATUS_NOT_FOUND;
+      }
+      if(!check_write(ctx, instance, rid)) {
+        return LWM2M_STATUS_OPERATION_NOT_ALLOWED;
+      }
+
+      /* Let the resource read the value of the record */
+      inpos = ctx->inbuf->pos;
+      ctx->inbuf->buffer = (uint8_t *)record.value;
+      ctx->inbuf->pos = 0;
+      ctx->inbuf->size = record.value_len;
+      status = instance->callback(instance, ctx);
+      ctx->inbuf->buffer = inbuf;
+      ctx->inbuf->pos = inpos;
+      ctx->inbuf->size = insize;
+      ctx->level = olv;
+      if(status != LWM2M_STATUS_OK) {
+        return status;
+      }
+    }
   } else if(format == LWM2M_TLV || format == LWM2M_OLD_TLV) {
     size_t len;
     lwm2m_tlv_t tlv;
@@ -1215,13 +1506,52 @@ lwm2m_engine_has_instance(uint16_t object_id, uint16_t instance_id)
   return get_instance(object_id, instance_id, NULL) != NULL;
 }
 /*---------------------------------------------------------------------------*/
+lwm2m_object_instance_t *
+lwm2m_engine_get_instance(uint16_t object_id, uint16_t instance_id)
+{
+  return get_instance(object_id, instance_id, NULL);
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Returns the instance in object_list that an instance with the given IDs
+ * goes after, or NULL if it becomes the head of the list. Appending to an
+ * object and adding its successor ID take constant time, other positions
+ * skip the instances of the preceding objects.
+ */
+static lwm2m_object_instance_t *
+find_insert_position(lwm2m_object_instance_t *first,
+                     uint16_t object_id, uint16_t instance_id)
+{
+  lwm2m_object_instance_t *prev;
+
+  if(first != NULL && first->instance_id < instance_id) {
+    if(first->object_last->instance_id < instance_id) {
+      return first->object_last;
+    }
+    prev = get_non_generic_instance(object_id, instance_id - 1);
+    if(prev == NULL) {
+      for(prev = first; prev->next->instance_id < instance_id;
+          prev = prev->next);
+    }
+    return prev;
+  }
+
+  /* Before the first instance of the object, after the last instance of
+     the preceding object */
+  prev = NULL;
+  for(first = list_head(object_list);
+      first != NULL && first->object_id < object_id;
+      first = prev->next) {
+    prev = first->object_last;
+  }
+  return prev;
+}
+/*---------------------------------------------------------------------------*/
 int
 lwm2m_engine_add_object(lwm2m_object_instance_t *object)
 {
-  lwm2m_object_instance_t *instance;
-  uint16_t min_id = 0xffff;
-  uint16_t max_id = 0;
-  int found = 0;
+  lwm2m_object_instance_t *first;
+  lwm2m_object_instance_t **bucket;
 
   if(object == NULL || object->callback == NULL) {
     /* Insufficient object configuration */
@@ -1234,38 +1564,52 @@ lwm2m_engine_add_object(lwm2m_object_instance_t *object)
     return 0;
   }
 
-  for(instance = list_head(object_list);
-      instance != NULL;
-      instance = instance->next) {
-    if(object->object_id == instance->object_id) {
-      if(object->instance_id == instance->instance_id) {
-        LOG_DBG("object with id %u/%u already registered\n",
-               instance->object_id, instance->instance_id);
-        return 0;
-      }
-
-      found++;
-      if(instance->instance_id > max_id) {
-        max_id = instance->instance_id;
-      }
-      if(instance->instance_id < min_id) {
-        min_id = instance->instance_id;
-      }
-    }
-  }
-
+  first = get_first_instance(object->object_id);
   if(object->instance_id == LWM2M_OBJECT_INSTANCE_NONE) {
     /* No instance id has been assigned yet */
-    if(found == 0) {
+    if(first == NULL) {
       /* First object with this id */
       object->instance_id = 0;
-    } else if(min_id > 0) {
-      object->instance_id = min_id - 1;
+    } else if(first->instance_id > 0) {
+      object->instance_id = first->instance_id - 1;
     } else {
-      object->instance_id = max_id + 1;
+      object->instance_id = first->object_last->instance_id + 1;
+    }
+  } else if(get_non_generic_instance(object->object_id,
+                                     object->instance_id) != NULL) {
+    LOG_DBG("object with id %u/%u already registered\n",
+            object->object_id, object->instance_id);
+    return 0;
+  }
+
+  list_insert(object_list,
+              find_insert_position(first, object->object_id,
+                                   object->instance_id),
+              object);
+
+  bucket = &instance_table[instance_hash(object->object_id, object->instance_id)];
+  object->table_next = *bucket;
+  *bucket = object;
+
+  if(first == NULL) {
+    /* First instance of the object in its index bucket */
+    bucket = &first_instance_table[object_hash(object->object_id)];
+    object->object_table_next = *bucket;
+    object->object_last = object;
+    *bucket = object;
+  } else if(first->instance_id > object->instance_id) {
+    /* Replace the first instance of the object in its index bucket */
+    bucket = &first_instance_table[object_hash(object->object_id)];
+    while(*bucket != first) {
+      bucket = &(*bucket)->object_table_next;
     }
+    object->object_table_next = first->object_table_next;
+    object->object_last = first->object_last;
+    *bucket = object;
+  } else if(first->object_last->instance_id < object->instance_id) {
+    first->object_last = object;
   }
-  list_add(object_list, object);
+
 #if USE_RD_CLIENT
   lwm2m_rd_client_set_update_rd();
 #endif
@@ -1275,6 +1619,41 @@ lwm2m_engine_add_object(lwm2m_object_instance_t *object)
 void
 lwm2m_engine_remove_object(lwm2m_object_instance_t *object)
 {
+  lwm2m_object_instance_t **bucket;
+  lwm2m_object_instance_t *first;
+  lwm2m_object_instance_t *next;
+  lwm2m_object_instance_t *prev;
+
+  bucket = &instance_table[instance_hash(object->object_id, object->instance_id)];
+  while(*bucket != NULL && *bucket != object) {
+    bucket = &(*bucket)->table_next;
+  }
+  if(*bucket == NULL) {
+    /* Not registered */
+    return;
+  }
+  *bucket = object->table_next;
+
+  bucket = &first_instance_table[object_hash(object->object_id)];
+  while((*bucket)->object_id != object->object_id) {
+    bucket = &(*bucket)->object_table_next;
+  }
+  first = *bucket;
+  if(first == object) {
+    /* The next instance of the object, if any, becomes its first instance */
+    next = object->next;
+    if(object->object_last != object) {
+      next->object_table_next = object->object_table_next;
+      next->object_last = object->object_last;
+      *bucket = next;
+    } else {
+      *bucket = object->object_table_next;
+    }
+  } else if(first->object_last == object) {
+    for(prev = first; prev->next != object; prev = prev->next);
+    first->object_last = prev;
+  }
+
   list_remove(object_list, object);
 #if USE_RD_CLIENT
   lwm2m_rd_client_set_update_rd();
@@ -1284,6 +1663,10 @@ lwm2m_engine_remove_object(lwm2m_object_instance_t *object)
 int
 lwm2m_engine_add_generic_object(lwm2m_object_t *object)
 {
+  lwm2m_object_t *prev;
+  lwm2m_object_t **bucket;
+  uint16_t object_id;
+
   if(object == NULL || object->impl == NULL
      || object->impl->get_first == NULL
      || object->impl->get_next == NULL
@@ -1291,19 +1674,31 @@ lwm2m_engine_add_generic_object(lwm2m_object_t *object)
     LOG_WARN("failed to register NULL object\n");
     return 0;
   }
-  if(get_object(object->impl->object_id) != NULL) {
+  object_id = object->impl->object_id;
+  if(get_object(object_id) != NULL) {
     /* A generic object with this id has already been registered */
-    LOG_WARN("object with id %u already registered\n",
-             object->impl->object_id);
+    LOG_WARN("object with id %u already registered\n", object_id);
     return 0;
   }
-  if(has_non_generic_object(object->impl->object_id)) {
+  if(has_non_generic_object(object_id)) {
     /* An object with this id has already been registered */
-    LOG_WARN("object with id %u already registered\n",
-             object->impl->object_id);
+    LOG_WARN("object with id %u already registered\n", object_id);
     return 0;
   }
-  list_add(generic_object_list, object);
+
+  prev = list_head(generic_object_list);
+  if(prev != NULL && prev->impl->object_id > object_id) {
+    prev = NULL;
+  }
+  while(prev != NULL && prev->next != NULL &&
+        prev->next->impl->object_id < object_id) {
+    prev = prev->next;
+  }
+  list_insert(generic_object_list, prev, object);
+
+  bucket = &generic_object_table[object_hash(object_id)];
+  object->table_next = *bucket;
+  *bucket = object;
 
 #if USE_RD_CLIENT
   lwm2m_rd_client_set_update_rd();
@@ -1315,6 +1710,18 @@ lwm2m_engine_add_generic_object(lwm2m_object_t *object)
 void
 lwm2m_engine_remove_generic_object(lwm2m_object_t *object)
 {
+  lwm2m_object_t **bucket;
+
+  bucket = &generic_object_table[object_hash(object->impl->object_id)];
+  while(*bucket != NULL && *bucket != object) {
+    bucket = &(*bucket)->table_next;
+  }
+  if(*bucket == NULL) {
+    /* Not registered */
+    return;
+  }
+  *bucket = object->table_next;
+
   list_remove(generic_object_list, object);
 #if USE_RD_CLIENT
   lwm2m_rd_client_set_update_rd();
@@ -1336,17 +1743,47 @@ next_object_instance(const lwm2m_context_t *context, lwm2m_object_t *object,
   }
 
   if(object == NULL) {
-    for(last = last->next; last != NULL; last = last->next) {
-      /* if no context is given - this will just give the next object */
-      if(context == NULL || last->object_id == context->object_id) {
-        return last;
-      }
+    /* if no context is given - this will just give the next object */
+    last = last->next;
+    if(context != NULL && last != NULL &&
+       last->object_id != context->object_id) {
+      /* object_list is sorted, no more instances of this object */
+      return NULL;
     }
-    return NULL;
+    return last;
   }
   return object->impl->get_next(last, NULL);
 }
 /*---------------------------------------------------------------------------*/
+static void
+set_error_status(coap_message_t *response, lwm2m_status_t status)
+{
+  switch(status) {
+  case LWM2M_STATUS_BAD_REQUEST:
+    coap_set_status_code(response, BAD_REQUEST_4_00);
+    break;
+  case LWM2M_STATUS_FORBIDDEN:
+    coap_set_status_code(response, FORBIDDEN_4_03);
+    break;
+  case LWM2M_STATUS_NOT_FOUND:
+    coap_set_status_code(response, NOT_FOUND_4_04);
+    break;
+  case LWM2M_STATUS_OPERATION_NOT_ALLOWED:
+    coap_set_status_code(response, METHOD_NOT_ALLOWED_4_05);
+    break;
+  case LWM2M_STATUS_NOT_ACCEPTABLE:
+    coap_set_status_code(response, NOT_ACCEPTABLE_4_06);
+    break;
+  case LWM2M_STATUS_UNSUPPORTED_CONTENT_FORMAT:
+    coap_set_status_code(response, UNSUPPORTED_MEDIA_TYPE_4_15);
+    break;
+  default:
+    /* Failed to handle the request */
+    coap_set_status_code(response, INTERNAL_SERVER_ERROR_5_00);
+    break;
+  }
+}
+/*---------------------------------------------------------------------------*/
 static coap_handler_status_t
 lwm2m_handler_callback(coap_message_t *request, coap_message_t *response,
                        uint8_t *buffer, uint16_t buffer_size, int32_t *offset)
@@ -1359,6 +1796,9 @@ lwm2m_handler_callback(coap_message_t *request, coap_message_t *response,
   lwm2m_context_t context;
   lwm2m_object_t *object;
   lwm2m_object_instance_t *instance;
+  const char *query;
+  int query_len;
+  uint32_t observe;
   uint32_t bnum;
   uint8_t bmore;
   uint16_t bsize;
@@ -1371,6 +1811,8 @@ lwm2m_handler_callback(coap_message_t *request, coap_message_t *response,
   memset(&context, 0, sizeof(context));
   memset(&outbuf, 0, sizeof(outbuf));
   memset(&inbuf, 0, sizeof(inbuf));
+  query = NULL;
+  query_len = 0;
 
   context.outbuf = &outbuf;
   context.inbuf = &inbuf;
@@ -1446,14 +1888,37 @@ lwm2m_queue_mode_request_received();
   }
   if(!coap_get_header_accept(request, &accept)) {
     if(format == TEXT_PLAIN && depth < 3) {
-      LOG_DBG("No Accept header, assume JSON\n");
-      accept = LWM2M_JSON;
+      LOG_DBG("No Accept header, using %u\n", MULTI_READ_FORMAT);
+      accept = MULTI_READ_FORMAT;
     } else {
       LOG_DBG("No Accept header, using same as content-format: %d\n", format);
       accept = format;
     }
   }
 
+  if(request->code == COAP_FETCH && url_len == 0) {
+    /* Read-Composite, the paths are in the payload */
+    if(format != LWM2M_SENML_CBOR) {
+      success = LWM2M_STATUS_UNSUPPORTED_CONTENT_FORMAT;
+    } else if(accept != LWM2M_SENML_CBOR) {
+      success = LWM2M_STATUS_NOT_ACCEPTABLE;
+    } else {
+      success = perform_composite_read_op(&context);
+    }
+    if(success == LWM2M_STATUS_OK) {
+      coap_set_status_code(response, CONTENT_2_05);
+      coap_set_header_content_format(response, LWM2M_SENML_CBOR);
+      coap_set_payload(response, context.outbuf->buffer, context.outbuf->len);
+      if(offset != NULL) {
+        *offset = -1;
+      }
+    } else {
+      LOG_WARN("Read-Composite failed: %s\n", get_status_as_string(success));
+      set_error_status(response, success);
+    }
+    return COAP_HANDLER_STATUS_PROCESSED;
+  }
+
   /*
    * 1 => Object only
    * 2 => Object and Instance
@@ -1507,7 +1972,12 @@ lwm2m_queue_mode_request_received();
   switch(coap_get_method_type(request)) {
   case METHOD_PUT:
     /* can also be write atts */
-    context.operation = LWM2M_OP_WRITE;
+    query_len = coap_get_header_uri_query(request, &query);
+    if(query_len > 0 && context.inbuf->size == 0) {
+      context.operation = LWM2M_OP_WRITE_ATTR;
+    } else {
+      context.operation = LWM2M_OP_WRITE;
+    }
     coap_set_status_code(response, CHANGED_2_04);
     break;
   case METHOD_POST:
@@ -1570,11 +2040,38 @@ lwm2m_queue_mode_request_received();
     success = perform_multi_resource_read_op(object, instance, &context);
     break;
   case LWM2M_OP_READ:
+#if LWM2M_QUEUE_MODE_ENABLED && LWM2M_QUEUE_MODE_PERSISTENT_NOTIFICATIONS
+    if(context.level == 3 &&
+       lwm2m_notification_queue_is_replaying(context.object_id,
+                                             context.object_instance_id,
+                                             context.resource_id)) {
+      /* A notification of the values stored while sleeping */
+      success = lwm2m_notification_queue_write_stored(&context);
+      break;
+    }
+#endif
     success = perform_multi_resource_read_op(object, instance, &context);
+    if(success == LWM2M_STATUS_OK &&
+       coap_get_header_observe(request, &observe) && observe == 0) {
+      lwm2m_notification_attributes_observed(context.object_id,
+                                             context.level >= 2 ?
+                                             context.object_instance_id :
+                                             LWM2M_OBJECT_INSTANCE_NONE,
+                                             context.level >= 3 ?
+                                             context.resource_id :
+                                             LWM2M_OBJECT_RESOURCE_NONE);
+#if LWM2M_QUEUE_MODE_ENABLED && LWM2M_QUEUE_MODE_PERSISTENT_NOTIFICATIONS
+      /* Values stored for the path, e.g. before a reboot */
+      lwm2m_notification_queue_observed();
+#endif
+    }
     break;
   case LWM2M_OP_WRITE:
     success = perform_multi_resource_write_op(object, instance, &context, format);
     break;
+  case LWM2M_OP_WRITE_ATTR:
+    success = lwm2m_notification_attributes_write(&context, query, query_len);
+    break;
   case LWM2M_OP_EXECUTE:
     success = call_instance(instance, &context);
     break;
@@ -1625,27 +2122,7 @@ lwm2m_queue_mode_request_received();
       LOG_DBG_("] no data in reply\n");
     }
   } else {
-    switch(success) {
-    case LWM2M_STATUS_FORBIDDEN:
-      coap_set_status_code(response, FORBIDDEN_4_03);
-      break;
-    case LWM2M_STATUS_NOT_FOUND:
-      coap_set_status_code(response, NOT_FOUND_4_04);
-      break;
-    case LWM2M_STATUS_OPERATION_NOT_ALLOWED:
-      coap_set_status_code(response, METHOD_NOT_ALLOWED_4_05);
-      break;
-    case LWM2M_STATUS_NOT_ACCEPTABLE:
-      coap_set_status_code(response, NOT_ACCEPTABLE_4_06);
-      break;
-    case LWM2M_STATUS_UNSUPPORTED_CONTENT_FORMAT:
-      coap_set_status_code(response, UNSUPPORTED_MEDIA_TYPE_4_15);
-      break;
-    default:
-      /* Failed to handle the request */
-      coap_set_status_code(response, INTERNAL_SERVER_ERROR_5_00);
-      break;
-    }
+    set_error_status(response, success);
     LOG_WARN("[");
     LOG_WARN_COAP_STRING(url, url_len);
     LOG_WARN("] resource failed: %s\n", get_status_as_string(success));
@@ -1654,31 +2131,42 @@ lwm2m_queue_mode_request_received();
 }
 /*---------------------------------------------------------------------------*/
 static void
-lwm2m_send_notification(char* path)
+lwm2m_send_notification(char* path, int exact)
 {
 #if LWM2M_QUEUE_MODE_ENABLED && LWM2M_QUEUE_MODE_INCLUDE_DYNAMIC_ADAPTATION
     if(lwm2m_queue_mode_get_dynamic_adaptation_flag()) {
       lwm2m_queue_mode_set_handler_from_notification();
     } 
 #endif
-  coap_notify_observers_sub(NULL, path);
+  if(exact) {
+    /* not the observers of the resources of an instance or object */
+    coap_notify_observers_exact(path);
+  } else {
+    coap_notify_observers_sub(NULL, path);
+  }
 }
 /*---------------------------------------------------------------------------*/
-void 
-lwm2m_notify_object_observers(lwm2m_object_instance_t *obj,
-                                   uint16_t resource)
+void
+lwm2m_notify_path_observers(uint16_t object_id, uint16_t instance_id,
+                            uint16_t resource_id)
 {
   char path[20]; /* 60000/60000/60000 */
-  if(obj != NULL) {
-    snprintf(path, 20, "%d/%d/%d", obj->object_id, obj->instance_id, resource);
+  int exact = resource_id == LWM2M_OBJECT_RESOURCE_NONE;
+
+  if(instance_id == LWM2M_OBJECT_INSTANCE_NONE) {
+    snprintf(path, 20, "%d", object_id);
+  } else if(exact) {
+    snprintf(path, 20, "%d/%d", object_id, instance_id);
+  } else {
+    snprintf(path, 20, "%d/%d/%d", object_id, instance_id, resource_id);
   }
 
 #if LWM2M_QUEUE_MODE_ENABLED
   
-  if(coap_has_observers(path)) {
+  if(exact ? coap_has_observers_exact(path) : coap_has_observers(path)) {
     /* Client is sleeping -> add the notification to the list */
     if(!lwm2m_rd_client_is_client_awake()) {
-      lwm2m_notification_queue_add_notification_path(obj->object_id, obj->instance_id, resource);
+      lwm2m_notification_queue_add_notification_path(object_id, instance_id, resource_id);
 
       /* if it is the first notification -> wake up and send update */
       if(!lwm2m_queue_mode_is_waked_up_by_notification()) {
@@ -1687,12 +2175,38 @@ lwm2m_notify_object_observers(lwm2m_object_instance_t *obj,
       }
     /* Client is awake -> send the notification */  
     } else {
-      lwm2m_send_notification(path);
+      lwm2m_send_notification(path, exact);
     }
   }
 #else 
-  lwm2m_send_notification(path);
+  lwm2m_send_notification(path, exact);
 #endif
 }
 /*---------------------------------------------------------------------------*/
+void
+lwm2m_notify_object_observers(lwm2m_object_instance_t *obj,
+                              uint16_t resource)
+{
+  if(obj == NULL) {
+    return;
+  }
+  /* pmin, gt, lt and st might leave out or defer the notification */
+  if(lwm2m_notification_attributes_changed(obj->object_id, obj->instance_id,
+                                           resource)) {
+    lwm2m_notify_path_observers(obj->object_id, obj->instance_id, resource);
+  }
+  /* The instance and object changed as well, for their own observers */
+  if(lwm2m_notification_attributes_changed(obj->object_id, obj->instance_id,
+                                           LWM2M_OBJECT_RESOURCE_NONE)) {
+    lwm2m_notify_path_observers(obj->object_id, obj->instance_id,
+                                LWM2M_OBJECT_RESOURCE_NONE);
+  }
+  if(lwm2m_notification_attributes_changed(obj->object_id,
+                                           LWM2M_OBJECT_INSTANCE_NONE,
+                                           LWM2M_OBJECT_RESOURCE_NONE)) {
+    lwm2m_notify_path_observers(obj->object_id, LWM2M_OBJECT_INSTANCE_NONE,
+                                LWM2M_OBJECT_RESOURCE_NONE);
+  }
+}
+/*---------------------------------------------------------------------------*/
 /** @} */
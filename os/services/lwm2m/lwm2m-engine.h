@@ -58,7 +58,8 @@ typedef enum {
   LWM2M_JSON       = 11543,
   LWM2M_OLD_TLV    = 1542,
   LWM2M_OLD_JSON   = 1543,
-  LWM2M_OLD_OPAQUE  = 1544
+  LWM2M_OLD_OPAQUE  = 1544,
+  LWM2M_SENML_CBOR = 112
 } lwm2m_content_format_t;
 
 void lwm2m_engine_init(void);
@@ -73,6 +74,7 @@ typedef int
                                   uint16_t resource_id);
 
 #define LWM2M_OBJECT_INSTANCE_NONE 0xffff
+#define LWM2M_OBJECT_RESOURCE_NONE 0xffff
 
 struct lwm2m_object_instance {
   lwm2m_object_instance_t *next;
@@ -84,6 +86,12 @@ struct lwm2m_object_instance {
   /* the callback for requests */
   lwm2m_object_instance_callback_t callback;
   lwm2m_resource_dim_callback_t resource_dim_callback;
+  /* managed by the engine: next instance in the same index bucket,
+     next first instance of an object in the same object index bucket
+     and, in the first instance of an object, its last instance */
+  lwm2m_object_instance_t *table_next;
+  lwm2m_object_instance_t *object_table_next;
+  lwm2m_object_instance_t *object_last;
 };
 
 typedef struct {
@@ -102,17 +110,41 @@ typedef struct lwm2m_object lwm2m_object_t;
 struct lwm2m_object {
   lwm2m_object_t *next;
   const lwm2m_object_impl_t *impl;
+  lwm2m_object_t *table_next; /* managed by the engine */
 };
 
 lwm2m_object_instance_t *lwm2m_engine_get_instance_buffer(void);
 
 int  lwm2m_engine_has_instance(uint16_t object_id, uint16_t instance_id);
+lwm2m_object_instance_t *lwm2m_engine_get_instance(uint16_t object_id,
+                                                   uint16_t instance_id);
+/* A path of a composite operation */
+typedef struct {
+  uint16_t object_id;
+  uint16_t instance_id;
+  uint16_t resource_id;
+  uint8_t level; /* 1: object, 2: object instance, 3: resource */
+} lwm2m_path_t;
+
+/*
+ * Writes the readable resources of the paths into buffer as one SenML-CBOR
+ * pack, leaving out paths that do not exist. Returns the length of the
+ * pack, or -1 if it does not fit or a read fails.
+ */
+int lwm2m_engine_write_composite(const lwm2m_path_t *paths, int count,
+                                 uint8_t *buffer, uint16_t size);
+
 int  lwm2m_engine_add_object(lwm2m_object_instance_t *object);
 void lwm2m_engine_remove_object(lwm2m_object_instance_t *object);
 int  lwm2m_engine_add_generic_object(lwm2m_object_t *object);
 void lwm2m_engine_remove_generic_object(lwm2m_object_t *object);
 void lwm2m_notify_object_observers(lwm2m_object_instance_t *obj,
                                    uint16_t resource);
+/* Notifies the observers of a resource regardless of its attributes, or
+   those of an instance or object with LWM2M_OBJECT_RESOURCE_NONE and
+   LWM2M_OBJECT_INSTANCE_NONE */
+void lwm2m_notify_path_observers(uint16_t object_id, uint16_t instance_id,
+                                 uint16_t resource_id);
 
 void lwm2m_engine_set_opaque_callback(lwm2m_context_t *ctx, lwm2m_write_opaque_callback cb);
 
@@ -0,0 +1,767 @@
+/*
+ * Copyright (c) 2026, Contiki-NG contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \addtogroup lwm2m
+ * @{
+ */
+
+/**
+ * \file
+ *         Implementation of the Contiki OMA LWM2M notification attributes
+ *         (pmin, pmax, gt, lt and st, OMA LwM2M 1.0, Section 5.1.2).
+ *         Changes inside the pmin period of an observed object, instance
+ *         or resource are coalesced into one notification when the period
+ *         ends, and one timer runs for the earliest pmin or pmax deadline
+ *         of all observed paths.
+ */
+
+#include "lwm2m-engine.h"
+#include "lwm2m-notification-attributes.h"
+#include "lwm2m-plain-text.h"
+#include "coap-observe.h"
+#include "coap-timer.h"
+#include "lib/memb.h"
+#include "lib/list.h"
+#include <stdio.h>
+#include <string.h>
+
+/* Log configuration */
+#include "coap-log.h"
+#define LOG_MODULE "lwm2m-attr"
+#define LOG_LEVEL  LOG_LEVEL_LWM2M
+
+/* Number of objects, instances and resources that can have attributes */
+#ifdef LWM2M_NOTIFICATION_ATTRIBUTES_CONF_ENTRIES
+#define ATTRIBUTES_ENTRIES LWM2M_NOTIFICATION_ATTRIBUTES_CONF_ENTRIES
+#else
+#define ATTRIBUTES_ENTRIES 4
+#endif /* LWM2M_NOTIFICATION_ATTRIBUTES_CONF_ENTRIES */
+
+/* Number of observed paths with attributes in effect. Notifications of
+   further paths are sent on every change. */
+#ifdef LWM2M_NOTIFICATION_ATTRIBUTES_CONF_STATES
+#define ATTRIBUTES_STATES LWM2M_NOTIFICATION_ATTRIBUTES_CONF_STATES
+#else
+#define ATTRIBUTES_STATES COAP_MAX_OBSERVERS
+#endif /* LWM2M_NOTIFICATION_ATTRIBUTES_CONF_STATES */
+
+#define ATTR_PMIN 0x01
+#define ATTR_PMAX 0x02
+#define ATTR_GT   0x04
+#define ATTR_LT   0x08
+#define ATTR_ST   0x10
+#define ATTR_VALUE_CONDITIONS (ATTR_GT | ATTR_LT | ATTR_ST)
+
+#define STATE_NOTIFIED  0x01
+#define STATE_PENDING   0x02
+#define STATE_HAS_VALUE 0x04
+
+#define NO_RESOURCE LWM2M_OBJECT_RESOURCE_NONE
+
+typedef struct attributes {
+  struct attributes *next;
+  uint16_t object_id;
+  uint16_t instance_id; /* LWM2M_OBJECT_INSTANCE_NONE for an object */
+  uint16_t resource_id; /* NO_RESOURCE for an object or instance */
+  uint8_t flags;
+  uint32_t pmin; /* seconds */
+  uint32_t pmax;
+  int32_t gt; /* fixed point with LWM2M_FLOAT32_BITS */
+  int32_t lt;
+  int32_t st;
+} attributes_t;
+
+typedef struct notification_state {
+  struct notification_state *next;
+  uint16_t object_id;
+  uint16_t instance_id; /* LWM2M_OBJECT_INSTANCE_NONE for an object */
+  uint16_t resource_id; /* NO_RESOURCE for an object or instance */
+  uint8_t flags;
+  uint64_t last_time; /* of the last notification */
+  int64_t last_value;
+} notification_state_t;
+
+MEMB(attributes_memb, attributes_t, ATTRIBUTES_ENTRIES);
+LIST(attributes_list);
+MEMB(state_memb, notification_state_t, ATTRIBUTES_STATES);
+LIST(state_list);
+
+static coap_timer_t notification_timer;
+
+/* Value captured by reading a resource through value_writer */
+static int32_t read_value;
+static int read_bits;
+static uint8_t has_read_value;
+/*---------------------------------------------------------------------------*/
+static size_t
+capture_none(lwm2m_context_t *ctx)
+{
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+capture_float32fix(lwm2m_context_t *ctx, uint8_t *outbuf, size_t outlen,
+                   int32_t value, int bits)
+{
+  /* Multiple resource instances: keep the first */
+  if(!has_read_value) {
+    read_value = value;
+    read_bits = bits;
+    has_read_value = 1;
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+capture_int(lwm2m_context_t *ctx, uint8_t *outbuf, size_t outlen,
+            int32_t value)
+{
+  return capture_float32fix(ctx, outbuf, outlen, value, 0);
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+capture_boolean(lwm2m_context_t *ctx, uint8_t *outbuf, size_t outlen,
+                int value)
+{
+  return capture_float32fix(ctx, outbuf, outlen, value != 0, 0);
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+capture_string(lwm2m_context_t *ctx, uint8_t *outbuf, size_t outlen,
+               const char *value, size_t strlen)
+{
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+capture_opaque_header(lwm2m_context_t *ctx, size_t total_size)
+{
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static const lwm2m_writer_t value_writer = {
+  capture_none,
+  capture_none,
+  capture_none,
+  capture_none,
+  capture_int,
+  capture_string,
+  capture_float32fix,
+  capture_boolean,
+  capture_opaque_header
+};
+/*---------------------------------------------------------------------------*/
+/*
+ * Reads the numeric value of a resource, in fixed point with
+ * LWM2M_FLOAT32_BITS. Returns 0 if the resource has no numeric value.
+ */
+static int
+get_value(uint16_t object_id, uint16_t instance_id, uint16_t resource_id,
+          int64_t *value)
+{
+  lwm2m_object_instance_t *instance;
+  lwm2m_context_t ctx;
+  lwm2m_buffer_t buffer;
+  uint8_t data[8];
+
+  instance = lwm2m_engine_get_instance(object_id, instance_id);
+  if(instance == NULL || instance->callback == NULL) {
+    return 0;
+  }
+
+  memset(&ctx, 0, sizeof(ctx));
+  buffer.buffer = data;
+  buffer.size = sizeof(data);
+  buffer.len = 0;
+  buffer.pos = 0;
+  ctx.object_id = object_id;
+  ctx.object_instance_id = instance_id;
+  ctx.resource_id = resource_id;
+  ctx.level = 3;
+  ctx.operation = LWM2M_OP_READ;
+  ctx.outbuf = &buffer;
+  ctx.inbuf = &buffer;
+  ctx.writer = &value_writer;
+
+  has_read_value = 0;
+  if(instance->callback(instance, &ctx) != LWM2M_STATUS_OK ||
+     !has_read_value) {
+    return 0;
+  }
+
+  *value = read_value;
+  if(read_bits < LWM2M_FLOAT32_BITS) {
+    *value *= 1L << (LWM2M_FLOAT32_BITS - read_bits);
+  } else {
+    *value /= 1L << (read_bits - LWM2M_FLOAT32_BITS);
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static int
+format_path(char *path, size_t size, uint16_t object_id,
+            uint16_t instance_id, uint16_t resource_id)
+{
+  if(instance_id == LWM2M_OBJECT_INSTANCE_NONE) {
+    return snprintf(path, size, "%u", object_id);
+  }
+  if(resource_id == NO_RESOURCE) {
+    return snprintf(path, size, "%u/%u", object_id, instance_id);
+  }
+  return snprintf(path, size, "%u/%u/%u", object_id, instance_id,
+                  resource_id);
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Returns 1 if the object, instance or resource is observed. Observers of
+ * the resources of an instance or object do not count for it.
+ */
+static int
+has_observers(uint16_t object_id, uint16_t instance_id,
+              uint16_t resource_id)
+{
+  char path[20];
+
+  format_path(path, sizeof(path), object_id, instance_id, resource_id);
+  if(resource_id == NO_RESOURCE) {
+    return coap_has_observers_exact(path);
+  }
+  return coap_has_observers(path);
+}
+/*---------------------------------------------------------------------------*/
+static attributes_t *
+find_attributes(uint16_t object_id, uint16_t instance_id,
+                uint16_t resource_id)
+{
+  attributes_t *a;
+  for(a = list_head(attributes_list); a != NULL; a = a->next) {
+    if(a->object_id == object_id && a->instance_id == instance_id &&
+       a->resource_id == resource_id) {
+      return a;
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static void
+merge_attributes(attributes_t *attr, const attributes_t *a)
+{
+  if(a == NULL) {
+    return;
+  }
+  if(a->flags & ATTR_PMIN) {
+    attr->pmin = a->pmin;
+  }
+  if(a->flags & ATTR_PMAX) {
+    attr->pmax = a->pmax;
+  }
+  if(a->flags & ATTR_GT) {
+    attr->gt = a->gt;
+  }
+  if(a->flags & ATTR_LT) {
+    attr->lt = a->lt;
+  }
+  if(a->flags & ATTR_ST) {
+    attr->st = a->st;
+  }
+  attr->flags |= a->flags;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Gets the attributes in effect for an object, instance or resource: those
+ * set on a resource take precedence over those of its instance, which take
+ * precedence over those of its object.
+ */
+static void
+get_attributes(uint16_t object_id, uint16_t instance_id,
+               uint16_t resource_id, attributes_t *attr)
+{
+  memset(attr, 0, sizeof(attributes_t));
+  if(list_head(attributes_list) == NULL) {
+    return;
+  }
+  merge_attributes(attr, find_attributes(object_id,
+                                         LWM2M_OBJECT_INSTANCE_NONE,
+                                         NO_RESOURCE));
+  merge_attributes(attr, find_attributes(object_id, instance_id,
+                                         NO_RESOURCE));
+  merge_attributes(attr, find_attributes(object_id, instance_id,
+                                         resource_id));
+}
+/*---------------------------------------------------------------------------*/
+static notification_state_t *
+find_state(uint16_t object_id, uint16_t instance_id, uint16_t resource_id)
+{
+  notification_state_t *state;
+  for(state = list_head(state_list); state != NULL; state = state->next) {
+    if(state->object_id == object_id && state->instance_id == instance_id &&
+       state->resource_id == resource_id) {
+      return state;
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static notification_state_t *
+get_state(uint16_t object_id, uint16_t instance_id, uint16_t resource_id)
+{
+  notification_state_t *state;
+
+  state = find_state(object_id, instance_id, resource_id);
+  if(state == NULL) {
+    state = memb_alloc(&state_memb);
+    if(state == NULL) {
+      LOG_DBG("No state for %u/%u/%u\n", object_id, instance_id,
+              resource_id);
+      return NULL;
+    }
+    state->object_id = object_id;
+    state->instance_id = instance_id;
+    state->resource_id = resource_id;
+    state->flags = 0;
+    list_add(state_list, state);
+  }
+  return state;
+}
+/*---------------------------------------------------------------------------*/
+static void
+remove_state(notification_state_t *state)
+{
+  list_remove(state_list, state);
+  memb_free(&state_memb, state);
+}
+/*---------------------------------------------------------------------------*/
+static void
+schedule(void)
+{
+  notification_state_t *state;
+  attributes_t attr;
+  uint64_t next = 0;
+  uint64_t deadline;
+  uint64_t now;
+
+  for(state = list_head(state_list); state != NULL; state = state->next) {
+    if(!(state->flags & STATE_NOTIFIED)) {
+      continue;
+    }
+    get_attributes(state->object_id, state->instance_id, state->resource_id,
+                   &attr);
+    if(state->flags & STATE_PENDING) {
+      deadline = state->last_time + (uint64_t)attr.pmin * 1000;
+      if(next == 0 || deadline < next) {
+        next = deadline;
+      }
+    }
+    if(attr.flags & ATTR_PMAX) {
+      deadline = state->last_time + (uint64_t)attr.pmax * 1000;
+      if(next == 0 || deadline < next) {
+        next = deadline;
+      }
+    }
+  }
+
+  if(next == 0) {
+    coap_timer_stop(&notification_timer);
+    return;
+  }
+  now = coap_timer_uptime();
+  coap_timer_set(&notification_timer, next > now ? next - now : 0);
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Checks the gt, lt and st conditions of a resource against the value of
+ * its last notification, and takes the current value if they are met or
+ * the notification is sent anyway.
+ */
+static int
+check_value(notification_state_t *state, const attributes_t *attr, int force)
+{
+  int64_t value;
+  int64_t diff;
+  int met;
+
+  if(!(attr->flags & ATTR_VALUE_CONDITIONS)) {
+    return 1;
+  }
+  if(!get_value(state->object_id, state->instance_id, state->resource_id,
+                &value)) {
+    /* Not a numeric resource */
+    return 1;
+  }
+
+  met = force || !(state->flags & STATE_HAS_VALUE);
+  if(!met && (attr->flags & ATTR_GT)) {
+    met = (state->last_value <= attr->gt) != (value <= attr->gt);
+  }
+  if(!met && (attr->flags & ATTR_LT)) {
+    met = (state->last_value < attr->lt) != (value < attr->lt);
+  }
+  if(!met && (attr->flags & ATTR_ST)) {
+    diff = value - state->last_value;
+    met = (diff < 0 ? -diff : diff) >= attr->st;
+  }
+  if(met) {
+    state->last_value = value;
+    state->flags |= STATE_HAS_VALUE;
+  }
+  return met;
+}
+/*---------------------------------------------------------------------------*/
+static void
+set_notified(notification_state_t *state)
+{
+  state->last_time = coap_timer_uptime();
+  state->flags = (state->flags & ~STATE_PENDING) | STATE_NOTIFIED;
+}
+/*---------------------------------------------------------------------------*/
+static void
+notification_timer_callback(coap_timer_t *timer)
+{
+  notification_state_t *state;
+  notification_state_t *next;
+  attributes_t attr;
+  char path[20];
+  uint64_t now;
+  int notify;
+
+  now = coap_timer_uptime();
+  for(state = list_head(state_list); state != NULL; state = next) {
+    next = state->next;
+
+    format_path(path, sizeof(path), state->object_id, state->instance_id,
+                state->resource_id);
+    get_attributes(state->object_id, state->instance_id, state->resource_id,
+                   &attr);
+    if(attr.flags == 0 ||
+       !has_observers(state->object_id, state->instance_id,
+                      state->resource_id)) {
+      remove_state(state);
+      continue;
+    }
+
+    notify = 0;
+    if((state->flags & STATE_PENDING) &&
+       now - state->last_time >= (uint64_t)attr.pmin * 1000) {
+      /* The changes during the pmin period */
+      state->flags &= ~STATE_PENDING;
+      notify = check_value(state, &attr, 0);
+    }
+    if(!notify && (attr.flags & ATTR_PMAX) &&
+       now - state->last_time >= (uint64_t)attr.pmax * 1000) {
+      notify = check_value(state, &attr, 1);
+    }
+    if(notify) {
+      LOG_DBG("Notifying %s\n", path);
+      set_notified(state);
+      lwm2m_notify_path_observers(state->object_id, state->instance_id,
+                                  state->resource_id);
+    }
+  }
+  schedule();
+}
+/*---------------------------------------------------------------------------*/
+int
+lwm2m_notification_attributes_changed(uint16_t object_id,
+                                      uint16_t instance_id,
+                                      uint16_t resource_id)
+{
+  notification_state_t *state;
+  attributes_t attr;
+
+  get_attributes(object_id, instance_id, resource_id, &attr);
+  if(attr.flags == 0) {
+    return 1;
+  }
+  if(!has_observers(object_id, instance_id, resource_id)) {
+    return 1;
+  }
+  state = get_state(object_id, instance_id, resource_id);
+  if(state == NULL) {
+    return 1;
+  }
+
+  if((state->flags & STATE_NOTIFIED) && (attr.flags & ATTR_PMIN) &&
+     coap_timer_uptime() - state->last_time < (uint64_t)attr.pmin * 1000) {
+    /* Sent when the pmin period ends, along with further changes */
+    if(!(state->flags & STATE_PENDING)) {
+      state->flags |= STATE_PENDING;
+      schedule();
+    }
+    return 0;
+  }
+
+  if(!check_value(state, &attr, 0)) {
+    return 0;
+  }
+  set_notified(state);
+  schedule();
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+void
+lwm2m_notification_attributes_observed(uint16_t object_id,
+                                       uint16_t instance_id,
+                                       uint16_t resource_id)
+{
+  notification_state_t *state;
+  attributes_t attr;
+
+  get_attributes(object_id, instance_id, resource_id, &attr);
+  if(attr.flags == 0) {
+    return;
+  }
+  state = get_state(object_id, instance_id, resource_id);
+  if(state == NULL) {
+    return;
+  }
+  /* The response to the observe request is the first notification */
+  check_value(state, &attr, 1);
+  set_notified(state);
+  schedule();
+}
+/*---------------------------------------------------------------------------*/
+static int
+parse_value(const char *value, int len, int fixed, int32_t *result)
+{
+  if(len <= 0) {
+    return 0;
+  }
+  if(fixed) {
+    return lwm2m_plain_text_read_float32fix((const uint8_t *)value, len,
+                                            result, LWM2M_FLOAT32_BITS) == len;
+  }
+  return value[0] != '-' &&
+    lwm2m_plain_text_read_int((const uint8_t *)value, len, result) == len;
+}
+/*---------------------------------------------------------------------------*/
+lwm2m_status_t
+lwm2m_notification_attributes_write(const lwm2m_context_t *ctx,
+                                    const char *query, int query_len)
+{
+  attributes_t *a;
+  attributes_t attr;
+  notification_state_t *state;
+  const char *name;
+  const char *value;
+  const char *end;
+  int name_len;
+  int value_len;
+  int32_t v;
+  uint8_t flag;
+
+  memset(&attr, 0, sizeof(attr));
+  attr.object_id = ctx->object_id;
+  attr.instance_id = ctx->level >= 2 ? ctx->object_instance_id :
+    LWM2M_OBJECT_INSTANCE_NONE;
+  attr.resource_id = ctx->level >= 3 ? ctx->resource_id : NO_RESOURCE;
+
+  a = find_attributes(attr.object_id, attr.instance_id, attr.resource_id);
+  if(a != NULL) {
+    memcpy(&attr, a, sizeof(attr));
+  }
+
+  /* pmin=10&pmax=60&st=0.5 - an attribute without value is removed */
+  name = query;
+  end = query + query_len;
+  while(name < end) {
+    for(name_len = 0; name + name_len < end && name[name_len] != '&' &&
+          name[name_len] != '='; name_len++);
+    value = name + name_len;
+    value_len = 0;
+    if(value < end && *value == '=') {
+      value++;
+      for(; value + value_len < end && value[value_len] != '&'; value_len++);
+    }
+
+    if(name_len == 4 && strncmp(name, "pmin", 4) == 0) {
+      flag = ATTR_PMIN;
+    } else if(name_len == 4 && strncmp(name, "pmax", 4) == 0) {
+      flag = ATTR_PMAX;
+    } else if(name_len == 2 && strncmp(name, "gt", 2) == 0) {
+      flag = ATTR_GT;
+    } else if(name_len == 2 && strncmp(name, "lt", 2) == 0) {
+      flag = ATTR_LT;
+    } else if(name_len == 2 && strncmp(name, "st", 2) == 0) {
+      flag = ATTR_ST;
+    } else {
+      LOG_DBG("Unsupported attribute %.*s\n", name_len, name);
+      return LWM2M_STATUS_BAD_REQUEST;
+    }
+
+    if(value == name + name_len) {
+      attr.flags &= ~flag;
+    } else if(!parse_value(value, value_len,
+                           (flag & ATTR_VALUE_CONDITIONS) != 0, &v)) {
+      return LWM2M_STATUS_BAD_REQUEST;
+    } else {
+      attr.flags |= flag;
+      switch(flag) {
+      case ATTR_PMIN:
+        attr.pmin = v;
+        break;
+      case ATTR_PMAX:
+        attr.pmax = v;
+        break;
+      case ATTR_GT:
+        attr.gt = v;
+        break;
+      case ATTR_LT:
+        attr.lt = v;
+        break;
+      default:
+        attr.st = v;
+        break;
+      }
+    }
+    name = value + value_len + 1;
+  }
+
+  /* Numeric attributes only apply to resources */
+  if(attr.resource_id == NO_RESOURCE && (attr.flags & ATTR_VALUE_CONDITIONS)) {
+    return LWM2M_STATUS_BAD_REQUEST;
+  }
+  if((attr.flags & ATTR_ST) && attr.st < 0) {
+    return LWM2M_STATUS_BAD_REQUEST;
+  }
+  if((attr.flags & ATTR_GT) && (attr.flags & ATTR_LT)) {
+    if(attr.lt >= attr.gt ||
+       ((attr.flags & ATTR_ST) && (int64_t)attr.lt + 2 * attr.st >= attr.gt)) {
+      return LWM2M_STATUS_BAD_REQUEST;
+    }
+  }
+  if((attr.flags & ATTR_PMIN) && (attr.flags & ATTR_PMAX) &&
+     attr.pmax < attr.pmin) {
+    return LWM2M_STATUS_BAD_REQUEST;
+  }
+
+  if(attr.flags == 0) {
+    if(a != NULL) {
+      list_remove(attributes_list, a);
+      memb_free(&attributes_memb, a);
+    }
+  } else {
+    if(a == NULL) {
+      a = memb_alloc(&attributes_memb);
+      if(a == NULL) {
+        LOG_WARN("No room for attributes of %u/%u/%u\n",
+                 attr.object_id, attr.instance_id, attr.resource_id);
+        return LWM2M_STATUS_SERVICE_UNAVAILABLE;
+      }
+      list_add(attributes_list, a);
+    }
+    attr.next = a->next;
+    memcpy(a, &attr, sizeof(attr));
+  }
+
+  if((attr.flags & ATTR_PMAX) && lwm2m_engine_has_instance(attr.object_id,
+                                                            attr.instance_id)) {
+    /* An observed path is notified when pmax has passed */
+    if(has_observers(attr.object_id, attr.instance_id, attr.resource_id) &&
+       find_state(attr.object_id, attr.instance_id,
+                  attr.resource_id) == NULL &&
+       (state = get_state(attr.object_id, attr.instance_id,
+                          attr.resource_id)) != NULL) {
+      set_notified(state);
+    }
+  }
+  schedule();
+  return LWM2M_STATUS_OK;
+}
+/*---------------------------------------------------------------------------*/
+size_t
+lwm2m_notification_attributes_write_link(uint16_t object_id,
+                                         uint16_t instance_id,
+                                         uint16_t resource_id,
+                                         uint8_t *outbuf, size_t outlen)
+{
+  const attributes_t *a;
+  static const char *const names[] = { ";gt=", ";lt=", ";st=" };
+  const int32_t *values[3];
+  size_t len = 0;
+  int n;
+  int i;
+
+  a = find_attributes(object_id, instance_id, resource_id);
+  if(a == NULL) {
+    return 0;
+  }
+
+  if(a->flags & ATTR_PMIN) {
+    n = snprintf((char *)outbuf, outlen, ";pmin=%lu", (unsigned long)a->pmin);
+    if(n < 0 || n >= outlen) {
+      return 0;
+    }
+    len += n;
+  }
+  if(a->flags & ATTR_PMAX) {
+    n = snprintf((char *)&outbuf[len], outlen - len, ";pmax=%lu",
+                 (unsigned long)a->pmax);
+    if(n < 0 || n >= outlen - len) {
+      return 0;
+    }
+    len += n;
+  }
+
+  values[0] = &a->gt;
+  values[1] = &a->lt;
+  values[2] = &a->st;
+  for(i = 0; i < 3; i++) {
+    if(a->flags & (ATTR_GT << i)) {
+      if(outlen - len <= 4) {
+        return 0;
+      }
+      memcpy(&outbuf[len], names[i], 4);
+      len += 4;
+      n = lwm2m_plain_text_write_float32fix(&outbuf[len], outlen - len,
+                                            *values[i], LWM2M_FLOAT32_BITS);
+      if(n == 0) {
+        return 0;
+      }
+      len += n;
+    }
+  }
+  return len;
+}
+/*---------------------------------------------------------------------------*/
+void
+lwm2m_notification_attributes_init(void)
+{
+  memb_init(&attributes_memb);
+  list_init(attributes_list);
+  memb_init(&state_memb);
+  list_init(state_list);
+  coap_timer_set_callback(&notification_timer, notification_timer_callback);
+}
+/*---------------------------------------------------------------------------*/
+/** @} */
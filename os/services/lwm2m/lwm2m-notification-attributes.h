@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2026, Contiki-NG contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \addtogroup lwm2m
+ * @{
+ */
+
+/**
+ * \file
+ *         Header file for the Contiki OMA LWM2M notification attributes
+ */
+
+#ifndef LWM2M_NOTIFICATION_ATTRIBUTES_H_
+#define LWM2M_NOTIFICATION_ATTRIBUTES_H_
+
+#include "lwm2m-object.h"
+
+void lwm2m_notification_attributes_init(void);
+
+/*
+ * Sets the attributes in query, as given by a Write-Attributes request, on
+ * the object, instance or resource addressed by ctx. An attribute without
+ * a value is removed.
+ */
+lwm2m_status_t lwm2m_notification_attributes_write(const lwm2m_context_t *ctx,
+                                                   const char *query,
+                                                   int query_len);
+
+/*
+ * Writes the attributes set on a resource as link-format parameters, for
+ * discovery. Returns the number of bytes written.
+ */
+size_t lwm2m_notification_attributes_write_link(uint16_t object_id,
+                                                uint16_t instance_id,
+                                                uint16_t resource_id,
+                                                uint8_t *outbuf,
+                                                size_t outlen);
+
+/*
+ * Called when a resource has changed. Returns 1 when its observers are
+ * to be notified now, 0 when the notification is left out or deferred
+ * by the attributes in effect for the resource.
+ */
+int lwm2m_notification_attributes_changed(uint16_t object_id,
+                                          uint16_t instance_id,
+                                          uint16_t resource_id);
+
+/* Called when a resource is observed, which starts the pmax period */
+void lwm2m_notification_attributes_observed(uint16_t object_id,
+                                            uint16_t instance_id,
+                                            uint16_t resource_id);
+
+#endif /* LWM2M_NOTIFICATION_ATTRIBUTES_H_ */
+/** @} */
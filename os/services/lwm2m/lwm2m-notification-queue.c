@@ -50,6 +50,10 @@
 #include "coap-engine.h"
 #include "lib/memb.h"
 #include "lib/list.h"
+#if LWM2M_QUEUE_MODE_PERSISTENT_NOTIFICATIONS
+#include "lwm2m-senml-cbor.h"
+#include "cfs/cfs.h"
+#endif
 #include <string.h>
 #include <inttypes.h>
 #include <stdlib.h>
@@ -66,6 +70,542 @@
 #define LWM2M_NOTIFICATION_QUEUE_LENGTH COAP_MAX_OBSERVERS
 #endif
 
+#if LWM2M_QUEUE_MODE_PERSISTENT_NOTIFICATIONS
+/*---------------------------------------------------------------------------*/
+/* Values longer than this are not stored, the current value is sent */
+#define STORED_VALUE_LEN 11
+
+#define STORED_NONE    0 /* no value, notify the current one */
+#define STORED_INT     1
+#define STORED_FLOAT   2
+#define STORED_BOOLEAN 3
+#define STORED_STRING  4
+
+/*
+ * Ends each record. Coffee finds the end of a file again, after a reboot,
+ * by skipping the zeros at its end, which would cut a record ending in
+ * zeros short.
+ */
+#define STORED_MARKER 0xa5
+
+/* A value as appended to the notification file, without padding */
+typedef struct {
+  uint32_t time;
+  uint16_t path[3];
+  uint8_t type;
+  uint8_t len; /* fraction bits of fixed point values, length of strings */
+  uint8_t value[STORED_VALUE_LEN];
+  uint8_t marker;
+} stored_notification_t;
+
+#define BITMAP_SIZE ((LWM2M_QUEUE_MODE_STORED_NOTIFICATIONS + 7) / 8)
+#define IS_SET(map, i) (((map)[(i) >> 3] & (1 << ((i) & 7))) != 0)
+#define SET(map, i) ((map)[(i) >> 3] |= 1 << ((i) & 7))
+
+static uint16_t stored_count;
+/* Values sent since waking up, and those in the notification being built */
+static uint8_t sent[BITMAP_SIZE];
+static uint8_t pending[BITMAP_SIZE];
+/* Path whose stored values are being notified */
+static uint16_t replay_path[3];
+static uint8_t replaying;
+
+/* Sends the values of paths observed again, e.g. after a reboot */
+static coap_timer_t observed_timer;
+
+/* Value captured by reading a resource through value_writer */
+static stored_notification_t capture;
+
+static int keep_unsent(void);
+/*---------------------------------------------------------------------------*/
+static size_t
+capture_none(lwm2m_context_t *ctx)
+{
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+capture_value(uint8_t type, uint8_t len, const void *value)
+{
+  /* Multiple resource instances: keep the first */
+  if(capture.type == STORED_NONE) {
+    capture.type = type;
+    capture.len = len;
+    memcpy(capture.value, value, type == STORED_STRING ? len : sizeof(int32_t));
+  }
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+capture_int(lwm2m_context_t *ctx, uint8_t *outbuf, size_t outlen,
+            int32_t value)
+{
+  capture_value(STORED_INT, 0, &value);
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+capture_float32fix(lwm2m_context_t *ctx, uint8_t *outbuf, size_t outlen,
+                   int32_t value, int bits)
+{
+  capture_value(STORED_FLOAT, bits, &value);
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+capture_boolean(lwm2m_context_t *ctx, uint8_t *outbuf, size_t outlen,
+                int value)
+{
+  int32_t b = value != 0;
+
+  capture_value(STORED_BOOLEAN, 0, &b);
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+capture_string(lwm2m_context_t *ctx, uint8_t *outbuf, size_t outlen,
+               const char *value, size_t strlen)
+{
+  if(strlen <= STORED_VALUE_LEN) {
+    capture_value(STORED_STRING, strlen, value);
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+capture_opaque_header(lwm2m_context_t *ctx, size_t total_size)
+{
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static const lwm2m_writer_t value_writer = {
+  capture_none,
+  capture_none,
+  capture_none,
+  capture_none,
+  capture_int,
+  capture_string,
+  capture_float32fix,
+  capture_boolean,
+  capture_opaque_header
+};
+/*---------------------------------------------------------------------------*/
+static void
+read_value(uint16_t object_id, uint16_t instance_id, uint16_t resource_id)
+{
+  lwm2m_object_instance_t *instance;
+  lwm2m_context_t ctx;
+  lwm2m_buffer_t buffer;
+  uint8_t data[8];
+
+  capture.type = STORED_NONE;
+  instance = lwm2m_engine_get_instance(object_id, instance_id);
+  if(instance == NULL || instance->callback == NULL) {
+    return;
+  }
+
+  memset(&ctx, 0, sizeof(ctx));
+  buffer.buffer = data;
+  buffer.size = sizeof(data);
+  buffer.len = 0;
+  buffer.pos = 0;
+  ctx.object_id = object_id;
+  ctx.object_instance_id = instance_id;
+  ctx.resource_id = resource_id;
+  ctx.level = 3;
+  ctx.operation = LWM2M_OP_READ;
+  ctx.outbuf = &buffer;
+  ctx.inbuf = &buffer;
+  ctx.writer = &value_writer;
+
+  if(instance->callback(instance, &ctx) != LWM2M_STATUS_OK) {
+    capture.type = STORED_NONE;
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+lwm2m_notification_queue_init(void)
+{
+  stored_notification_t record;
+  cfs_offset_t size;
+  uint32_t count;
+  int fd;
+
+  /* Values stored before a reboot are sent when the client wakes up */
+  stored_count = 0;
+  memset(sent, 0, sizeof(sent));
+  fd = cfs_open(LWM2M_QUEUE_MODE_NOTIFICATION_FILE, CFS_READ);
+  if(fd < 0) {
+    return;
+  }
+  /* A record cut short, e.g. by a reset while writing it, is counted and
+     fails the marker check */
+  size = cfs_seek(fd, 0, CFS_SEEK_END);
+  count = size > 0 ?
+    (size + sizeof(record) - 1) / sizeof(record) : 0;
+  cfs_seek(fd, 0, CFS_SEEK_SET);
+  while(stored_count < count &&
+        stored_count < LWM2M_QUEUE_MODE_STORED_NOTIFICATIONS &&
+        cfs_read(fd, &record, sizeof(record)) == sizeof(record) &&
+        record.marker == STORED_MARKER) {
+    stored_count++;
+  }
+  cfs_close(fd);
+
+  if(stored_count < count) {
+    /* Later records would be appended out of line */
+    LOG_WARN("Dropping %u damaged stored notifications\n",
+             (unsigned)(count - stored_count));
+    if(keep_unsent() < 0) {
+      stored_count = 0;
+      cfs_remove(LWM2M_QUEUE_MODE_NOTIFICATION_FILE);
+    }
+  }
+  LOG_DBG("%u stored notifications\n", stored_count);
+}
+/*---------------------------------------------------------------------------*/
+void
+lwm2m_notification_queue_add_notification_path(uint16_t object_id, uint16_t instance_id, uint16_t resource_id)
+{
+  int fd;
+
+  if(stored_count >= LWM2M_QUEUE_MODE_STORED_NOTIFICATIONS) {
+    LOG_WARN("Notification store is full, dropping %u/%u/%u\n",
+             object_id, instance_id, resource_id);
+    return;
+  }
+
+  if(resource_id != LWM2M_OBJECT_RESOURCE_NONE) {
+    read_value(object_id, instance_id, resource_id);
+  } else {
+    /* An object or instance, its current value is sent */
+    capture.type = STORED_NONE;
+  }
+  capture.time = clock_seconds();
+  capture.path[0] = object_id;
+  capture.path[1] = instance_id;
+  capture.path[2] = resource_id;
+  capture.marker = STORED_MARKER;
+
+  fd = cfs_open(LWM2M_QUEUE_MODE_NOTIFICATION_FILE, CFS_WRITE | CFS_APPEND);
+  if(fd < 0) {
+    LOG_WARN("Could not open the notification store\n");
+    return;
+  }
+  if(cfs_write(fd, &capture, sizeof(capture)) == sizeof(capture)) {
+    stored_count++;
+    LOG_DBG("Notification stored: %u/%u/%u\n", object_id, instance_id,
+            resource_id);
+  } else {
+    LOG_WARN("Could not write to the notification store\n");
+  }
+  cfs_close(fd);
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Returns the index of the first value not sent yet, of the given path
+ * unless it is NULL, or stored_count if there is none.
+ */
+static uint16_t
+find_unsent(const uint16_t *path, stored_notification_t *record)
+{
+  uint16_t i;
+  int fd;
+
+  fd = cfs_open(LWM2M_QUEUE_MODE_NOTIFICATION_FILE, CFS_READ);
+  if(fd < 0) {
+    return stored_count;
+  }
+  for(i = 0; i < stored_count; i++) {
+    if(cfs_read(fd, record, sizeof(*record)) != sizeof(*record)) {
+      i = stored_count;
+      break;
+    }
+    if(!IS_SET(sent, i) &&
+       (path == NULL || memcmp(record->path, path, sizeof(record->path)) == 0)) {
+      break;
+    }
+  }
+  cfs_close(fd);
+  return i;
+}
+/*---------------------------------------------------------------------------*/
+int
+lwm2m_notification_queue_is_replaying(uint16_t object_id, uint16_t instance_id, uint16_t resource_id)
+{
+  return replaying && replay_path[0] == object_id &&
+    replay_path[1] == instance_id && replay_path[2] == resource_id;
+}
+/*---------------------------------------------------------------------------*/
+lwm2m_status_t
+lwm2m_notification_queue_write_stored(lwm2m_context_t *ctx)
+{
+  lwm2m_buffer_t *outbuf = ctx->outbuf;
+  stored_notification_t record;
+  uint32_t now;
+  int32_t value;
+  size_t len;
+  uint16_t i;
+  int fd;
+
+  /* Called for each observer unless the notification is built once */
+  memset(pending, 0, sizeof(pending));
+
+  ctx->writer = &lwm2m_senml_cbor_writer;
+  ctx->content_type = LWM2M_SENML_CBOR;
+  ctx->writer_flags = WRITER_TIME;
+  outbuf->len += ctx->writer->init_write(ctx);
+
+  now = clock_seconds();
+  fd = cfs_open(LWM2M_QUEUE_MODE_NOTIFICATION_FILE, CFS_READ);
+  for(i = 0; fd >= 0 && i < stored_count; i++) {
+    if(cfs_read(fd, &record, sizeof(record)) != sizeof(record)) {
+      break;
+    }
+    if(IS_SET(sent, i) || record.type == STORED_NONE ||
+       memcmp(record.path, replay_path, sizeof(replay_path)) != 0) {
+      continue;
+    }
+    /* Without a real-time clock, values from before a reboot are sent as
+       current ones */
+    ctx->time = record.time > now ? 0 : -(int32_t)(now - record.time);
+
+    /* Leave room for the end of the pack */
+    if(outbuf->len + 1 >= outbuf->size) {
+      break;
+    }
+    len = outbuf->size - outbuf->len - 1;
+    memcpy(&value, record.value, sizeof(value));
+    switch(record.type) {
+    case STORED_INT:
+      len = ctx->writer->write_int(ctx, &outbuf->buffer[outbuf->len], len,
+                                   value);
+      break;
+    case STORED_FLOAT:
+      len = ctx->writer->write_float32fix(ctx, &outbuf->buffer[outbuf->len],
+                                          len, value, record.len);
+      break;
+    case STORED_BOOLEAN:
+      len = ctx->writer->write_boolean(ctx, &outbuf->buffer[outbuf->len], len,
+                                       value);
+      break;
+    default:
+      len = ctx->writer->write_string(ctx, &outbuf->buffer[outbuf->len], len,
+                                      (const char *)record.value, record.len);
+      break;
+    }
+    if(len == 0) {
+      /* The rest goes into the next notification */
+      break;
+    }
+    outbuf->len += len;
+    SET(pending, i);
+  }
+  if(fd >= 0) {
+    cfs_close(fd);
+  }
+
+  outbuf->len += ctx->writer->end_write(ctx);
+  return LWM2M_STATUS_OK;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Formats the path of a stored notification. Returns 1 for an object or
+ * instance, whose observers are notified without those of its resources.
+ */
+static int
+format_path(const uint16_t *ids, char *path, size_t size)
+{
+  if(ids[1] == LWM2M_OBJECT_INSTANCE_NONE) {
+    snprintf(path, size, "%u", ids[0]);
+    return 1;
+  }
+  if(ids[2] == LWM2M_OBJECT_RESOURCE_NONE) {
+    snprintf(path, size, "%u/%u", ids[0], ids[1]);
+    return 1;
+  }
+  snprintf(path, size, "%u/%u/%u", ids[0], ids[1], ids[2]);
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+/* Marks the values of the path in map, or only those without a value */
+static void
+set_sent(uint8_t *map, const uint16_t *path, int only_none)
+{
+  stored_notification_t record;
+  uint16_t i;
+  int fd;
+
+  fd = cfs_open(LWM2M_QUEUE_MODE_NOTIFICATION_FILE, CFS_READ);
+  if(fd < 0) {
+    return;
+  }
+  for(i = 0; i < stored_count; i++) {
+    if(cfs_read(fd, &record, sizeof(record)) != sizeof(record)) {
+      break;
+    }
+    if(memcmp(record.path, path, sizeof(record.path)) == 0 &&
+       (!only_none || record.type == STORED_NONE)) {
+      SET(map, i);
+    }
+  }
+  cfs_close(fd);
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Rewrites the notification file with the values not sent yet, through
+ * a second file as CFS can not truncate a file. Returns -1, leaving the
+ * file and the sent values as they are, if the copy could not be made.
+ */
+static int
+keep_unsent(void)
+{
+  stored_notification_t record;
+  uint16_t count = 0;
+  uint16_t i;
+  int ok;
+  int in;
+  int out;
+
+  cfs_remove(LWM2M_QUEUE_MODE_NOTIFICATION_TMP_FILE);
+  in = cfs_open(LWM2M_QUEUE_MODE_NOTIFICATION_FILE, CFS_READ);
+  out = cfs_open(LWM2M_QUEUE_MODE_NOTIFICATION_TMP_FILE, CFS_WRITE);
+  ok = in >= 0 && out >= 0;
+  for(i = 0; ok && i < stored_count; i++) {
+    if(cfs_read(in, &record, sizeof(record)) != sizeof(record)) {
+      break;
+    }
+    if(!IS_SET(sent, i)) {
+      if(cfs_write(out, &record, sizeof(record)) != sizeof(record)) {
+        ok = 0;
+      } else {
+        count++;
+      }
+    }
+  }
+  if(in >= 0) {
+    cfs_close(in);
+  }
+  if(out >= 0) {
+    cfs_close(out);
+  }
+  if(!ok) {
+    LOG_WARN("Could not copy the notification store\n");
+    cfs_remove(LWM2M_QUEUE_MODE_NOTIFICATION_TMP_FILE);
+    return -1;
+  }
+  cfs_remove(LWM2M_QUEUE_MODE_NOTIFICATION_FILE);
+
+  in = cfs_open(LWM2M_QUEUE_MODE_NOTIFICATION_TMP_FILE, CFS_READ);
+  out = cfs_open(LWM2M_QUEUE_MODE_NOTIFICATION_FILE, CFS_WRITE);
+  stored_count = 0;
+  while(in >= 0 && out >= 0 && stored_count < count &&
+        cfs_read(in, &record, sizeof(record)) == sizeof(record) &&
+        cfs_write(out, &record, sizeof(record)) == sizeof(record)) {
+    stored_count++;
+  }
+  if(in >= 0) {
+    cfs_close(in);
+  }
+  if(out >= 0) {
+    cfs_close(out);
+  }
+  cfs_remove(LWM2M_QUEUE_MODE_NOTIFICATION_TMP_FILE);
+  if(stored_count < count) {
+    LOG_WARN("Lost %u stored notifications\n", count - stored_count);
+  }
+
+  memset(sent, 0, sizeof(sent));
+  LOG_DBG("%u stored notifications kept\n", stored_count);
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+void
+lwm2m_notification_queue_send_notifications()
+{
+  stored_notification_t record;
+  char path[20];
+  uint16_t i;
+  /* Values of paths not observed, kept in the file */
+  uint8_t kept[BITMAP_SIZE];
+  int exact;
+  int j;
+
+  memset(kept, 0, sizeof(kept));
+  while((i = find_unsent(NULL, &record)) < stored_count) {
+    exact = format_path(record.path, path, sizeof(path));
+    if(exact ? !coap_has_observers_exact(path) : !coap_has_observers(path)) {
+      /* Not observed (again) yet, e.g. after a reboot */
+      LOG_DBG("No observers of %s, keeping its stored values\n", path);
+      set_sent(kept, record.path, 0);
+      for(j = 0; j < BITMAP_SIZE; j++) {
+        sent[j] |= kept[j];
+      }
+      continue;
+    }
+#if LWM2M_QUEUE_MODE_INCLUDE_DYNAMIC_ADAPTATION
+    if(lwm2m_queue_mode_get_dynamic_adaptation_flag()) {
+      lwm2m_queue_mode_set_handler_from_notification();
+    }
+#endif
+    if(record.type == STORED_NONE) {
+      LOG_DBG("Sending the current value of %s\n", path);
+      set_sent(sent, record.path, 1);
+      if(exact) {
+        coap_notify_observers_exact(path);
+      } else {
+        coap_notify_observers_sub(NULL, path);
+      }
+      continue;
+    }
+
+    LOG_DBG("Sending stored values of %s\n", path);
+    memcpy(replay_path, record.path, sizeof(replay_path));
+    memset(pending, 0, sizeof(pending));
+    replaying = 1;
+    coap_notify_observers_sub(NULL, path);
+    replaying = 0;
+
+    for(j = 0; j < BITMAP_SIZE && pending[j] == 0; j++);
+    if(j == BITMAP_SIZE) {
+      /* Not even one value fit, or the handler failed */
+      LOG_WARN("Could not send stored value %u of %s\n", i, path);
+      SET(sent, i);
+    }
+    for(j = 0; j < BITMAP_SIZE; j++) {
+      sent[j] |= pending[j];
+    }
+  }
+
+  for(j = 0; j < BITMAP_SIZE && kept[j] == 0; j++);
+  if(j < BITMAP_SIZE) {
+    for(j = 0; j < BITMAP_SIZE; j++) {
+      sent[j] &= ~kept[j];
+    }
+    keep_unsent();
+  } else {
+    stored_count = 0;
+    memset(sent, 0, sizeof(sent));
+    cfs_remove(LWM2M_QUEUE_MODE_NOTIFICATION_FILE);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+observed_timer_callback(coap_timer_t *timer)
+{
+  lwm2m_notification_queue_send_notifications();
+}
+/*---------------------------------------------------------------------------*/
+void
+lwm2m_notification_queue_observed(void)
+{
+  if(stored_count > 0) {
+    /* After the response, which registers the observer */
+    coap_timer_set_callback(&observed_timer, observed_timer_callback);
+    coap_timer_set(&observed_timer, 0);
+  }
+}
+/*---------------------------------------------------------------------------*/
+#else /* LWM2M_QUEUE_MODE_PERSISTENT_NOTIFICATIONS */
 /*---------------------------------------------------------------------------*/
 /* Queue to store the notifications in the period when the client has woken up, sent the update and it's waiting for the server response*/
 MEMB(notification_memb, notification_path_t, LWM2M_NOTIFICATION_QUEUE_LENGTH); /* Length + 1 to allocate the new path to add */
@@ -129,7 +669,8 @@ lwm2m_notification_queue_add_notification_path(uint16_t object_id, uint16_t inst
   path_object->reduced_path[0] = object_id;
   path_object->reduced_path[1] = instance_id;
   path_object->reduced_path[2] = resource_id;
-  path_object->level = 3;
+  path_object->level = instance_id == LWM2M_OBJECT_INSTANCE_NONE ? 1 :
+    resource_id == LWM2M_OBJECT_RESOURCE_NONE ? 2 : 3;
   list_add(notification_paths_queue, path_object);
   LOG_DBG("Notification path added to the list: %u/%u/%u\n", object_id, instance_id, resource_id);
 }
@@ -149,11 +690,17 @@ lwm2m_notification_queue_send_notifications()
     }
 #endif
     LOG_DBG("Sending stored notification with path: %s\n", path);
-    coap_notify_observers_sub(NULL, path);
+    if(iteration_path->level < 3) {
+      /* not the observers of the resources of an instance or object */
+      coap_notify_observers_exact(path);
+    } else {
+      coap_notify_observers_sub(NULL, path);
+    }
     aux = iteration_path;
     iteration_path = iteration_path->next;
     remove_notification_path(aux);
   }
 }
+#endif /* LWM2M_QUEUE_MODE_PERSISTENT_NOTIFICATIONS */
 #endif /* LWM2M_QUEUE_MODE_ENABLED */
 /** @} */
\ No newline at end of file
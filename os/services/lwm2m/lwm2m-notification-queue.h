@@ -61,5 +61,18 @@ void lwm2m_notification_queue_add_notification_path(uint16_t object_id, uint16_t
 
 void lwm2m_notification_queue_send_notifications();
 
+#if LWM2M_QUEUE_MODE_PERSISTENT_NOTIFICATIONS
+#include "lwm2m-object.h"
+
+/* Whether a notification of the stored values of the resource is sent */
+int lwm2m_notification_queue_is_replaying(uint16_t object_id, uint16_t instance_id, uint16_t resource_id);
+
+/* Writes the stored values of the resource as a SenML-CBOR pack */
+lwm2m_status_t lwm2m_notification_queue_write_stored(lwm2m_context_t *ctx);
+
+/* Called when a path is observed, its stored values are sent afterwards */
+void lwm2m_notification_queue_observed(void);
+#endif /* LWM2M_QUEUE_MODE_PERSISTENT_NOTIFICATIONS */
+
 #endif /* LWM2M_NOTIFICATION_QUEUE_H */
 /** @} */
\ No newline at end of file
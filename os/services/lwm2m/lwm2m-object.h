@@ -116,6 +116,14 @@ typedef enum {
 #define WRITER_OUTPUT_VALUE      1
 #define WRITER_RESOURCE_INSTANCE 2
 #define WRITER_HAS_MORE          4
+/* set by the engine while further object instances follow in a read */
+#define WRITER_MORE_INSTANCES    8
+/* the next record of a SenML pack carries the base name */
+#define WRITER_BASE_NAME         16
+/* the records of a SenML pack carry the time in the context */
+#define WRITER_TIME              32
+/* the pack holds several paths, the engine opens and closes it */
+#define WRITER_COMPOSITE         64
 
 typedef struct lwm2m_reader lwm2m_reader_t;
 typedef struct lwm2m_writer lwm2m_writer_t;
@@ -157,6 +165,9 @@ typedef struct lwm2m_context {
   uint16_t last_instance;
   uint16_t last_value_len;
 
+  /* SenML time of the written value with WRITER_TIME, relative to now */
+  int32_t time;
+
   uint8_t writer_flags; /* flags for reader/writer */
   const lwm2m_reader_t *reader;
   const lwm2m_writer_t *writer;
@@ -90,6 +90,37 @@
 #define LWM2M_QUEUE_MODE_OBJECT_ENABLED 0 /* not included */
 #endif /* LWM2M_QUEUE_MODE_OBJECT_ENABLED */
 
+/* Keep the value of each notification while sleeping in a CFS file, which
+   survives reboots, and send the stored values of a resource as one
+   SenML-CBOR pack with the time of each value when the client wakes up */
+#ifdef LWM2M_QUEUE_MODE_CONF_PERSISTENT_NOTIFICATIONS
+#define LWM2M_QUEUE_MODE_PERSISTENT_NOTIFICATIONS LWM2M_QUEUE_MODE_CONF_PERSISTENT_NOTIFICATIONS
+#else
+#define LWM2M_QUEUE_MODE_PERSISTENT_NOTIFICATIONS 0 /* disabled */
+#endif /* LWM2M_QUEUE_MODE_PERSISTENT_NOTIFICATIONS */
+
+/* Maximum number of stored values, further values are dropped */
+#ifdef LWM2M_QUEUE_MODE_CONF_STORED_NOTIFICATIONS
+#define LWM2M_QUEUE_MODE_STORED_NOTIFICATIONS LWM2M_QUEUE_MODE_CONF_STORED_NOTIFICATIONS
+#else
+#define LWM2M_QUEUE_MODE_STORED_NOTIFICATIONS 32
+#endif /* LWM2M_QUEUE_MODE_STORED_NOTIFICATIONS */
+
+/* Name of the file the values are stored in */
+#ifdef LWM2M_QUEUE_MODE_CONF_NOTIFICATION_FILE
+#define LWM2M_QUEUE_MODE_NOTIFICATION_FILE LWM2M_QUEUE_MODE_CONF_NOTIFICATION_FILE
+#else
+#define LWM2M_QUEUE_MODE_NOTIFICATION_FILE "lwm2m-notifications"
+#endif /* LWM2M_QUEUE_MODE_NOTIFICATION_FILE */
+
+/* Name of the file the values not sent yet are copied to while the
+   notification file is rewritten */
+#ifdef LWM2M_QUEUE_MODE_CONF_NOTIFICATION_TMP_FILE
+#define LWM2M_QUEUE_MODE_NOTIFICATION_TMP_FILE LWM2M_QUEUE_MODE_CONF_NOTIFICATION_TMP_FILE
+#else
+#define LWM2M_QUEUE_MODE_NOTIFICATION_TMP_FILE "lwm2m-notif-tmp"
+#endif /* LWM2M_QUEUE_MODE_NOTIFICATION_TMP_FILE */
+
 
 
 #endif /* LWM2M_QUEUE_MODE_CONF_H */
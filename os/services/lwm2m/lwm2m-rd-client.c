@@ -83,6 +83,11 @@
 
 #define STATE_MACHINE_UPDATE_INTERVAL 500
 
+/* Largest Send payload, it goes without blockwise transfer */
+#ifndef LWM2M_RD_CLIENT_SEND_BUFFER_SIZE
+#define LWM2M_RD_CLIENT_SEND_BUFFER_SIZE COAP_MAX_CHUNK_SIZE
+#endif
+
 static struct lwm2m_session_info session_info;
 static coap_callback_request_state_t rd_request_state;
 
@@ -112,6 +117,7 @@ static coap_message_t request[1];      /* This way the message can be treated as
 
 #define FLAG_RD_DATA_DIRTY            0x01
 #define FLAG_RD_DATA_UPDATE_TRIGGERED 0x02
+#define FLAG_RD_DATA_ACKED            0x04
 #define FLAG_RD_DATA_UPDATE_ON_DIRTY  0x10
 
 static uint8_t rd_state = 0;
@@ -124,11 +130,24 @@ static uint8_t rd_data[128]; /* allocate some data for the RD */
 
 static uint32_t rd_block1;
 static uint8_t rd_more;
+/*
+ * Generation of the object list, bumped on every change. The server has
+ * the list of rd_acked_generation when FLAG_RD_DATA_ACKED is set.
+ */
+static uint16_t rd_generation;
+static uint16_t rd_acked_generation;
+static uint16_t rd_pending_generation;
 static coap_timer_t rd_timer;
 static void (*rd_callback)(coap_callback_request_state_t *callback_state);
 
 static coap_timer_t block1_timer;
 
+/* The Send operation, one at a time next to the registration requests */
+static coap_callback_request_state_t send_request_state;
+static coap_message_t send_request[1];
+static uint8_t send_data[LWM2M_RD_CLIENT_SEND_BUFFER_SIZE];
+static uint8_t send_busy;
+
 #if LWM2M_QUEUE_MODE_ENABLED
 static coap_timer_t queue_mode_client_awake_timer; /* Timer to control the client's 
                                                 * awake time 
@@ -144,6 +163,7 @@ static void queue_mode_awake_timer_callback(coap_timer_t *timer);
 static void check_periodic_observations();
 static void update_callback(coap_callback_request_state_t *callback_state);
 
+/*---------------------------------------------------------------------------*/
 static int
 set_rd_data(coap_message_t *request)
 {
@@ -157,6 +177,7 @@ set_rd_data(coap_message_t *request)
   /* this will also set the request payload */
   rd_more = lwm2m_engine_set_rd_data(&outbuf, 0);
   coap_set_payload(request, rd_data, outbuf.len);
+  rd_pending_generation = rd_generation;
 
   if(rd_more) {
     /* set the first block here */
@@ -176,9 +197,17 @@ prepare_update(coap_message_t *request, int triggered)
   LOG_DBG("UPDATE:%s %s\n", session_info.assigned_ep, query_data);
   coap_set_header_uri_query(request, query_data);
 
+  rd_pending_generation = rd_acked_generation;
   if((triggered || rd_flags & FLAG_RD_DATA_UPDATE_ON_DIRTY) && (rd_flags & FLAG_RD_DATA_DIRTY)) {
     rd_flags &= ~FLAG_RD_DATA_DIRTY;
-    set_rd_data(request);
+    /* The update only carries the object list if the server does not
+       have this generation of it already */
+    if(!(rd_flags & FLAG_RD_DATA_ACKED) ||
+       rd_generation != rd_acked_generation) {
+      set_rd_data(request);
+    } else {
+      LOG_DBG("Object list unchanged\n");
+    }
     rd_callback = update_callback;
   }
 }
@@ -257,6 +286,7 @@ lwm2m_rd_client_set_lifetime(uint16_t lifetime)
 void
 lwm2m_rd_client_set_update_rd(void)
 {
+  rd_generation++;
   rd_flags |= FLAG_RD_DATA_DIRTY;
 }
 /*---------------------------------------------------------------------------*/
@@ -326,6 +356,50 @@ lwm2m_rd_client_deregister(void)
   return 0;
 }
 /*---------------------------------------------------------------------------*/
+static void
+send_callback(coap_callback_request_state_t *callback_state)
+{
+  coap_request_state_t *state = &callback_state->state;
+
+  if(state->status == COAP_REQUEST_STATUS_RESPONSE) {
+    if(state->response->code != CHANGED_2_04) {
+      LOG_WARN("Send rejected with code %u\n", state->response->code);
+    }
+  } else if(state->status != COAP_REQUEST_STATUS_MORE) {
+    if(state->status == COAP_REQUEST_STATUS_TIMEOUT) {
+      LOG_WARN("Send timed out\n");
+    }
+    send_busy = 0;
+  }
+}
+/*---------------------------------------------------------------------------*/
+int
+lwm2m_rd_client_send(const lwm2m_path_t *paths, int count)
+{
+  int len;
+
+  if(!lwm2m_rd_client_is_registered() || send_busy) {
+    return 0;
+  }
+  len = lwm2m_engine_write_composite(paths, count, send_data,
+                                     sizeof(send_data));
+  if(len < 0) {
+    return 0;
+  }
+
+  coap_init_message(send_request, COAP_TYPE_CON, COAP_POST, 0);
+  coap_set_header_uri_path(send_request, "/dp");
+  coap_set_header_content_format(send_request, LWM2M_SENML_CBOR);
+  coap_set_payload(send_request, send_data, len);
+  if(!coap_send_request(&send_request_state, &session_info.server_ep,
+                        send_request, send_callback)) {
+    return 0;
+  }
+  LOG_DBG("Send: %d bytes\n", len);
+  send_busy = 1;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
 void
 lwm2m_rd_client_update_triggered(void)
 {
@@ -443,10 +517,14 @@ registration_callback(coap_callback_request_state_t *callback_state)
       coap_timer_set(&block1_timer, 1); /* delay 1 ms */
       LOG_DBG_("Continue\n");
     } else if(CREATED_2_01 == state->response->code) {
-      if(state->response->location_path_len < LWM2M_RD_CLIENT_ASSIGNED_ENDPOINT_MAX_LEN) {
-        memcpy(session_info.assigned_ep, state->response->location_path,
-               state->response->location_path_len);
-        session_info.assigned_ep[state->response->location_path_len] = 0;
+      const char *location_path = NULL;
+      int location_path_len;
+
+      location_path_len = coap_get_header_location_path(state->response,
+                                                        &location_path);
+      if(location_path_len < LWM2M_RD_CLIENT_ASSIGNED_ENDPOINT_MAX_LEN) {
+        memcpy(session_info.assigned_ep, location_path, location_path_len);
+        session_info.assigned_ep[location_path_len] = 0;
         /* if we decide to not pass the lt-argument on registration, we should force an initial "update" to register lifetime with server */
 #if LWM2M_QUEUE_MODE_ENABLED
 #if LWM2M_QUEUE_MODE_INCLUDE_DYNAMIC_ADAPTATION
@@ -460,14 +538,15 @@ registration_callback(coap_callback_request_state_t *callback_state)
 #endif
         /* remember the last reg time */
         last_update = coap_timer_uptime();
+        rd_acked_generation = rd_pending_generation;
+        rd_flags |= FLAG_RD_DATA_ACKED;
         LOG_DBG_("Done (assigned EP='%s')!\n", session_info.assigned_ep);
         perform_session_callback(LWM2M_RD_CLIENT_REGISTERED);
         return;
       }
 
       LOG_DBG_("failed to handle assigned EP: '");
-      LOG_DBG_COAP_STRING(state->response->location_path,
-                          state->response->location_path_len);
+      LOG_DBG_COAP_STRING(location_path, location_path_len);
       LOG_DBG_("'. Re-init network.\n");
     } else {
       /* Possible error response codes are 4.00 Bad request & 4.03 Forbidden */
@@ -507,6 +586,8 @@ update_callback(coap_callback_request_state_t *callback_state)
       LOG_DBG_("Done!\n");
       /* remember the last reg time */
       last_update = coap_timer_uptime();
+      rd_acked_generation = rd_pending_generation;
+      rd_flags |= FLAG_RD_DATA_ACKED;
 #if LWM2M_QUEUE_MODE_ENABLED
       /* If it has been waked up by a notification, send the stored notifications in queue */
       if(lwm2m_queue_mode_is_waked_up_by_notification()) {
@@ -706,6 +787,10 @@ periodic_process(coap_timer_t *timer)
       snprintf(query_data, sizeof(query_data) - 1, "?ep=%s&lt=%d&b=%s", session_info.ep, session_info.lifetime, session_info.binding);
       coap_set_header_uri_query(request, query_data);
 
+      /* the registration carries the current object list, the server
+         has none until it is acknowledged */
+      rd_flags &= ~FLAG_RD_DATA_DIRTY;
+      rd_flags &= ~FLAG_RD_DATA_ACKED;
       len = set_rd_data(request);
       rd_callback = registration_callback;
 
@@ -52,7 +52,7 @@
 #define LWM2M_RD_CLIENT_DEREGISTER_FAILED  4
 #define LWM2M_RD_CLIENT_DISCONNECTED       5
 
-#include "lwm2m-object.h"
+#include "lwm2m-engine.h"
 #include "lwm2m-queue-mode-conf.h"
 
 struct lwm2m_session_info;
@@ -72,6 +72,13 @@ void lwm2m_rd_client_set_automatic_update(int update);
 /* trigger an immediate update */
 void lwm2m_rd_client_update_triggered(void);
 
+/*
+ * Sends the resources of the paths to the server with the Send operation
+ * (LwM2M 1.1) as one SenML-CBOR pack. Returns 0 if not registered, the
+ * previous Send is not done yet or the pack does not fit.
+ */
+int  lwm2m_rd_client_send(const lwm2m_path_t *paths, int count);
+
 int  lwm2m_rd_client_deregister(void);
 void lwm2m_rd_client_init(const char *ep);
 
@@ -0,0 +1,739 @@
+/*
+ * Copyright (c) 2026, Contiki-NG contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \addtogroup lwm2m
+ * @{
+ */
+
+/**
+ * \file
+ *         Implementation of the Contiki OMA LWM2M SenML-CBOR reader and
+ *         writer (RFC 8428, content format 112). The writer streams one
+ *         record per resource into an indefinite-length array, with the
+ *         base name set once per object instance.
+ */
+
+#include "lwm2m-object.h"
+#include "lwm2m-senml-cbor.h"
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+/* Log configuration */
+#include "coap-log.h"
+#define LOG_MODULE "lwm2m-cbor"
+#define LOG_LEVEL  LOG_LEVEL_NONE
+
+/* CBOR major types (RFC 8949) */
+#define CBOR_UNSIGNED 0x00
+#define CBOR_NEGATIVE 0x20
+#define CBOR_BYTES    0x40
+#define CBOR_TEXT     0x60
+#define CBOR_ARRAY    0x80
+#define CBOR_MAP      0xA0
+#define CBOR_SIMPLE   0xE0
+
+#define CBOR_FALSE    0xF4
+#define CBOR_TRUE     0xF5
+#define CBOR_HALF     0xF9
+#define CBOR_FLOAT    0xFA
+#define CBOR_DOUBLE   0xFB
+#define CBOR_BREAK    0xFF
+
+#define CBOR_INDEFINITE_INFO 0x1F
+#define CBOR_INDEFINITE      0xFFFFFFFF
+
+/* SenML labels (RFC 8428, Section 6) */
+#define SENML_BASE_NAME -2
+#define SENML_NAME       0
+#define SENML_VALUE      2
+#define SENML_STRING     3
+#define SENML_BOOLEAN    4
+#define SENML_TIME       6
+#define SENML_DATA       8
+
+/* Room for "/65535/65535/" and "65535/65535" */
+#define NAME_LEN 16
+
+/* Nesting skipped in values of unknown labels */
+#define MAX_DEPTH 4
+/*---------------------------------------------------------------------------*/
+static size_t
+put_head(uint8_t *buf, size_t len, uint8_t major, uint32_t value)
+{
+  size_t n;
+  size_t i;
+
+  n = value < 24 ? 1 : value <= 0xFF ? 2 : value <= 0xFFFF ? 3 : 5;
+  if(n > len) {
+    return 0;
+  }
+  if(n == 1) {
+    buf[0] = major | value;
+    return 1;
+  }
+  buf[0] = major | (n == 2 ? 24 : n == 3 ? 25 : 26);
+  for(i = n - 1; i > 0; i--) {
+    buf[i] = value;
+    value >>= 8;
+  }
+  return n;
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+put_int(uint8_t *buf, size_t len, int32_t value)
+{
+  if(value >= 0) {
+    return put_head(buf, len, CBOR_UNSIGNED, value);
+  }
+  return put_head(buf, len, CBOR_NEGATIVE, -1 - value);
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+put_string(uint8_t *buf, size_t len, uint8_t major,
+           const void *value, size_t value_len)
+{
+  size_t n = put_head(buf, len, major, value_len);
+
+  if(n == 0 || len - n < value_len) {
+    return 0;
+  }
+  memcpy(&buf[n], value, value_len);
+  return n + value_len;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Writes a fixed point value as an integer if it has no fraction, else as
+ * the shortest float that holds all of its bits, without float arithmetic.
+ * Values with more than 24 significant bits need a double.
+ */
+static size_t
+put_float32fix(uint8_t *buf, size_t len, int32_t value, int bits)
+{
+  uint32_t magnitude;
+  uint32_t mantissa;
+  uint32_t f;
+  int exponent;
+  int msb;
+
+  if((value & ((1L << bits) - 1)) == 0) {
+    return put_int(buf, len, value / (1L << bits));
+  }
+
+  magnitude = value < 0 ? -(uint32_t)value : (uint32_t)value;
+  for(msb = 31; (magnitude & (1UL << msb)) == 0; msb--);
+  mantissa = msb > 23 ? magnitude >> (msb - 23) : magnitude << (23 - msb);
+  exponent = msb - bits;
+
+  if(msb > 23 && (magnitude & ((1UL << (msb - 23)) - 1)) != 0) {
+    if(len < 9) {
+      return 0;
+    }
+    /* the 52 bit mantissa of a double holds any 32 bit magnitude */
+    mantissa = magnitude << (31 - msb);
+    f = (value < 0 ? 0x80000000UL : 0) | ((uint32_t)(exponent + 1023) << 20)
+      | ((mantissa >> 11) & 0xFFFFF);
+    buf[0] = CBOR_DOUBLE;
+    buf[1] = f >> 24;
+    buf[2] = f >> 16;
+    buf[3] = f >> 8;
+    buf[4] = f;
+    buf[5] = mantissa >> 3;
+    buf[6] = mantissa << 5;
+    buf[7] = 0;
+    buf[8] = 0;
+    return 9;
+  }
+
+  if(exponent >= -14 && exponent <= 15 && (mantissa & 0x1FFF) == 0) {
+    if(len < 3) {
+      return 0;
+    }
+    f = (value < 0 ? 0x8000 : 0) | ((uint32_t)(exponent + 15) << 10)
+      | ((mantissa >> 13) & 0x3FF);
+    buf[0] = CBOR_HALF;
+    buf[1] = f >> 8;
+    buf[2] = f;
+    return 3;
+  }
+
+  if(len < 5) {
+    return 0;
+  }
+  f = (value < 0 ? 0x80000000UL : 0) | ((uint32_t)(exponent + 127) << 23)
+    | (mantissa & 0x7FFFFF);
+  buf[0] = CBOR_FLOAT;
+  buf[1] = f >> 24;
+  buf[2] = f >> 16;
+  buf[3] = f >> 8;
+  buf[4] = f;
+  return 5;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Starts the record of the current resource up to the label of its value.
+ * The base name goes into the first record of each object instance, the
+ * time into every record when WRITER_TIME is set.
+ */
+static size_t
+start_record(lwm2m_context_t *ctx, uint8_t *buf, size_t len, int label)
+{
+  char name[NAME_LEN];
+  int base_name = (ctx->writer_flags & WRITER_BASE_NAME) != 0;
+  int time = (ctx->writer_flags & WRITER_TIME) != 0;
+  int name_len;
+  size_t n;
+  size_t m;
+
+  if((n = put_head(buf, len, CBOR_MAP, 2 + base_name + time)) == 0) {
+    return 0;
+  }
+  if(base_name) {
+    name_len = snprintf(name, sizeof(name), "/%u/%u/",
+                        ctx->object_id, ctx->object_instance_id);
+    if((m = put_head(&buf[n], len - n, CBOR_NEGATIVE,
+                     -1 - SENML_BASE_NAME)) == 0) {
+      return 0;
+    }
+    n += m;
+    if((m = put_string(&buf[n], len - n, CBOR_TEXT, name, name_len)) == 0) {
+      return 0;
+    }
+    n += m;
+  }
+
+  if(ctx->writer_flags & WRITER_RESOURCE_INSTANCE) {
+    name_len = snprintf(name, sizeof(name), "%u/%u",
+                        ctx->resource_id, ctx->resource_instance_id);
+  } else {
+    name_len = snprintf(name, sizeof(name), "%u", ctx->resource_id);
+  }
+  if((m = put_head(&buf[n], len - n, CBOR_UNSIGNED, SENML_NAME)) == 0) {
+    return 0;
+  }
+  n += m;
+  if((m = put_string(&buf[n], len - n, CBOR_TEXT, name, name_len)) == 0) {
+    return 0;
+  }
+  n += m;
+  if(time) {
+    if((m = put_head(&buf[n], len - n, CBOR_UNSIGNED, SENML_TIME)) == 0) {
+      return 0;
+    }
+    n += m;
+    if((m = put_int(&buf[n], len - n, ctx->time)) == 0) {
+      return 0;
+    }
+    n += m;
+  }
+  if((m = put_head(&buf[n], len - n, CBOR_UNSIGNED, label)) == 0) {
+    return 0;
+  }
+  return n + m;
+}
+/*---------------------------------------------------------------------------*/
+/* Completes a record of n bytes, 0 if the value did not fit */
+static size_t
+end_record(lwm2m_context_t *ctx, size_t n, size_t value_len)
+{
+  if(n == 0 || value_len == 0) {
+    return 0;
+  }
+  ctx->writer_flags &= ~WRITER_BASE_NAME;
+  return n + value_len;
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+init_write(lwm2m_context_t *ctx)
+{
+  lwm2m_buffer_t *outbuf = ctx->outbuf;
+
+  ctx->writer_flags |= WRITER_BASE_NAME;
+  if(ctx->writer_flags & (WRITER_MORE_INSTANCES | WRITER_COMPOSITE)) {
+    /* the pack was opened by an earlier object instance or path */
+    return 0;
+  }
+  if(outbuf->len >= outbuf->size) {
+    return 0;
+  }
+  outbuf->buffer[outbuf->len] = CBOR_ARRAY | CBOR_INDEFINITE_INFO;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+end_write(lwm2m_context_t *ctx)
+{
+  lwm2m_buffer_t *outbuf = ctx->outbuf;
+
+  if(ctx->writer_flags & (WRITER_MORE_INSTANCES | WRITER_COMPOSITE)) {
+    return 0;
+  }
+  if(outbuf->len >= outbuf->size) {
+    return 0;
+  }
+  outbuf->buffer[outbuf->len] = CBOR_BREAK;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+enter_sub(lwm2m_context_t *ctx)
+{
+  ctx->writer_flags |= WRITER_RESOURCE_INSTANCE;
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+exit_sub(lwm2m_context_t *ctx)
+{
+  ctx->writer_flags &= ~WRITER_RESOURCE_INSTANCE;
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+write_int(lwm2m_context_t *ctx, uint8_t *outbuf, size_t outlen,
+          int32_t value)
+{
+  size_t n = start_record(ctx, outbuf, outlen, SENML_VALUE);
+
+  return end_record(ctx, n, n ? put_int(&outbuf[n], outlen - n, value) : 0);
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+write_string(lwm2m_context_t *ctx, uint8_t *outbuf, size_t outlen,
+             const char *value, size_t stringlen)
+{
+  size_t n = start_record(ctx, outbuf, outlen, SENML_STRING);
+
+  return end_record(ctx, n, n ? put_string(&outbuf[n], outlen - n, CBOR_TEXT,
+                                           value, stringlen) : 0);
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+write_float32fix(lwm2m_context_t *ctx, uint8_t *outbuf, size_t outlen,
+                 int32_t value, int bits)
+{
+  size_t n = start_record(ctx, outbuf, outlen, SENML_VALUE);
+
+  return end_record(ctx, n, n ? put_float32fix(&outbuf[n], outlen - n,
+                                               value, bits) : 0);
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+write_boolean(lwm2m_context_t *ctx, uint8_t *outbuf, size_t outlen,
+              int value)
+{
+  size_t n = start_record(ctx, outbuf, outlen, SENML_BOOLEAN);
+
+  if(n == 0 || n >= outlen) {
+    return 0;
+  }
+  outbuf[n] = value ? CBOR_TRUE : CBOR_FALSE;
+  return end_record(ctx, n, 1);
+}
+/*---------------------------------------------------------------------------*/
+/* The opaque data streamed after this becomes the byte string */
+static size_t
+write_opaque_header(lwm2m_context_t *ctx, size_t payloadsize)
+{
+  uint8_t *outbuf = &ctx->outbuf->buffer[ctx->outbuf->len];
+  size_t outlen = ctx->outbuf->size - ctx->outbuf->len;
+  size_t n = start_record(ctx, outbuf, outlen, SENML_DATA);
+
+  return end_record(ctx, n, n ? put_head(&outbuf[n], outlen - n,
+                                         CBOR_BYTES, payloadsize) : 0);
+}
+/*---------------------------------------------------------------------------*/
+const lwm2m_writer_t lwm2m_senml_cbor_writer = {
+  init_write,
+  end_write,
+  enter_sub,
+  exit_sub,
+  write_int,
+  write_string,
+  write_float32fix,
+  write_boolean,
+  write_opaque_header
+};
+/*---------------------------------------------------------------------------*/
+/* Reads the head of a data item, returns its length or 0 if malformed */
+static size_t
+get_head(const uint8_t *buf, size_t len, uint8_t *major, uint32_t *value)
+{
+  uint8_t info;
+  size_t n;
+  size_t i;
+
+  if(len == 0) {
+    return 0;
+  }
+  *major = buf[0] & 0xE0;
+  info = buf[0] & 0x1F;
+  if(info < 24) {
+    *value = info;
+    return 1;
+  }
+  if(info == CBOR_INDEFINITE_INFO) {
+    *value = CBOR_INDEFINITE;
+    return 1;
+  }
+  /* no 64-bit values here, doubles are handled by the callers */
+  n = info == 24 ? 1 : info == 25 ? 2 : info == 26 ? 4 : 0;
+  if(n == 0 || len < 1 + n) {
+    return 0;
+  }
+  *value = 0;
+  for(i = 1; i <= n; i++) {
+    *value = (*value << 8) | buf[i];
+  }
+  return 1 + n;
+}
+/*---------------------------------------------------------------------------*/
+/* Returns the length of the data item at buf, 0 if malformed */
+static size_t
+skip_item(const uint8_t *buf, size_t len, int depth)
+{
+  uint8_t major;
+  uint32_t value;
+  uint32_t items;
+  size_t n;
+  size_t m;
+
+  if(len > 0 && buf[0] == CBOR_DOUBLE) {
+    return len >= 9 ? 9 : 0;
+  }
+  if((n = get_head(buf, len, &major, &value)) == 0) {
+    return 0;
+  }
+  switch(major) {
+  case CBOR_BYTES:
+  case CBOR_TEXT:
+    if(value == CBOR_INDEFINITE || value > len - n) {
+      return 0;
+    }
+    return n + value;
+  case CBOR_ARRAY:
+  case CBOR_MAP:
+    if(depth == 0) {
+      return 0;
+    }
+    if(value == CBOR_INDEFINITE) {
+      while(n < len && buf[n] != CBOR_BREAK) {
+        if((m = skip_item(&buf[n], len - n, depth - 1)) == 0) {
+          return 0;
+        }
+        n += m;
+      }
+      return n < len ? n + 1 : 0;
+    }
+    items = major == CBOR_MAP ? 2 * value : value;
+    while(items-- > 0) {
+      if((m = skip_item(&buf[n], len - n, depth - 1)) == 0) {
+        return 0;
+      }
+      n += m;
+    }
+    return n;
+  default:
+    /* integers, simple values and floats */
+    return value == CBOR_INDEFINITE ? 0 : n;
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Gets the contents of a text or byte string */
+static int
+get_string(const uint8_t *buf, size_t len, const uint8_t **value,
+           uint32_t *value_len)
+{
+  uint8_t major;
+  size_t n;
+
+  if((n = get_head(buf, len, &major, value_len)) == 0
+     || (major != CBOR_TEXT && major != CBOR_BYTES)
+     || *value_len == CBOR_INDEFINITE || *value_len > len - n) {
+    return 0;
+  }
+  *value = &buf[n];
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+/* Reads an integer or float as a fixed point value with the given bits */
+static size_t
+get_number(const uint8_t *buf, size_t len, int32_t *value, int bits)
+{
+  uint64_t mantissa;
+  uint64_t limit;
+  uint32_t head;
+  uint8_t major;
+  int exponent;
+  int negative;
+  int shift;
+  size_t n;
+
+  if(len >= 3 && buf[0] == CBOR_HALF) {
+    head = ((uint32_t)buf[1] << 8) | buf[2];
+    negative = head >> 15;
+    exponent = (head >> 10) & 0x1F;
+    mantissa = head & 0x3FF;
+    if(exponent == 0x1F) {
+      return 0;
+    }
+    shift = (exponent ? exponent : 1) - 15 - 10 + bits;
+    mantissa |= exponent ? 0x400 : 0;
+    n = 3;
+  } else if(len >= 5 && buf[0] == CBOR_FLOAT) {
+    head = ((uint32_t)buf[1] << 24) | ((uint32_t)buf[2] << 16)
+      | ((uint32_t)buf[3] << 8) | buf[4];
+    negative = head >> 31;
+    exponent = (head >> 23) & 0xFF;
+    mantissa = head & 0x7FFFFF;
+    if(exponent == 0xFF) {
+      return 0;
+    }
+    shift = (exponent ? exponent : 1) - 127 - 23 + bits;
+    mantissa |= exponent ? 0x800000 : 0;
+    n = 5;
+  } else if(len >= 9 && buf[0] == CBOR_DOUBLE) {
+    negative = buf[1] >> 7;
+    exponent = ((buf[1] & 0x7F) << 4) | (buf[2] >> 4);
+    mantissa = buf[2] & 0x0F;
+    for(n = 3; n < 9; n++) {
+      mantissa = (mantissa << 8) | buf[n];
+    }
+    if(exponent == 0x7FF) {
+      return 0;
+    }
+    shift = (exponent ? exponent : 1) - 1023 - 52 + bits;
+    mantissa |= exponent ? (uint64_t)1 << 52 : 0;
+  } else {
+    if((n = get_head(buf, len, &major, &head)) == 0
+       || (major != CBOR_UNSIGNED && major != CBOR_NEGATIVE)
+       || head == CBOR_INDEFINITE) {
+      return 0;
+    }
+    negative = major == CBOR_NEGATIVE;
+    /* -1 - head, as -(head + 1) */
+    mantissa = (uint64_t)head + negative;
+    shift = bits;
+  }
+
+  /* the magnitude of INT32_MIN is one more than that of INT32_MAX */
+  limit = negative ? (uint64_t)INT32_MAX + 1 : INT32_MAX;
+  if(shift >= 0) {
+    if(shift > 31 || mantissa > (limit >> shift)) {
+      mantissa = limit;
+    } else {
+      mantissa <<= shift;
+    }
+  } else {
+    mantissa = -shift >= 64 ? 0 : mantissa >> -shift;
+    if(mantissa > limit) {
+      mantissa = limit;
+    }
+  }
+  *value = negative ? (int32_t)(0 - (uint32_t)mantissa) : (int32_t)mantissa;
+  return n;
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+read_int(lwm2m_context_t *ctx, const uint8_t *inbuf, size_t len,
+         int32_t *value)
+{
+  size_t n = get_number(inbuf, len, value, 0);
+
+  ctx->last_value_len = n;
+  return n;
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+read_string(lwm2m_context_t *ctx, const uint8_t *inbuf, size_t len,
+            uint8_t *value, size_t stringlen)
+{
+  const uint8_t *string;
+  uint32_t string_len;
+
+  if(!get_string(inbuf, len, &string, &string_len)
+     || stringlen <= string_len) {
+    /* The outbuffer can not contain the full string including ending zero */
+    return 0;
+  }
+  memcpy(value, string, string_len);
+  value[string_len] = '\0';
+  ctx->last_value_len = string_len;
+  return string_len;
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+read_float32fix(lwm2m_context_t *ctx, const uint8_t *inbuf, size_t len,
+                int32_t *value, int bits)
+{
+  size_t n = get_number(inbuf, len, value, bits);
+
+  ctx->last_value_len = n;
+  return n;
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+read_boolean(lwm2m_context_t *ctx, const uint8_t *inbuf, size_t len,
+             int *value)
+{
+  if(len > 0 && (*inbuf == CBOR_TRUE || *inbuf == CBOR_FALSE)) {
+    *value = *inbuf == CBOR_TRUE;
+    ctx->last_value_len = 1;
+    return 1;
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+const lwm2m_reader_t lwm2m_senml_cbor_reader = {
+  read_int,
+  read_string,
+  read_float32fix,
+  read_boolean
+};
+/*---------------------------------------------------------------------------*/
+static int
+next_record(lwm2m_context_t *ctx, lwm2m_senml_cbor_record_t *record,
+            int with_value)
+{
+  const uint8_t *buf = ctx->inbuf->buffer;
+  size_t len = ctx->inbuf->size;
+  size_t pos = ctx->inbuf->pos;
+  const uint8_t *string;
+  uint32_t string_len;
+  uint32_t count;
+  uint32_t label_value;
+  uint8_t major;
+  int indefinite;
+  int named;
+  int label;
+  size_t n;
+
+  if(pos == 0) {
+    /* the records are in an array */
+    if((n = get_head(buf, len, &major, &count)) == 0 || major != CBOR_ARRAY) {
+      LOG_DBG("not a SenML pack\n");
+      return 0;
+    }
+    pos = n;
+  }
+
+  while(pos < len && buf[pos] != CBOR_BREAK) {
+    if((n = get_head(&buf[pos], len - pos, &major, &count)) == 0
+       || major != CBOR_MAP) {
+      LOG_DBG("malformed record at %u\n", (unsigned)pos);
+      return 0;
+    }
+    pos += n;
+    indefinite = count == CBOR_INDEFINITE;
+    record->name = NULL;
+    record->name_len = 0;
+    record->value = NULL;
+    record->value_len = 0;
+    named = 0;
+
+    while(indefinite ? pos < len && buf[pos] != CBOR_BREAK : count-- > 0) {
+      label = 256;
+      if((n = get_head(&buf[pos], len - pos, &major, &label_value)) == 0) {
+        return 0;
+      }
+      if(major == CBOR_UNSIGNED && label_value < 256) {
+        label = label_value;
+      } else if(major == CBOR_NEGATIVE && label_value < 256) {
+        label = -1 - (int)label_value;
+      } else if((n = skip_item(&buf[pos], len - pos, MAX_DEPTH)) == 0) {
+        return 0;
+      }
+      pos += n;
+
+      if((n = skip_item(&buf[pos], len - pos, MAX_DEPTH)) == 0) {
+        return 0;
+      }
+      switch(label) {
+      case SENML_BASE_NAME:
+      case SENML_NAME:
+        if(!get_string(&buf[pos], n, &string, &string_len)
+           || string_len > 0xFF) {
+          return 0;
+        }
+        named = 1;
+        if(label == SENML_NAME) {
+          record->name = string;
+          record->name_len = string_len;
+        } else {
+          record->base_name = string;
+          record->base_name_len = string_len;
+        }
+        break;
+      case SENML_VALUE:
+      case SENML_STRING:
+      case SENML_BOOLEAN:
+      case SENML_DATA:
+        record->value = &buf[pos];
+        record->value_len = n;
+        break;
+      default:
+        /* e.g. times and units, of no use here */
+        break;
+      }
+      pos += n;
+    }
+    if(indefinite) {
+      pos++;
+    }
+
+    if(with_value ? record->value != NULL
+       : named) {
+      ctx->inbuf->pos = pos;
+      return 1;
+    }
+  }
+  ctx->inbuf->pos = pos;
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+int
+lwm2m_senml_cbor_next_record(lwm2m_context_t *ctx,
+                             lwm2m_senml_cbor_record_t *record)
+{
+  return next_record(ctx, record, 1);
+}
+/*---------------------------------------------------------------------------*/
+int
+lwm2m_senml_cbor_next_path(lwm2m_context_t *ctx,
+                           lwm2m_senml_cbor_record_t *record)
+{
+  return next_record(ctx, record, 0);
+}
+/*---------------------------------------------------------------------------*/
+/** @} */
@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2026, Contiki-NG contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \addtogroup lwm2m
+ * @{
+ */
+
+/**
+ * \file
+ *         Header file for the Contiki OMA LWM2M SenML-CBOR reader and writer
+ */
+
+#ifndef LWM2M_SENML_CBOR_H_
+#define LWM2M_SENML_CBOR_H_
+
+#include "lwm2m-object.h"
+
+/* A record of a SenML pack, the base name is kept from record to record */
+typedef struct {
+  const uint8_t *base_name;
+  const uint8_t *name;
+  const uint8_t *value;
+  uint16_t value_len;
+  uint8_t base_name_len;
+  uint8_t name_len;
+} lwm2m_senml_cbor_record_t;
+
+extern const lwm2m_writer_t lwm2m_senml_cbor_writer;
+extern const lwm2m_reader_t lwm2m_senml_cbor_reader;
+
+/*
+ * Steps to the next record of the pack in ctx->inbuf, starting at its
+ * position. Returns 1 when a record with a value was found.
+ */
+int lwm2m_senml_cbor_next_record(lwm2m_context_t *ctx,
+                                 lwm2m_senml_cbor_record_t *record);
+
+/*
+ * Steps to the next record with a name or base name, as in the paths of a
+ * composite operation, which have no values.
+ */
+int lwm2m_senml_cbor_next_path(lwm2m_context_t *ctx,
+                               lwm2m_senml_cbor_record_t *record);
+
+#endif /* LWM2M_SENML_CBOR_H_ */
+/** @} */
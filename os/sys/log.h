@@ -83,6 +83,7 @@ extern int curr_log_level_framer;
 extern int curr_log_level_6top;
 extern int curr_log_level_coap;
 extern int curr_log_level_lwm2m;
+extern int curr_log_level_mqtt_sn;
 extern int curr_log_level_main;
 
 extern struct log_module all_modules[];
@@ -97,6 +98,7 @@ extern struct log_module all_modules[];
 #define LOG_LEVEL_6TOP                        MIN((LOG_CONF_LEVEL_6TOP), curr_log_level_6top)
 #define LOG_LEVEL_COAP                        MIN((LOG_CONF_LEVEL_COAP), curr_log_level_coap)
 #define LOG_LEVEL_LWM2M                       MIN((LOG_CONF_LEVEL_LWM2M), curr_log_level_lwm2m)
+#define LOG_LEVEL_MQTT_SN                     MIN((LOG_CONF_LEVEL_MQTT_SN), curr_log_level_mqtt_sn)
 #define LOG_LEVEL_MAIN                        MIN((LOG_CONF_LEVEL_MAIN), curr_log_level_main)
 
 /* Main log function */
@@ -0,0 +1,58 @@
+#!/bin/bash
+source ../utils.sh
+
+# Contiki directory
+CONTIKI=$1
+
+# Example code directory
+CODE_DIR=$CONTIKI/examples/platform-specific/native/rpl-convergence/
+CODE=rpl-convergence
+TEST=rpl-storing-dao-aggregation
+
+# Counts the DAOs sent and forwarded by all nodes of a run
+count_daos() {
+  grep -c "Sending a DAO with\|Sending a No-Path DAO with\|Forwarding DAO\|Forwarding No-path DAO\|Sending an aggregated DAO with" $1
+}
+
+# Runs a storing-mode network of native nodes, with and without DAO aggregation
+FAIL=0
+for AGGREGATION in 0 1; do
+  echo "Starting native nodes, DAO aggregation $AGGREGATION"
+  make -C $CODE_DIR TARGET=native clean > /dev/null 2>&1
+  make -C $CODE_DIR TARGET=native MAKE_ROUTING=MAKE_ROUTING_RPL_CLASSIC \
+    DEFINES=RPL_CONF_DAO_AGGREGATION=$AGGREGATION,LOG_CONF_LEVEL_RPL=LOG_LEVEL_DBG \
+    > make.log 2> make.err
+  timeout 120 $CODE_DIR/$CODE.native > $TEST-$AGGREGATION.log 2> $TEST.err
+  if ! grep -q "Converged" $TEST-$AGGREGATION.log ; then
+    echo "==== make.log ====" ; cat make.log;
+    echo "==== make.err ====" ; cat make.err;
+    echo "==== $TEST.err ====" ; cat $TEST.err;
+    tail -20 $TEST-$AGGREGATION.log
+    FAIL=1
+  fi
+done
+make -C $CODE_DIR TARGET=native clean > /dev/null 2>&1
+
+DAOS=$(count_daos $TEST-0.log)
+AGGREGATED_DAOS=$(count_daos $TEST-1.log)
+echo "DAOs until convergence: $DAOS, with aggregation: $AGGREGATED_DAOS"
+if [ $AGGREGATED_DAOS -eq 0 ] || [ $AGGREGATED_DAOS -ge $DAOS ] || \
+   ! grep -q "Sending an aggregated DAO" $TEST-1.log ; then
+  FAIL=1
+fi
+
+if [ $FAIL -ne 0 ] ; then
+  printf "%-32s TEST FAIL\n" "$TEST" | tee $TEST.testlog;
+else
+  printf "%-32s TEST OK\n" "$TEST" | tee $TEST.testlog;
+fi
+
+rm make.log
+rm make.err
+rm $TEST-0.log
+rm $TEST-1.log
+rm $TEST.err
+
+# We do not want Make to stop -> Return 0
+# The Makefile will check if a log contains FAIL at the end
+exit 0
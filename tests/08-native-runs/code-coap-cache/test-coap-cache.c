@@ -0,0 +1,209 @@
+/*
+ * Copyright (c) 2026, Contiki-NG contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ */
+/*---------------------------------------------------------------------------*/
+#include "contiki.h"
+#include "coap.h"
+#include "coap-cache.h"
+#include "services/unit-test/unit-test.h"
+
+#include <string.h>
+#include <stdio.h>
+/*---------------------------------------------------------------------------*/
+PROCESS(coap_cache_test_process, "CoAP cache test");
+AUTOSTART_PROCESSES(&coap_cache_test_process);
+/*---------------------------------------------------------------------------*/
+static coap_endpoint_t server;
+static coap_message_t request[1];
+static coap_message_t response[1];
+static coap_message_t cached[1];
+static const uint8_t etag[] = { 0xe1, 0x7a, 0x90, 0x3b };
+static const uint8_t other_etag[] = { 0x01, 0x02, 0x03, 0x04 };
+/*---------------------------------------------------------------------------*/
+void
+print_test_report(const unit_test_t *utp)
+{
+  printf("=check-me= ");
+  if(utp->result == unit_test_failure) {
+    printf("FAILED   - %s: exit at L%u\n", utp->descr, utp->exit_line);
+  } else {
+    printf("SUCCEEDED - %s\n", utp->descr);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+make_request(const char *path)
+{
+  coap_init_message(request, COAP_TYPE_CON, COAP_GET, 0);
+  coap_set_header_uri_path(request, path);
+}
+/*---------------------------------------------------------------------------*/
+static void
+make_response(uint8_t code, uint32_t max_age, const uint8_t *tag,
+              const char *payload)
+{
+  coap_init_message(response, COAP_TYPE_ACK, code, 0);
+  coap_set_header_max_age(response, max_age);
+  if(tag != NULL) {
+    coap_set_header_etag(response, tag, sizeof(etag));
+  }
+  if(payload != NULL) {
+    coap_set_header_content_format(response, TEXT_PLAIN);
+    coap_set_payload(response, payload, strlen(payload));
+  }
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_fresh, "Fresh response");
+UNIT_TEST(test_fresh)
+{
+  unsigned int format;
+
+  UNIT_TEST_BEGIN();
+
+  coap_cache_flush();
+  make_request("fresh");
+  UNIT_TEST_ASSERT(coap_cache_lookup(&server, request) == COAP_CACHE_MISS);
+
+  make_response(CONTENT_2_05, 60, NULL, "22.5");
+  UNIT_TEST_ASSERT(coap_cache_response(&server, request, response) == response);
+
+  make_request("fresh");
+  UNIT_TEST_ASSERT(coap_cache_lookup(&server, request) == COAP_CACHE_FRESH);
+  UNIT_TEST_ASSERT(coap_cache_get(&server, request, cached));
+  UNIT_TEST_ASSERT(cached->code == CONTENT_2_05);
+  UNIT_TEST_ASSERT(cached->payload_len == 4);
+  UNIT_TEST_ASSERT(memcmp(cached->payload, "22.5", 4) == 0);
+  UNIT_TEST_ASSERT(coap_get_header_content_format(cached, &format));
+  UNIT_TEST_ASSERT(format == TEXT_PLAIN);
+
+  /* other resources are not answered */
+  make_request("other");
+  UNIT_TEST_ASSERT(coap_cache_lookup(&server, request) == COAP_CACHE_MISS);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_stale, "Stale response and 2.03 Valid");
+UNIT_TEST(test_stale)
+{
+  const uint8_t *tag;
+  coap_message_t *result;
+  uint32_t revalidations;
+
+  UNIT_TEST_BEGIN();
+
+  coap_cache_flush();
+  revalidations = coap_cache_get_stats()->revalidations;
+
+  /* expires right away, but can be revalidated with its ETag */
+  make_request("stale");
+  make_response(CONTENT_2_05, 0, etag, "on");
+  coap_cache_response(&server, request, response);
+
+  make_request("stale");
+  UNIT_TEST_ASSERT(coap_cache_lookup(&server, request) == COAP_CACHE_STALE);
+  UNIT_TEST_ASSERT(coap_get_header_etag(request, &tag) == sizeof(etag));
+  UNIT_TEST_ASSERT(memcmp(tag, etag, sizeof(etag)) == 0);
+
+  /* a 2.03 for another ETag does not confirm the cached response */
+  make_response(VALID_2_03, 60, other_etag, NULL);
+  UNIT_TEST_ASSERT(coap_cache_response(&server, request, response) == response);
+  make_request("stale");
+  UNIT_TEST_ASSERT(coap_cache_lookup(&server, request) == COAP_CACHE_STALE);
+
+  /* the 2.03 for the cached ETag is replaced by the cached response */
+  make_response(VALID_2_03, 60, etag, NULL);
+  result = coap_cache_response(&server, request, response);
+  UNIT_TEST_ASSERT(result != response);
+  UNIT_TEST_ASSERT(result->code == CONTENT_2_05);
+  UNIT_TEST_ASSERT(result->payload_len == 2);
+  UNIT_TEST_ASSERT(memcmp(result->payload, "on", 2) == 0);
+  UNIT_TEST_ASSERT(coap_cache_get_stats()->revalidations == revalidations + 1);
+
+  /* and fresh again for the new Max-Age */
+  make_request("stale");
+  UNIT_TEST_ASSERT(coap_cache_lookup(&server, request) == COAP_CACHE_FRESH);
+
+  /* without an ETag, an expired response is dropped */
+  make_request("expired");
+  make_response(CONTENT_2_05, 0, NULL, "off");
+  coap_cache_response(&server, request, response);
+  make_request("expired");
+  UNIT_TEST_ASSERT(coap_cache_lookup(&server, request) == COAP_CACHE_MISS);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_observe, "Observe requests bypass the cache");
+UNIT_TEST(test_observe)
+{
+  UNIT_TEST_BEGIN();
+
+  coap_cache_flush();
+
+  /* a cached response does not answer a registration */
+  make_request("sensor");
+  make_response(CONTENT_2_05, 60, etag, "21.0");
+  coap_cache_response(&server, request, response);
+  make_request("sensor");
+  coap_set_header_observe(request, 0);
+  UNIT_TEST_ASSERT(coap_cache_lookup(&server, request) == COAP_CACHE_MISS);
+  UNIT_TEST_ASSERT(!coap_is_option(request, COAP_OPTION_ETAG));
+
+  /* and notifications are not stored */
+  coap_cache_flush();
+  make_response(CONTENT_2_05, 60, etag, "21.5");
+  coap_set_header_observe(response, 7);
+  UNIT_TEST_ASSERT(coap_cache_response(&server, request, response) == response);
+  make_request("sensor");
+  UNIT_TEST_ASSERT(coap_cache_lookup(&server, request) == COAP_CACHE_MISS);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(coap_cache_test_process, ev, data)
+{
+  PROCESS_BEGIN();
+
+  printf("Run unit-test\n");
+  printf("---\n");
+
+  coap_endpoint_parse("coap://[fd00::1]", strlen("coap://[fd00::1]"), &server);
+
+  UNIT_TEST_RUN(test_fresh);
+  UNIT_TEST_RUN(test_stale);
+  UNIT_TEST_RUN(test_observe);
+
+  printf("=check-me= DONE\n");
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,559 @@
+/*
+ * Copyright (c) 2026, Contiki-NG contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ */
+/*---------------------------------------------------------------------------*/
+#include "contiki.h"
+#include "net/netstack.h"
+#include "net/ipv6/uip.h"
+#include "net/ipv6/uip-ds6.h"
+#include "net/ipv6/uip-ds6-nbr.h"
+#include "coap.h"
+#include "coap-engine.h"
+#include "coap-tcp.h"
+#include "services/unit-test/unit-test.h"
+
+#include <string.h>
+#include <stdio.h>
+/*---------------------------------------------------------------------------*/
+PROCESS(coap_tcp_test_process, "CoAP over TCP test");
+AUTOSTART_PROCESSES(&coap_tcp_test_process);
+/*---------------------------------------------------------------------------*/
+#define UIP_IP_BUF  ((struct uip_ip_hdr *)&uip_buf[UIP_LLH_LEN])
+#define UIP_TCP_BUF ((struct uip_tcp_hdr *)&uip_buf[UIP_LLH_LEN + UIP_IPH_LEN])
+
+#define TCP_FLAG_FIN 0x01
+#define TCP_FLAG_SYN 0x02
+#define TCP_FLAG_ACK 0x10
+
+#define PEER_PORT 40000
+
+/* Size of the messages larger than the default Max-Message-Size */
+#define LARGE_PAYLOAD_LEN COAP_MAX_CHUNK_SIZE
+
+/* The test is the TCP peer of the node, at fe80::2 */
+static uip_ipaddr_t peer_addr;
+static uint32_t snd_nxt;
+static uint32_t rcv_nxt;
+static uint8_t need_ack;
+static uint8_t syn_received;
+static uint8_t fin_received;
+
+/* What the node sent, and how much of it has been looked at */
+static uint8_t stream[4096];
+static uint16_t stream_len;
+static uint16_t stream_pos;
+
+static uint8_t frame[1400];
+static uint8_t large_payload[LARGE_PAYLOAD_LEN];
+
+/* A frame received from the node */
+typedef struct {
+  uint8_t code;
+  uint8_t token_len;
+  const uint8_t *token;
+  const uint8_t *payload;
+  uint16_t payload_len;
+} test_frame_t;
+
+static test_frame_t csm;
+static uint32_t csm_max_message_size;
+static test_frame_t responses[6];
+static int response_count;
+static int connected_before_close;
+static int connected_after_close;
+/*---------------------------------------------------------------------------*/
+void
+print_test_report(const unit_test_t *utp)
+{
+  printf("=check-me= ");
+  if(utp->result == unit_test_failure) {
+    printf("FAILED   - %s: exit at L%u\n", utp->descr, utp->exit_line);
+  } else {
+    printf("SUCCEEDED - %s\n", utp->descr);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static uint32_t
+get32(const uint8_t *p)
+{
+  return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | (p[2] << 8) | p[3];
+}
+/*---------------------------------------------------------------------------*/
+static void
+put32(uint8_t *p, uint32_t v)
+{
+  p[0] = v >> 24;
+  p[1] = v >> 16;
+  p[2] = v >> 8;
+  p[3] = v;
+}
+/*---------------------------------------------------------------------------*/
+static void
+net_init(void)
+{
+}
+/*---------------------------------------------------------------------------*/
+static void
+net_input(void)
+{
+}
+/*---------------------------------------------------------------------------*/
+/* Receives the segments the node sends to the peer */
+static uint8_t
+net_output(const linkaddr_t *localdest)
+{
+  struct uip_tcp_hdr *tcp = UIP_TCP_BUF;
+  const uint8_t *data;
+  uint32_t seq;
+  int len;
+
+  if(uip_len < UIP_IPTCPH_LEN || UIP_IP_BUF->proto != UIP_PROTO_TCP
+     || tcp->destport != UIP_HTONS(PEER_PORT)) {
+    return 1;
+  }
+  seq = get32(tcp->seqno);
+  data = &uip_buf[UIP_LLH_LEN + UIP_IPH_LEN + (tcp->tcpoffset >> 4) * 4];
+  len = &uip_buf[UIP_LLH_LEN + uip_len] - data;
+
+  if(tcp->flags & TCP_FLAG_SYN) {
+    rcv_nxt = seq + 1;
+    syn_received = 1;
+    need_ack = 1;
+    return 1;
+  }
+  if(len > 0) {
+    /* anything else is a retransmission */
+    if(seq == rcv_nxt && stream_len + len <= sizeof(stream)) {
+      memcpy(&stream[stream_len], data, len);
+      stream_len += len;
+      rcv_nxt += len;
+    }
+    need_ack = 1;
+  }
+  if((tcp->flags & TCP_FLAG_FIN) && seq + len == rcv_nxt) {
+    rcv_nxt++;
+    fin_received = 1;
+    need_ack = 1;
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+const struct network_driver test_net_driver = {
+  "test",
+  net_init,
+  net_input,
+  net_output
+};
+/*---------------------------------------------------------------------------*/
+/* Passes a segment from the peer to the node */
+static void
+send_segment(uint8_t flags, const uint8_t *data, uint16_t len)
+{
+  struct uip_ip_hdr *ip = UIP_IP_BUF;
+  struct uip_tcp_hdr *tcp = UIP_TCP_BUF;
+  /* uIP takes the MSS from the SYN */
+  int header_len = UIP_TCPH_LEN + ((flags & TCP_FLAG_SYN) ? 4 : 0);
+
+  memset(ip, 0, UIP_IPH_LEN + header_len);
+  ip->vtc = 0x60;
+  ip->len[0] = (header_len + len) >> 8;
+  ip->len[1] = header_len + len;
+  ip->proto = UIP_PROTO_TCP;
+  ip->ttl = 64;
+  uip_ipaddr_copy(&ip->srcipaddr, &peer_addr);
+  uip_ipaddr_copy(&ip->destipaddr, &uip_ds6_get_link_local(-1)->ipaddr);
+
+  tcp->srcport = UIP_HTONS(PEER_PORT);
+  tcp->destport = UIP_HTONS(COAP_DEFAULT_PORT);
+  put32(tcp->seqno, snd_nxt);
+  put32(tcp->ackno, (flags & TCP_FLAG_ACK) ? rcv_nxt : 0);
+  tcp->tcpoffset = (header_len / 4) << 4;
+  tcp->flags = flags;
+  tcp->wnd[0] = sizeof(stream) >> 8;
+  tcp->wnd[1] = sizeof(stream) & 0xff;
+  if(flags & TCP_FLAG_SYN) {
+    tcp->optdata[0] = 2;
+    tcp->optdata[1] = 4;
+    tcp->optdata[2] = UIP_TCP_MSS >> 8;
+    tcp->optdata[3] = UIP_TCP_MSS & 0xff;
+  }
+  memcpy(&uip_buf[UIP_LLH_LEN + UIP_IPH_LEN + header_len], data, len);
+
+  uip_len = UIP_IPH_LEN + header_len + len;
+  uip_ext_len = 0;
+  tcp->tcpchksum = ~uip_tcpchksum();
+
+  snd_nxt += len + ((flags & (TCP_FLAG_SYN | TCP_FLAG_FIN)) ? 1 : 0);
+  need_ack = 0;
+  tcpip_input();
+}
+/*---------------------------------------------------------------------------*/
+/* Frames a request, the path is one or two segments */
+static int
+put_request(uint8_t *buf, uint8_t code, uint8_t token, const char *path,
+            const uint8_t *payload, uint16_t payload_len)
+{
+  uint8_t options[32];
+  uint16_t options_len = 0;
+  uint8_t delta = COAP_OPTION_URI_PATH;
+  const char *segment;
+  uint16_t length;
+  int n = 0;
+
+  while(*path != '\0') {
+    segment = path;
+    while(*path != '\0' && *path != '/') {
+      path++;
+    }
+    options[options_len++] = (delta << 4) | (path - segment);
+    memcpy(&options[options_len], segment, path - segment);
+    options_len += path - segment;
+    delta = 0;
+    if(*path == '/') {
+      path++;
+    }
+  }
+
+  length = options_len + (payload_len > 0 ? 1 + payload_len : 0);
+  if(length < 13) {
+    buf[n++] = length << 4 | 1;
+  } else if(length < 269) {
+    buf[n++] = 13 << 4 | 1;
+    buf[n++] = length - 13;
+  } else {
+    buf[n++] = 14 << 4 | 1;
+    buf[n++] = (length - 269) >> 8;
+    buf[n++] = length - 269;
+  }
+  buf[n++] = code;
+  buf[n++] = token;
+  memcpy(&buf[n], options, options_len);
+  n += options_len;
+  if(payload_len > 0) {
+    buf[n++] = 0xff;
+    memcpy(&buf[n], payload, payload_len);
+    n += payload_len;
+  }
+  return n;
+}
+/*---------------------------------------------------------------------------*/
+/* Takes the next complete frame the node sent, returns 0 if there is none */
+static int
+next_frame(test_frame_t *f)
+{
+  const uint8_t *p = &stream[stream_pos];
+  const uint8_t *end;
+  uint16_t available = stream_len - stream_pos;
+  uint8_t nibble;
+  int ext;
+  uint32_t length;
+  unsigned int option_len;
+
+  if(available < 2) {
+    return 0;
+  }
+  nibble = p[0] >> 4;
+  ext = nibble < 13 ? 0 : nibble == 13 ? 1 : 2;
+  if(available < 2 + ext) {
+    return 0;
+  }
+  length = nibble < 13 ? nibble : nibble == 13 ? 13 + p[1]
+    : 269 + ((p[1] << 8) | p[2]);
+  f->token_len = p[0] & 0x0f;
+  if(available < 2 + ext + f->token_len + length) {
+    return 0;
+  }
+  f->code = p[1 + ext];
+  f->token = &p[2 + ext];
+  f->payload = NULL;
+  f->payload_len = 0;
+
+  /* find the payload marker behind the options */
+  p = f->token + f->token_len;
+  end = p + length;
+  while(p < end) {
+    if(*p == 0xff) {
+      f->payload = p + 1;
+      f->payload_len = end - f->payload;
+      break;
+    }
+    option_len = *p & 0x0f;
+    p += 1 + ((*p >> 4) == 13 ? 1 : (*p >> 4) == 14 ? 2 : 0);
+    if(option_len == 13) {
+      option_len = 13 + *p++;
+    } else if(option_len == 14) {
+      option_len = 269 + ((p[0] << 8) | p[1]);
+      p += 2;
+    }
+    p += option_len;
+  }
+  stream_pos = end - stream;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static void
+res_hello_get_handler(coap_message_t *request, coap_message_t *response,
+                      uint8_t *buffer, uint16_t preferred_size,
+                      int32_t *offset)
+{
+  coap_set_payload(response, "hello", 5);
+}
+/*---------------------------------------------------------------------------*/
+static void
+res_large_get_handler(coap_message_t *request, coap_message_t *response,
+                      uint8_t *buffer, uint16_t preferred_size,
+                      int32_t *offset)
+{
+  coap_set_payload(response, large_payload, sizeof(large_payload));
+}
+/*---------------------------------------------------------------------------*/
+/* Answers with the length of the payload if it is the large one */
+static void
+res_large_post_handler(coap_message_t *request, coap_message_t *response,
+                       uint8_t *buffer, uint16_t preferred_size,
+                       int32_t *offset)
+{
+  const uint8_t *payload;
+  int len = coap_get_payload(request, &payload);
+
+  if(len != sizeof(large_payload)
+     || memcmp(payload, large_payload, len) != 0) {
+    coap_set_status_code(response, BAD_REQUEST_4_00);
+    return;
+  }
+  coap_set_status_code(response, CHANGED_2_04);
+  coap_set_payload(response, buffer, snprintf((char *)buffer, preferred_size,
+                                              "%d", len));
+}
+/*---------------------------------------------------------------------------*/
+RESOURCE(res_hello, "", res_hello_get_handler, NULL, NULL, NULL);
+RESOURCE(res_large, "", res_large_get_handler, res_large_post_handler,
+         NULL, NULL);
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_csm, "CSM exchange");
+UNIT_TEST(test_csm)
+{
+  UNIT_TEST_BEGIN();
+
+  UNIT_TEST_ASSERT(syn_received);
+  /* the CSM is the first message of the node */
+  UNIT_TEST_ASSERT(csm.code == COAP_SIGNAL_CSM);
+  UNIT_TEST_ASSERT(csm.token_len == 0);
+  UNIT_TEST_ASSERT(csm_max_message_size == COAP_TCP_MAX_MESSAGE_SIZE);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_request, "Request and response");
+UNIT_TEST(test_request)
+{
+  UNIT_TEST_BEGIN();
+
+  UNIT_TEST_ASSERT(response_count >= 1);
+  UNIT_TEST_ASSERT(responses[0].code == CONTENT_2_05);
+  UNIT_TEST_ASSERT(responses[0].token_len == 1);
+  UNIT_TEST_ASSERT(responses[0].token[0] == 0x10);
+  UNIT_TEST_ASSERT(responses[0].payload_len == 5);
+  UNIT_TEST_ASSERT(memcmp(responses[0].payload, "hello", 5) == 0);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_split, "Frames split across and sharing segments");
+UNIT_TEST(test_split)
+{
+  int i;
+
+  UNIT_TEST_BEGIN();
+
+  /* one request in three segments, then two in one segment */
+  UNIT_TEST_ASSERT(response_count >= 4);
+  for(i = 1; i < 4; i++) {
+    UNIT_TEST_ASSERT(responses[i].code == CONTENT_2_05);
+    UNIT_TEST_ASSERT(responses[i].token_len == 1);
+    UNIT_TEST_ASSERT(responses[i].token[0] == 0x10 + i);
+    UNIT_TEST_ASSERT(responses[i].payload_len == 5);
+  }
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_large, "Frames above the default Max-Message-Size");
+UNIT_TEST(test_large)
+{
+  UNIT_TEST_BEGIN();
+
+  UNIT_TEST_ASSERT(response_count == 6);
+
+  /* received in several segments */
+  UNIT_TEST_ASSERT(responses[4].code == CHANGED_2_04);
+  UNIT_TEST_ASSERT(responses[4].token[0] == 0x14);
+  UNIT_TEST_ASSERT(responses[4].payload_len == 4);
+  UNIT_TEST_ASSERT(memcmp(responses[4].payload, "1160", 4) == 0);
+
+  /* sent, as the CSM of the peer allows it */
+  UNIT_TEST_ASSERT(responses[5].code == CONTENT_2_05);
+  UNIT_TEST_ASSERT(responses[5].token[0] == 0x15);
+  UNIT_TEST_ASSERT(responses[5].payload_len == sizeof(large_payload));
+  UNIT_TEST_ASSERT(memcmp(responses[5].payload, large_payload,
+                          sizeof(large_payload)) == 0);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_disconnect, "Connection state and disconnect");
+UNIT_TEST(test_disconnect)
+{
+  UNIT_TEST_BEGIN();
+
+  UNIT_TEST_ASSERT(connected_before_close);
+  UNIT_TEST_ASSERT(fin_received);
+  UNIT_TEST_ASSERT(!connected_after_close);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+/* Lets the node run, acknowledging what it sends */
+#define RUN_NODE()                                          \
+  do {                                                      \
+    if(need_ack) {                                          \
+      send_segment(TCP_FLAG_ACK, NULL, 0);                  \
+    }                                                       \
+    etimer_set(&et, CLOCK_SECOND / 10);                     \
+    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));          \
+  } while(need_ack)
+
+/* Sends part of a frame as a segment of its own */
+#define SEND_NODE(data, len)                                \
+  do {                                                      \
+    send_segment(TCP_FLAG_ACK, (data), (len));              \
+    RUN_NODE();                                             \
+  } while(0)
+
+PROCESS_THREAD(coap_tcp_test_process, ev, data)
+{
+  static struct etimer et;
+  static coap_endpoint_t peer;
+  static int len;
+  static int i;
+  const uint8_t *option;
+  uip_lladdr_t peer_lladdr;
+
+  PROCESS_BEGIN();
+
+  printf("Run unit-test\n");
+  printf("---\n");
+
+  for(i = 0; i < sizeof(large_payload); i++) {
+    large_payload[i] = i;
+  }
+  uip_ip6addr(&peer_addr, 0xfe80, 0, 0, 0, 0, 0, 0, 2);
+  /* no neighbor discovery with the peer */
+  uip_ds6_set_lladdr_from_iid(&peer_lladdr, &peer_addr);
+  uip_ds6_nbr_add(&peer_addr, &peer_lladdr, 0, NBR_REACHABLE,
+                  NBR_TABLE_REASON_UNDEFINED, NULL);
+  coap_endpoint_parse("coap+tcp://[fe80::2]:40000",
+                      strlen("coap+tcp://[fe80::2]:40000"), &peer);
+
+  coap_engine_init();
+  coap_activate_resource(&res_hello, "test/hello");
+  coap_activate_resource(&res_large, "test/large");
+  RUN_NODE();
+
+  /* the peer connects and the node sends its CSM */
+  snd_nxt = 1000;
+  send_segment(TCP_FLAG_SYN, NULL, 0);
+  RUN_NODE();
+  if(next_frame(&csm) && csm.payload == NULL) {
+    /* a CSM has only the Max-Message-Size option */
+    option = csm.token + csm.token_len;
+    if((option[0] >> 4) == COAP_SIGNAL_OPTION_MAX_MESSAGE_SIZE) {
+      for(i = 0; i < (option[0] & 0x0f); i++) {
+        csm_max_message_size = (csm_max_message_size << 8) | option[1 + i];
+      }
+    }
+  }
+
+  /* the CSM of the peer allows messages of up to 2048 bytes */
+  frame[0] = 3 << 4;
+  frame[1] = COAP_SIGNAL_CSM;
+  frame[2] = (COAP_SIGNAL_OPTION_MAX_MESSAGE_SIZE << 4) | 2;
+  frame[3] = 2048 >> 8;
+  frame[4] = 2048 & 0xff;
+  len = 5;
+  len += put_request(&frame[len], COAP_GET, 0x10, "test/hello", NULL, 0);
+  SEND_NODE(frame, len);
+
+  /* a request split after its first byte and in its options */
+  len = put_request(frame, COAP_GET, 0x11, "test/hello", NULL, 0);
+  SEND_NODE(frame, 1);
+  SEND_NODE(&frame[1], 5);
+  SEND_NODE(&frame[6], len - 6);
+
+  /* two requests in a segment */
+  len = put_request(frame, COAP_GET, 0x12, "test/hello", NULL, 0);
+  len += put_request(&frame[len], COAP_GET, 0x13, "test/hello", NULL, 0);
+  SEND_NODE(frame, len);
+
+  /* a request larger than the default Max-Message-Size, in segments */
+  len = put_request(frame, COAP_POST, 0x14, "test/large",
+                    large_payload, sizeof(large_payload));
+  for(i = 0; i < len; i += 500) {
+    SEND_NODE(&frame[i], MIN(500, len - i));
+  }
+
+  /* and a response as large */
+  len = put_request(frame, COAP_GET, 0x15, "test/large", NULL, 0);
+  SEND_NODE(frame, len);
+
+  while(response_count < 6 && next_frame(&responses[response_count])) {
+    response_count++;
+  }
+
+  /* the node closes the connection */
+  connected_before_close = coap_tcp_is_connected(&peer);
+  coap_tcp_disconnect(&peer);
+  RUN_NODE();
+  send_segment(TCP_FLAG_FIN | TCP_FLAG_ACK, NULL, 0);
+  RUN_NODE();
+  connected_after_close = coap_tcp_is_connected(&peer);
+
+  UNIT_TEST_RUN(test_csm);
+  UNIT_TEST_RUN(test_request);
+  UNIT_TEST_RUN(test_split);
+  UNIT_TEST_RUN(test_large);
+  UNIT_TEST_RUN(test_disconnect);
+
+  printf("=check-me= DONE\n");
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
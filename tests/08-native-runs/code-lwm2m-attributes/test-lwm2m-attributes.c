@@ -0,0 +1,343 @@
+/*
+ * Copyright (c) 2026, Contiki-NG contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ */
+/*---------------------------------------------------------------------------*/
+#include "contiki.h"
+#include "net/netstack.h"
+#include "net/ipv6/uip.h"
+#include "coap.h"
+#include "coap-engine.h"
+#include "coap-timer.h"
+#include "lwm2m-engine.h"
+#include "lwm2m-object.h"
+#include "lwm2m-notification-attributes.h"
+#include "services/unit-test/unit-test.h"
+
+#include <string.h>
+#include <stdio.h>
+/*---------------------------------------------------------------------------*/
+PROCESS(lwm2m_attributes_test_process, "LwM2M notification attributes test");
+AUTOSTART_PROCESSES(&lwm2m_attributes_test_process);
+/*---------------------------------------------------------------------------*/
+#define UIP_IP_BUF ((struct uip_ip_hdr *)&uip_buf[UIP_LLH_LEN])
+
+#define TEST_OBJECT_ID 32001
+#define RESOURCES 3
+
+/* The current values of the test object, floats with 10 fraction bits */
+static int32_t values[RESOURCES];
+
+/* Notifications sent to the observer of each resource */
+static int notifications[RESOURCES];
+static uint16_t last_mid[RESOURCES];
+
+/* The time seen by CoAP timers, in milliseconds */
+static uint64_t now;
+/*---------------------------------------------------------------------------*/
+void
+print_test_report(const unit_test_t *utp)
+{
+  printf("=check-me= ");
+  if(utp->result == unit_test_failure) {
+    printf("FAILED   - %s: exit at L%u\n", utp->descr, utp->exit_line);
+  } else {
+    printf("SUCCEEDED - %s\n", utp->descr);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static uint64_t
+timer_uptime(void)
+{
+  return now;
+}
+/*---------------------------------------------------------------------------*/
+static void
+timer_update(void)
+{
+}
+/*---------------------------------------------------------------------------*/
+const coap_timer_driver_t test_timer_driver = {
+  .init = NULL,
+  .uptime = timer_uptime,
+  .update = timer_update,
+};
+/*---------------------------------------------------------------------------*/
+/* Moves the time forward and runs the CoAP timers that expired */
+static void
+advance(uint64_t ms)
+{
+  now += ms;
+  while(coap_timer_run());
+}
+/*---------------------------------------------------------------------------*/
+static void
+net_init(void)
+{
+}
+/*---------------------------------------------------------------------------*/
+static void
+net_input(void)
+{
+}
+/*---------------------------------------------------------------------------*/
+static uint8_t
+net_output(const linkaddr_t *localdest)
+{
+  static coap_message_t message[1];
+  uint32_t observe;
+  int r;
+
+  if(uip_len > UIP_IPUDPH_LEN && UIP_IP_BUF->proto == UIP_PROTO_UDP &&
+     coap_parse_message(message, &uip_buf[UIP_LLH_LEN + UIP_IPUDPH_LEN],
+                        uip_len - UIP_IPUDPH_LEN) == NO_ERROR &&
+     coap_get_header_observe(message, &observe) &&
+     message->token_len == 2 && message->token[0] == 0x4f &&
+     message->token[1] < RESOURCES) {
+    r = message->token[1];
+    /* Retransmissions of confirmable notifications do not count */
+    if(notifications[r] == 0 || message->mid != last_mid[r]) {
+      notifications[r]++;
+      last_mid[r] = message->mid;
+    }
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+const struct network_driver test_net_driver = {
+  "test",
+  net_init,
+  net_input,
+  net_output
+};
+/*---------------------------------------------------------------------------*/
+static lwm2m_status_t
+lwm2m_callback(lwm2m_object_instance_t *object, lwm2m_context_t *ctx)
+{
+  if(ctx->operation != LWM2M_OP_READ) {
+    return LWM2M_STATUS_OPERATION_NOT_ALLOWED;
+  }
+  switch(ctx->resource_id) {
+  case 0:
+  case 2:
+    lwm2m_object_write_int(ctx, values[ctx->resource_id]);
+    break;
+  case 1:
+    lwm2m_object_write_float32fix(ctx, values[1], 10);
+    break;
+  default:
+    return LWM2M_STATUS_NOT_FOUND;
+  }
+  return LWM2M_STATUS_OK;
+}
+/*---------------------------------------------------------------------------*/
+static const lwm2m_resource_id_t resources[] = { RO(0), RO(1), RO(2) };
+
+static lwm2m_object_instance_t test_object = {
+  .object_id = TEST_OBJECT_ID,
+  .instance_id = 0,
+  .resource_ids = resources,
+  .resource_count = sizeof(resources) / sizeof(lwm2m_resource_id_t),
+  .callback = lwm2m_callback,
+};
+/*---------------------------------------------------------------------------*/
+/* Writes attributes of a resource, as a Write-Attributes request would */
+static lwm2m_status_t
+write_attributes(uint16_t resource_id, const char *query)
+{
+  lwm2m_context_t ctx;
+
+  memset(&ctx, 0, sizeof(ctx));
+  ctx.object_id = TEST_OBJECT_ID;
+  ctx.object_instance_id = 0;
+  ctx.resource_id = resource_id;
+  ctx.level = 3;
+  return lwm2m_notification_attributes_write(&ctx, query, strlen(query));
+}
+/*---------------------------------------------------------------------------*/
+/* Registers an observer of the resource, as an LwM2M server would */
+static void
+observe(uint16_t resource_id)
+{
+  static coap_endpoint_t server;
+  static coap_message_t request[1];
+  static uint8_t buffer[64];
+  uint8_t token[2];
+  char path[20];
+
+  coap_endpoint_parse("coap://[ff02::1]", strlen("coap://[ff02::1]"),
+                      &server);
+  snprintf(path, sizeof(path), "%u/0/%u", TEST_OBJECT_ID, resource_id);
+  token[0] = 0x4f;
+  token[1] = resource_id;
+
+  coap_init_message(request, COAP_TYPE_CON, COAP_GET, 100 + resource_id);
+  coap_set_token(request, token, sizeof(token));
+  coap_set_header_uri_path(request, path);
+  coap_set_header_observe(request, 0);
+  coap_set_header_accept(request, TEXT_PLAIN);
+  coap_receive(&server, buffer, coap_serialize_message(request, buffer));
+}
+/*---------------------------------------------------------------------------*/
+/* Changes a value and returns the number of notifications sent for it */
+static int
+change(uint16_t resource_id, int32_t value)
+{
+  int sent;
+
+  sent = notifications[resource_id];
+  values[resource_id] = value;
+  lwm2m_notify_object_observers(&test_object, resource_id);
+  return notifications[resource_id] - sent;
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_gt_lt, "gt and lt are crossed in both directions");
+UNIT_TEST(test_gt_lt)
+{
+  UNIT_TEST_BEGIN();
+
+  UNIT_TEST_ASSERT(write_attributes(0, "gt=10&lt=5") == LWM2M_STATUS_OK);
+  values[0] = 7;
+  observe(0);
+  UNIT_TEST_ASSERT(notifications[0] == 1);
+
+  /* Between lt and gt */
+  UNIT_TEST_ASSERT(change(0, 8) == 0);
+  /* Up and down across gt */
+  UNIT_TEST_ASSERT(change(0, 11) == 1);
+  UNIT_TEST_ASSERT(change(0, 12) == 0);
+  UNIT_TEST_ASSERT(change(0, 10) == 1);
+  UNIT_TEST_ASSERT(change(0, 9) == 0);
+  /* Down and up across lt */
+  UNIT_TEST_ASSERT(change(0, 4) == 1);
+  UNIT_TEST_ASSERT(change(0, 3) == 0);
+  UNIT_TEST_ASSERT(change(0, 5) == 1);
+  UNIT_TEST_ASSERT(change(0, 6) == 0);
+  /* Across both at once */
+  UNIT_TEST_ASSERT(change(0, 20) == 1);
+  UNIT_TEST_ASSERT(change(0, -20) == 1);
+
+  /* Without the attributes every change is sent */
+  UNIT_TEST_ASSERT(write_attributes(0, "gt&lt") == LWM2M_STATUS_OK);
+  UNIT_TEST_ASSERT(change(0, -20) == 1);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_st, "st on fixed point values");
+UNIT_TEST(test_st)
+{
+  UNIT_TEST_BEGIN();
+
+  UNIT_TEST_ASSERT(write_attributes(1, "st=0.5") == LWM2M_STATUS_OK);
+  values[1] = 1 << 10; /* 1.0 */
+  observe(1);
+  UNIT_TEST_ASSERT(notifications[1] == 1);
+
+  /* Steps are measured from the value last sent */
+  UNIT_TEST_ASSERT(change(1, 5 << 8) == 0); /* 1.25 */
+  UNIT_TEST_ASSERT(change(1, 3 << 9) == 1); /* 1.5 */
+  UNIT_TEST_ASSERT(change(1, 7 << 8) == 0); /* 1.75 */
+  UNIT_TEST_ASSERT(change(1, 5 << 8) == 0); /* 1.25 */
+  UNIT_TEST_ASSERT(change(1, 3 << 8) == 1); /* 0.75 */
+  UNIT_TEST_ASSERT(change(1, -1 << 8) == 1); /* -0.25 */
+  UNIT_TEST_ASSERT(change(1, -1 << 9) == 0); /* -0.5 */
+  UNIT_TEST_ASSERT(change(1, -3 << 8) == 1); /* -0.75 */
+
+  /* A step below one fraction bit of the resource */
+  UNIT_TEST_ASSERT(write_attributes(1, "st=0.001") == LWM2M_STATUS_OK);
+  UNIT_TEST_ASSERT(change(1, (-3 << 8) + 1) == 1);
+  UNIT_TEST_ASSERT(change(1, (-3 << 8) + 1) == 0);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_pmin_pmax, "Changes wait for pmin, pmax forces one");
+UNIT_TEST(test_pmin_pmax)
+{
+  UNIT_TEST_BEGIN();
+
+  UNIT_TEST_ASSERT(write_attributes(2, "pmin=2&pmax=5") == LWM2M_STATUS_OK);
+  values[2] = 1;
+  observe(2);
+  UNIT_TEST_ASSERT(notifications[2] == 1);
+
+  /* Changes inside pmin are sent together when it ends */
+  advance(1000);
+  UNIT_TEST_ASSERT(change(2, 2) == 0);
+  advance(500);
+  UNIT_TEST_ASSERT(change(2, 3) == 0);
+  advance(499);
+  UNIT_TEST_ASSERT(notifications[2] == 1);
+  advance(1);
+  UNIT_TEST_ASSERT(notifications[2] == 2);
+
+  /* Nothing changes, pmax after the last notification */
+  advance(4999);
+  UNIT_TEST_ASSERT(notifications[2] == 2);
+  advance(1);
+  UNIT_TEST_ASSERT(notifications[2] == 3);
+  advance(5000);
+  UNIT_TEST_ASSERT(notifications[2] == 4);
+
+  /* A change after pmin is sent right away and restarts both periods */
+  advance(3000);
+  UNIT_TEST_ASSERT(change(2, 4) == 1);
+  advance(1000);
+  UNIT_TEST_ASSERT(change(2, 5) == 0);
+  advance(1000);
+  UNIT_TEST_ASSERT(notifications[2] == 6);
+  advance(4999);
+  UNIT_TEST_ASSERT(notifications[2] == 6);
+  advance(1);
+  UNIT_TEST_ASSERT(notifications[2] == 7);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(lwm2m_attributes_test_process, ev, data)
+{
+  PROCESS_BEGIN();
+
+  printf("Run unit-test\n");
+  printf("---\n");
+
+  lwm2m_engine_init();
+  lwm2m_engine_add_object(&test_object);
+
+  UNIT_TEST_RUN(test_gt_lt);
+  UNIT_TEST_RUN(test_st);
+  UNIT_TEST_RUN(test_pmin_pmax);
+
+  printf("=check-me= DONE\n");
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
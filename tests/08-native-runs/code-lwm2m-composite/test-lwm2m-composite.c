@@ -0,0 +1,472 @@
+/*
+ * Copyright (c) 2026, Contiki-NG contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ */
+/*---------------------------------------------------------------------------*/
+#include "contiki.h"
+#include "net/netstack.h"
+#include "net/ipv6/uip.h"
+#include "coap.h"
+#include "coap-engine.h"
+#include "lwm2m-engine.h"
+#include "lwm2m-object.h"
+#include "lwm2m-rd-client.h"
+#include "lwm2m-senml-cbor.h"
+#include "services/unit-test/unit-test.h"
+
+#include <string.h>
+#include <stdio.h>
+/*---------------------------------------------------------------------------*/
+PROCESS(lwm2m_composite_test_process, "LwM2M composite test");
+AUTOSTART_PROCESSES(&lwm2m_composite_test_process);
+/*---------------------------------------------------------------------------*/
+#define UIP_IP_BUF ((struct uip_ip_hdr *)&uip_buf[UIP_LLH_LEN])
+
+#define TEST_OBJECT_ID  32004
+#define OTHER_OBJECT_ID 32005
+
+/* The records of the test paths, as path=value */
+#define TEST_RECORDS                                          \
+  "32004/0/1=i0;32004/1/0=41;32004/1/1=i1;32004/1/2=2560;"     \
+  "32005/0/0=50;"
+
+static coap_endpoint_t server;
+
+/* The last CoAP message sent */
+static uint8_t sent[COAP_MAX_CHUNK_SIZE + 64];
+static uint16_t sent_len;
+static int sent_count;
+static coap_message_t message[1];
+
+static char records[256];
+/*---------------------------------------------------------------------------*/
+void
+print_test_report(const unit_test_t *utp)
+{
+  printf("=check-me= ");
+  if(utp->result == unit_test_failure) {
+    printf("FAILED   - %s: exit at L%u\n", utp->descr, utp->exit_line);
+  } else {
+    printf("SUCCEEDED - %s\n", utp->descr);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+net_init(void)
+{
+}
+/*---------------------------------------------------------------------------*/
+static void
+net_input(void)
+{
+}
+/*---------------------------------------------------------------------------*/
+static uint8_t
+net_output(const linkaddr_t *localdest)
+{
+  uint16_t len;
+
+  if(uip_len > UIP_IPUDPH_LEN && UIP_IP_BUF->proto == UIP_PROTO_UDP) {
+    len = uip_len - UIP_IPUDPH_LEN;
+    if(len <= sizeof(sent)) {
+      memcpy(sent, &uip_buf[UIP_LLH_LEN + UIP_IPUDPH_LEN], len);
+      sent_len = len;
+      sent_count++;
+    }
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+const struct network_driver test_net_driver = {
+  "test",
+  net_init,
+  net_input,
+  net_output
+};
+/*---------------------------------------------------------------------------*/
+static lwm2m_status_t
+lwm2m_callback(lwm2m_object_instance_t *object, lwm2m_context_t *ctx)
+{
+  char value[8];
+
+  if(ctx->operation != LWM2M_OP_READ) {
+    return LWM2M_STATUS_OPERATION_NOT_ALLOWED;
+  }
+  switch(ctx->resource_id) {
+  case 0:
+    lwm2m_object_write_int(ctx, object->object_id % 100 * 10 +
+                           object->instance_id);
+    break;
+  case 1:
+    snprintf(value, sizeof(value), "i%u", object->instance_id);
+    lwm2m_object_write_string(ctx, value, strlen(value));
+    break;
+  case 2:
+    /* 2.5 */
+    lwm2m_object_write_float32fix(ctx, 5 << 9, 10);
+    break;
+  default:
+    return LWM2M_STATUS_NOT_FOUND;
+  }
+  return LWM2M_STATUS_OK;
+}
+/*---------------------------------------------------------------------------*/
+static const lwm2m_resource_id_t resources[] = { RO(0), RO(1), RO(2) };
+static const lwm2m_resource_id_t other_resources[] = { RO(0) };
+
+static lwm2m_object_instance_t instances[] = {
+  {
+    .object_id = TEST_OBJECT_ID,
+    .instance_id = 0,
+    .resource_ids = resources,
+    .resource_count = sizeof(resources) / sizeof(lwm2m_resource_id_t),
+    .callback = lwm2m_callback,
+  }, {
+    .object_id = TEST_OBJECT_ID,
+    .instance_id = 1,
+    .resource_ids = resources,
+    .resource_count = sizeof(resources) / sizeof(lwm2m_resource_id_t),
+    .callback = lwm2m_callback,
+  }, {
+    .object_id = OTHER_OBJECT_ID,
+    .instance_id = 0,
+    .resource_ids = other_resources,
+    .resource_count = 1,
+    .callback = lwm2m_callback,
+  }
+};
+/*---------------------------------------------------------------------------*/
+/* Test paths: missing ones and some of each level */
+static const lwm2m_path_t test_paths[] = {
+  { TEST_OBJECT_ID, 0, 1, 3 },
+  { 32099, 0, 0, 1 },
+  { TEST_OBJECT_ID, 5, 0, 2 },
+  { TEST_OBJECT_ID, 1, 7, 3 },
+  { TEST_OBJECT_ID, 1, 0, 2 },
+  { OTHER_OBJECT_ID, 0, 0, 1 },
+};
+#define TEST_PATHS (sizeof(test_paths) / sizeof(test_paths[0]))
+
+/* Paths that do not fit into COAP_MAX_CHUNK_SIZE */
+static const lwm2m_path_t large_paths[] = {
+  { TEST_OBJECT_ID, 0, 0, 1 },
+  { TEST_OBJECT_ID, 0, 0, 1 },
+  { TEST_OBJECT_ID, 0, 0, 1 },
+};
+#define LARGE_PATHS (sizeof(large_paths) / sizeof(large_paths[0]))
+/*---------------------------------------------------------------------------*/
+/*
+ * Lists the records of a SenML pack as path=value; with floats in fixed
+ * point with 10 bits. Returns 0 if the pack is malformed.
+ */
+static int
+list_records(const uint8_t *pack, uint16_t len)
+{
+  lwm2m_senml_cbor_record_t record;
+  lwm2m_context_t ctx;
+  lwm2m_buffer_t inbuf;
+  uint8_t string[8];
+  int32_t value;
+  int n = 0;
+
+  memset(&ctx, 0, sizeof(ctx));
+  memset(&record, 0, sizeof(record));
+  inbuf.buffer = (uint8_t *)pack;
+  inbuf.size = len;
+  inbuf.pos = 0;
+  ctx.inbuf = &inbuf;
+  records[0] = '\0';
+  while(lwm2m_senml_cbor_next_record(&ctx, &record)) {
+    if(record.base_name_len == 0 || record.base_name[0] != '/') {
+      return 0;
+    }
+    n += snprintf(&records[n], sizeof(records) - n, "%.*s%.*s=",
+                  record.base_name_len - 1, record.base_name + 1,
+                  record.name_len, record.name);
+    if((record.value[0] & 0xE0) == 0x60) {
+      if(lwm2m_senml_cbor_reader.read_string(&ctx, record.value,
+                                             record.value_len, string,
+                                             sizeof(string)) == 0) {
+        return 0;
+      }
+      n += snprintf(&records[n], sizeof(records) - n, "%s;", string);
+    } else {
+      if((record.value[0] < 0x40 ?
+          lwm2m_senml_cbor_reader.read_int(&ctx, record.value,
+                                           record.value_len, &value) :
+          lwm2m_senml_cbor_reader.read_float32fix(&ctx, record.value,
+                                                  record.value_len,
+                                                  &value, 10)) == 0) {
+        return 0;
+      }
+      n += snprintf(&records[n], sizeof(records) - n, "%ld;", (long)value);
+    }
+    if(n >= sizeof(records)) {
+      return 0;
+    }
+  }
+  /* All of the pack was read */
+  return inbuf.pos < len && pack[inbuf.pos] == 0xff && inbuf.pos + 1 == len;
+}
+/*---------------------------------------------------------------------------*/
+/* Puts a record with a path in its name, or in its base name and name */
+static int
+put_path(uint8_t *buf, const char *base_name, const char *name)
+{
+  int n = 0;
+  int len;
+
+  buf[n++] = base_name != NULL ? 0xa2 : 0xa1;
+  if(base_name != NULL) {
+    len = strlen(base_name);
+    buf[n++] = 0x21;
+    buf[n++] = 0x60 | len;
+    memcpy(&buf[n], base_name, len);
+    n += len;
+  }
+  len = strlen(name);
+  buf[n++] = 0x00;
+  buf[n++] = 0x60 | len;
+  memcpy(&buf[n], name, len);
+  return n + len;
+}
+/*---------------------------------------------------------------------------*/
+/* Sends a Read-Composite request of the test paths, or of larger ones */
+static void
+read_composite(int large)
+{
+  static coap_message_t request[1];
+  static uint8_t payload[128];
+  static uint8_t buffer[COAP_MAX_CHUNK_SIZE + 64];
+  static uint16_t mid;
+  int n = 0;
+  int i;
+
+  payload[n++] = 0x9f;
+  if(large) {
+    for(i = 0; i < LARGE_PATHS; i++) {
+      n += put_path(&payload[n], NULL, "/32004");
+    }
+  } else {
+    /* Resource, missing object, missing instance, missing resource,
+       instance, object - with and without base names */
+    n += put_path(&payload[n], NULL, "/32004/0/1");
+    n += put_path(&payload[n], NULL, "/32099");
+    n += put_path(&payload[n], "/32004/", "5");
+    n += put_path(&payload[n], NULL, "1/7");
+    n += put_path(&payload[n], NULL, "1");
+    n += put_path(&payload[n], "/32005", "");
+  }
+  payload[n++] = 0xff;
+
+  coap_init_message(request, COAP_TYPE_CON, COAP_FETCH, ++mid);
+  coap_set_header_content_format(request, LWM2M_SENML_CBOR);
+  coap_set_header_accept(request, LWM2M_SENML_CBOR);
+  coap_set_payload(request, payload, n);
+  sent_len = 0;
+  coap_receive(&server, buffer, coap_serialize_message(request, buffer));
+}
+/*---------------------------------------------------------------------------*/
+/* Parses the last message sent */
+static int
+parse_sent(void)
+{
+  return sent_len > 0 && coap_parse_message(message, sent, sent_len) ==
+    NO_ERROR;
+}
+/*---------------------------------------------------------------------------*/
+/* Answers the last request sent, as the server would */
+static void
+respond(uint8_t code, const char *location)
+{
+  static coap_message_t response[1];
+  static uint8_t buffer[64];
+
+  coap_init_message(response, COAP_TYPE_ACK, code, message->mid);
+  coap_set_token(response, message->token, message->token_len);
+  if(location != NULL) {
+    coap_set_header_location_path(response, location);
+  }
+  coap_receive(&server, buffer, coap_serialize_message(response, buffer));
+}
+/*---------------------------------------------------------------------------*/
+static int
+sent_to(const char *path)
+{
+  const char *uri_path;
+  int len;
+
+  len = coap_get_header_uri_path(message, &uri_path);
+  return len == strlen(path) && strncmp(uri_path, path, len) == 0;
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_read_composite, "Read-Composite");
+UNIT_TEST(test_read_composite)
+{
+  const uint8_t *payload;
+  int len;
+
+  UNIT_TEST_BEGIN();
+
+  read_composite(0);
+  UNIT_TEST_ASSERT(parse_sent() && message->code == CONTENT_2_05);
+  len = coap_get_payload(message, &payload);
+  UNIT_TEST_ASSERT(list_records(payload, len));
+  UNIT_TEST_ASSERT(strcmp(records, TEST_RECORDS) == 0);
+
+  /* No part of a composite that does not fit */
+  read_composite(1);
+  UNIT_TEST_ASSERT(parse_sent() &&
+                   message->code == INTERNAL_SERVER_ERROR_5_00);
+  UNIT_TEST_ASSERT(coap_get_payload(message, &payload) == 0 ||
+                   payload[0] != 0x9f);
+
+  /* Nothing is left over from it */
+  read_composite(0);
+  UNIT_TEST_ASSERT(parse_sent() && message->code == CONTENT_2_05);
+  len = coap_get_payload(message, &payload);
+  UNIT_TEST_ASSERT(list_records(payload, len));
+  UNIT_TEST_ASSERT(strcmp(records, TEST_RECORDS) == 0);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_write_composite, "Composites fit or fail");
+UNIT_TEST(test_write_composite)
+{
+  static uint8_t full[COAP_MAX_CHUNK_SIZE];
+  static uint8_t buffer[COAP_MAX_CHUNK_SIZE];
+  int full_len;
+  int size;
+
+  UNIT_TEST_BEGIN();
+
+  full_len = lwm2m_engine_write_composite(test_paths, TEST_PATHS, full,
+                                          sizeof(full));
+  UNIT_TEST_ASSERT(full_len > 0 && list_records(full, full_len));
+  UNIT_TEST_ASSERT(strcmp(records, TEST_RECORDS) == 0);
+
+  /* Every buffer too small gives an error rather than part of the pack */
+  for(size = 0; size < full_len; size++) {
+    UNIT_TEST_ASSERT(lwm2m_engine_write_composite(test_paths, TEST_PATHS,
+                                                  buffer, size) == -1);
+  }
+  UNIT_TEST_ASSERT(lwm2m_engine_write_composite(test_paths, TEST_PATHS,
+                                                buffer, full_len) ==
+                   full_len);
+  UNIT_TEST_ASSERT(memcmp(buffer, full, full_len) == 0);
+
+  UNIT_TEST_ASSERT(lwm2m_engine_write_composite(large_paths, LARGE_PATHS,
+                                                buffer, sizeof(buffer)) ==
+                   -1);
+
+  /* Only missing paths */
+  UNIT_TEST_ASSERT(lwm2m_engine_write_composite(&test_paths[1], 2, buffer,
+                                                sizeof(buffer)) == 2);
+  UNIT_TEST_ASSERT(buffer[0] == 0x9f && buffer[1] == 0xff);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_send, "Send");
+UNIT_TEST(test_send)
+{
+  const uint8_t *payload;
+  int count;
+  int len;
+
+  UNIT_TEST_BEGIN();
+
+  UNIT_TEST_ASSERT(lwm2m_rd_client_is_registered());
+
+  count = sent_count;
+  UNIT_TEST_ASSERT(lwm2m_rd_client_send(test_paths, TEST_PATHS));
+  UNIT_TEST_ASSERT(sent_count == count + 1);
+  UNIT_TEST_ASSERT(parse_sent() && message->code == COAP_POST &&
+                   sent_to("dp"));
+  len = coap_get_payload(message, &payload);
+  UNIT_TEST_ASSERT(list_records(payload, len));
+  UNIT_TEST_ASSERT(strcmp(records, TEST_RECORDS) == 0);
+
+  /* One Send at a time */
+  UNIT_TEST_ASSERT(!lwm2m_rd_client_send(test_paths, TEST_PATHS));
+  respond(CHANGED_2_04, NULL);
+
+  /* Nothing is sent of a pack that does not fit */
+  count = sent_count;
+  UNIT_TEST_ASSERT(!lwm2m_rd_client_send(large_paths, LARGE_PATHS));
+  UNIT_TEST_ASSERT(sent_count == count);
+
+  UNIT_TEST_ASSERT(lwm2m_rd_client_send(test_paths, 1));
+  UNIT_TEST_ASSERT(sent_count == count + 1);
+  respond(CHANGED_2_04, NULL);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(lwm2m_composite_test_process, ev, data)
+{
+  static struct etimer et;
+  static int i;
+
+  PROCESS_BEGIN();
+
+  printf("Run unit-test\n");
+  printf("---\n");
+
+  coap_endpoint_parse("coap://[ff02::1]", strlen("coap://[ff02::1]"),
+                      &server);
+  lwm2m_engine_init();
+  for(i = 0; i < sizeof(instances) / sizeof(instances[0]); i++) {
+    lwm2m_engine_add_object(&instances[i]);
+  }
+
+  UNIT_TEST_RUN(test_read_composite);
+  UNIT_TEST_RUN(test_write_composite);
+
+  /* Register with a server played by the test */
+  lwm2m_rd_client_use_bootstrap_server(0);
+  lwm2m_rd_client_use_registration_server(1);
+  lwm2m_rd_client_register_with_server(&server);
+  for(i = 0; i < 20 && !lwm2m_rd_client_is_registered(); i++) {
+    etimer_set(&et, CLOCK_SECOND / 10);
+    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+    if(parse_sent() && message->code == COAP_POST && sent_to("rd")) {
+      respond(CREATED_2_01, "rd/5");
+    }
+  }
+
+  UNIT_TEST_RUN(test_send);
+
+  printf("=check-me= DONE\n");
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
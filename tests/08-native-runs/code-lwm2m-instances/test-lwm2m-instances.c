@@ -0,0 +1,467 @@
+/*
+ * Copyright (c) 2026, Contiki-NG contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ */
+/*---------------------------------------------------------------------------*/
+#include "contiki.h"
+#include "net/netstack.h"
+#include "net/ipv6/uip.h"
+#include "coap.h"
+#include "coap-engine.h"
+#include "lwm2m-engine.h"
+#include "lwm2m-object.h"
+#include "lwm2m-senml-cbor.h"
+#include "lib/random.h"
+#include "services/unit-test/unit-test.h"
+
+#include <string.h>
+#include <stdio.h>
+/*---------------------------------------------------------------------------*/
+PROCESS(lwm2m_instances_test_process, "LwM2M object instance test");
+AUTOSTART_PROCESSES(&lwm2m_instances_test_process);
+/*---------------------------------------------------------------------------*/
+#define UIP_IP_BUF ((struct uip_ip_hdr *)&uip_buf[UIP_LLH_LEN])
+
+/* The first and last objects share an index bucket */
+static const uint16_t object_ids[] = { 32002, 32003, 32010 };
+#define OBJECTS (sizeof(object_ids) / sizeof(object_ids[0]))
+
+/* The instance IDs used of each object */
+static const uint16_t instance_ids[] = {
+  0, 1, 2, 3, 4, 7, 8, 15, 16, 100, 1000
+};
+#define INSTANCES (sizeof(instance_ids) / sizeof(instance_ids[0]))
+
+#define STEPS 400
+
+static lwm2m_object_instance_t instances[OBJECTS][INSTANCES];
+static uint8_t registered[OBJECTS][INSTANCES];
+/* Added without an instance ID */
+static lwm2m_object_instance_t extra;
+
+/* The payload of the last CoAP message sent */
+static uint8_t response[COAP_MAX_CHUNK_SIZE];
+static uint16_t response_len;
+/*---------------------------------------------------------------------------*/
+void
+print_test_report(const unit_test_t *utp)
+{
+  printf("=check-me= ");
+  if(utp->result == unit_test_failure) {
+    printf("FAILED   - %s: exit at L%u\n", utp->descr, utp->exit_line);
+  } else {
+    printf("SUCCEEDED - %s\n", utp->descr);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+net_init(void)
+{
+}
+/*---------------------------------------------------------------------------*/
+static void
+net_input(void)
+{
+}
+/*---------------------------------------------------------------------------*/
+static uint8_t
+net_output(const linkaddr_t *localdest)
+{
+  static coap_message_t message[1];
+  const uint8_t *payload;
+  int len;
+
+  if(uip_len > UIP_IPUDPH_LEN && UIP_IP_BUF->proto == UIP_PROTO_UDP &&
+     coap_parse_message(message, &uip_buf[UIP_LLH_LEN + UIP_IPUDPH_LEN],
+                        uip_len - UIP_IPUDPH_LEN) == NO_ERROR) {
+    len = coap_get_payload(message, &payload);
+    if(len <= sizeof(response)) {
+      memcpy(response, payload, len);
+      response_len = len;
+    }
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+const struct network_driver test_net_driver = {
+  "test",
+  net_init,
+  net_input,
+  net_output
+};
+/*---------------------------------------------------------------------------*/
+static lwm2m_status_t
+lwm2m_callback(lwm2m_object_instance_t *object, lwm2m_context_t *ctx)
+{
+  if(ctx->operation != LWM2M_OP_READ || ctx->resource_id != 0) {
+    return LWM2M_STATUS_OPERATION_NOT_ALLOWED;
+  }
+  lwm2m_object_write_int(ctx, object->instance_id);
+  return LWM2M_STATUS_OK;
+}
+/*---------------------------------------------------------------------------*/
+static const lwm2m_resource_id_t resources[] = { RO(0) };
+/*---------------------------------------------------------------------------*/
+static void
+init_instance(lwm2m_object_instance_t *instance, uint16_t object_id,
+              uint16_t instance_id)
+{
+  memset(instance, 0, sizeof(*instance));
+  instance->object_id = object_id;
+  instance->instance_id = instance_id;
+  instance->resource_ids = resources;
+  instance->resource_count = 1;
+  instance->callback = lwm2m_callback;
+}
+/*---------------------------------------------------------------------------*/
+static int
+add_instance(int o, int i)
+{
+  init_instance(&instances[o][i], object_ids[o], instance_ids[i]);
+  if(!lwm2m_engine_add_object(&instances[o][i])) {
+    return 0;
+  }
+  registered[o][i] = 1;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static void
+remove_instance(int o, int i)
+{
+  lwm2m_engine_remove_object(&instances[o][i]);
+  registered[o][i] = 0;
+}
+/*---------------------------------------------------------------------------*/
+/* Checks that each instance is found if registered and only then */
+static int
+check_lookup(void)
+{
+  lwm2m_object_instance_t *expected;
+  int o;
+  int i;
+
+  for(o = 0; o < OBJECTS; o++) {
+    for(i = 0; i < INSTANCES; i++) {
+      expected = registered[o][i] ? &instances[o][i] : NULL;
+      if(lwm2m_engine_get_instance(object_ids[o], instance_ids[i]) !=
+         expected) {
+        printf("%u/%u not found as expected\n", object_ids[o],
+               instance_ids[i]);
+        return 0;
+      }
+    }
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+/* Checks the links of the registration, which list object_list in order */
+static int
+check_rd_data(void)
+{
+  static char links[OBJECTS * INSTANCES * 16];
+  static char expected[sizeof(links)];
+  static uint8_t block[64];
+  lwm2m_buffer_t outbuf;
+  int links_len;
+  int len;
+  int more;
+  int o;
+  int i;
+  int n;
+
+  links_len = 0;
+  n = 0;
+  do {
+    outbuf.buffer = block;
+    outbuf.size = sizeof(block);
+    outbuf.len = 0;
+    more = lwm2m_engine_set_rd_data(&outbuf, n++);
+    if(links_len + outbuf.len >= sizeof(links)) {
+      return 0;
+    }
+    memcpy(&links[links_len], block, outbuf.len);
+    links_len += outbuf.len;
+  } while(more);
+  links[links_len] = '\0';
+
+  expected[0] = '\0';
+  len = 0;
+  for(o = 0; o < OBJECTS; o++) {
+    for(i = 0; i < INSTANCES; i++) {
+      if(registered[o][i]) {
+        len += snprintf(&expected[len], sizeof(expected) - len,
+                        len > 0 ? ",</%u/%u>" : "</%u/%u>",
+                        object_ids[o], instance_ids[i]);
+      }
+    }
+  }
+
+  if(strcmp(links, expected) != 0) {
+    printf("links %s\nexpected %s\n", links, expected);
+    return 0;
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+/* Reads a whole object, as an LwM2M server would */
+static void
+read_object(uint16_t object_id)
+{
+  static coap_endpoint_t server;
+  static coap_message_t request[1];
+  static uint8_t buffer[64];
+  static uint16_t mid;
+  char path[8];
+
+  coap_endpoint_parse("coap://[ff02::1]", strlen("coap://[ff02::1]"),
+                      &server);
+  snprintf(path, sizeof(path), "%u", object_id);
+
+  coap_init_message(request, COAP_TYPE_CON, COAP_GET, ++mid);
+  coap_set_header_uri_path(request, path);
+  coap_set_header_accept(request, LWM2M_SENML_CBOR);
+  response_len = 0;
+  coap_receive(&server, buffer, coap_serialize_message(request, buffer));
+}
+/*---------------------------------------------------------------------------*/
+/* Checks that a read of the object has its instances in order */
+static int
+check_read(int o)
+{
+  static uint8_t read_ids[INSTANCES];
+  lwm2m_senml_cbor_record_t record;
+  lwm2m_context_t ctx;
+  lwm2m_buffer_t inbuf;
+  const uint8_t *base_name;
+  char name[20];
+  unsigned object_id;
+  unsigned instance_id;
+  int count;
+  int i;
+
+  read_object(object_ids[o]);
+
+  memset(&ctx, 0, sizeof(ctx));
+  memset(&record, 0, sizeof(record));
+  inbuf.buffer = response;
+  inbuf.size = response_len;
+  inbuf.pos = 0;
+  ctx.inbuf = &inbuf;
+  base_name = NULL;
+  count = 0;
+  while(lwm2m_senml_cbor_next_record(&ctx, &record)) {
+    if(record.base_name == base_name) {
+      continue;
+    }
+    /* Each instance starts with its base name */
+    base_name = record.base_name;
+    snprintf(name, sizeof(name), "%.*s", record.base_name_len, base_name);
+    if(count == INSTANCES ||
+       sscanf(name, "/%u/%u/", &object_id, &instance_id) != 2 ||
+       object_id != object_ids[o]) {
+      return 0;
+    }
+    for(i = 0; i < INSTANCES && instance_ids[i] != instance_id; i++);
+    read_ids[count++] = i;
+  }
+
+  for(i = 0; i < INSTANCES; i++) {
+    if(registered[o][i]) {
+      if(count == 0 || read_ids[0] != i) {
+        printf("read of %u: instance %u missing or out of order\n",
+               object_ids[o], instance_ids[i]);
+        return 0;
+      }
+      memmove(read_ids, &read_ids[1], --count);
+    }
+  }
+  return count == 0;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Checks the ID given to an instance added without one: one below the
+ * first instance of its object, or one above the last if the first is 0.
+ */
+static int
+check_new_id(int o)
+{
+  int expected = 0;
+  int first = -1;
+  int last = -1;
+  int i;
+  int ok;
+
+  for(i = 0; i < INSTANCES; i++) {
+    if(registered[o][i]) {
+      if(first < 0) {
+        first = instance_ids[i];
+      }
+      last = instance_ids[i];
+    }
+  }
+  if(first > 0) {
+    expected = first - 1;
+  } else if(first == 0) {
+    expected = last + 1;
+  }
+
+  init_instance(&extra, object_ids[o], LWM2M_OBJECT_INSTANCE_NONE);
+  if(!lwm2m_engine_add_object(&extra)) {
+    return 0;
+  }
+  ok = extra.instance_id == expected &&
+    lwm2m_engine_get_instance(object_ids[o], expected) == &extra;
+  lwm2m_engine_remove_object(&extra);
+  if(!ok) {
+    printf("new instance of %u got %u, expected %u\n", object_ids[o],
+           extra.instance_id, expected);
+  }
+  return ok && lwm2m_engine_get_instance(object_ids[o], expected) == NULL;
+}
+/*---------------------------------------------------------------------------*/
+static int
+check_all(void)
+{
+  int o;
+
+  if(!check_lookup() || !check_rd_data()) {
+    return 0;
+  }
+  for(o = 0; o < OBJECTS; o++) {
+    if(!check_read(o)) {
+      return 0;
+    }
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_first_last, "First and last instances");
+UNIT_TEST(test_first_last)
+{
+  int i;
+
+  UNIT_TEST_BEGIN();
+
+  /* Out of order, each object around the others */
+  UNIT_TEST_ASSERT(add_instance(2, 3));
+  UNIT_TEST_ASSERT(add_instance(0, 5));
+  UNIT_TEST_ASSERT(add_instance(1, 0));
+  UNIT_TEST_ASSERT(add_instance(0, 2));
+  UNIT_TEST_ASSERT(add_instance(2, 10));
+  UNIT_TEST_ASSERT(add_instance(0, 10));
+  UNIT_TEST_ASSERT(add_instance(0, 0));
+  UNIT_TEST_ASSERT(add_instance(2, 0));
+  UNIT_TEST_ASSERT(check_all());
+  /* Added twice, or another instance with the same IDs */
+  UNIT_TEST_ASSERT(!lwm2m_engine_add_object(&instances[0][5]));
+  init_instance(&extra, object_ids[0], instance_ids[5]);
+  UNIT_TEST_ASSERT(!lwm2m_engine_add_object(&extra));
+  UNIT_TEST_ASSERT(check_all());
+
+  /* The first instance of an object, then the last */
+  remove_instance(0, 0);
+  UNIT_TEST_ASSERT(check_all());
+  UNIT_TEST_ASSERT(check_new_id(0));
+  remove_instance(0, 10);
+  UNIT_TEST_ASSERT(check_all());
+  UNIT_TEST_ASSERT(check_new_id(0));
+  remove_instance(2, 10);
+  UNIT_TEST_ASSERT(check_all());
+  UNIT_TEST_ASSERT(check_new_id(2));
+  /* The only instance, which is both */
+  remove_instance(1, 0);
+  UNIT_TEST_ASSERT(check_all());
+  UNIT_TEST_ASSERT(check_new_id(1));
+  /* Not registered any more */
+  remove_instance(1, 0);
+  UNIT_TEST_ASSERT(check_all());
+
+  /* Down to one instance, then none */
+  remove_instance(0, 5);
+  UNIT_TEST_ASSERT(check_all());
+  remove_instance(0, 2);
+  UNIT_TEST_ASSERT(check_all());
+  remove_instance(2, 0);
+  remove_instance(2, 3);
+  UNIT_TEST_ASSERT(check_all());
+
+  for(i = 0; i < INSTANCES; i++) {
+    UNIT_TEST_ASSERT(lwm2m_engine_get_instance(object_ids[0],
+                                               instance_ids[i]) == NULL);
+  }
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_random, "Instances added and removed at random");
+UNIT_TEST(test_random)
+{
+  int step;
+  int o;
+  int i;
+
+  UNIT_TEST_BEGIN();
+
+  random_init(0x4c57);
+  for(step = 0; step < STEPS; step++) {
+    o = random_rand() % OBJECTS;
+    i = random_rand() % INSTANCES;
+    if(registered[o][i]) {
+      remove_instance(o, i);
+    } else {
+      UNIT_TEST_ASSERT(add_instance(o, i));
+    }
+    UNIT_TEST_ASSERT(check_all());
+    if(step % 4 == 0) {
+      UNIT_TEST_ASSERT(check_new_id(o));
+      UNIT_TEST_ASSERT(check_all());
+    }
+  }
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(lwm2m_instances_test_process, ev, data)
+{
+  PROCESS_BEGIN();
+
+  printf("Run unit-test\n");
+  printf("---\n");
+
+  lwm2m_engine_init();
+
+  UNIT_TEST_RUN(test_first_last);
+  UNIT_TEST_RUN(test_random);
+
+  printf("=check-me= DONE\n");
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,304 @@
+/*
+ * Copyright (c) 2026, Contiki-NG contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ */
+/*---------------------------------------------------------------------------*/
+#include "contiki.h"
+#include "net/netstack.h"
+#include "net/ipv6/uip.h"
+#include "coap.h"
+#include "coap-engine.h"
+#include "lwm2m-engine.h"
+#include "lwm2m-object.h"
+#include "lwm2m-notification-queue.h"
+#include "lwm2m-queue-mode-conf.h"
+#include "cfs/cfs.h"
+#include "services/unit-test/unit-test.h"
+
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+/*---------------------------------------------------------------------------*/
+PROCESS(lwm2m_queue_test_process, "LwM2M notification queue test");
+AUTOSTART_PROCESSES(&lwm2m_queue_test_process);
+/*---------------------------------------------------------------------------*/
+#define UIP_IP_BUF ((struct uip_ip_hdr *)&uip_buf[UIP_LLH_LEN])
+
+#define TEST_OBJECT_ID 32000
+
+/* The current values of the test object, floats with 10 fraction bits */
+static int32_t int_value;
+static int32_t float_value;
+static int bool_value;
+static const char *string_value;
+
+/* Payloads of the CoAP messages sent */
+static uint8_t captured[2048];
+static uint16_t captured_len;
+/*---------------------------------------------------------------------------*/
+void
+print_test_report(const unit_test_t *utp)
+{
+  printf("=check-me= ");
+  if(utp->result == unit_test_failure) {
+    printf("FAILED   - %s: exit at L%u\n", utp->descr, utp->exit_line);
+  } else {
+    printf("SUCCEEDED - %s\n", utp->descr);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+net_init(void)
+{
+}
+/*---------------------------------------------------------------------------*/
+static void
+net_input(void)
+{
+}
+/*---------------------------------------------------------------------------*/
+static uint8_t
+net_output(const linkaddr_t *localdest)
+{
+  static coap_message_t message[1];
+  const uint8_t *payload;
+  int len;
+
+  if(uip_len > UIP_IPUDPH_LEN && UIP_IP_BUF->proto == UIP_PROTO_UDP &&
+     coap_parse_message(message, &uip_buf[UIP_LLH_LEN + UIP_IPUDPH_LEN],
+                        uip_len - UIP_IPUDPH_LEN) == NO_ERROR) {
+    len = coap_get_payload(message, &payload);
+    if(captured_len + len <= sizeof(captured)) {
+      memcpy(&captured[captured_len], payload, len);
+      captured_len += len;
+    }
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+const struct network_driver test_net_driver = {
+  "test",
+  net_init,
+  net_input,
+  net_output
+};
+/*---------------------------------------------------------------------------*/
+static lwm2m_status_t
+lwm2m_callback(lwm2m_object_instance_t *object, lwm2m_context_t *ctx)
+{
+  if(ctx->operation != LWM2M_OP_READ) {
+    return LWM2M_STATUS_OPERATION_NOT_ALLOWED;
+  }
+  switch(ctx->resource_id) {
+  case 0:
+    lwm2m_object_write_int(ctx, int_value);
+    break;
+  case 1:
+    lwm2m_object_write_float32fix(ctx, float_value, 10);
+    break;
+  case 2:
+    lwm2m_object_write_boolean(ctx, bool_value);
+    break;
+  case 3:
+    lwm2m_object_write_string(ctx, string_value, strlen(string_value));
+    break;
+  default:
+    return LWM2M_STATUS_NOT_FOUND;
+  }
+  return LWM2M_STATUS_OK;
+}
+/*---------------------------------------------------------------------------*/
+static const lwm2m_resource_id_t resources[] = { RO(0), RO(1), RO(2), RO(3) };
+
+static lwm2m_object_instance_t test_object = {
+  .object_id = TEST_OBJECT_ID,
+  .instance_id = 0,
+  .resource_ids = resources,
+  .resource_count = sizeof(resources) / sizeof(lwm2m_resource_id_t),
+  .callback = lwm2m_callback,
+};
+/*---------------------------------------------------------------------------*/
+/*
+ * Drops the zeros at the end of the notification file, which is what Coffee
+ * does when it finds the end of a file again after a reboot. Returns the
+ * number of bytes dropped.
+ */
+static int
+drop_trailing_zeros(void)
+{
+  static uint8_t data[4096];
+  FILE *f;
+  int len;
+  int end;
+
+  f = fopen(LWM2M_QUEUE_MODE_NOTIFICATION_FILE, "rb");
+  if(f == NULL) {
+    return -1;
+  }
+  len = fread(data, 1, sizeof(data), f);
+  fclose(f);
+  for(end = len; end > 0 && data[end - 1] == 0; end--);
+  if(end < len && truncate(LWM2M_QUEUE_MODE_NOTIFICATION_FILE, end) < 0) {
+    return -1;
+  }
+  return len - end;
+}
+/*---------------------------------------------------------------------------*/
+static int
+captured_contains(const uint8_t *data, size_t len)
+{
+  int i;
+
+  for(i = 0; i + len <= captured_len; i++) {
+    if(memcmp(&captured[i], data, len) == 0) {
+      return 1;
+    }
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+/* Registers an observer of the resource, as an LwM2M server would */
+static void
+observe(uint16_t resource_id)
+{
+  static coap_endpoint_t server;
+  static coap_message_t request[1];
+  static uint8_t buffer[64];
+  uint8_t token[2];
+  char path[20];
+
+  coap_endpoint_parse("coap://[ff02::1]", strlen("coap://[ff02::1]"),
+                      &server);
+  snprintf(path, sizeof(path), "%u/0/%u", TEST_OBJECT_ID, resource_id);
+  token[0] = 0x4f;
+  token[1] = resource_id;
+
+  coap_init_message(request, COAP_TYPE_CON, COAP_GET, 100 + resource_id);
+  coap_set_token(request, token, sizeof(token));
+  coap_set_header_uri_path(request, path);
+  coap_set_header_observe(request, 0);
+  coap_set_header_accept(request, LWM2M_SENML_CBOR);
+  coap_receive(&server, buffer, coap_serialize_message(request, buffer));
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_store, "Stored values survive a reboot");
+UNIT_TEST(test_store)
+{
+  static const uint8_t partial[] = { 0x11, 0x22, 0x33 };
+  int fd;
+
+  UNIT_TEST_BEGIN();
+
+  int_value = 5;
+  float_value = 3 << 9; /* 1.5 */
+  bool_value = 1;
+  string_value = "ab";
+  lwm2m_notification_queue_add_notification_path(TEST_OBJECT_ID, 0, 0);
+  lwm2m_notification_queue_add_notification_path(TEST_OBJECT_ID, 0, 1);
+  lwm2m_notification_queue_add_notification_path(TEST_OBJECT_ID, 0, 2);
+  lwm2m_notification_queue_add_notification_path(TEST_OBJECT_ID, 0, 3);
+
+  /* Small values end in zeros in the record, but the record does not */
+  UNIT_TEST_ASSERT(drop_trailing_zeros() == 0);
+  lwm2m_notification_queue_init();
+
+  /* A record cut short by a reset is dropped */
+  fd = cfs_open(LWM2M_QUEUE_MODE_NOTIFICATION_FILE, CFS_WRITE | CFS_APPEND);
+  UNIT_TEST_ASSERT(fd >= 0);
+  UNIT_TEST_ASSERT(cfs_write(fd, partial, sizeof(partial)) == sizeof(partial));
+  cfs_close(fd);
+  lwm2m_notification_queue_init();
+
+  /* A value stored after the reboot follows the others */
+  int_value = 7;
+  lwm2m_notification_queue_add_notification_path(TEST_OBJECT_ID, 0, 0);
+  UNIT_TEST_ASSERT(drop_trailing_zeros() == 0);
+  lwm2m_notification_queue_init();
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_replay, "Stored values are sent once observed");
+UNIT_TEST(test_replay)
+{
+  /* SenML-CBOR value labels and values */
+  static const uint8_t first_int[] = { 0x02, 0x05 };
+  static const uint8_t second_int[] = { 0x02, 0x07 };
+  static const uint8_t half_float[] = { 0x02, 0xf9, 0x3e, 0x00 };
+  static const uint8_t boolean[] = { 0x04, 0xf5 };
+  static const uint8_t string[] = { 0x03, 0x62, 'a', 'b' };
+
+  UNIT_TEST_BEGIN();
+
+  UNIT_TEST_ASSERT(captured_contains(first_int, sizeof(first_int)));
+  UNIT_TEST_ASSERT(captured_contains(second_int, sizeof(second_int)));
+  UNIT_TEST_ASSERT(captured_contains(half_float, sizeof(half_float)));
+  UNIT_TEST_ASSERT(captured_contains(boolean, sizeof(boolean)));
+  UNIT_TEST_ASSERT(captured_contains(string, sizeof(string)));
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(lwm2m_queue_test_process, ev, data)
+{
+  static struct etimer et;
+
+  PROCESS_BEGIN();
+
+  printf("Run unit-test\n");
+  printf("---\n");
+
+  cfs_remove(LWM2M_QUEUE_MODE_NOTIFICATION_FILE);
+  lwm2m_engine_init();
+  lwm2m_engine_add_object(&test_object);
+
+  UNIT_TEST_RUN(test_store);
+
+  /* The values now read differ from the stored ones */
+  int_value = 99;
+  float_value = 3 << 10;
+  bool_value = 0;
+  string_value = "zz";
+  observe(0);
+  observe(1);
+  observe(2);
+  observe(3);
+
+  etimer_set(&et, CLOCK_SECOND);
+  PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+
+  UNIT_TEST_RUN(test_replay);
+
+  cfs_remove(LWM2M_QUEUE_MODE_NOTIFICATION_FILE);
+  printf("=check-me= DONE\n");
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,244 @@
+/*
+ * Copyright (c) 2026, Contiki-NG contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ */
+/*---------------------------------------------------------------------------*/
+#include "contiki.h"
+#include "lwm2m-object.h"
+#include "lwm2m-senml-cbor.h"
+#include "services/unit-test/unit-test.h"
+
+#include <string.h>
+#include <stdio.h>
+/*---------------------------------------------------------------------------*/
+PROCESS(senml_cbor_test_process, "SenML-CBOR number test");
+AUTOSTART_PROCESSES(&senml_cbor_test_process);
+/*---------------------------------------------------------------------------*/
+#define CBOR_HALF   0xF9
+#define CBOR_FLOAT  0xFA
+#define CBOR_DOUBLE 0xFB
+
+static uint8_t pack[32];
+static lwm2m_buffer_t buffer;
+static lwm2m_context_t ctx;
+/* The record of the last value encoded or decoded */
+static lwm2m_senml_cbor_record_t record;
+/*---------------------------------------------------------------------------*/
+void
+print_test_report(const unit_test_t *utp)
+{
+  printf("=check-me= ");
+  if(utp->result == unit_test_failure) {
+    printf("FAILED   - %s: exit at L%u\n", utp->descr, utp->exit_line);
+  } else {
+    printf("SUCCEEDED - %s\n", utp->descr);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Makes a pack of one record with the value as it is written */
+static int
+encode(int32_t value, int bits)
+{
+  size_t n;
+
+  memset(&ctx, 0, sizeof(ctx));
+  ctx.resource_id = 1;
+  pack[0] = 0x9f;
+  n = lwm2m_senml_cbor_writer.write_float32fix(&ctx, &pack[1],
+                                               sizeof(pack) - 2, value, bits);
+  if(n == 0) {
+    return 0;
+  }
+  pack[1 + n] = 0xff;
+  buffer.buffer = pack;
+  buffer.size = n + 2;
+  buffer.pos = 0;
+  ctx.inbuf = &buffer;
+  return lwm2m_senml_cbor_next_record(&ctx, &record);
+}
+/*---------------------------------------------------------------------------*/
+/* Reads the value of the record back */
+static int
+decode(int32_t *value, int bits)
+{
+  return lwm2m_senml_cbor_reader.read_float32fix(&ctx, record.value,
+                                                 record.value_len,
+                                                 value, bits) ==
+    record.value_len;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Writes and reads back a value with the given fraction bits, and checks
+ * that it took the given encoding: a CBOR float type or 0 for an integer.
+ */
+static int
+round_trip(int32_t value, int bits, uint8_t type, size_t len)
+{
+  int32_t result;
+
+  if(!encode(value, bits) || !decode(&result, bits) || result != value) {
+    printf("%ld with %d bits: read back %ld\n", (long)value, bits,
+           (long)result);
+    return 0;
+  }
+  if(record.value_len != len ||
+     (type == 0 ? record.value[0] >= 0x40 : record.value[0] != type)) {
+    printf("%ld with %d bits: 0x%02x, %u bytes\n", (long)value, bits,
+           record.value[0], record.value_len);
+    return 0;
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+/* Reads a value written by another encoder */
+static int
+read_value(const uint8_t *value, size_t len, int bits, int32_t *result)
+{
+  memset(&ctx, 0, sizeof(ctx));
+  record.value = value;
+  record.value_len = len;
+  return decode(result, bits);
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_integers, "Integers");
+UNIT_TEST(test_integers)
+{
+  UNIT_TEST_BEGIN();
+
+  /* Each length of a CBOR integer, either sign */
+  UNIT_TEST_ASSERT(round_trip(0, 0, 0, 1));
+  UNIT_TEST_ASSERT(round_trip(23, 0, 0, 1));
+  UNIT_TEST_ASSERT(round_trip(-24, 0, 0, 1));
+  UNIT_TEST_ASSERT(round_trip(24, 0, 0, 2));
+  UNIT_TEST_ASSERT(round_trip(-25, 0, 0, 2));
+  UNIT_TEST_ASSERT(round_trip(256, 0, 0, 3));
+  UNIT_TEST_ASSERT(round_trip(-65536, 0, 0, 3));
+  UNIT_TEST_ASSERT(round_trip(65536, 0, 0, 5));
+  UNIT_TEST_ASSERT(round_trip(INT32_MAX, 0, 0, 5));
+  UNIT_TEST_ASSERT(round_trip(INT32_MIN, 0, 0, 5));
+
+  /* Fixed point values without a fraction are written as integers */
+  UNIT_TEST_ASSERT(round_trip(5 << 10, 10, 0, 1));
+  UNIT_TEST_ASSERT(round_trip(-100 << 10, 10, 0, 2));
+  UNIT_TEST_ASSERT(round_trip(INT32_MIN, 10, 0, 5));
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_fractions, "Negative and fractional fixed point");
+UNIT_TEST(test_fractions)
+{
+  int32_t value;
+
+  UNIT_TEST_BEGIN();
+
+  UNIT_TEST_ASSERT(round_trip(3 << 9, 10, CBOR_HALF, 3)); /* 1.5 */
+  UNIT_TEST_ASSERT(memcmp(record.value, "\xf9\x3e\x00", 3) == 0);
+  UNIT_TEST_ASSERT(round_trip(-3 << 9, 10, CBOR_HALF, 3));
+  UNIT_TEST_ASSERT(memcmp(record.value, "\xf9\xbe\x00", 3) == 0);
+  UNIT_TEST_ASSERT(round_trip(1, 10, CBOR_HALF, 3)); /* 2^-10 */
+  UNIT_TEST_ASSERT(round_trip(-1, 10, CBOR_HALF, 3));
+  UNIT_TEST_ASSERT(round_trip(-(1 << 10) - 1, 10, CBOR_HALF, 3));
+  UNIT_TEST_ASSERT(round_trip(1, 0x1f, CBOR_FLOAT, 5)); /* 2^-31 */
+  UNIT_TEST_ASSERT(round_trip(-0x12345, 16, CBOR_FLOAT, 5));
+
+  /* Read with other fraction bits than written */
+  UNIT_TEST_ASSERT(encode(3 << 9, 10));
+  UNIT_TEST_ASSERT(decode(&value, 12) && value == 3 << 11);
+  UNIT_TEST_ASSERT(decode(&value, 0) && value == 1);
+  UNIT_TEST_ASSERT(encode(-3 << 9, 10));
+  UNIT_TEST_ASSERT(decode(&value, 0) && value == -1);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_precision, "Half, single or double precision");
+UNIT_TEST(test_precision)
+{
+  /* 1.0, 1.5, 0.1 and -2.75 from other encoders */
+  static const uint8_t half[] = { 0xf9, 0x3c, 0x00 };
+  static const uint8_t single[] = { 0xfa, 0x3f, 0xc0, 0x00, 0x00 };
+  static const uint8_t one_tenth[] = {
+    0xfb, 0x3f, 0xb9, 0x99, 0x99, 0x99, 0x99, 0x99, 0x9a
+  };
+  static const uint8_t negative[] = {
+    0xfb, 0xc0, 0x06, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+  };
+  int32_t value;
+
+  UNIT_TEST_BEGIN();
+
+  /* 11 significant bits fit a half, 12 do not */
+  UNIT_TEST_ASSERT(round_trip(0x7ff, 10, CBOR_HALF, 3));
+  UNIT_TEST_ASSERT(round_trip(0xfff, 10, CBOR_FLOAT, 5));
+  /* Below the smallest normal half */
+  UNIT_TEST_ASSERT(round_trip(1, 15, CBOR_FLOAT, 5));
+  UNIT_TEST_ASSERT(round_trip(1, 14, CBOR_HALF, 3));
+  /* Above the largest half */
+  UNIT_TEST_ASSERT(round_trip((1L << 26) + (1 << 9), 10, CBOR_FLOAT, 5));
+
+  /* 24 significant bits fit a single, 25 need a double */
+  UNIT_TEST_ASSERT(round_trip(0xffffff, 10, CBOR_FLOAT, 5));
+  UNIT_TEST_ASSERT(round_trip(0x1ffffff, 10, CBOR_DOUBLE, 9));
+  UNIT_TEST_ASSERT(round_trip(INT32_MAX, 10, CBOR_DOUBLE, 9));
+  UNIT_TEST_ASSERT(round_trip(INT32_MIN + 1, 10, CBOR_DOUBLE, 9));
+  UNIT_TEST_ASSERT(round_trip(-0x1234567, 20, CBOR_DOUBLE, 9));
+
+  UNIT_TEST_ASSERT(read_value(half, sizeof(half), 10, &value));
+  UNIT_TEST_ASSERT(value == 1 << 10);
+  UNIT_TEST_ASSERT(read_value(single, sizeof(single), 10, &value));
+  UNIT_TEST_ASSERT(value == 3 << 9);
+  UNIT_TEST_ASSERT(read_value(one_tenth, sizeof(one_tenth), 10, &value));
+  UNIT_TEST_ASSERT(value == 102);
+  UNIT_TEST_ASSERT(read_value(negative, sizeof(negative), 10, &value));
+  UNIT_TEST_ASSERT(value == -11 << 8);
+
+  /* Cut short */
+  UNIT_TEST_ASSERT(!read_value(single, sizeof(single) - 1, 10, &value));
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(senml_cbor_test_process, ev, data)
+{
+  PROCESS_BEGIN();
+
+  printf("Run unit-test\n");
+  printf("---\n");
+
+  UNIT_TEST_RUN(test_integers);
+  UNIT_TEST_RUN(test_fractions);
+  UNIT_TEST_RUN(test_precision);
+
+  printf("=check-me= DONE\n");
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
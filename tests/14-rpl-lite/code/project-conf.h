@@ -27,3 +27,11 @@
  * SUCH DAMAGE.
  */
 #define TCPIP_CONF_ANNOTATE_TRANSMISSIONS 1
+
+#if TEST_CONF_LOG_PROBES
+/* Log every RPL probe, so that simulation scripts can measure probing overhead */
+#define RPL_CONF_PROBING_SEND_FUNC(addr) do { \
+    printf("Probe sent\n"); \
+    rpl_icmp6_dio_output((addr)); \
+  } while(0)
+#endif /* TEST_CONF_LOG_PROBES */
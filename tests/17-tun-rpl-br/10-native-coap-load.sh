@@ -0,0 +1,47 @@
+#!/bin/bash
+source ../utils.sh
+
+# Contiki directory
+CONTIKI=$1
+# Test basename
+BASENAME=$(basename $0 .sh)
+
+IPADDR=fd00::302:304:506:708
+REQUESTS=5000
+
+# Starting Contiki-NG native node
+echo "Starting native CoAP server"
+make -C $CONTIKI/examples/coap/coap-example-server > make.log 2> make.err
+make -C $CONTIKI/tools/coap-load >> make.log 2>> make.err
+sudo $CONTIKI/examples/coap/coap-example-server/coap-example-server.native > node.log 2> node.err &
+CPID=$!
+sleep 2
+
+# Concurrent GET and PUT requests with an observer
+echo "Running CoAP load"
+timeout 120 $CONTIKI/tools/coap-load/coap-load -c 8 -n $REQUESTS -o 1 $IPADDR > $BASENAME.log 2>&1
+STATUS=$?
+cat $BASENAME.log
+COMPLETED=`awk '/^completed/ { print $2 }' $BASENAME.log`
+SUMMARY=`awk '/^throughput/ { t = $2 } /^latency/ { print t " req/s, p50 " $6 " ms, p99 " $9 " ms" }' $BASENAME.log`
+
+echo "Closing native node"
+sleep 2
+kill_bg $CPID
+
+if [ $STATUS -eq 0 ] && [ "$COMPLETED" == "$REQUESTS" ] ; then
+  printf "%-32s TEST OK    %s\n" "$BASENAME" "$SUMMARY" | tee $BASENAME.testlog;
+else
+  echo "==== make.log ====" ; cat make.log;
+  echo "==== make.err ====" ; cat make.err;
+  echo "==== node.log ====" ; cat node.log;
+  echo "==== node.err ====" ; cat node.err;
+
+  printf "%-32s TEST FAIL  %s/%d\n" "$BASENAME" "$COMPLETED" "$REQUESTS" | tee $BASENAME.testlog;
+fi
+
+rm -f make.log make.err node.log node.err
+
+# We do not want Make to stop -> Return 0
+# The Makefile will check if a log contains FAIL at the end
+exit 0
@@ -0,0 +1,67 @@
+#!/bin/bash
+source ../utils.sh
+
+# Contiki directory
+CONTIKI=$1
+# Test basename
+BASENAME=$(basename $0 .sh)
+
+NODE=$CONTIKI/tests/17-tun-rpl-br/code-mqtt-publisher
+BROKER=$CONTIKI/tools/mqtt-broker-stub/mqtt-broker-stub
+MESSAGES=500
+# Broker latency in ms, which the in-flight window hides
+DELAY=10
+
+make -C $CONTIKI/tools/mqtt-broker-stub > make.log 2> make.err
+
+# Publishes $MESSAGES messages with the given window, QoS and streamed
+# payload size (0 for none) through the broker stand-in, extra arguments go
+# to the broker
+run() {
+  WINDOW=$1
+  QOS=$2
+  SIZE=$3
+  shift 3
+  make -C $NODE clean >> make.log 2>> make.err
+  make -C $NODE DEFINES=MQTT_CONF_MAX_IN_FLIGHT=$WINDOW,MQTT_PUBLISHER_CONF_QOS=$QOS,MQTT_PUBLISHER_CONF_COUNT=$MESSAGES,MQTT_PUBLISHER_CONF_STREAM_SIZE=$SIZE >> make.log 2>> make.err
+
+  echo "Window $WINDOW, QoS $QOS, stream $SIZE $@" | tee -a $BASENAME.log
+  $BROKER -n $MESSAGES -d $DELAY -t 60 -s $SIZE "$@" > broker.log 2>&1 &
+  BPID=$!
+  sleep 1
+  sudo $NODE/mqtt-publisher.native > node.log 2> node.err &
+  CPID=$!
+  wait $BPID
+  STATUS=$?
+  cat broker.log >> $BASENAME.log
+  sleep 1
+  kill_bg $CPID
+  cat node.log >> $BASENAME.node.log
+  return $STATUS
+}
+
+echo "Running MQTT publishers"
+rm -f $BASENAME.log $BASENAME.node.log
+run 1 1 0 && RATE1=`awk '/^throughput/ { print $2 }' broker.log` &&
+run 8 1 0 && RATE8=`awk '/^throughput/ { print $2 }' broker.log` &&
+run 8 2 0 -k 100 && RETRANSMITTED=`awk '/^received/ { print $3 }' broker.log` &&
+run 4 2 2000 -k 100
+STATUS=$?
+cat $BASENAME.log
+
+if [ $STATUS -eq 0 ] && [ "$RETRANSMITTED" -gt 0 ] ; then
+  printf "%-32s TEST OK    %s msg/s with a window of 1, %s with 8\n" "$BASENAME" "$RATE1" "$RATE8" | tee $BASENAME.testlog;
+else
+  echo "==== make.log ====" ; cat make.log;
+  echo "==== make.err ====" ; cat make.err;
+  echo "==== node.log ====" ; cat $BASENAME.node.log;
+  echo "==== node.err ====" ; cat node.err;
+
+  printf "%-32s TEST FAIL\n" "$BASENAME" | tee $BASENAME.testlog;
+fi
+
+rm -f make.log make.err broker.log node.log node.err $BASENAME.node.log
+
+# We do not want Make to stop -> Return 0
+# The Makefile will check if a log contains FAIL at the end
+exit 0
@@ -0,0 +1,52 @@
+#!/bin/bash
+source ../utils.sh
+
+# Contiki directory
+CONTIKI=$1
+# Test basename
+BASENAME=$(basename $0 .sh)
+
+NODE=$CONTIKI/tests/17-tun-rpl-br/code-mqtt-sn-gateway
+BROKER=$CONTIKI/tools/mqtt-broker-stub/mqtt-broker-stub
+CLIENT=$CONTIKI/tests/17-tun-rpl-br/mqtt-sn-client.py
+# The gateway node, as its address is derived from the native link-layer address
+GATEWAY=fd00::302:304:506:708
+
+make -C $CONTIKI/tools/mqtt-broker-stub > make.log 2> make.err
+make -C $NODE TARGET=native >> make.log 2>> make.err
+
+# The broker expects the messages 0 to 2 with QoS 1 and 2, and echoes them
+# back for the sleeping client
+echo "Starting broker and MQTT-SN gateway"
+$BROKER -n 3 -t 60 -e > broker.log 2>&1 &
+BPID=$!
+sleep 1
+sudo $NODE/mqtt-sn-gw.native > node.log 2> node.err &
+CPID=$!
+sleep 5
+
+echo "Running MQTT-SN clients"
+python3 $CLIENT $GATEWAY > $BASENAME.log 2>&1
+STATUS=$?
+wait $BPID
+BSTATUS=$?
+cat broker.log >> $BASENAME.log
+kill_bg $CPID
+
+if [ $STATUS -eq 0 ] && [ $BSTATUS -eq 0 ] && grep -q "QoS 2" broker.log ; then
+  printf "%-32s TEST OK\n" "$BASENAME" | tee $BASENAME.testlog;
+else
+  echo "==== make.log ====" ; cat make.log;
+  echo "==== make.err ====" ; cat make.err;
+  echo "==== $BASENAME.log ====" ; cat $BASENAME.log;
+  echo "==== node.log ====" ; cat node.log;
+  echo "==== node.err ====" ; cat node.err;
+
+  printf "%-32s TEST FAIL\n" "$BASENAME" | tee $BASENAME.testlog;
+fi
+
+rm -f make.log make.err broker.log node.log node.err
+
+# We do not want Make to stop -> Return 0
+# The Makefile will check if a log contains FAIL at the end
+exit 0
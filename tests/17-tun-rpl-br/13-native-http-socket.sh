@@ -0,0 +1,49 @@
+#!/bin/bash
+source ../utils.sh
+
+# Contiki directory
+CONTIKI=$1
+# Test basename
+BASENAME=$(basename $0 .sh)
+
+NODE=$CONTIKI/tests/17-tun-rpl-br/code-http-socket
+SERVER=$CONTIKI/tests/17-tun-rpl-br/http-server.py
+
+make -C $NODE TARGET=native > make.log 2> make.err
+
+# The server closes connections idle for a second, the node fetches the
+# last resource after waiting longer than that
+echo "Starting HTTP server and node"
+python3 $SERVER 8080 > server.log 2>&1 &
+SPID=$!
+sleep 1
+sudo $NODE/http-socket-client.native > node.log 2> node.err &
+CPID=$!
+
+for i in $(seq 30); do
+  sleep 1
+  grep -q "All responses OK\|FAILED" node.log && break
+done
+kill_bg $CPID
+kill_bg $SPID
+cat node.log server.log > $BASENAME.log
+
+# Four requests over the first connection, one over the second
+if grep -q "All responses OK" node.log &&
+   [ $(grep -c "^connection" server.log) -eq 2 ] ; then
+  printf "%-32s TEST OK\n" "$BASENAME" | tee $BASENAME.testlog;
+else
+  echo "==== make.log ====" ; cat make.log;
+  echo "==== make.err ====" ; cat make.err;
+  echo "==== node.log ====" ; cat node.log;
+  echo "==== node.err ====" ; cat node.err;
+  echo "==== server.log ====" ; cat server.log;
+
+  printf "%-32s TEST FAIL\n" "$BASENAME" | tee $BASENAME.testlog;
+fi
+
+rm -f make.log make.err server.log node.log node.err
+
+# We do not want Make to stop -> Return 0
+# The Makefile will check if a log contains FAIL at the end
+exit 0
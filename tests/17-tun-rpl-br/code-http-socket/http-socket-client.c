@@ -0,0 +1,183 @@
+/*
+ * Copyright (c) 2026, Contiki-NG contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         Fetches a number of resources from tests/17-tun-rpl-br/http-server.py
+ *         over one kept-alive connection and checks the bodies. The server
+ *         then closes the idle connection, and the last resource has to be
+ *         fetched over a new one.
+ */
+
+#include "contiki.h"
+#include "http-socket.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "sys/log.h"
+#define LOG_MODULE "App"
+#define LOG_LEVEL LOG_LEVEL_INFO
+/*---------------------------------------------------------------------------*/
+#define SERVER "http://[fd00::1]:8080"
+
+#define CHUNKED_BODY "hello, abcdefghijklmnopqrstuvwxyz"
+#define LENGTH_BODY "a body with a Content-Length"
+
+/* Longer than the idle timeout of http-server.py */
+#define IDLE_WAIT (3 * CLOCK_SECOND)
+
+static const struct {
+  const char *path;
+  const char *body;
+} requests[] = {
+  /* Written to the connection a byte at a time */
+  { "/chunked?split=1", CHUNKED_BODY },
+  { "/empty", "" },
+  { "/length", LENGTH_BODY },
+  /* Chunk sizes, data and CRLFs split at every other offset */
+  { "/chunked?split=3", CHUNKED_BODY },
+  /* After the server closed the idle connection */
+  { "/chunked?split=3", CHUNKED_BODY },
+};
+#define REQUEST_COUNT (sizeof(requests) / sizeof(requests[0]))
+#define FIRST_AFTER_IDLE (REQUEST_COUNT - 1)
+/*---------------------------------------------------------------------------*/
+static struct http_socket s;
+static char url[HTTP_SOCKET_URLLEN];
+static char body[64];
+static uint16_t bodylen;
+static int busy;
+static int completed;
+/* Connections closed while no request was going on */
+static int closed;
+static int failed;
+/*---------------------------------------------------------------------------*/
+PROCESS(http_socket_client_process, "HTTP socket client");
+AUTOSTART_PROCESSES(&http_socket_client_process);
+/*---------------------------------------------------------------------------*/
+static void
+callback(struct http_socket *hs, void *ptr, http_socket_event_t ev,
+         const uint8_t *data, uint16_t datalen)
+{
+  switch(ev) {
+  case HTTP_SOCKET_HEADER:
+    break;
+  case HTTP_SOCKET_DATA:
+    if(bodylen + datalen > sizeof(body)) {
+      LOG_ERR("Body too long\n");
+      failed = 1;
+      break;
+    }
+    memcpy(body + bodylen, data, datalen);
+    bodylen += datalen;
+    break;
+  case HTTP_SOCKET_COMPLETE:
+    busy = 0;
+    completed = 1;
+    process_poll(&http_socket_client_process);
+    break;
+  case HTTP_SOCKET_CLOSED:
+    if(busy) {
+      LOG_ERR("Closed before the response was complete\n");
+      failed = 1;
+    } else {
+      closed++;
+    }
+    process_poll(&http_socket_client_process);
+    break;
+  default:
+    LOG_ERR("Event %d\n", ev);
+    failed = 1;
+    process_poll(&http_socket_client_process);
+    break;
+  }
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(http_socket_client_process, ev, data)
+{
+  static struct etimer et;
+  static unsigned i;
+
+  PROCESS_BEGIN();
+
+  /* Let the tun interface come up */
+  etimer_set(&et, CLOCK_SECOND);
+  PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+
+  http_socket_init(&s);
+
+  for(i = 0; i < REQUEST_COUNT && !failed; i++) {
+    if(i == FIRST_AFTER_IDLE) {
+      etimer_set(&et, IDLE_WAIT);
+      PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+      if(closed != 1) {
+        LOG_ERR("Idle connection not closed by the server\n");
+        failed = 1;
+        break;
+      }
+    }
+
+    snprintf(url, sizeof(url), "%s%s", SERVER, requests[i].path);
+    bodylen = 0;
+    completed = 0;
+    busy = 1;
+    if(http_socket_get(&s, url, 0, 0, callback, NULL) != HTTP_SOCKET_OK) {
+      LOG_ERR("GET %s refused\n", requests[i].path);
+      failed = 1;
+      break;
+    }
+    PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_POLL && (completed || failed));
+    if(!completed) {
+      LOG_ERR("GET %s not completed\n", requests[i].path);
+      failed = 1;
+      break;
+    }
+    if(bodylen != strlen(requests[i].body) ||
+       memcmp(body, requests[i].body, bodylen) != 0) {
+      LOG_ERR("GET %s: body \"%.*s\"\n", requests[i].path, bodylen, body);
+      failed = 1;
+      break;
+    }
+    LOG_INFO("GET %s: %u bytes\n", requests[i].path, bodylen);
+  }
+
+  if(failed) {
+    LOG_INFO("FAILED\n");
+  } else {
+    LOG_INFO("All responses OK\n");
+  }
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
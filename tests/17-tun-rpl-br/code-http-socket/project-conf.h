@@ -0,0 +1,10 @@
+#ifndef PROJECT_CONF_H_
+#define PROJECT_CONF_H_
+
+#define UIP_CONF_TCP 1
+
+#define HTTP_SOCKET_CONF_KEEP_ALIVE 1
+/* Longer than the idle timeout of http-server.py, which closes first */
+#define HTTP_SOCKET_CONF_IDLE_TIMEOUT (10 * CLOCK_SECOND)
+
+#endif /* PROJECT_CONF_H_ */
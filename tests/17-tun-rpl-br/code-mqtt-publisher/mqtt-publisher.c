@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) 2026, Contiki-NG contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         Publishes a number of messages to a broker as fast as the MQTT
+ *         in-flight window allows. The payload of each message is its
+ *         sequence number, as tools/mqtt-broker-stub expects. With
+ *         MQTT_PUBLISHER_CONF_STREAM_SIZE it is streamed instead, padded
+ *         to that size with the alphabet.
+ */
+
+#include "contiki.h"
+#include "mqtt.h"
+
+#include <stdio.h>
+
+#include "sys/log.h"
+#define LOG_MODULE "App"
+#define LOG_LEVEL LOG_LEVEL_INFO
+/*---------------------------------------------------------------------------*/
+#ifdef MQTT_PUBLISHER_CONF_BROKER
+#define BROKER MQTT_PUBLISHER_CONF_BROKER
+#else
+#define BROKER "fd00::1"
+#endif
+
+#ifdef MQTT_PUBLISHER_CONF_COUNT
+#define COUNT MQTT_PUBLISHER_CONF_COUNT
+#else
+#define COUNT 1000
+#endif
+
+#ifdef MQTT_PUBLISHER_CONF_QOS
+#define QOS MQTT_PUBLISHER_CONF_QOS
+#else
+#define QOS MQTT_QOS_LEVEL_1
+#endif
+
+/* Payload size of streamed messages, 0 to publish from buffers */
+#ifdef MQTT_PUBLISHER_CONF_STREAM_SIZE
+#define STREAM_SIZE MQTT_PUBLISHER_CONF_STREAM_SIZE
+#else
+#define STREAM_SIZE 0
+#endif
+
+#define TOPIC "bench/seq"
+#define KEEP_ALIVE 60
+#define MAX_SEGMENT_SIZE 256
+/*---------------------------------------------------------------------------*/
+static struct mqtt_connection conn;
+
+/*
+ * A buffer for each message in flight and one for the next message, the
+ * broker acknowledges them in order
+ */
+#define BUFFERS (MQTT_MAX_IN_FLIGHT + 1)
+static char payload[BUFFERS][12];
+
+static unsigned long sent;
+static unsigned long completed;
+/*---------------------------------------------------------------------------*/
+static int
+produce(struct mqtt_connection *m, void *ptr, uint32_t offset,
+        uint8_t *buf, uint16_t len)
+{
+  char seq[12];
+  uint32_t seq_len;
+  uint16_t i;
+
+  seq_len = snprintf(seq, sizeof(seq), "%lu ", (unsigned long)(uintptr_t)ptr);
+  for(i = 0; i < len; i++, offset++) {
+    buf[i] = offset < seq_len ? seq[offset] : 'a' + offset % 26;
+  }
+  return len;
+}
+/*---------------------------------------------------------------------------*/
+PROCESS(mqtt_publisher_process, "MQTT publisher");
+AUTOSTART_PROCESSES(&mqtt_publisher_process);
+/*---------------------------------------------------------------------------*/
+static void
+mqtt_event(struct mqtt_connection *m, mqtt_event_t event, void *data)
+{
+  switch(event) {
+  case MQTT_EVENT_CONNECTED:
+    LOG_INFO("Connected\n");
+    break;
+  case MQTT_EVENT_DISCONNECTED:
+    LOG_INFO("Disconnected\n");
+    break;
+  case MQTT_EVENT_PUBACK:
+  case MQTT_EVENT_PUBCOMP:
+    completed++;
+    break;
+  case MQTT_EVENT_PUBLISH_FAILED:
+    LOG_WARN("Message %u dropped\n", *(uint16_t *)data);
+    completed++;
+    break;
+  default:
+    break;
+  }
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(mqtt_publisher_process, ev, data)
+{
+  static clock_time_t start;
+  mqtt_status_t status;
+  char *buf;
+
+  PROCESS_BEGIN();
+
+  mqtt_register(&conn, &mqtt_publisher_process, "contiki-bench", mqtt_event,
+                MAX_SEGMENT_SIZE);
+  /* Keep the session, so that messages are resent after a reconnect */
+  mqtt_set_clean_session(&conn, 0);
+  mqtt_connect(&conn, BROKER, 1883, KEEP_ALIVE);
+
+  PROCESS_WAIT_EVENT_UNTIL(ev == mqtt_update_event && mqtt_connected(&conn));
+
+  LOG_INFO("Publishing %u messages with QoS %u, window of %u\n",
+           COUNT, QOS, MQTT_MAX_IN_FLIGHT);
+  start = clock_time();
+
+  while(completed < COUNT) {
+    /* Fill the window, mqtt_publish() refuses once it is full */
+    while(sent < COUNT) {
+      if(STREAM_SIZE > 0) {
+        status = mqtt_publish_stream(&conn, NULL, TOPIC, STREAM_SIZE, QOS,
+                                     MQTT_RETAIN_OFF, produce,
+                                     (void *)(uintptr_t)sent);
+      } else {
+        buf = payload[sent % BUFFERS];
+        snprintf(buf, sizeof(payload[0]), "%lu", sent);
+        status = mqtt_publish(&conn, NULL, TOPIC, (uint8_t *)buf, strlen(buf),
+                              QOS, MQTT_RETAIN_OFF);
+      }
+      if(status != MQTT_STATUS_OK) {
+        break;
+      }
+      sent++;
+      if(QOS == MQTT_QOS_LEVEL_0) {
+        completed++;
+      }
+    }
+    PROCESS_WAIT_EVENT_UNTIL(ev == mqtt_update_event);
+  }
+
+  LOG_INFO("Published %lu messages in %lu ms\n", completed,
+           (unsigned long)((clock_time() - start) * 1000 / CLOCK_SECOND));
+
+  mqtt_disconnect(&conn);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
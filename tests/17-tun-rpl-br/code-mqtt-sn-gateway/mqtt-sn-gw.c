@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2026, Contiki-NG contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         Runs the MQTT-SN gateway on a native node, with the broker on the
+ *         host side of the tun interface. The gateway is reached over tun
+ *         by the MQTT-SN clients of mqtt-sn-client.py.
+ */
+
+#include "contiki.h"
+#include "mqtt-sn-gateway.h"
+
+#include "sys/log.h"
+#define LOG_MODULE "App"
+#define LOG_LEVEL LOG_LEVEL_INFO
+/*---------------------------------------------------------------------------*/
+#ifdef MQTT_SN_GW_CONF_BROKER
+#define BROKER MQTT_SN_GW_CONF_BROKER
+#else
+#define BROKER "fd00::1"
+#endif
+/*---------------------------------------------------------------------------*/
+PROCESS(mqtt_sn_gw_process, "MQTT-SN gateway node");
+AUTOSTART_PROCESSES(&mqtt_sn_gw_process);
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(mqtt_sn_gw_process, ev, data)
+{
+  PROCESS_BEGIN();
+
+  mqtt_sn_gateway_init(BROKER, 1883, "contiki-gw");
+  LOG_INFO("MQTT-SN gateway started, broker at %s\n", BROKER);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,74 @@
+#!/usr/bin/env python3
+#
+# HTTP/1.1 server for 13-native-http-socket.sh. Chunked responses are
+# written a few bytes at a time, so that chunk sizes, data and CRLFs end up
+# split across TCP segments. Connections are kept alive, but closed after
+# IDLE_TIMEOUT without a request. Every new connection is logged.
+
+import http.server
+import socket
+import socketserver
+import sys
+import time
+import urllib.parse
+
+CHUNKS = [b'hello', b', ', b'abcdefghijklmnopqrstuvwxyz']
+LENGTH_BODY = b'a body with a Content-Length'
+
+IDLE_TIMEOUT = 1
+SEGMENT_DELAY = 0.02
+
+
+class Handler(http.server.BaseHTTPRequestHandler):
+    protocol_version = 'HTTP/1.1'
+    timeout = IDLE_TIMEOUT
+
+    def setup(self):
+        super().setup()
+        self.connection.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        self.server.connections += 1
+        print('connection %d from %s' % (self.server.connections,
+                                         self.client_address[0]), flush=True)
+
+    def do_GET(self):
+        url = urllib.parse.urlparse(self.path)
+        if url.path == '/chunked':
+            split = int(urllib.parse.parse_qs(url.query)['split'][0])
+            self.send_response(200)
+            self.send_header('Transfer-Encoding', 'chunked')
+            self.end_headers()
+            raw = b''.join(b'%x\r\n%s\r\n' % (len(c), c) for c in CHUNKS)
+            raw += b'0\r\n\r\n'
+            for i in range(0, len(raw), split):
+                self.wfile.write(raw[i:i + split])
+                time.sleep(SEGMENT_DELAY)
+        elif url.path == '/empty':
+            self.send_response(200)
+            self.send_header('Content-Length', '0')
+            self.end_headers()
+        elif url.path == '/length':
+            self.send_response(200)
+            self.send_header('Content-Length', str(len(LENGTH_BODY)))
+            self.end_headers()
+            half = len(LENGTH_BODY) // 2
+            self.wfile.write(LENGTH_BODY[:half])
+            time.sleep(SEGMENT_DELAY)
+            self.wfile.write(LENGTH_BODY[half:])
+        else:
+            self.send_error(404)
+
+
+class Server(socketserver.TCPServer):
+    address_family = socket.AF_INET6
+    allow_reuse_address = True
+    connections = 0
+
+
+def main():
+    port = int(sys.argv[1]) if len(sys.argv) > 1 else 8080
+    with Server(('::', port), Handler) as server:
+        server.serve_forever()
+
+
+if __name__ == '__main__':
+    main()
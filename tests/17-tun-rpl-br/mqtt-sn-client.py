@@ -0,0 +1,165 @@
+#!/usr/bin/env python3
+#
+# MQTT-SN clients for 12-native-mqtt-sn-gateway.sh. A publisher sends
+# messages with QoS 1 and 2 through the gateway to tools/mqtt-broker-stub,
+# which echoes them on echo/<topic>. A sleeping client subscribed to echo/#
+# has to get them when it wakes up. Exits with 0 if all went as expected.
+
+import socket
+import struct
+import sys
+import time
+
+CONNECT = 0x04
+CONNACK = 0x05
+REGISTER = 0x0A
+REGACK = 0x0B
+PUBLISH = 0x0C
+PUBACK = 0x0D
+PUBCOMP = 0x0E
+PUBREC = 0x0F
+PUBREL = 0x10
+SUBSCRIBE = 0x12
+SUBACK = 0x13
+PINGREQ = 0x16
+PINGRESP = 0x17
+DISCONNECT = 0x18
+
+FLAG_CLEAN_SESSION = 0x04
+QOS_1 = 0x20
+QOS_2 = 0x40
+
+TIMEOUT = 5
+
+
+class Client:
+    def __init__(self, gateway, port, client_id):
+        self.gateway = (gateway, port)
+        self.client_id = client_id.encode()
+        self.sock = socket.socket(socket.AF_INET6, socket.SOCK_DGRAM)
+        self.sock.settimeout(TIMEOUT)
+        self.msg_id = 0
+
+    def next_msg_id(self):
+        self.msg_id += 1
+        return self.msg_id
+
+    def send(self, msg_type, body=b''):
+        self.sock.sendto(bytes([2 + len(body), msg_type]) + body, self.gateway)
+
+    def receive(self):
+        data, _ = self.sock.recvfrom(1024)
+        if data[0] == 1:
+            return data[3], data[4:]
+        return data[1], data[2:]
+
+    def expect(self, msg_type):
+        got, body = self.receive()
+        if got != msg_type:
+            raise RuntimeError('%s: expected 0x%02x, got 0x%02x' %
+                               (self.client_id.decode(), msg_type, got))
+        return body
+
+    def connect(self, duration=60):
+        self.send(CONNECT, struct.pack('!BBH', FLAG_CLEAN_SESSION, 1,
+                                       duration) + self.client_id)
+        body = self.expect(CONNACK)
+        check(body[0] == 0, 'connection refused')
+
+    def register(self, topic):
+        msg_id = self.next_msg_id()
+        self.send(REGISTER, struct.pack('!HH', 0, msg_id) + topic.encode())
+        topic_id, acked, rc = struct.unpack('!HHB', self.expect(REGACK))
+        check(acked == msg_id and rc == 0, 'REGISTER refused')
+        return topic_id
+
+    def subscribe(self, topic):
+        msg_id = self.next_msg_id()
+        self.send(SUBSCRIBE, struct.pack('!BH', 0, msg_id) + topic.encode())
+        _, _, acked, rc = struct.unpack('!BHHB', self.expect(SUBACK))
+        check(acked == msg_id and rc == 0, 'SUBSCRIBE refused')
+
+    def publish(self, topic_id, qos, payload):
+        msg_id = self.next_msg_id()
+        self.send(PUBLISH, struct.pack('!BHH', qos, topic_id, msg_id) +
+                  payload.encode())
+        if qos == QOS_1:
+            _, acked, rc = struct.unpack('!HHB', self.expect(PUBACK))
+            check(acked == msg_id and rc == 0, 'QoS 1 PUBLISH refused')
+        elif qos == QOS_2:
+            check(struct.unpack('!H', self.expect(PUBREC))[0] == msg_id,
+                  'PUBREC for another message')
+            self.send(PUBREL, struct.pack('!H', msg_id))
+            check(struct.unpack('!H', self.expect(PUBCOMP))[0] == msg_id,
+                  'PUBCOMP for another message')
+
+    def sleep(self, duration):
+        self.send(DISCONNECT, struct.pack('!H', duration))
+        self.expect(DISCONNECT)
+
+    def wake_up(self):
+        """Returns the messages held for the client as (topic, payload)"""
+        topics = {}
+        messages = []
+        self.send(PINGREQ, self.client_id)
+        while True:
+            msg_type, body = self.receive()
+            if msg_type == PINGRESP:
+                return messages
+            if msg_type == REGISTER:
+                topic_id, msg_id = struct.unpack('!HH', body[:4])
+                topics[topic_id] = body[4:].decode()
+                self.send(REGACK, struct.pack('!HHB', topic_id, msg_id, 0))
+            elif msg_type == PUBLISH:
+                topic_id = struct.unpack('!H', body[1:3])[0]
+                messages.append((topics.get(topic_id), body[5:].decode()))
+            else:
+                raise RuntimeError('unexpected message 0x%02x' % msg_type)
+
+    def disconnect(self):
+        self.send(DISCONNECT)
+        self.expect(DISCONNECT)
+
+
+def check(condition, what):
+    if not condition:
+        raise RuntimeError(what)
+
+
+def main():
+    gateway = sys.argv[1]
+    port = int(sys.argv[2]) if len(sys.argv) > 2 else 1883
+
+    sleeper = Client(gateway, port, 'sn-sleeper')
+    sleeper.connect()
+    sleeper.subscribe('echo/#')
+    sleeper.sleep(30)
+    print('sleeper subscribed to echo/# and asleep')
+
+    publisher = Client(gateway, port, 'sn-publisher')
+    publisher.connect()
+    topic_id = publisher.register('sn/seq')
+    publisher.publish(topic_id, QOS_1, '0')
+    print('QoS 1 message acknowledged')
+    publisher.publish(topic_id, QOS_2, '1')
+    print('QoS 2 message completed')
+
+    # let the echoes reach the gateway
+    time.sleep(1)
+    messages = sleeper.wake_up()
+    print('held for the sleeper: %s' % messages)
+    check(messages == [('echo/sn/seq', '0'), ('echo/sn/seq', '1')],
+          'messages held during sleep not delivered')
+
+    # the last message the broker waits for
+    publisher.publish(topic_id, QOS_1, '2')
+    publisher.disconnect()
+    print('OK')
+
+
+if __name__ == '__main__':
+    try:
+        main()
+    except (RuntimeError, socket.timeout) as e:
+        print('FAILED: %s' % e)
+        sys.exit(1)
@@ -0,0 +1,671 @@
+/*
+ * Copyright (c) 2026, Contiki-NG contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         CoAP load generator: keeps a number of GET and PUT requests in
+ *         flight against a CoAP server, optionally with observers, and
+ *         reports throughput, latency percentiles and retransmissions.
+ *         Meant to be run on the host against a native node over tun.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+
+#include <err.h>
+
+#define COAP_DEFAULT_PORT "5683"
+
+#define TYPE_CON 0
+#define TYPE_NON 1
+#define TYPE_ACK 2
+#define TYPE_RST 3
+
+#define CODE_GET 1
+#define CODE_PUT 3
+
+#define OPTION_OBSERVE        6
+#define OPTION_URI_PATH       11
+#define OPTION_CONTENT_FORMAT 12
+
+#define TEXT_PLAIN 0
+
+/* RFC 7252, Section 4.8 */
+#define MAX_RETRANSMIT 4
+#define MAX_LATENCY    100000 /* ms */
+
+#define MAX_MESSAGE_SIZE 256
+#define TOKEN_LEN 4
+
+#define MAX_CONCURRENCY 64
+#define MAX_OBSERVERS 16
+
+typedef struct {
+  uint8_t message[MAX_MESSAGE_SIZE];
+  size_t len;
+  uint32_t token;
+  uint16_t mid;
+  uint8_t code;
+  uint8_t active;
+  /* an empty ACK was received, the response comes separately
+     until EXCHANGE_LIFETIME at the latest */
+  uint8_t acked;
+  uint8_t retransmits;
+  uint8_t observing;
+  uint64_t start;
+  uint64_t deadline;
+  unsigned int timeout;
+} exchange_t;
+
+static exchange_t requests[MAX_CONCURRENCY];
+static exchange_t observers[MAX_OBSERVERS];
+
+static int sock;
+
+static unsigned int concurrency = 4;
+static unsigned long total = 1000;
+static unsigned int duration;
+static unsigned int num_observers;
+static unsigned int ack_timeout = 2000;
+static int confirmable = 1;
+static const char *mode = "mix";
+static const char *get_path = "test/hello";
+static const char *put_path = "debug/mirror";
+static const char *observe_path = "test/push";
+
+static uint16_t next_mid;
+static uint16_t next_seq;
+
+static unsigned long started;
+static unsigned long completed;
+static unsigned long failed;
+static unsigned long retransmits;
+static unsigned long notifications;
+static unsigned long unexpected;
+
+static uint32_t *latencies;
+static unsigned long latencies_size;
+/*---------------------------------------------------------------------------*/
+static uint64_t
+now_us(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+put_option(uint8_t *buf, unsigned int *last, unsigned int number,
+           const uint8_t *value, size_t len)
+{
+  unsigned int delta = number - *last;
+  size_t n = 1;
+
+  /* only what the requests here need: deltas and lengths below 269 */
+  buf[0] = 0;
+  if(delta < 13) {
+    buf[0] = delta << 4;
+  } else {
+    buf[0] = 13 << 4;
+    buf[n++] = delta - 13;
+  }
+  if(len < 13) {
+    buf[0] |= len;
+  } else {
+    buf[0] |= 13;
+    buf[n++] = len - 13;
+  }
+  memcpy(&buf[n], value, len);
+  *last = number;
+  return n + len;
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+put_uri_path(uint8_t *buf, unsigned int *last, const char *path)
+{
+  size_t n = 0;
+  const char *end;
+
+  while(*path == '/') {
+    path++;
+  }
+  while(*path != '\0') {
+    end = strchr(path, '/');
+    if(end == NULL) {
+      end = path + strlen(path);
+    }
+    n += put_option(&buf[n], last, OPTION_URI_PATH,
+                    (const uint8_t *)path, end - path);
+    path = *end == '/' ? end + 1 : end;
+  }
+  return n;
+}
+/*---------------------------------------------------------------------------*/
+static void
+build_request(exchange_t *e, int type, uint8_t code, const char *path,
+              int observe, const char *payload)
+{
+  uint8_t *buf = e->message;
+  unsigned int last = 0;
+  size_t n = 4;
+  uint8_t value;
+
+  e->mid = next_mid++;
+  e->code = code;
+
+  buf[0] = (1 << 6) | (type << 4) | TOKEN_LEN;
+  buf[1] = code;
+  buf[2] = e->mid >> 8;
+  buf[3] = e->mid;
+  buf[n++] = e->token >> 24;
+  buf[n++] = e->token >> 16;
+  buf[n++] = e->token >> 8;
+  buf[n++] = e->token;
+
+  if(observe >= 0) {
+    value = observe;
+    n += put_option(&buf[n], &last, OPTION_OBSERVE, &value, observe ? 1 : 0);
+  }
+  n += put_uri_path(&buf[n], &last, path);
+  if(payload != NULL) {
+    value = TEXT_PLAIN;
+    n += put_option(&buf[n], &last, OPTION_CONTENT_FORMAT, &value, 0);
+    buf[n++] = 0xFF;
+    memcpy(&buf[n], payload, strlen(payload));
+    n += strlen(payload);
+  }
+  e->len = n;
+}
+/*---------------------------------------------------------------------------*/
+/* EXCHANGE_LIFETIME (RFC 7252, Section 4.8.2) for the configured ACK_TIMEOUT */
+static uint64_t
+exchange_lifetime(void)
+{
+  uint64_t max_transmit_span;
+
+  max_transmit_span = (uint64_t)ack_timeout * ((1 << MAX_RETRANSMIT) - 1) * 3 / 2;
+  return max_transmit_span + 2 * MAX_LATENCY + ack_timeout;
+}
+/*---------------------------------------------------------------------------*/
+static void
+transmit(exchange_t *e)
+{
+  if(send(sock, e->message, e->len, 0) < 0 && errno != ENOBUFS) {
+    err(1, "send");
+  }
+  e->deadline = now_us() + (uint64_t)e->timeout * 1000;
+}
+/*---------------------------------------------------------------------------*/
+static void
+send_empty(int type, uint16_t mid)
+{
+  uint8_t buf[4];
+
+  buf[0] = (1 << 6) | (type << 4);
+  buf[1] = 0;
+  buf[2] = mid >> 8;
+  buf[3] = mid;
+  if(send(sock, buf, sizeof(buf), 0) < 0 && errno != ENOBUFS) {
+    err(1, "send");
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+start_exchange(exchange_t *e)
+{
+  e->active = 1;
+  e->acked = 0;
+  e->retransmits = 0;
+  /* ACK_TIMEOUT scaled by a random factor between 1 and 1.5 */
+  e->timeout = ack_timeout + random() % (ack_timeout / 2 + 1);
+  e->start = now_us();
+  transmit(e);
+}
+/*---------------------------------------------------------------------------*/
+static void
+start_request(exchange_t *e)
+{
+  static const char payload[] = "coap-load";
+  int put;
+
+  if(strcmp(mode, "get") == 0) {
+    put = 0;
+  } else if(strcmp(mode, "put") == 0) {
+    put = 1;
+  } else {
+    put = started & 1;
+  }
+
+  e->token = ((uint32_t)(e - requests) << 16) | next_seq++;
+  build_request(e, confirmable ? TYPE_CON : TYPE_NON,
+                put ? CODE_PUT : CODE_GET, put ? put_path : get_path,
+                -1, put ? payload : NULL);
+  start_exchange(e);
+  started++;
+}
+/*---------------------------------------------------------------------------*/
+static void
+finish_request(exchange_t *e, int success)
+{
+  uint32_t *grown;
+
+  e->active = 0;
+  if(!success) {
+    failed++;
+    return;
+  }
+  completed++;
+  if(completed > latencies_size) {
+    latencies_size = latencies_size ? latencies_size * 2 : 1024;
+    if((grown = realloc(latencies, latencies_size * sizeof(*latencies))) == NULL) {
+      err(1, "realloc");
+    }
+    latencies = grown;
+  }
+  latencies[completed - 1] = now_us() - e->start;
+}
+/*---------------------------------------------------------------------------*/
+static exchange_t *
+find_by_mid(uint16_t mid)
+{
+  unsigned int i;
+
+  for(i = 0; i < concurrency; i++) {
+    if(requests[i].active && requests[i].mid == mid) {
+      return &requests[i];
+    }
+  }
+  for(i = 0; i < num_observers; i++) {
+    if(observers[i].active && observers[i].mid == mid) {
+      return &observers[i];
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static exchange_t *
+find_by_token(const uint8_t *token, uint8_t token_len)
+{
+  uint32_t t;
+  unsigned int i;
+
+  if(token_len != TOKEN_LEN) {
+    return NULL;
+  }
+  t = ((uint32_t)token[0] << 24) | ((uint32_t)token[1] << 16)
+    | ((uint32_t)token[2] << 8) | token[3];
+  for(i = 0; i < concurrency; i++) {
+    if(requests[i].active && requests[i].token == t) {
+      return &requests[i];
+    }
+  }
+  for(i = 0; i < num_observers; i++) {
+    if((observers[i].active || observers[i].observing)
+       && observers[i].token == t) {
+      return &observers[i];
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static int
+is_observer(const exchange_t *e)
+{
+  return e >= observers && e < &observers[MAX_OBSERVERS];
+}
+/*---------------------------------------------------------------------------*/
+static void
+handle_response(exchange_t *e, uint8_t code)
+{
+  if(is_observer(e)) {
+    if(e->active) {
+      /* the registration, answered with the current representation */
+      e->active = 0;
+      e->observing = (code >> 5) == 2;
+      if(!e->observing) {
+        fprintf(stderr, "observe registration failed with %u.%02u\n",
+                code >> 5, code & 0x1F);
+      }
+    } else {
+      notifications++;
+    }
+    return;
+  }
+  if((code >> 5) != 2) {
+    fprintf(stderr, "request failed with %u.%02u\n", code >> 5, code & 0x1F);
+    finish_request(e, 0);
+    return;
+  }
+  finish_request(e, 1);
+}
+/*---------------------------------------------------------------------------*/
+static void
+receive(void)
+{
+  uint8_t buf[MAX_MESSAGE_SIZE];
+  ssize_t len;
+  uint8_t type;
+  uint8_t token_len;
+  uint8_t code;
+  uint16_t mid;
+  exchange_t *e;
+
+  while((len = recv(sock, buf, sizeof(buf), MSG_DONTWAIT)) >= 0) {
+    if(len < 4 || (buf[0] >> 6) != 1) {
+      continue;
+    }
+    type = (buf[0] >> 4) & 0x3;
+    token_len = buf[0] & 0xF;
+    code = buf[1];
+    mid = (buf[2] << 8) | buf[3];
+    if(len < 4 + token_len) {
+      continue;
+    }
+
+    if(type == TYPE_ACK || type == TYPE_RST) {
+      if((e = find_by_mid(mid)) == NULL) {
+        /* e.g. the ACK to a retransmission */
+        continue;
+      }
+      if(type == TYPE_RST) {
+        if(is_observer(e)) {
+          e->active = 0;
+        } else {
+          finish_request(e, 0);
+        }
+      } else if(code == 0) {
+        e->acked = 1;
+        e->deadline = now_us() + exchange_lifetime() * 1000;
+      } else {
+        handle_response(e, code);
+      }
+      continue;
+    }
+
+    /* a separate response or a notification */
+    e = find_by_token(&buf[4], token_len);
+    if(type == TYPE_CON) {
+      send_empty(e != NULL ? TYPE_ACK : TYPE_RST, mid);
+    }
+    if(e == NULL) {
+      unexpected++;
+      continue;
+    }
+    /* a separate response may overtake the empty ACK */
+    handle_response(e, code);
+  }
+  if(errno != EAGAIN && errno != EWOULDBLOCK && errno != ECONNREFUSED) {
+    err(1, "recv");
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+check_timeouts(uint64_t now)
+{
+  exchange_t *e;
+  unsigned int i;
+
+  for(i = 0; i < concurrency + num_observers; i++) {
+    e = i < concurrency ? &requests[i] : &observers[i - concurrency];
+    if(!e->active || now < e->deadline) {
+      continue;
+    }
+    if(e->acked) {
+      /* the separate response never came */
+      if(is_observer(e)) {
+        fprintf(stderr, "observe registration timed out\n");
+        e->active = 0;
+      } else {
+        finish_request(e, 0);
+      }
+    } else if(e->retransmits < MAX_RETRANSMIT && (confirmable || is_observer(e))) {
+      e->retransmits++;
+      retransmits++;
+      e->timeout *= 2;
+      transmit(e);
+    } else if(is_observer(e)) {
+      fprintf(stderr, "observe registration timed out\n");
+      e->active = 0;
+    } else {
+      finish_request(e, 0);
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static int
+compare_latencies(const void *a, const void *b)
+{
+  uint32_t x = *(const uint32_t *)a;
+  uint32_t y = *(const uint32_t *)b;
+
+  return x < y ? -1 : x > y;
+}
+/*---------------------------------------------------------------------------*/
+/* Nearest-rank percentile of the sorted latencies, in milliseconds */
+static double
+percentile(unsigned int p)
+{
+  unsigned long rank = (p * completed + 99) / 100;
+
+  return latencies[rank > 0 ? rank - 1 : 0] / 1000.0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+report(const char *host, const char *port, uint64_t elapsed)
+{
+  double seconds = elapsed / 1000000.0;
+
+  printf("target        [%s]:%s\n", host, port);
+  printf("concurrency   %u\n", concurrency);
+  printf("observers     %u\n", num_observers);
+  printf("completed     %lu\n", completed);
+  printf("failed        %lu\n", failed);
+  printf("retransmits   %lu\n", retransmits);
+  printf("notifications %lu\n", notifications);
+  printf("unexpected    %lu\n", unexpected);
+  printf("duration      %.3f s\n", seconds);
+  printf("throughput    %.1f req/s\n", seconds > 0 ? completed / seconds : 0);
+  if(completed > 0) {
+    qsort(latencies, completed, sizeof(*latencies), compare_latencies);
+    printf("latency       min %.3f ms, p50 %.3f ms, p99 %.3f ms, max %.3f ms\n",
+           latencies[0] / 1000.0, percentile(50), percentile(99),
+           latencies[completed - 1] / 1000.0);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+usage(const char *prog)
+{
+  fprintf(stderr, "usage: %s [options] host [port]\n"
+          "  -c n     requests kept in flight (default 4, at most %u)\n"
+          "  -n n     number of requests (default 1000)\n"
+          "  -d s     run for s seconds instead of a number of requests\n"
+          "  -m mode  get, put or mix (default)\n"
+          "  -o n     observers registered during the run (at most %u)\n"
+          "  -N       send non-confirmable requests\n"
+          "  -t ms    initial retransmission timeout (default 2000)\n"
+          "  -g path  resource for GET (default test/hello)\n"
+          "  -p path  resource for PUT (default debug/mirror)\n"
+          "  -O path  resource to observe (default test/push)\n",
+          prog, MAX_CONCURRENCY, MAX_OBSERVERS);
+  exit(2);
+}
+/*---------------------------------------------------------------------------*/
+int
+main(int argc, char **argv)
+{
+  struct addrinfo hints;
+  struct addrinfo *res;
+  struct pollfd pfd;
+  const char *host;
+  const char *port;
+  uint64_t begin;
+  uint64_t end;
+  uint64_t now;
+  int timeout;
+  int busy;
+  int c;
+  unsigned int i;
+
+  while((c = getopt(argc, argv, "c:n:d:m:o:Nt:g:p:O:")) != -1) {
+    switch(c) {
+    case 'c':
+      concurrency = atoi(optarg);
+      break;
+    case 'n':
+      total = strtoul(optarg, NULL, 10);
+      break;
+    case 'd':
+      duration = atoi(optarg);
+      break;
+    case 'm':
+      mode = optarg;
+      break;
+    case 'o':
+      num_observers = atoi(optarg);
+      break;
+    case 'N':
+      confirmable = 0;
+      break;
+    case 't':
+      ack_timeout = atoi(optarg);
+      break;
+    case 'g':
+      get_path = optarg;
+      break;
+    case 'p':
+      put_path = optarg;
+      break;
+    case 'O':
+      observe_path = optarg;
+      break;
+    default:
+      usage(argv[0]);
+    }
+  }
+  if(optind >= argc || argc - optind > 2
+     || concurrency < 1 || concurrency > MAX_CONCURRENCY
+     || num_observers > MAX_OBSERVERS || ack_timeout < 1
+     || (strcmp(mode, "get") && strcmp(mode, "put") && strcmp(mode, "mix"))) {
+    usage(argv[0]);
+  }
+  host = argv[optind];
+  port = optind + 1 < argc ? argv[optind + 1] : COAP_DEFAULT_PORT;
+
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_DGRAM;
+  if((c = getaddrinfo(host, port, &hints, &res)) != 0) {
+    errx(1, "%s: %s", host, gai_strerror(c));
+  }
+  if((sock = socket(res->ai_family, SOCK_DGRAM, 0)) < 0) {
+    err(1, "socket");
+  }
+  if(connect(sock, res->ai_addr, res->ai_addrlen) < 0) {
+    err(1, "connect");
+  }
+  freeaddrinfo(res);
+
+  srandom(time(NULL) ^ getpid());
+  next_mid = random();
+
+  begin = now_us();
+  end = begin + (uint64_t)duration * 1000000;
+
+  for(i = 0; i < num_observers; i++) {
+    observers[i].token = 0x80000000 | i;
+    build_request(&observers[i], TYPE_CON, CODE_GET, observe_path, 0, NULL);
+    start_exchange(&observers[i]);
+  }
+
+  pfd.fd = sock;
+  pfd.events = POLLIN;
+  for(;;) {
+    now = now_us();
+    busy = 0;
+    for(i = 0; i < concurrency; i++) {
+      if(!requests[i].active
+         && (duration ? now < end : started < total)) {
+        start_request(&requests[i]);
+      }
+      busy |= requests[i].active;
+    }
+    if(!busy) {
+      break;
+    }
+
+    /* wake up for the next retransmission or expiry at the latest */
+    timeout = 100;
+    for(i = 0; i < concurrency + num_observers; i++) {
+      exchange_t *e = i < concurrency ? &requests[i] : &observers[i - concurrency];
+      if(e->active && e->deadline < now + timeout * 1000) {
+        timeout = e->deadline > now ? (e->deadline - now) / 1000 : 0;
+      }
+    }
+    if(poll(&pfd, 1, timeout) < 0 && errno != EINTR) {
+      err(1, "poll");
+    }
+    if(pfd.revents & POLLIN) {
+      receive();
+    }
+    check_timeouts(now_us());
+  }
+  now = now_us();
+
+  /* deregister, the server would otherwise keep notifying us */
+  for(i = 0; i < num_observers; i++) {
+    if(observers[i].observing) {
+      build_request(&observers[i], TYPE_NON, CODE_GET, observe_path, 1, NULL);
+      transmit(&observers[i]);
+    }
+  }
+
+  report(host, port, now - begin);
+  free(latencies);
+  close(sock);
+  return failed > 0 ? 1 : 0;
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,606 @@
+/*
+ * Copyright (c) 2026, Contiki-NG contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         MQTT broker stand-in: accepts one client at a time, acknowledges
+ *         its QoS 0, 1 and 2 PUBLISH messages after a configurable delay
+ *         and reports throughput, duplicates and retransmissions. Meant to
+ *         be run on the host against a native node over tun. Messages do
+ *         not go anywhere, the payload is expected to be a sequence number
+ *         below the number of messages, optionally followed by a space and
+ *         filler that repeats the alphabet from the start of the payload.
+ *         With -e, each new message is also sent back to the client with
+ *         QoS 0, on its topic prefixed with "echo/", as if the client had
+ *         subscribed to that.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#include <err.h>
+
+#define MQTT_DEFAULT_PORT 1883
+
+#define TYPE_CONNECT    0x10
+#define TYPE_CONNACK    0x20
+#define TYPE_PUBLISH    0x30
+#define TYPE_PUBACK     0x40
+#define TYPE_PUBREC     0x50
+#define TYPE_PUBREL     0x60
+#define TYPE_PUBCOMP    0x70
+#define TYPE_SUBSCRIBE  0x80
+#define TYPE_SUBACK     0x90
+#define TYPE_PINGREQ    0xC0
+#define TYPE_PINGRESP   0xD0
+#define TYPE_DISCONNECT 0xE0
+
+#define FLAG_DUP 0x08
+#define FLAG_CLEAN_SESSION 0x02
+
+#define INPUT_SIZE 16384
+
+#define ECHO_PREFIX "echo/"
+#define MAX_DELAYED 1024
+
+typedef struct {
+  uint64_t due;
+  uint8_t packet[4];
+  uint8_t len;
+} delayed_t;
+
+static delayed_t delayed[MAX_DELAYED];
+static unsigned int delayed_head;
+static unsigned int delayed_count;
+
+static int client = -1;
+static uint8_t input[INPUT_SIZE];
+static size_t input_len;
+
+static unsigned long total = 1000;
+static unsigned int ack_delay;
+static unsigned long kill_after;
+static unsigned int run_timeout = 60;
+static size_t payload_size;
+static int echo;
+
+/* Deliveries per sequence number and QoS 2 messages waiting for PUBREL */
+static uint8_t *delivered;
+static uint8_t released[65536];
+static unsigned long awaiting_release;
+
+static unsigned long received;
+static unsigned long unique;
+static unsigned long duplicates;
+static unsigned long retransmitted;
+static unsigned long connections;
+/* Set once a client connected without Clean Session */
+static int session;
+static unsigned long unexpected;
+static int max_qos;
+
+static uint64_t first_publish;
+static uint64_t last_completion;
+/*---------------------------------------------------------------------------*/
+static uint64_t
+now_us(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+/*---------------------------------------------------------------------------*/
+static void
+send_packet(const uint8_t *packet, size_t len)
+{
+  if(client >= 0 && send(client, packet, len, MSG_NOSIGNAL) < 0) {
+    warn("send");
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* PUBACK, PUBREC and PUBCOMP go out after the configured delay */
+static void
+send_ack(uint8_t type, uint16_t mid)
+{
+  delayed_t *d;
+
+  if(delayed_count == MAX_DELAYED) {
+    errx(1, "too many delayed acks");
+  }
+  d = &delayed[(delayed_head + delayed_count++) % MAX_DELAYED];
+  d->due = now_us() + (uint64_t)ack_delay * 1000;
+  d->packet[0] = type;
+  d->packet[1] = 2;
+  d->packet[2] = mid >> 8;
+  d->packet[3] = mid;
+  d->len = 4;
+}
+/*---------------------------------------------------------------------------*/
+static void
+send_due_acks(uint64_t now)
+{
+  uint8_t buf[MAX_DELAYED * 4];
+  size_t len = 0;
+  delayed_t *d;
+
+  /* Due acks go out in one write, like a broker answering a burst */
+  while(delayed_count > 0) {
+    d = &delayed[delayed_head];
+    if(d->due > now) {
+      break;
+    }
+    memcpy(&buf[len], d->packet, d->len);
+    len += d->len;
+    if(d->packet[0] != TYPE_PUBREC) {
+      last_completion = now;
+    }
+    delayed_head = (delayed_head + 1) % MAX_DELAYED;
+    delayed_count--;
+  }
+  if(len > 0) {
+    send_packet(buf, len);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+close_client(void)
+{
+  close(client);
+  client = -1;
+  input_len = 0;
+  delayed_count = 0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+deliver(const uint8_t *payload, size_t len)
+{
+  unsigned long seq = 0;
+  size_t i;
+
+  for(i = 0; i < len && payload[i] != ' '; i++) {
+    if(payload[i] < '0' || payload[i] > '9') {
+      unexpected++;
+      return;
+    }
+    seq = seq * 10 + payload[i] - '0';
+  }
+  if(i == 0 || seq >= total || (payload_size && len != payload_size)) {
+    unexpected++;
+    return;
+  }
+  for(i++; i < len; i++) {
+    if(payload[i] != 'a' + i % 26) {
+      unexpected++;
+      return;
+    }
+  }
+  if(delivered[seq]++) {
+    duplicates++;
+  } else {
+    unique++;
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Sends a message back with QoS 0 on ECHO_PREFIX and its topic */
+static void
+send_echo(const uint8_t *topic, size_t topic_len, const uint8_t *payload,
+          size_t len)
+{
+  static uint8_t packet[INPUT_SIZE + sizeof(ECHO_PREFIX) + 8];
+  size_t prefix_len = strlen(ECHO_PREFIX);
+  size_t remaining = 2 + prefix_len + topic_len + len;
+  size_t pos = 1;
+
+  if(remaining + 8 > sizeof(packet)) {
+    unexpected++;
+    return;
+  }
+  packet[0] = TYPE_PUBLISH;
+  do {
+    packet[pos] = remaining & 127;
+    remaining >>= 7;
+    if(remaining > 0) {
+      packet[pos] |= 128;
+    }
+    pos++;
+  } while(remaining > 0);
+  packet[pos++] = (prefix_len + topic_len) >> 8;
+  packet[pos++] = prefix_len + topic_len;
+  memcpy(&packet[pos], ECHO_PREFIX, prefix_len);
+  pos += prefix_len;
+  memcpy(&packet[pos], topic, topic_len);
+  pos += topic_len;
+  memcpy(&packet[pos], payload, len);
+  send_packet(packet, pos + len);
+}
+/*---------------------------------------------------------------------------*/
+static void
+handle_publish(uint8_t fhdr, const uint8_t *data, size_t len)
+{
+  size_t topic_len;
+  size_t pos;
+  uint16_t mid = 0;
+  int qos = (fhdr >> 1) & 3;
+
+  if(len < 2) {
+    unexpected++;
+    return;
+  }
+  topic_len = (data[0] << 8) | data[1];
+  pos = 2 + topic_len;
+  if(qos > 0) {
+    if(pos + 2 > len) {
+      unexpected++;
+      return;
+    }
+    mid = (data[pos] << 8) | data[pos + 1];
+    pos += 2;
+  }
+  if(pos > len) {
+    unexpected++;
+    return;
+  }
+
+  received++;
+  if(first_publish == 0) {
+    first_publish = now_us();
+  }
+  if(fhdr & FLAG_DUP) {
+    retransmitted++;
+  }
+  if(qos > max_qos) {
+    max_qos = qos;
+  }
+
+  /* Drop the connection once, before acknowledging this message */
+  if(kill_after > 0 && received == kill_after) {
+    printf("closing the connection after %lu messages\n", received);
+    close_client();
+    return;
+  }
+
+  if(echo && (qos < 2 || !released[mid])) {
+    send_echo(&data[2], topic_len, &data[pos], len - pos);
+  }
+
+  switch(qos) {
+  case 0:
+    deliver(&data[pos], len - pos);
+    last_completion = now_us();
+    break;
+  case 1:
+    deliver(&data[pos], len - pos);
+    send_ack(TYPE_PUBACK, mid);
+    break;
+  default:
+    /* Deliver on receipt, a retransmission before PUBREL is not new */
+    if(!released[mid]) {
+      deliver(&data[pos], len - pos);
+      released[mid] = 1;
+      awaiting_release++;
+    }
+    send_ack(TYPE_PUBREC, mid);
+    break;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+handle_connect(const uint8_t *data, size_t len)
+{
+  uint8_t connack[] = { TYPE_CONNACK, 2, 0, 0 };
+  size_t pos;
+
+  if(len < 2 || (pos = 2 + ((data[0] << 8) | data[1]) + 1) >= len) {
+    unexpected++;
+    return;
+  }
+  if(data[pos] & FLAG_CLEAN_SESSION) {
+    /* QoS 2 messages not released are forgotten */
+    memset(released, 0, sizeof(released));
+    awaiting_release = 0;
+    session = 0;
+  } else {
+    /* Session Present */
+    connack[2] = session;
+    session = 1;
+  }
+  send_packet(connack, sizeof(connack));
+}
+/*---------------------------------------------------------------------------*/
+static void
+handle_packet(uint8_t fhdr, const uint8_t *data, size_t len)
+{
+  static const uint8_t pingresp[] = { TYPE_PINGRESP, 0 };
+  uint8_t suback[5];
+  uint16_t mid;
+
+  switch(fhdr & 0xF0) {
+  case TYPE_CONNECT:
+    handle_connect(data, len);
+    break;
+  case TYPE_PUBLISH:
+    handle_publish(fhdr, data, len);
+    break;
+  case TYPE_PUBREL:
+    if(len < 2) {
+      unexpected++;
+      break;
+    }
+    mid = (data[0] << 8) | data[1];
+    if(released[mid]) {
+      released[mid] = 0;
+      awaiting_release--;
+    }
+    send_ack(TYPE_PUBCOMP, mid);
+    break;
+  case TYPE_SUBSCRIBE:
+    if(len < 2) {
+      unexpected++;
+      break;
+    }
+    suback[0] = TYPE_SUBACK;
+    suback[1] = 3;
+    suback[2] = data[0];
+    suback[3] = data[1];
+    suback[4] = data[len - 1] & 3;
+    send_packet(suback, sizeof(suback));
+    break;
+  case TYPE_PINGREQ:
+    send_packet(pingresp, sizeof(pingresp));
+    break;
+  case TYPE_DISCONNECT:
+    close_client();
+    break;
+  default:
+    unexpected++;
+    break;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+receive(void)
+{
+  ssize_t n;
+  size_t pos = 0;
+  size_t start;
+  size_t remaining;
+  unsigned int shift;
+  uint8_t byte;
+#ifdef TCP_QUICKACK
+  int one = 1;
+#endif
+
+  n = recv(client, &input[input_len], sizeof(input) - input_len, 0);
+  if(n <= 0) {
+    close_client();
+    return;
+  }
+  input_len += n;
+
+#ifdef TCP_QUICKACK
+  /* Do not delay the TCP ACK, uIP only sends one segment at a time */
+  setsockopt(client, IPPROTO_TCP, TCP_QUICKACK, &one, sizeof(one));
+#endif
+
+  while(client >= 0 && pos < input_len) {
+    start = pos + 1;
+    remaining = 0;
+    shift = 0;
+    do {
+      if(start >= input_len) {
+        goto incomplete;
+      }
+      byte = input[start++];
+      remaining |= (size_t)(byte & 127) << shift;
+      shift += 7;
+    } while((byte & 128) && shift < 28);
+    if(start + remaining > input_len) {
+      if(start - pos + remaining > sizeof(input)) {
+        errx(1, "packet of %zu bytes does not fit", remaining);
+      }
+      goto incomplete;
+    }
+    handle_packet(input[pos], &input[start], remaining);
+    pos = start + remaining;
+  }
+
+incomplete:
+  if(client >= 0) {
+    memmove(input, &input[pos], input_len - pos);
+    input_len -= pos;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+report(void)
+{
+  uint64_t elapsed = last_completion > first_publish ?
+    last_completion - first_publish : 0;
+
+  printf("messages      %lu of %lu (QoS %d)\n", unique, total, max_qos);
+  printf("received      %lu, %lu with DUP, %lu duplicates\n",
+         received, retransmitted, duplicates);
+  printf("connections   %lu\n", connections);
+  printf("unexpected    %lu\n", unexpected);
+  printf("elapsed       %.3f s\n", elapsed / 1000000.0);
+  printf("throughput    %.1f msg/s\n",
+         elapsed > 0 ? unique * 1000000.0 / elapsed : 0.0);
+}
+/*---------------------------------------------------------------------------*/
+static void
+usage(const char *prog)
+{
+  fprintf(stderr, "usage: %s [options]\n"
+          "  -p port  port to listen on (default %u)\n"
+          "  -n n     number of messages to expect (default 1000)\n"
+          "  -d ms    delay before acknowledging a message (default 0)\n"
+          "  -k n     drop the connection once, on the n-th message\n"
+          "  -t s     give up after s seconds (default 60)\n"
+          "  -s size  expect payloads of exactly size bytes\n"
+          "  -e       send each message back on echo/<topic>\n",
+          prog, MQTT_DEFAULT_PORT);
+  exit(2);
+}
+/*---------------------------------------------------------------------------*/
+int
+main(int argc, char **argv)
+{
+  struct sockaddr_in6 addr;
+  struct pollfd pfd[2];
+  unsigned int port = MQTT_DEFAULT_PORT;
+  uint64_t deadline;
+  uint64_t now;
+  int listener;
+  int timeout;
+  int one = 1;
+  int c;
+
+  while((c = getopt(argc, argv, "p:n:d:k:t:s:e")) != -1) {
+    switch(c) {
+    case 'p':
+      port = atoi(optarg);
+      break;
+    case 'n':
+      total = strtoul(optarg, NULL, 10);
+      break;
+    case 'd':
+      ack_delay = atoi(optarg);
+      break;
+    case 'k':
+      kill_after = strtoul(optarg, NULL, 10);
+      break;
+    case 't':
+      run_timeout = atoi(optarg);
+      break;
+    case 's':
+      payload_size = strtoul(optarg, NULL, 10);
+      break;
+    case 'e':
+      echo = 1;
+      break;
+    default:
+      usage(argv[0]);
+    }
+  }
+  if(optind != argc || total < 1 || port < 1 || port > 65535) {
+    usage(argv[0]);
+  }
+
+  if((delivered = calloc(total, 1)) == NULL) {
+    err(1, "calloc");
+  }
+
+  if((listener = socket(AF_INET6, SOCK_STREAM, 0)) < 0) {
+    err(1, "socket");
+  }
+  setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  memset(&addr, 0, sizeof(addr));
+  addr.sin6_family = AF_INET6;
+  addr.sin6_addr = in6addr_any;
+  addr.sin6_port = htons(port);
+  if(bind(listener, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+    err(1, "bind");
+  }
+  if(listen(listener, 1) < 0) {
+    err(1, "listen");
+  }
+
+  deadline = now_us() + (uint64_t)run_timeout * 1000000;
+  while(unique < total || awaiting_release > 0 || delayed_count > 0) {
+    now = now_us();
+    if(now >= deadline) {
+      printf("timed out\n");
+      break;
+    }
+
+    timeout = 100;
+    if(delayed_count > 0) {
+      timeout = delayed[delayed_head].due > now ?
+        (delayed[delayed_head].due - now + 999) / 1000 : 0;
+    }
+    pfd[0].fd = listener;
+    pfd[0].events = POLLIN;
+    pfd[1].fd = client;
+    pfd[1].events = POLLIN;
+    pfd[1].revents = 0;
+    if(poll(pfd, client >= 0 ? 2 : 1, timeout) < 0 && errno != EINTR) {
+      err(1, "poll");
+    }
+
+    if(pfd[0].revents & POLLIN) {
+      c = accept(listener, NULL, NULL);
+      if(c >= 0) {
+        if(client >= 0) {
+          /* The client reconnected, the old connection is gone */
+          close_client();
+        }
+        client = c;
+        setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        connections++;
+      }
+    }
+    if(client >= 0 && (pfd[1].revents & (POLLIN | POLLHUP | POLLERR))) {
+      receive();
+    }
+    send_due_acks(now_us());
+  }
+
+  /* Let the last acks reach the client before closing */
+  if(client >= 0) {
+    usleep(500000);
+    close_client();
+  }
+  close(listener);
+
+  report();
+  free(delivered);
+
+  if(unique < total || (max_qos == 2 && duplicates > 0)) {
+    return 1;
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/